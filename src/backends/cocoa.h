@@ -0,0 +1,21 @@
+/**
+ * @package TouchJS
+ *
+ * @file Cocoa backend header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_BACKEND_COCOA_H
+#define TJS_BACKEND_COCOA_H 1
+
+/* Includes */
+#include "../embed.h"
+
+/* Globals */
+extern const TjsBackend tjs_backend_cocoa;
+
+#endif /* TJS_BACKEND_COCOA_H */
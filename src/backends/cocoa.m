@@ -0,0 +1,192 @@
+/**
+ * @package TouchJS
+ *
+ * @file Cocoa backend functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#import <Cocoa/Cocoa.h>
+
+#include "../touchjs.h"
+#include "../delegate.h"
+#include "../embed.h"
+
+#include "cocoa.h"
+
+/**
+ * Helper to convert color
+ *
+ * @param[in]  col  A #TjsColor
+ *
+ * @return A #NSColor
+ **/
+
+static NSColor *tjs_cocoa_to_nscolor(TjsColor *col) {
+    return [NSColor
+        colorWithRed: ((float)(col->red) / 0xff)
+        green: ((float)(col->green) / 0xff)
+        blue: ((float)(col->blue) / 0xff)
+        alpha: 1.0f];
+}
+
+/**
+ * Create view of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+static void tjs_cocoa_create(TjsEmbed *embed) {
+    NSView *view = NULL;
+
+    /* Get delegate as target */
+    AppDelegate *delegate = (AppDelegate *)[[NSApplication sharedApplication] delegate];
+
+    /* Handle type */
+    if (0 < (embed->userdata->flags & TJS_FLAG_TYPE_LABEL)) { ///< TjsLabel
+        view = [NSTextField labelWithString:
+            [NSString stringWithUTF8String: ((TjsWidget *)embed->userdata)->value.asChar]];
+
+        [((NSTextField *)view) setTag: embed->idx];
+    } else if (0 < (embed->userdata->flags & TJS_FLAG_TYPE_BUTTON)) { ///< TjsButton
+        view = [NSButton buttonWithTitle:
+            [NSString stringWithUTF8String: ((TjsWidget *)embed->userdata)->value.asChar]
+            target: delegate action: @selector(button:)];
+
+        [((NSButton *)view) setTag: embed->idx];
+    } else if (0 < (embed->userdata->flags & TJS_FLAG_TYPE_SLIDER)) { ///< TjsSlider
+        view = [NSSlider sliderWithValue: ((TjsWidget *)embed->userdata)->value.asInt
+            minValue: 0 maxValue: 100 target: delegate action: @selector(slider:)];
+
+        [((NSSlider *)view) setTag: embed->idx];
+    } else if (0 < (embed->userdata->flags & TJS_FLAG_TYPE_SCRUBBER)) {
+        view = [[[NSScrollView alloc] initWithFrame:
+            CGRectMake(0, 0, 400, 30)] autorelease];
+    }
+
+    /* Keep view until the embed is destroyed */
+    embed->view = [view retain];
+}
+
+/**
+ * Configure view of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+static void tjs_cocoa_configure(TjsEmbed *embed) {
+    /* Handle type */
+    if (0 < (embed->userdata->flags & TJS_FLAG_TYPE_SCRUBBER)) {
+        NSMutableDictionary *constraintViews = [NSMutableDictionary dictionary];
+        NSView *docView = [[NSView alloc] initWithFrame: NSZeroRect];
+        NSSize size = NSMakeSize(8, 30);
+
+        /* Build format and collect children */
+        NSString *layoutFormat = @"H:|-8-";
+
+        for (int i = 0; i < tjs_embed_count(); i++) {
+            TjsEmbed *childEmbed = tjs_embed_get(i);
+
+            if (NULL != childEmbed && childEmbed->parent == embed->userdata) {
+                NSView *childView = (NSView *)childEmbed->view;
+
+                [childView setTranslatesAutoresizingMaskIntoConstraints: NO];
+                [docView addSubview: childView];
+
+                /* Append constraint */
+                NSString *identifier = [NSString stringWithFormat: @"widget%d", i];
+
+                layoutFormat = [layoutFormat stringByAppendingString:
+                    [NSString stringWithFormat: @"[%@]-8-", identifier]];
+
+                [constraintViews setObject: childView forKey: identifier];
+
+                size.width += 8 + childView.intrinsicContentSize.width + 8;
+
+                tjs_embed_update(childEmbed);
+            }
+        }
+
+        layoutFormat = [layoutFormat stringByAppendingString: [NSString stringWithFormat:@"|"]];
+
+        /* Add layout constraint */
+        NSArray *constraints = [NSLayoutConstraint constraintsWithVisualFormat: layoutFormat
+            options: NSLayoutFormatAlignAllCenterY metrics: nil views: constraintViews];
+
+        [docView setFrame: NSMakeRect(0, 0, size.width, size.height)];
+        [docView addConstraints: constraints];
+
+        ((NSScrollView *)embed->view).documentView = docView;
+    }
+}
+
+/**
+ * Update color of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ * @param[in]     flag   Color flag
+ * @param[in]     color  A #TjsColor
+ **/
+
+static void tjs_cocoa_color(TjsEmbed *embed, int flag, TjsColor *color) {
+    NSColor *parsedCol = tjs_cocoa_to_nscolor(color);
+    int flags = embed->userdata->flags;
+
+    /* Handle widget types */
+    if (TJS_FLAG_STATE_COLOR_FG == flag) {
+        if (0 < (flags & TJS_FLAG_TYPE_LABEL)) {
+            [((NSTextField *)(embed->view)) setTextColor: parsedCol];
+        }
+    } else {
+        if (0 < (flags & TJS_FLAG_TYPE_BUTTON)) {
+            [((NSButton *)(embed->view)) setBezelColor: parsedCol];
+        } else if (0 < (flags & TJS_FLAG_TYPE_SLIDER)) {
+            [((NSSlider *)(embed->view)) setTrackFillColor: parsedCol];
+            [((NSSlider *)(embed->view)) setNeedsDisplay];
+        }
+    }
+}
+
+/**
+ * Update value of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ * @param[in]     value  A #TjsValue
+ **/
+
+static void tjs_cocoa_value(TjsEmbed *embed, TjsValue *value) {
+    int flags = embed->userdata->flags;
+
+    /* Handle widget types */
+    if (0 < (flags & TJS_FLAG_TYPE_LABEL)) {
+        [((NSTextField *)(embed->view)) setStringValue:
+            [NSString stringWithUTF8String: value->asChar]];
+    } else if (0 < (flags & TJS_FLAG_TYPE_SLIDER)) {
+        [((NSSlider *)(embed->view)) setDoubleValue: value->asInt];
+    }
+}
+
+/**
+ * Destroy view of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+static void tjs_cocoa_destroy(TjsEmbed *embed) {
+    [((NSView *)embed->view) release];
+
+    embed->view = NULL;
+}
+
+/* Backend */
+const TjsBackend tjs_backend_cocoa = {
+    .name = "cocoa",
+    .create = tjs_cocoa_create,
+    .configure = tjs_cocoa_configure,
+    .color = tjs_cocoa_color,
+    .value = tjs_cocoa_value,
+    .destroy = tjs_cocoa_destroy
+};
@@ -0,0 +1,242 @@
+/**
+ * @package TouchJS
+ *
+ * @file Headless backend functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include "../touchjs.h"
+#include "../embed.h"
+
+#include "headless.h"
+
+/* Defines */
+#define TJS_HEADLESS_LOG_MAX 65536 ///< Ops beyond this are only counted
+
+/* Globals */
+static TjsHeadlessOp *oplog = NULL;
+static int nops = 0;
+static unsigned long counts[TJS_HEADLESS_OP_MAX] = { 0 };
+
+static const char *opnames[TJS_HEADLESS_OP_MAX] = {
+    "create", "configure", "color_fg", "color_bg", "value", "destroy"
+};
+
+/**
+ * Helper to record an op
+ *
+ * @param[in]  op     Op type
+ * @param[in]  embed  A #TjsEmbed
+ *
+ * @return Either new #TjsHeadlessOp; otherwise NULL when log is full
+ **/
+
+static TjsHeadlessOp *tjs_headless_record(int op, TjsEmbed *embed) {
+    counts[op]++;
+
+    /* Allocate lazily */
+    if (NULL == oplog) {
+        oplog = (TjsHeadlessOp *)calloc(TJS_HEADLESS_LOG_MAX,
+            sizeof(TjsHeadlessOp));
+    }
+
+    if (NULL == oplog || TJS_HEADLESS_LOG_MAX <= nops) return NULL;
+
+    TjsHeadlessOp *entry = &(oplog[nops++]);
+
+    memset(entry, 0, sizeof(TjsHeadlessOp));
+
+    entry->op = op;
+    entry->idx = embed->idx;
+    entry->flags = embed->userdata->flags;
+
+    return entry;
+}
+
+/**
+ * Create view of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+static void tjs_headless_create(TjsEmbed *embed) {
+    TjsHeadlessOp *entry = tjs_headless_record(TJS_HEADLESS_OP_CREATE, embed);
+
+    /* Keep initial title of labels and buttons */
+    if (NULL != entry && 0 < (embed->userdata->flags &
+            (TJS_FLAG_TYPE_LABEL|TJS_FLAG_TYPE_BUTTON)))
+    {
+        TjsWidget *widget = (TjsWidget *)embed->userdata;
+
+        if (NULL != widget->value.asChar) {
+            snprintf(entry->text, sizeof(entry->text), "%s",
+                widget->value.asChar);
+        }
+    }
+
+    embed->view = embed; ///< Non-NULL marker for views
+}
+
+/**
+ * Configure view of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+static void tjs_headless_configure(TjsEmbed *embed) {
+    tjs_headless_record(TJS_HEADLESS_OP_CONFIGURE, embed);
+
+    /* Scrubbers update their children like the cocoa backend */
+    if (0 < (embed->userdata->flags & TJS_FLAG_TYPE_SCRUBBER)) {
+        for (int i = 0; i < tjs_embed_count(); i++) {
+            TjsEmbed *childEmbed = tjs_embed_get(i);
+
+            if (NULL != childEmbed && childEmbed->parent == embed->userdata) {
+                tjs_embed_update(childEmbed);
+            }
+        }
+    }
+}
+
+/**
+ * Update color of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ * @param[in]     flag   Color flag
+ * @param[in]     color  A #TjsColor
+ **/
+
+static void tjs_headless_color(TjsEmbed *embed, int flag, TjsColor *color) {
+    TjsHeadlessOp *entry = tjs_headless_record(
+        (TJS_FLAG_STATE_COLOR_FG == flag ?
+            TJS_HEADLESS_OP_COLOR_FG : TJS_HEADLESS_OP_COLOR_BG), embed);
+
+    if (NULL != entry) {
+        entry->value.color = *color;
+    }
+}
+
+/**
+ * Update value of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ * @param[in]     value  A #TjsValue
+ **/
+
+static void tjs_headless_value(TjsEmbed *embed, TjsValue *value) {
+    TjsHeadlessOp *entry = tjs_headless_record(TJS_HEADLESS_OP_VALUE, embed);
+
+    if (NULL != entry) {
+        if (0 < (embed->userdata->flags & TJS_FLAG_TYPE_SLIDER)) {
+            entry->value.asInt = value->asInt;
+        } else if (NULL != value->asChar) {
+            snprintf(entry->text, sizeof(entry->text), "%s", value->asChar);
+        }
+    }
+}
+
+/**
+ * Destroy view of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+static void tjs_headless_destroy(TjsEmbed *embed) {
+    tjs_headless_record(TJS_HEADLESS_OP_DESTROY, embed);
+
+    embed->view = NULL;
+}
+
+/**
+ * Get number of recorded ops of given type
+ *
+ * @param[in]  op  Op type
+ *
+ * @return Number of ops including those beyond the log limit
+ **/
+
+unsigned long tjs_headless_count(int op) {
+    return (0 <= op && TJS_HEADLESS_OP_MAX > op ? counts[op] : 0);
+}
+
+/**
+ * Get number of logged ops
+ *
+ * @return Number of entries in op log
+ **/
+
+int tjs_headless_nops(void) {
+    return nops;
+}
+
+/**
+ * Get logged op based on index
+ *
+ * @param[in]  idx  Index to get
+ *
+ * @return Either found #TjsHeadlessOp; otherwise NULL
+ **/
+
+const TjsHeadlessOp *tjs_headless_get(int idx) {
+    return (0 <= idx && nops > idx ? &(oplog[idx]) : NULL);
+}
+
+/**
+ * Dump op log
+ *
+ * @param[inout]  fp  File to write to
+ **/
+
+void tjs_headless_dump(FILE *fp) {
+    for (int i = 0; i < nops; i++) {
+        TjsHeadlessOp *entry = &(oplog[i]);
+
+        fprintf(fp, "%d %s idx=%d flags=%d", i, opnames[entry->op],
+            entry->idx, entry->flags);
+
+        switch (entry->op) {
+            case TJS_HEADLESS_OP_COLOR_FG:
+            case TJS_HEADLESS_OP_COLOR_BG:
+                fprintf(fp, " rgb=%d,%d,%d", entry->value.color.red,
+                    entry->value.color.green, entry->value.color.blue);
+                break;
+            case TJS_HEADLESS_OP_CREATE:
+            case TJS_HEADLESS_OP_VALUE:
+                if ('\0' != entry->text[0]) {
+                    fprintf(fp, " text=%s", entry->text);
+                } else if (TJS_HEADLESS_OP_VALUE == entry->op) {
+                    fprintf(fp, " value=%d", entry->value.asInt);
+                }
+                break;
+        }
+
+        fputc('\n', fp);
+    }
+}
+
+/**
+ * Reset op log and counters
+ **/
+
+void tjs_headless_reset(void) {
+    free(oplog);
+
+    oplog = NULL;
+    nops = 0;
+
+    memset(counts, 0, sizeof(counts));
+}
+
+/* Backend */
+const TjsBackend tjs_backend_headless = {
+    .name = "headless",
+    .create = tjs_headless_create,
+    .configure = tjs_headless_configure,
+    .color = tjs_headless_color,
+    .value = tjs_headless_value,
+    .destroy = tjs_headless_destroy
+};
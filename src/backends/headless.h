@@ -0,0 +1,49 @@
+/**
+ * @package TouchJS
+ *
+ * @file Headless backend header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_BACKEND_HEADLESS_H
+#define TJS_BACKEND_HEADLESS_H 1
+
+/* Includes */
+#include "../embed.h"
+
+/* Ops */
+#define TJS_HEADLESS_OP_CREATE 0
+#define TJS_HEADLESS_OP_CONFIGURE 1
+#define TJS_HEADLESS_OP_COLOR_FG 2
+#define TJS_HEADLESS_OP_COLOR_BG 3
+#define TJS_HEADLESS_OP_VALUE 4
+#define TJS_HEADLESS_OP_DESTROY 5
+#define TJS_HEADLESS_OP_MAX 6
+
+/* Types */
+typedef struct tjs_headless_op_t {
+    int op, idx, flags;
+
+    union {
+        struct tjs_color_t color;
+        int asInt;
+    } value;
+
+    char text[32]; ///< Truncated copy of string values
+} TjsHeadlessOp;
+
+/* Globals */
+extern const TjsBackend tjs_backend_headless;
+
+/* Methods */
+unsigned long tjs_headless_count(int op);
+int tjs_headless_nops(void);
+const TjsHeadlessOp *tjs_headless_get(int idx);
+void tjs_headless_dump(FILE *fp);
+void tjs_headless_reset(void);
+
+#endif /* TJS_BACKEND_HEADLESS_H */
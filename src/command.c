@@ -0,0 +1,879 @@
+/**
+ * @package TouchJS
+ *
+ * @file Command functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "touchjs.h"
+#include "touchbar.h"
+
+#include "common/userdata.h"
+#include "common/callback.h"
+#include "common/value.h"
+#include "common/proc.h"
+#include "common/exec.h"
+#include "common/timer.h"
+#include "common/gc.h"
+
+/* Defines */
+#define TJS_COMMAND_KEEP 4096 ///< Output buffers up to this size are reused
+
+/* Types */
+typedef struct tjs_command_t {
+    int flags;
+
+    char *line;
+    union tjs_value_t value; ///< Collected output
+
+    size_t len, capacity;
+    int status; ///< Exit status; -1 while running
+
+    unsigned long id; ///< Exec id; key while running or pending
+    int options;      ///< Exec flags, see TJS_EXEC_FLAG_*
+
+    struct tjs_proc_t *proc; ///< Running child; NULL otherwise
+    struct tjs_exec_entry_t *entry; ///< Cache entry filled by this command
+    struct tjs_command_t *owner; ///< Command whose child is shared
+
+    duk_context *ctx; ///< Heap the command is kept reachable in
+} TjsCommand;
+
+/* Globals */
+static unsigned long tjs_command_lastid = 0;
+
+/**
+ * Helper to push command object of running or pending command
+ *
+ * @param[inout]  ctx  A #duk_context
+ * @param[in]     id   Exec id
+ *
+ * @return Either 1 when pushed; otherwise 0 and nothing is pushed
+ **/
+
+static int tjs_command_push(duk_context *ctx, unsigned long id) {
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_COMMANDS);
+    duk_get_prop_index(ctx, -1, (duk_uarridx_t)id);
+    duk_remove(ctx, -2);
+    duk_remove(ctx, -2);
+
+    if (duk_is_object(ctx, -1)) return 1;
+
+    duk_pop(ctx);
+
+    return 0;
+}
+
+/**
+ * Helper to call callback of command object on stack top; pops object
+ * and arguments
+ *
+ * @param[inout]  ctx    A #duk_context
+ * @param[in]     sym    Symbol of the callback
+ * @param[in]     nargs  Number of arguments
+ *
+ * @return Either 1 when called; otherwise 0
+ **/
+
+static int tjs_command_call(duk_context *ctx, const char *sym, int nargs) {
+    duk_get_prop_string(ctx, -1 - nargs, sym);
+
+    int callable = duk_is_callable(ctx, -1);
+
+    duk_pop(ctx);
+
+    if (callable) {
+        tjs_callback_call(ctx, sym, nargs);
+    } else {
+        duk_pop_n(ctx, 1 + nargs);
+    }
+
+    return callable;
+}
+
+/**
+ * Helper to append output
+ *
+ * @param[inout]  command  A #TjsCommand
+ * @param[in]     buf      Output chunk
+ * @param[in]     len      Length of chunk
+ **/
+
+static void tjs_command_append(TjsCommand *command, const char *buf, size_t len) {
+    if (command->len + len + 1 > command->capacity) {
+        size_t capacity = (0 < command->capacity ? command->capacity : 256);
+
+        while (command->len + len + 1 > capacity) capacity *= 2;
+
+        command->value.asChar = (char *)realloc(command->value.asChar, capacity);
+        command->capacity = capacity;
+    }
+
+    memcpy(command->value.asChar + command->len, buf, len);
+
+    command->len += len;
+    command->value.asChar[command->len] = '\0';
+}
+
+/**
+ * Helper to clear output and status
+ *
+ * @param[inout]  command  A #TjsCommand
+ **/
+
+static void tjs_command_reset(TjsCommand *command) {
+    command->len = 0;
+    command->status = -1;
+
+    if (NULL != command->value.asChar) command->value.asChar[0] = '\0';
+}
+
+/**
+ * Helper to store output string on command object on stack top; large
+ * output buffers are released, so the string is the only copy
+ *
+ * @param[inout]  ctx      A #duk_context
+ * @param[inout]  command  A #TjsCommand
+ * @param[in]     output   Index of output string
+ **/
+
+static void tjs_command_store(duk_context *ctx, TjsCommand *command,
+    duk_idx_t output)
+{
+    duk_size_t len = 0;
+
+    duk_get_lstring(ctx, output, &len);
+    duk_dup(ctx, output);
+    duk_put_prop_string(ctx, -2, TJS_SYM_OUTPUT);
+
+    if (NULL != command) {
+        command->len = len;
+
+        if (TJS_COMMAND_KEEP < command->capacity) {
+            free(command->value.asChar);
+
+            command->value.asChar = NULL;
+            command->capacity = 0;
+        }
+    }
+}
+
+/**
+ * Helper to spawn child of command; either runs line through the user
+ * shell or splits it and execs it directly
+ *
+ * @param[inout]  command  A #TjsCommand
+ *
+ * @return Either new #TjsProc; otherwise NULL and errno is set
+ **/
+
+static TjsProc *tjs_command_spawn(TjsCommand *command) {
+    char *argv[TJS_EXEC_MAX_ARGS], *line = NULL;
+
+    if (0 < (command->options & TJS_EXEC_FLAG_DIRECT)) {
+        line = strdup(command->line);
+
+        if (0 == tjs_exec_split(line, argv, TJS_EXEC_MAX_ARGS)) {
+            free(line);
+
+            errno = EINVAL;
+
+            return NULL;
+        }
+    } else {
+        const char *shell = getenv("SHELL");
+
+        argv[0] = (char *)(NULL != shell ? shell : "/bin/sh");
+        argv[1] = "-l";
+        argv[2] = "-c";
+        argv[3] = command->line;
+        argv[4] = NULL;
+    }
+
+    command->proc = tjs_procs_spawn(touch.procs, argv, command);
+
+    int err = errno;
+
+    free(line);
+
+    errno = err;
+
+    if (NULL != command->proc) {
+        command->flags &= ~TJS_FLAG_STATE_PENDING;
+    }
+
+    return command->proc;
+}
+
+/**
+ * Helper to hand result of command on stack top to it; pops object
+ *
+ * @param[inout]  ctx     A #duk_context
+ * @param[in]     output  Index of output string
+ * @param[in]     status  Exit status
+ **/
+
+static void tjs_command_deliver(duk_context *ctx, duk_idx_t output, int status) {
+    TjsCommand *command = (TjsCommand *)tjs_userdata_from(ctx,
+        TJS_FLAG_TYPE_COMMAND);
+
+    if (NULL != command) {
+        command->flags &= ~TJS_FLAG_STATE_PENDING;
+        command->owner = NULL;
+        command->status = status;
+    }
+
+    tjs_command_store(ctx, command, output);
+
+    /* Whole output at once */
+    if (0 < duk_get_length(ctx, output)) {
+        duk_dup(ctx, -1);
+        duk_dup(ctx, output);
+        tjs_command_call(ctx, TJS_SYM_DATA_CB, 1);
+    }
+
+    duk_push_int(ctx, status);
+    tjs_command_call(ctx, TJS_SYM_EXIT_CB, 1);
+}
+
+/**
+ * Helper to settle command and the commands sharing its child; calls
+ * onExit or with message onError
+ *
+ * @param[inout]  ctx      A #duk_context
+ * @param[inout]  command  A #TjsCommand
+ * @param[in]     msg      Error message; NULL on exit
+ **/
+
+static void tjs_command_settle(duk_context *ctx, TjsCommand *command,
+    const char *msg)
+{
+    unsigned long id = command->id;
+
+    command->flags &= ~TJS_FLAG_STATE_PENDING;
+
+    if (NULL != command->entry) {
+        if (NULL != msg) {
+            tjs_exec_abort(touch.exec, command->entry);
+        } else {
+            tjs_exec_end(touch.exec, command->entry, command->value.asChar,
+                command->len, command->status, tjs_timers_now(touch.timers));
+        }
+
+        command->entry = NULL;
+    }
+
+    /* Callbacks might re-exec commands, so keep a copy */
+    duk_push_lstring(ctx, (NULL != command->value.asChar ?
+        command->value.asChar : ""), command->len);
+
+    duk_idx_t output = duk_get_top_index(ctx);
+    int status = command->status;
+
+    if (NULL == msg && tjs_command_push(ctx, id)) {
+        tjs_command_store(ctx, command, output);
+        duk_pop(ctx);
+    }
+
+    /* Commands sharing the child */
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_WAITERS);
+    duk_get_prop_index(ctx, -1, (duk_uarridx_t)id);
+    duk_del_prop_index(ctx, -2, (duk_uarridx_t)id);
+
+    if (duk_is_array(ctx, -1)) {
+        duk_size_t nwaiters = duk_get_length(ctx, -1);
+
+        for (duk_size_t i = 0; i < nwaiters; i++) {
+            duk_get_prop_index(ctx, -1, (duk_uarridx_t)i);
+
+            if (NULL != msg) {
+                TjsCommand *waiter = (TjsCommand *)tjs_userdata_from(ctx,
+                    TJS_FLAG_TYPE_COMMAND);
+
+                if (NULL != waiter) {
+                    waiter->flags &= ~TJS_FLAG_STATE_PENDING;
+                    waiter->owner = NULL;
+                }
+
+                duk_push_string(ctx, msg);
+                tjs_command_call(ctx, TJS_SYM_ERROR_CB, 1);
+            } else {
+                tjs_command_deliver(ctx, output, status);
+            }
+        }
+    }
+
+    duk_pop_3(ctx);
+
+    if (tjs_command_push(ctx, id)) {
+        if (NULL != msg) {
+            duk_push_string(ctx, msg);
+
+            if (!tjs_command_call(ctx, TJS_SYM_ERROR_CB, 1)) {
+                TJS_LOG_ERROR("%s", msg);
+            }
+        } else {
+            duk_push_int(ctx, status);
+            tjs_command_call(ctx, TJS_SYM_EXIT_CB, 1);
+        }
+    }
+
+    duk_pop(ctx);
+
+    /* Release object */
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_COMMANDS);
+    duk_del_prop_index(ctx, -1, (duk_uarridx_t)id);
+    duk_pop_2(ctx);
+
+    tjs_gc_activity(touch.gc);
+}
+
+/**
+ * Helper to check whether another child may be started
+ *
+ * @return Either 1 when a slot is free; otherwise 0
+ **/
+
+static int tjs_command_slot(void) {
+    return (0 == touch.exec->limit ||
+        tjs_procs_count(touch.procs) < touch.exec->limit);
+}
+
+/**
+ * Helper to start queued commands of all heaps while slots are free
+ **/
+
+static void tjs_command_drain(void) {
+    TjsCommand *command;
+
+    while (tjs_command_slot() &&
+            NULL != (command = (TjsCommand *)tjs_exec_dequeue(touch.exec)))
+    {
+        if (NULL == tjs_command_spawn(command)) {
+            char msg[256];
+
+            snprintf(msg, sizeof(msg), "Failed to exec %s: %s",
+                command->line, strerror(errno));
+
+            tjs_command_settle(command->ctx, command, msg);
+        }
+    }
+}
+
+/**
+ * Helper to block until command or the command it shares is done
+ *
+ * @param[inout]  ctx      A #duk_context
+ * @param[inout]  command  A #TjsCommand
+ **/
+
+static void tjs_command_wait(duk_context *ctx, TjsCommand *command) {
+    TjsCommand *owner = (NULL != command->owner ? command->owner : command);
+
+    /* Queued commands skip the line */
+    if (0 < (owner->flags & TJS_FLAG_STATE_PENDING) && NULL == owner->proc &&
+            tjs_exec_remove(touch.exec, owner))
+    {
+        if (NULL == tjs_command_spawn(owner)) {
+            char msg[256];
+
+            snprintf(msg, sizeof(msg), "Failed to exec %s: %s",
+                owner->line, strerror(errno));
+
+            tjs_command_settle(ctx, owner, msg);
+
+            return;
+        }
+    }
+
+    if (NULL != owner->proc) {
+        tjs_procs_finish(touch.procs, owner->proc);
+    }
+}
+
+/**
+ * Proc handler: output chunk; streamed to onData and collected when
+ * there is no onData or the output is cached
+ *
+ * @param[inout]  proc  A #TjsProc
+ * @param[in]     buf   Output chunk
+ * @param[in]     len   Length of chunk
+ * @param[inout]  arg   Unused
+ **/
+
+static void tjs_command_data(TjsProc *proc, const char *buf, size_t len,
+    void *arg)
+{
+    TjsCommand *command = (TjsCommand *)proc->userdata;
+    duk_context *ctx;
+
+    (void)arg;
+
+    if (NULL == command) return;
+
+    ctx = command->ctx;
+
+    if (tjs_command_push(ctx, command->id)) {
+        duk_push_lstring(ctx, buf, len);
+
+        if (tjs_command_call(ctx, TJS_SYM_DATA_CB, 1) &&
+                NULL == command->entry)
+        {
+            return;
+        }
+    }
+
+    tjs_command_append(command, buf, len);
+}
+
+/**
+ * Proc handler: child exited
+ *
+ * @param[inout]  proc  A #TjsProc
+ * @param[inout]  arg   Unused
+ **/
+
+static void tjs_command_exit(TjsProc *proc, void *arg) {
+    TjsCommand *command = (TjsCommand *)proc->userdata;
+
+    (void)arg;
+
+    if (NULL != command) {
+        command->proc = NULL;
+        command->status = proc->status;
+
+        TJS_LOG_DEBUG("obj=%p, pid=%d, status=%d", command,
+            proc->pid, proc->status);
+
+        tjs_command_settle(command->ctx, command, NULL);
+    }
+
+    tjs_command_drain();
+}
+
+/**
+ * Userdata hook; releases command data
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+static void tjs_command_hook(TjsUserdata *userdata) {
+    TjsCommand *command = (TjsCommand *)userdata;
+
+    /* Only at heap destruction; running commands are kept reachable */
+    if (NULL != command->proc) {
+        command->proc->userdata = NULL;
+    }
+
+    if (0 < (command->flags & TJS_FLAG_STATE_PENDING) && NULL != touch.exec) {
+        tjs_exec_remove(touch.exec, command);
+    }
+
+    free(command->line);
+    free(command->value.asChar);
+}
+
+/**
+ * Native constructor
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_command_ctor(duk_context *ctx) {
+    /* Sanity check */
+    if (!duk_is_constructor_call(ctx)) {
+        return DUK_RET_TYPE_ERROR;
+    }
+
+    /* Create new userdata */
+    TjsCommand *command = (TjsCommand *)tjs_userdata_new(ctx,
+        TJS_FLAG_TYPE_COMMAND, sizeof(TjsCommand));
+
+    if (NULL == command) {
+        return DUK_RET_TYPE_ERROR;
+    }
+
+    /* Get arguments */
+    command->line = strdup((char *)duk_require_string(ctx, -1));
+    command->status = -1;
+    duk_pop(ctx);
+
+    tjs_userdata_init(ctx, (TjsUserdata *)command);
+
+    TJS_LOG_OBJ(command);
+
+    return 0;
+}
+
+/**
+ * Native exec prototype method; takes optional callbacks and options
+ * { onData: fn(chunk), onExit: fn(status), onError: fn(message),
+ *   direct: bool, ttl: ms }
+ *
+ * With direct the line is split into words and run without the login
+ * shell. With ttl the output is cached by line for ttl ms and callers
+ * of the same line share one running child; cached results are passed
+ * to the callbacks before exec returns.
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_command_prototype_exec(duk_context *ctx) {
+    static const struct {
+        const char *name, *sym;
+    } cbs[] = {
+        { "onData", TJS_SYM_DATA_CB },
+        { "onExit", TJS_SYM_EXIT_CB },
+        { "onError", TJS_SYM_ERROR_CB }
+    };
+
+    /* Get userdata */
+    TjsCommand *command = (TjsCommand *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_COMMAND);
+
+    if (NULL != command) {
+        TJS_LOG_OBJ(command);
+
+        if (NULL != command->proc ||
+                0 < (command->flags & TJS_FLAG_STATE_PENDING))
+        {
+            return duk_error(ctx, DUK_ERR_ERROR, "Command is running");
+        }
+
+        duk_set_top(ctx, 1);
+        duk_push_this(ctx);
+
+        /* Store callbacks; plain exec() collects output */
+        for (int i = 0; i < (int)(sizeof(cbs) / sizeof(cbs[0])); i++) {
+            if (duk_is_object(ctx, 0)) {
+                duk_get_prop_string(ctx, 0, cbs[i].name);
+            } else {
+                duk_push_undefined(ctx);
+            }
+
+            duk_put_prop_string(ctx, -2, cbs[i].sym);
+        }
+
+        /* Get options */
+        double ttl = -1;
+
+        command->options = 0;
+
+        if (duk_is_object(ctx, 0)) {
+            if (duk_get_prop_string(ctx, 0, "direct") && duk_to_boolean(ctx, -1)) {
+                command->options |= TJS_EXEC_FLAG_DIRECT;
+            }
+
+            if (duk_get_prop_string(ctx, 0, "ttl") && duk_is_number(ctx, -1)) {
+                ttl = duk_get_number(ctx, -1);
+            }
+
+            duk_pop_2(ctx);
+        }
+
+        tjs_command_reset(command);
+        duk_del_prop_string(ctx, 1, TJS_SYM_OUTPUT);
+
+        command->id = ++tjs_command_lastid;
+        command->entry = NULL;
+        command->owner = NULL;
+        command->ctx = ctx;
+
+        if (0 <= ttl) {
+            TjsExecEntry *entry = tjs_exec_lookup(touch.exec, command->line,
+                command->options, ttl, tjs_timers_now(touch.timers));
+
+            /* Cache hit */
+            if (NULL != entry && 0 < entry->stamp) {
+                duk_push_lstring(ctx, entry->output, entry->len);
+                duk_dup(ctx, 1);
+                tjs_command_deliver(ctx, 2, entry->status);
+                duk_pop(ctx);
+
+                return 1;
+            }
+
+            /* Share running child */
+            if (NULL != entry && tjs_command_push(ctx, entry->owner)) {
+                command->owner = (TjsCommand *)tjs_userdata_from(ctx,
+                    TJS_FLAG_TYPE_COMMAND);
+                command->flags |= TJS_FLAG_STATE_PENDING;
+                duk_pop(ctx);
+
+                duk_push_heap_stash(ctx);
+                duk_get_prop_string(ctx, -1, TJS_SYM_WAITERS);
+
+                if (!duk_get_prop_index(ctx, -1, (duk_uarridx_t)entry->owner)) {
+                    duk_pop(ctx);
+                    duk_push_array(ctx);
+                    duk_dup(ctx, -1);
+                    duk_put_prop_index(ctx, -3, (duk_uarridx_t)entry->owner);
+                }
+
+                duk_dup(ctx, 1);
+                duk_put_prop_index(ctx, -2,
+                    (duk_uarridx_t)duk_get_length(ctx, -2));
+                duk_pop_3(ctx);
+
+                return 1;
+            }
+
+            if (NULL == entry) {
+                command->entry = tjs_exec_begin(touch.exec, command->line,
+                    command->options, command->id);
+            }
+        }
+
+        /* Keep object reachable while running or queued */
+        duk_push_heap_stash(ctx);
+        duk_get_prop_string(ctx, -1, TJS_SYM_COMMANDS);
+        duk_dup(ctx, 1);
+        duk_put_prop_index(ctx, -2, (duk_uarridx_t)command->id);
+        duk_pop_2(ctx);
+
+        /* Wait for free slot */
+        if (!tjs_command_slot() || 0 < touch.exec->nqueued) {
+            command->flags |= TJS_FLAG_STATE_PENDING;
+
+            tjs_exec_enqueue(touch.exec, command);
+
+            return 1;
+        }
+
+        if (NULL == tjs_command_spawn(command)) {
+            int err = errno;
+
+            if (NULL != command->entry) {
+                tjs_exec_abort(touch.exec, command->entry);
+
+                command->entry = NULL;
+            }
+
+            duk_push_heap_stash(ctx);
+            duk_get_prop_string(ctx, -1, TJS_SYM_COMMANDS);
+            duk_del_prop_index(ctx, -1, (duk_uarridx_t)command->id);
+            duk_pop_2(ctx);
+
+            duk_dup(ctx, 1);
+            duk_push_sprintf(ctx, "Failed to exec %s: %s", command->line,
+                strerror(err));
+
+            if (!tjs_command_call(ctx, TJS_SYM_ERROR_CB, 1)) {
+                return duk_error(ctx, DUK_ERR_ERROR, "Failed to exec %s: %s",
+                    command->line, strerror(err));
+            }
+        }
+
+        return 1;
+    }
+
+    /* Allow fluid.. */
+    duk_push_this(ctx);
+
+    return 1;
+}
+
+/**
+ * Native getOutput prototype method; blocks until the command exited
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_command_prototype_getoutput(duk_context *ctx) {
+    /* Get userdata */
+    TjsCommand *command = (TjsCommand *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_COMMAND);
+
+    if (NULL != command) {
+        TJS_LOG_OBJ(command);
+
+        if (NULL != command->proc ||
+                0 < (command->flags & TJS_FLAG_STATE_PENDING))
+        {
+            tjs_command_wait(ctx, command);
+        }
+
+        /* Stored output of finished command */
+        duk_push_this(ctx);
+
+        if (duk_get_prop_string(ctx, -1, TJS_SYM_OUTPUT)) return 1;
+
+        duk_pop_2(ctx);
+
+        duk_push_lstring(ctx, (NULL != command->value.asChar ?
+            command->value.asChar : ""), command->len);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native getStatus prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_command_prototype_getstatus(duk_context *ctx) {
+    /* Get userdata */
+    TjsCommand *command = (TjsCommand *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_COMMAND);
+
+    if (NULL != command) {
+        duk_push_int(ctx, command->status);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native isRunning prototype method; true while queued or sharing a
+ * running child as well
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_command_prototype_isrunning(duk_context *ctx) {
+    /* Get userdata */
+    TjsCommand *command = (TjsCommand *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_COMMAND);
+
+    duk_push_boolean(ctx, (NULL != command && (NULL != command->proc ||
+        0 < (command->flags & TJS_FLAG_STATE_PENDING))));
+
+    return 1;
+}
+
+/**
+ * Native toString prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_command_prototype_tostring(duk_context *ctx) {
+    /* Get userdata */
+    TjsCommand *command = (TjsCommand *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_COMMAND);
+
+    if (NULL != command) {
+        TJS_LOG_OBJ(command);
+
+        duk_push_sprintf(ctx, "flags=%d, line=%s, status=%d, len=%zu",
+            command->flags, command->line, command->status, command->len);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native commandstats method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_command_stats(duk_context *ctx) {
+    duk_idx_t idx = duk_push_object(ctx);
+
+    duk_push_int(ctx, tjs_procs_count(touch.procs));
+    duk_put_prop_string(ctx, idx, "running");
+    duk_push_int(ctx, touch.exec->nqueued);
+    duk_put_prop_string(ctx, idx, "queued");
+    duk_push_int(ctx, touch.exec->limit);
+    duk_put_prop_string(ctx, idx, "limit");
+    duk_push_number(ctx, touch.procs->stats.spawned);
+    duk_put_prop_string(ctx, idx, "spawned");
+    duk_push_number(ctx, touch.procs->stats.failed);
+    duk_put_prop_string(ctx, idx, "failed");
+    duk_push_number(ctx, touch.exec->stats.hits);
+    duk_put_prop_string(ctx, idx, "hits");
+    duk_push_number(ctx, touch.exec->stats.misses);
+    duk_put_prop_string(ctx, idx, "misses");
+    duk_push_number(ctx, touch.exec->stats.shared);
+    duk_put_prop_string(ctx, idx, "shared");
+    duk_push_number(ctx, touch.exec->stats.expired);
+    duk_put_prop_string(ctx, idx, "expired");
+    duk_push_number(ctx, touch.exec->stats.queued);
+    duk_put_prop_string(ctx, idx, "waited");
+
+    return 1;
+}
+
+/**
+ * Poll output of running commands
+ *
+ * @param[in]  timeout  Timeout in ms; -1 blocks, 0 returns immediately
+ *
+ * @return Number of commands with activity
+ **/
+
+int tjs_command_poll(int timeout) {
+    int nready = tjs_procs_poll(touch.procs, timeout);
+
+    /* Apply changes made by the callbacks */
+    if (0 < nready && 0 == touch.tick) {
+        tjs_touchbar_flush();
+    }
+
+    return nready;
+}
+
+/**
+ * Init methods for #TjsCommand
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+void tjs_command_init(duk_context *ctx) {
+    /* Register constructor */
+    duk_push_c_function(ctx, tjs_command_ctor, 1);
+    duk_push_object(ctx);
+
+    /* Register methods */
+    duk_push_c_function(ctx, tjs_command_prototype_exec, 1);
+    duk_put_prop_string(ctx, -2, "exec");
+
+    duk_push_c_function(ctx, tjs_command_prototype_getoutput, 0);
+    duk_put_prop_string(ctx, -2, "getOutput");
+    duk_push_c_function(ctx, tjs_command_prototype_getstatus, 0);
+    duk_put_prop_string(ctx, -2, "getStatus");
+    duk_push_c_function(ctx, tjs_command_prototype_isrunning, 0);
+    duk_put_prop_string(ctx, -2, "isRunning");
+
+    duk_push_c_function(ctx, tjs_command_prototype_tostring, 0);
+    duk_put_prop_string(ctx, -2, "toString");
+
+    duk_put_prop_string(ctx, -2, "prototype");
+    duk_put_global_string(ctx, "TjsCommand");
+
+    duk_push_c_function(ctx, tjs_command_stats, 0);
+    duk_put_global_string(ctx, "tjs_commandstats");
+
+    /* Running and queued commands; commands sharing their children */
+    duk_push_heap_stash(ctx);
+    duk_push_object(ctx);
+    duk_put_prop_string(ctx, -2, TJS_SYM_COMMANDS);
+    duk_push_object(ctx);
+    duk_put_prop_string(ctx, -2, TJS_SYM_WAITERS);
+    duk_pop(ctx);
+
+    touch.procs->data = tjs_command_data;
+    touch.procs->exit = tjs_command_exit;
+
+    tjs_userdata_hook(TJS_FLAG_TYPE_COMMAND, tjs_command_hook);
+}
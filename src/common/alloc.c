@@ -0,0 +1,673 @@
+/**
+ * @package TouchJS
+ *
+ * @file Allocator functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif /* __APPLE__ */
+
+#include "alloc.h"
+#include "clock.h"
+
+/* Defines */
+#define TJS_ALLOC_LARGE UINT16_MAX
+#define TJS_ALLOC_CLASS(ALLOC, SIZE) \
+    (TJS_ALLOC_MAXSMALL >= (SIZE) ? (ALLOC)->lookup[((SIZE) + 7) / 8] : -1)
+
+/* Types */
+typedef union tjs_alloc_header_t {
+    struct {
+        uint16_t cls;  ///< Class index or #TJS_ALLOC_LARGE
+        uint16_t heap; ///< Id of the owning #TjsAllocHeap; 0 is none
+        uint32_t size; ///< Requested size
+    } info;
+
+    uint64_t align; ///< Keeps payload 8-byte aligned like duktape expects
+} TjsAllocHeader;
+
+/* Payload sizes of the small classes; duktape mostly allocates
+ * hobjects, strings and property tables below 256 bytes */
+static const size_t smallsizes[] = {
+    16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512
+};
+
+/**
+ * Helper to convert payload to header
+ *
+ * @param[in]  ptr  Payload pointer
+ *
+ * @return A #TjsAllocHeader
+ **/
+
+static inline TjsAllocHeader *tjs_alloc_header(void *ptr) {
+    return ((TjsAllocHeader *)ptr) - 1;
+}
+
+/**
+ * Helper to get owning heap of chunk
+ *
+ * @param[inout]  alloc   A #TjsAlloc
+ * @param[in]     header  A #TjsAllocHeader
+ *
+ * @return Either #TjsAllocHeap; otherwise NULL
+ **/
+
+static inline TjsAllocHeap *tjs_alloc_owner(TjsAlloc *alloc,
+    TjsAllocHeader *header)
+{
+    return (0 < header->info.heap ?
+        &(alloc->heaps[header->info.heap - 1]) : NULL);
+}
+
+/**
+ * Helper to add a size class
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[in]     size   Payload size
+ *
+ * @return Either index of the class; otherwise -1
+ **/
+
+static int tjs_alloc_add_class(TjsAlloc *alloc, size_t size) {
+    if (TJS_ALLOC_MAXCLASSES <= alloc->nclasses) return -1;
+
+    TjsAllocClass *class = &(alloc->classes[alloc->nclasses]);
+
+    memset(class, 0, sizeof(TjsAllocClass));
+
+    class->size = (size + 7) & ~((size_t)7);
+
+    return alloc->nclasses++;
+}
+
+/**
+ * Helper to get a chunk of given class
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[in]     cls    Class index
+ *
+ * @return Either header of the chunk; otherwise NULL
+ **/
+
+static TjsAllocHeader *tjs_alloc_chunk(TjsAlloc *alloc, int cls) {
+    TjsAllocClass *class = &(alloc->classes[cls]);
+    TjsAllocHeader *header = NULL;
+    size_t chunksize = sizeof(TjsAllocHeader) + class->size;
+
+    if (NULL != class->freelist) {
+        /* Pop free list; link is stored in the payload */
+        header = (TjsAllocHeader *)class->freelist;
+        class->freelist = *((void **)(header + 1));
+    } else {
+        /* Carve from slab and get a new one when exhausted */
+        if (NULL == class->cursor || class->cursor + chunksize > class->end) {
+            if (alloc->nslabs == alloc->maxslabs) {
+                int maxslabs = (0 == alloc->maxslabs ? 16 : alloc->maxslabs * 2);
+                void **slabs = (void **)realloc(alloc->slabs,
+                    maxslabs * sizeof(void *));
+
+                if (NULL == slabs) return NULL;
+
+                alloc->slabs = slabs;
+                alloc->maxslabs = maxslabs;
+            }
+
+            /* Start small; most classes hold a handful of objects */
+            size_t slabsize = (0 == class->slabsize ? TJS_ALLOC_MINSLAB :
+                (TJS_ALLOC_MAXSLAB > class->slabsize ?
+                    class->slabsize * 2 : TJS_ALLOC_MAXSLAB));
+
+            char *slab = (char *)malloc(slabsize);
+
+            if (NULL == slab) return NULL;
+
+            alloc->slabs[alloc->nslabs++] = slab;
+            alloc->stats.slabbytes += slabsize;
+
+            class->slabsize = slabsize;
+            class->cursor = slab;
+            class->end = slab + slabsize;
+        }
+
+        header = (TjsAllocHeader *)class->cursor;
+        class->cursor += chunksize;
+    }
+
+    header->info.cls = cls;
+
+    class->live++;
+    class->allocs++;
+
+    return header;
+}
+
+/**
+ * Helper to update live bytes of allocator and heap
+ *
+ * @param[inout]  alloc    A #TjsAlloc
+ * @param[inout]  heap     A #TjsAllocHeap; might be NULL
+ * @param[in]     oldsize  Previous size
+ * @param[in]     size     New size
+ **/
+
+static void tjs_alloc_live(TjsAlloc *alloc, TjsAllocHeap *heap,
+    size_t oldsize, size_t size)
+{
+    alloc->stats.live = alloc->stats.live - oldsize + size;
+
+    if (alloc->stats.live > alloc->stats.peak) {
+        alloc->stats.peak = alloc->stats.live;
+    }
+
+    if (NULL != heap) {
+        heap->live = heap->live - oldsize + size;
+
+        if (heap->live > heap->peak) heap->peak = heap->live;
+    }
+}
+
+/**
+ * Helper to update stats after allocation
+ *
+ * @param[inout]  alloc   A #TjsAlloc
+ * @param[inout]  heap    Owning #TjsAllocHeap; might be NULL
+ * @param[inout]  header  A #TjsAllocHeader
+ * @param[in]     size    Requested size
+ *
+ * @return Payload pointer
+ **/
+
+static void *tjs_alloc_account(TjsAlloc *alloc, TjsAllocHeap *heap,
+    TjsAllocHeader *header, size_t size)
+{
+    header->info.heap = (NULL != heap ? heap->id : 0);
+    header->info.size = (uint32_t)size;
+
+    alloc->stats.allocs++;
+
+    tjs_alloc_live(alloc, heap, 0, size);
+
+    return (void *)(header + 1);
+}
+
+/**
+ * Helper to check limit of heap
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[inout]  heap   A #TjsAllocHeap; NULL is unlimited
+ * @param[in]     grow   Number of additional live bytes
+ *
+ * @return Either 1 when allowed; otherwise 0
+ **/
+
+static inline int tjs_alloc_allowed(TjsAlloc *alloc, TjsAllocHeap *heap,
+    size_t grow)
+{
+    if (NULL == heap || 0 == heap->limit ||
+            heap->live + grow <= heap->limit)
+    {
+        return 1;
+    }
+
+    /* Duktape runs an emergency gc and retries on failure */
+    heap->denied++;
+    alloc->stats.denied++;
+
+    return 0;
+}
+
+/**
+ * Helper to allocate from given class or malloc
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[inout]  heap   Owning #TjsAllocHeap; might be NULL
+ * @param[in]     cls    Class index; -1 for malloc
+ * @param[in]     size   Requested size
+ *
+ * @return Either payload pointer; otherwise NULL
+ **/
+
+static void *tjs_alloc_from(TjsAlloc *alloc, TjsAllocHeap *heap, int cls,
+    size_t size)
+{
+    TjsAllocHeader *header = NULL;
+
+    if (-1 != cls && TJS_ALLOC_MODE_POOL == alloc->mode) {
+        header = tjs_alloc_chunk(alloc, cls);
+    } else {
+        if (UINT32_MAX <= size) return NULL;
+
+        header = (TjsAllocHeader *)malloc(sizeof(TjsAllocHeader) + size);
+
+        if (NULL == header) return NULL;
+
+        header->info.cls = TJS_ALLOC_LARGE;
+
+        alloc->stats.large++;
+    }
+
+    if (NULL == header) return NULL;
+
+    return tjs_alloc_account(alloc, heap, header, size);
+}
+
+/**
+ * Helper to allocate memory for heap
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[inout]  heap   Owning #TjsAllocHeap; might be NULL
+ * @param[in]     size   Size to allocate
+ *
+ * @return Either new memory; otherwise NULL
+ **/
+
+static void *tjs_alloc_malloc_in(TjsAlloc *alloc, TjsAllocHeap *heap,
+    size_t size)
+{
+    if (0 == size || !tjs_alloc_allowed(alloc, heap, size)) return NULL;
+
+    return tjs_alloc_from(alloc, heap, TJS_ALLOC_CLASS(alloc, size), size);
+}
+
+/**
+ * Helper to resize memory; existing chunks stay with their heap
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[inout]  heap   Owning #TjsAllocHeap of new memory; might be NULL
+ * @param[inout]  ptr    Memory to resize; might be NULL
+ * @param[in]     size   New size; 0 frees
+ *
+ * @return Either resized memory; otherwise NULL
+ **/
+
+static void *tjs_alloc_realloc_in(TjsAlloc *alloc, TjsAllocHeap *heap,
+    void *ptr, size_t size)
+{
+    if (NULL == ptr) return tjs_alloc_malloc_in(alloc, heap, size);
+
+    if (0 == size) {
+        tjs_alloc_free(alloc, ptr);
+
+        return NULL;
+    }
+
+    TjsAllocHeader *header = tjs_alloc_header(ptr);
+    size_t oldsize = header->info.size;
+
+    heap = tjs_alloc_owner(alloc, header);
+
+    alloc->stats.reallocs++;
+
+    if (size > oldsize && !tjs_alloc_allowed(alloc, heap, size - oldsize)) {
+        return NULL;
+    }
+
+    /* Stay in chunk when it still fits */
+    if (TJS_ALLOC_LARGE != header->info.cls &&
+            alloc->classes[header->info.cls].size >= size)
+    {
+        header->info.size = (uint32_t)size;
+
+        tjs_alloc_live(alloc, heap, oldsize, size);
+
+        return ptr;
+    }
+
+    /* Limit is already checked; the old chunk is freed right after */
+    void *newptr = tjs_alloc_from(alloc, heap, TJS_ALLOC_CLASS(alloc, size),
+        size);
+
+    if (NULL != newptr) {
+        memcpy(newptr, ptr, (oldsize < size ? oldsize : size));
+
+        tjs_alloc_free(alloc, ptr);
+    }
+
+    return newptr;
+}
+
+/**
+ * Helper to allocate zeroed memory from a slab of exactly this size
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[inout]  heap   Owning #TjsAllocHeap; might be NULL
+ * @param[in]     size   Size of the struct
+ *
+ * @return Either new memory; otherwise NULL
+ **/
+
+static void *tjs_alloc_typed_in(TjsAlloc *alloc, TjsAllocHeap *heap,
+    size_t size)
+{
+    size_t rounded = (size + 7) & ~((size_t)7);
+    int cls = -1;
+
+    /* Find or add class */
+    for (int i = alloc->nsmall; i < alloc->nclasses; i++) {
+        if (alloc->classes[i].size == rounded) {
+            cls = i;
+
+            break;
+        }
+    }
+
+    if (-1 == cls) cls = tjs_alloc_add_class(alloc, rounded);
+
+    if (!tjs_alloc_allowed(alloc, heap, size)) return NULL;
+
+    /* Fall back to small classes when out of classes */
+    void *ptr = tjs_alloc_from(alloc, heap,
+        (-1 != cls ? cls : TJS_ALLOC_CLASS(alloc, size)), size);
+
+    if (NULL != ptr) memset(ptr, 0, size);
+
+    return ptr;
+}
+
+/**
+ * Create new allocator
+ *
+ * @param[in]  mode  Allocator mode
+ *
+ * @return A new #TjsAlloc
+ **/
+
+TjsAlloc *tjs_alloc_new(int mode) {
+    TjsAlloc *alloc = (TjsAlloc *)calloc(1, sizeof(TjsAlloc));
+
+    alloc->mode = mode;
+    alloc->stats.start = tjs_clock_now();
+
+    /* Create small classes and size lookup in 8 byte steps */
+    int nsmall = sizeof(smallsizes) / sizeof(smallsizes[0]);
+
+    for (int i = 0, cls = 0; i <= TJS_ALLOC_MAXSMALL / 8; i++) {
+        if (i * 8 > smallsizes[cls]) cls++;
+
+        alloc->lookup[i] = cls;
+    }
+
+    for (int i = 0; i < nsmall; i++) {
+        tjs_alloc_add_class(alloc, smallsizes[i]);
+    }
+
+    alloc->nsmall = nsmall;
+
+    return alloc;
+}
+
+/**
+ * Parse size string with optional K, M or G suffix
+ *
+ * @param[in]  str  Size string
+ *
+ * @return Size in bytes
+ **/
+
+size_t tjs_alloc_parse_size(const char *str) {
+    char *end = NULL;
+    size_t size = (size_t)strtoull(str, &end, 10);
+
+    switch (NULL != end ? *end : '\0') {
+        case 'g': case 'G': size *= 1024;  /* Falls through */
+        case 'm': case 'M': size *= 1024;  /* Falls through */
+        case 'k': case 'K': size *= 1024;  break;
+    }
+
+    return size;
+}
+
+/**
+ * Allocate memory
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[in]     size   Size to allocate
+ *
+ * @return Either new memory; otherwise NULL
+ **/
+
+void *tjs_alloc_malloc(TjsAlloc *alloc, size_t size) {
+    return tjs_alloc_malloc_in(alloc, NULL, size);
+}
+
+/**
+ * Allocate zeroed memory
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[in]     size   Size to allocate
+ *
+ * @return Either new memory; otherwise NULL
+ **/
+
+void *tjs_alloc_calloc(TjsAlloc *alloc, size_t size) {
+    void *ptr = tjs_alloc_malloc(alloc, size);
+
+    if (NULL != ptr) memset(ptr, 0, size);
+
+    return ptr;
+}
+
+/**
+ * Resize memory
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[inout]  ptr    Memory to resize; might be NULL
+ * @param[in]     size   New size; 0 frees
+ *
+ * @return Either resized memory; otherwise NULL
+ **/
+
+void *tjs_alloc_realloc(TjsAlloc *alloc, void *ptr, size_t size) {
+    return tjs_alloc_realloc_in(alloc, NULL, ptr, size);
+}
+
+/**
+ * Free memory
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[inout]  ptr    Memory to free; might be NULL
+ **/
+
+void tjs_alloc_free(TjsAlloc *alloc, void *ptr) {
+    if (NULL == ptr) return;
+
+    TjsAllocHeader *header = tjs_alloc_header(ptr);
+
+    alloc->stats.frees++;
+
+    tjs_alloc_live(alloc, tjs_alloc_owner(alloc, header),
+        header->info.size, 0);
+
+    if (TJS_ALLOC_LARGE == header->info.cls) {
+        free(header);
+    } else {
+        TjsAllocClass *class = &(alloc->classes[header->info.cls]);
+
+        /* Push to free list */
+        *((void **)ptr) = class->freelist;
+        class->freelist = header;
+        class->live--;
+    }
+}
+
+/**
+ * Allocate zeroed memory from a slab of exactly this size
+ *
+ * Native structs like #TjsWidget get their own class, so they pack
+ * densely instead of rounding up to the next small class
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ * @param[in]     size   Size of the struct
+ *
+ * @return Either new memory; otherwise NULL
+ **/
+
+void *tjs_alloc_typed(TjsAlloc *alloc, size_t size) {
+    return tjs_alloc_typed_in(alloc, NULL, size);
+}
+
+/**
+ * Create new heap accounting; the limit of the allocator applies to
+ * each heap separately, so one heap can't use up the budget of another
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ *
+ * @return Either new #TjsAllocHeap; otherwise NULL
+ **/
+
+TjsAllocHeap *tjs_alloc_heap_new(TjsAlloc *alloc) {
+    if (TJS_ALLOC_MAXHEAPS <= alloc->nheaps) return NULL;
+
+    TjsAllocHeap *heap = &(alloc->heaps[alloc->nheaps++]);
+
+    memset(heap, 0, sizeof(TjsAllocHeap));
+
+    heap->alloc = alloc;
+    heap->id = alloc->nheaps;
+    heap->limit = alloc->limit;
+
+    return heap;
+}
+
+/**
+ * Allocate zeroed memory like #tjs_alloc_typed and charge it to heap
+ *
+ * @param[inout]  heap  A #TjsAllocHeap
+ * @param[in]     size  Size of the struct
+ *
+ * @return Either new memory; otherwise NULL
+ **/
+
+void *tjs_alloc_heap_typed(TjsAllocHeap *heap, size_t size) {
+    return tjs_alloc_typed_in(heap->alloc, heap, size);
+}
+
+/**
+ * Get requested size of allocation
+ *
+ * @param[in]  ptr  Memory to check
+ *
+ * @return Size of the allocation
+ **/
+
+size_t tjs_alloc_size(void *ptr) {
+    return (NULL != ptr ? tjs_alloc_header(ptr)->info.size : 0);
+}
+
+/**
+ * Get allocation rate since creation
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ *
+ * @return Allocations per second
+ **/
+
+double tjs_alloc_rate(TjsAlloc *alloc) {
+    double elapsed = tjs_clock_now() - alloc->stats.start;
+
+    return (0 < elapsed ? alloc->stats.allocs * 1000.0 / elapsed : 0);
+}
+
+/**
+ * Get resident set size of the process
+ *
+ * @return Size in bytes; 0 when unknown
+ **/
+
+size_t tjs_alloc_rss(void) {
+#ifdef __APPLE__
+    struct mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if (KERN_SUCCESS != task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+            (task_info_t)&info, &count))
+    {
+        return 0;
+    }
+
+    return (size_t)info.resident_size;
+#else
+    unsigned long pages = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (NULL == fp) return 0;
+
+    if (1 != fscanf(fp, "%*s %lu", &pages)) pages = 0;
+
+    fclose(fp);
+
+    return (size_t)pages * (size_t)sysconf(_SC_PAGESIZE);
+#endif /* __APPLE__ */
+}
+
+/**
+ * Destroy allocator and all slabs
+ *
+ * @param[inout]  alloc  A #TjsAlloc
+ **/
+
+void tjs_alloc_destroy(TjsAlloc *alloc) {
+    if (NULL != alloc) {
+        for (int i = 0; i < alloc->nslabs; i++) {
+            free(alloc->slabs[i]);
+        }
+
+        free(alloc->slabs);
+        free(alloc);
+    }
+}
+
+/**
+ * Duktape alloc hook
+ *
+ * @param[inout]  udata  A #TjsAllocHeap
+ * @param[in]     size   Size to allocate
+ *
+ * @return Either new memory; otherwise NULL
+ **/
+
+void *tjs_alloc_duk_alloc(void *udata, size_t size) {
+    TjsAllocHeap *heap = (TjsAllocHeap *)udata;
+
+    return tjs_alloc_malloc_in(heap->alloc, heap, size);
+}
+
+/**
+ * Duktape realloc hook
+ *
+ * @param[inout]  udata  A #TjsAllocHeap
+ * @param[inout]  ptr    Memory to resize
+ * @param[in]     size   New size
+ *
+ * @return Either resized memory; otherwise NULL
+ **/
+
+void *tjs_alloc_duk_realloc(void *udata, void *ptr, size_t size) {
+    TjsAllocHeap *heap = (TjsAllocHeap *)udata;
+
+    return tjs_alloc_realloc_in(heap->alloc, heap, ptr, size);
+}
+
+/**
+ * Duktape free hook
+ *
+ * @param[inout]  udata  A #TjsAllocHeap
+ * @param[inout]  ptr    Memory to free
+ **/
+
+void tjs_alloc_duk_free(void *udata, void *ptr) {
+    tjs_alloc_free(((TjsAllocHeap *)udata)->alloc, ptr);
+}
@@ -0,0 +1,95 @@
+/**
+ * @package TouchJS
+ *
+ * @file Allocator header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_ALLOC_H
+#define TJS_ALLOC_H 1
+
+/* Includes */
+#include <stddef.h>
+
+/* Modes */
+#define TJS_ALLOC_MODE_POOL 0
+#define TJS_ALLOC_MODE_MALLOC 1 ///< Plain malloc with same accounting
+
+/* Defines */
+#define TJS_ALLOC_MAXSMALL 512 ///< Bigger requests go to malloc
+#define TJS_ALLOC_MAXCLASSES 32
+#define TJS_ALLOC_MAXHEAPS 16 ///< Heaps with their own accounting
+#define TJS_ALLOC_MINSLAB (4 * 1024)
+#define TJS_ALLOC_MAXSLAB (64 * 1024) ///< Slabs double per class up to this
+
+/* Types */
+typedef struct tjs_alloc_class_t {
+    size_t size; ///< Payload size
+
+    void *freelist;
+    char *cursor, *end; ///< Uncarved rest of current slab
+    size_t slabsize;
+
+    unsigned long live, allocs;
+} TjsAllocClass;
+
+typedef struct tjs_alloc_heap_t {
+    struct tjs_alloc_t *alloc;
+    int id; ///< Owner tag in the chunk header; 0 is no heap
+
+    size_t limit; ///< Cap of live bytes of this heap; 0 is unlimited
+    size_t live, peak;
+    unsigned long denied; ///< Requests over the limit
+} TjsAllocHeap;
+
+typedef struct tjs_alloc_t {
+    int mode;
+    size_t limit; ///< Default cap of each new heap; 0 is unlimited
+
+    /* Size classes; typed classes follow the small ones */
+    int nclasses, nsmall;
+    struct tjs_alloc_class_t classes[TJS_ALLOC_MAXCLASSES];
+    unsigned char lookup[TJS_ALLOC_MAXSMALL / 8 + 1];
+
+    /* Slabs */
+    int nslabs, maxslabs;
+    void **slabs;
+
+    /* Heaps; each is charged for its own chunks */
+    int nheaps;
+    struct tjs_alloc_heap_t heaps[TJS_ALLOC_MAXHEAPS];
+
+    /* Stats */
+    struct {
+        size_t live, peak, slabbytes;
+        unsigned long allocs, frees, reallocs, large;
+        unsigned long denied; ///< Requests over the limit of any heap
+        double start;
+    } stats;
+} TjsAlloc;
+
+/* Methods */
+TjsAlloc *tjs_alloc_new(int mode);
+size_t tjs_alloc_parse_size(const char *str);
+void *tjs_alloc_malloc(TjsAlloc *alloc, size_t size);
+void *tjs_alloc_calloc(TjsAlloc *alloc, size_t size);
+void *tjs_alloc_realloc(TjsAlloc *alloc, void *ptr, size_t size);
+void tjs_alloc_free(TjsAlloc *alloc, void *ptr);
+void *tjs_alloc_typed(TjsAlloc *alloc, size_t size);
+TjsAllocHeap *tjs_alloc_heap_new(TjsAlloc *alloc);
+void *tjs_alloc_heap_typed(TjsAllocHeap *heap, size_t size);
+size_t tjs_alloc_size(void *ptr);
+double tjs_alloc_rate(TjsAlloc *alloc);
+size_t tjs_alloc_rss(void);
+void tjs_alloc_destroy(TjsAlloc *alloc);
+
+/* Duktape hooks; udata is the #TjsAllocHeap */
+void *tjs_alloc_duk_alloc(void *udata, size_t size);
+void *tjs_alloc_duk_realloc(void *udata, void *ptr, size_t size);
+void tjs_alloc_duk_free(void *udata, void *ptr);
+
+#endif /* TJS_ALLOC_H */
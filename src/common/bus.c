@@ -0,0 +1,842 @@
+/**
+ * @package TouchJS
+ *
+ * @file Event bus functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "../touchjs.h"
+
+#include "bus.h"
+#include "callback.h"
+#include "timer.h"
+#include "clock.h"
+#include "syms.h"
+
+/* Defines */
+#define TJS_BUS_MIN_SUBS 16
+#define TJS_BUS_MIN_TOKENS 8
+#define TJS_BUS_REGEX 256 ///< Max length of translated title regex
+
+#define TJS_BUS_TOKEN(IDX, GEN) (((unsigned int)(GEN) << 16) | (unsigned int)(IDX))
+#define TJS_BUS_TOKEN_IDX(TOKEN) ((int)((TOKEN) & 0xffff))
+#define TJS_BUS_TOKEN_GEN(TOKEN) ((unsigned int)(TOKEN) >> 16)
+
+/**
+ * Helper to get live subscription of token
+ *
+ * @param[in]  bus    A #TjsBus
+ * @param[in]  token  Subscription token
+ *
+ * @return Either #TjsBusSub when live; otherwise NULL
+ **/
+
+static TjsBusSub *tjs_bus_sub(TjsBus *bus, unsigned int token) {
+    int idx = TJS_BUS_TOKEN_IDX(token);
+
+    if (idx >= bus->nsubs) return NULL;
+
+    TjsBusSub *sub = &bus->subs[idx];
+
+    return (0 < (sub->flags & TJS_BUS_FLAG_ACTIVE) &&
+        sub->gen == TJS_BUS_TOKEN_GEN(token) ? sub : NULL);
+}
+
+/**
+ * Helper to drop tokens of removed subscriptions
+ *
+ * @param[inout]  bus   A #TjsBus
+ * @param[inout]  list  A #TjsBusList
+ **/
+
+static void tjs_bus_compact(TjsBus *bus, TjsBusList *list) {
+    int n = 0;
+
+    for (int i = 0; i < list->n; i++) {
+        if (NULL != tjs_bus_sub(bus, list->tokens[i])) {
+            list->tokens[n++] = list->tokens[i];
+        }
+    }
+
+    list->n = n;
+    list->dead = 0;
+
+    bus->stats.compactions++;
+}
+
+/**
+ * Helper to release filter of subscription
+ *
+ * @param[inout]  sub  A #TjsBusSub
+ **/
+
+static void tjs_bus_release(TjsBusSub *sub) {
+    if (0 < (sub->filter.flags & TJS_BUS_FILTER_TITLE)) {
+        regfree(&sub->filter.title);
+    }
+
+    sub->filter.flags = 0;
+}
+
+/**
+ * Helper to check attribute filters of subscription; attributes are
+ * fetched once per event and only when a filter needs them
+ *
+ * @param[inout]  bus     A #TjsBus
+ * @param[in]     filter  A #TjsBusFilter
+ * @param[inout]  event   A #TjsBusEvent
+ *
+ * @return Either 1 when they match; otherwise 0
+ **/
+
+static int tjs_bus_match_attrs(TjsBus *bus, const TjsBusFilter *filter,
+    TjsBusEvent *event)
+{
+    if (0 == event->fetched) {
+        memset(&event->attrs, 0, sizeof(TjsBusAttrs));
+
+        event->fetched = (NULL != event->fetch &&
+            0 == event->fetch(event->ref, &event->attrs) ? 1 : -1);
+
+        bus->stats.fetches++;
+    }
+
+    /* Unknown attributes don't match */
+    if (0 > event->fetched) return 0;
+
+    TjsBusAttrs *attrs = &event->attrs;
+
+    return !((0 < (filter->flags & TJS_BUS_FILTER_PID) &&
+            filter->pid != attrs->pid) ||
+        (0 < (filter->flags & TJS_BUS_FILTER_ROLE) &&
+            0 != strcmp(filter->role, attrs->role)) ||
+        (0 < (filter->flags & TJS_BUS_FILTER_SUBROLE) &&
+            0 != strcmp(filter->subrole, attrs->subrole)) ||
+        (0 < (filter->flags & TJS_BUS_FILTER_TITLE) &&
+            0 != regexec(&filter->title, attrs->title, 0, NULL, 0)));
+}
+
+/**
+ * Helper to check whether subscription matches event; cheap checks
+ * run first
+ *
+ * @param[inout]  bus    A #TjsBus
+ * @param[inout]  sub    A #TjsBusSub
+ * @param[inout]  event  A #TjsBusEvent
+ *
+ * @return Either 1 when it matches; otherwise 0
+ **/
+
+static int tjs_bus_match(TjsBus *bus, TjsBusSub *sub, TjsBusEvent *event) {
+    TjsBusFilter *filter = &sub->filter;
+
+    if (0 < (sub->flags & TJS_BUS_FLAG_PREFIX) &&
+            0 != strncmp(bus->names[event->id], sub->pattern, sub->len))
+    {
+        return 0;
+    }
+
+    sub->stats.seen++;
+
+    if ((0 != filter->window && filter->window != event->window) ||
+            (0 < (filter->flags & TJS_BUS_FILTER_ATTRS) &&
+                !tjs_bus_match_attrs(bus, filter, event)))
+    {
+        sub->stats.dropped++;
+        bus->stats.filtered++;
+
+        return 0;
+    }
+
+    /* Rate limit last, so only calls count */
+    if (0 < filter->interval) {
+        double now = (NULL != touch.timers ?
+            tjs_timers_now(touch.timers) : tjs_clock_now());
+
+        if (0 < sub->stats.passed && now - sub->last < filter->interval) {
+            sub->stats.dropped++;
+            bus->stats.filtered++;
+
+            return 0;
+        }
+
+        sub->last = now;
+    }
+
+    sub->stats.passed++;
+
+    return 1;
+}
+
+/**
+ * Helper to call handler of subscription
+ *
+ * @param[inout]  bus    A #TjsBus
+ * @param[in]     sub    A #TjsBusSub
+ * @param[in]     idx    Index of the subscription
+ * @param[in]     event  A #TjsBusEvent
+ * @param[in]     push   Handler to push arguments; may be NULL
+ * @param[inout]  arg    Argument of push
+ **/
+
+static void tjs_bus_deliver(TjsBus *bus, TjsBusSub *sub, int idx,
+    const TjsBusEvent *event, TjsBusPush push, void *arg)
+{
+    duk_context *ctx = sub->ctx;
+
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_BUS);
+    duk_get_prop_index(ctx, -1, (duk_uarridx_t)idx);
+
+    int nargs = (NULL != push ? push(ctx, arg) : 0);
+
+    bus->stats.delivered++;
+
+    if (DUK_EXEC_SUCCESS != tjs_callback_pcall(ctx,
+            bus->names[event->id], nargs, 0))
+    {
+        TJS_LOG_ERROR("Failed to call handler: %s",
+            duk_safe_to_string(ctx, -1));
+    }
+
+    duk_pop_3(ctx);
+}
+
+/**
+ * Create new event bus
+ *
+ * @return Either #TjsBus on success; otherwise NULL
+ **/
+
+TjsBus *tjs_bus_new(void) {
+    TjsBus *bus = (TjsBus *)calloc(1, sizeof(TjsBus));
+
+    if (NULL != bus) {
+        bus->freesub = -1;
+
+        tjs_bus_intern(bus, "*");
+    }
+
+    return bus;
+}
+
+/**
+ * Intern event name
+ *
+ * @param[inout]  bus   A #TjsBus
+ * @param[in]     name  Name of the event
+ *
+ * @return Either id of the event on success; otherwise -1
+ **/
+
+int tjs_bus_intern(TjsBus *bus, const char *name) {
+    int id = tjs_bus_lookup(bus, name);
+
+    if (0 > id && TJS_BUS_EVENTS > bus->nnames &&
+            TJS_BUS_NAME > strlen(name))
+    {
+        id = bus->nnames++;
+
+        snprintf(bus->names[id], TJS_BUS_NAME, "%s", name);
+    }
+
+    return id;
+}
+
+/**
+ * Look up id of interned event name
+ *
+ * @param[in]  bus   A #TjsBus
+ * @param[in]  name  Name of the event
+ *
+ * @return Either id of the event on success; otherwise -1
+ **/
+
+int tjs_bus_lookup(TjsBus *bus, const char *name) {
+    for (int i = 0; i < bus->nnames; i++) {
+        if (0 == strcmp(bus->names[i], name)) return i;
+    }
+
+    return -1;
+}
+
+/**
+ * Get name of interned event
+ *
+ * @param[in]  bus  A #TjsBus
+ * @param[in]  id   Id of the event
+ *
+ * @return Either name on success; otherwise NULL
+ **/
+
+const char *tjs_bus_name(TjsBus *bus, int id) {
+    return (0 <= id && id < bus->nnames ? bus->names[id] : NULL);
+}
+
+/**
+ * Subscribe handler to event
+ *
+ * Patterns are either an interned event name, * for all events or a
+ * prefix like win_* that is matched against the name on dispatch.
+ *
+ * @param[inout]  bus      A #TjsBus
+ * @param[inout]  ctx      A #duk_context of the handler
+ * @param[in]     pattern  Event name or pattern
+ * @param[in]     fn       Stack index of the handler
+ * @param[in]     filter   A #TjsBusFilter; may be NULL
+ *
+ * @return Either token on success; otherwise 0
+ **/
+
+unsigned int tjs_bus_subscribe(TjsBus *bus, duk_context *ctx,
+    const char *pattern, duk_idx_t fn, const TjsBusFilter *filter)
+{
+    int len = strlen(pattern), event = TJS_BUS_ANY, flags = TJS_BUS_FLAG_ACTIVE;
+
+    if (0 == len || TJS_BUS_NAME <= len) return 0;
+
+    /* Resolve pattern */
+    if ('*' == pattern[len - 1]) {
+        if (1 < len) flags |= TJS_BUS_FLAG_PREFIX;
+    } else if (0 > (event = tjs_bus_lookup(bus, pattern))) {
+        return 0;
+    }
+
+    TjsBusList *list = &bus->lists[event];
+
+    if (list->n == list->max) {
+        int max = (0 < list->max ? list->max * 2 : TJS_BUS_MIN_TOKENS);
+        unsigned int *tokens = (unsigned int *)realloc(list->tokens,
+            max * sizeof(unsigned int));
+
+        if (NULL == tokens) return 0;
+
+        list->tokens = tokens;
+        list->max = max;
+    }
+
+    /* Get free subscription */
+    int idx = bus->freesub;
+
+    if (-1 != idx) {
+        bus->freesub = bus->subs[idx].next;
+    } else {
+        if (TJS_BUS_SUBS <= bus->nsubs) return 0;
+
+        if (bus->nsubs == bus->maxsubs) {
+            int max = (0 < bus->maxsubs ? bus->maxsubs * 2 : TJS_BUS_MIN_SUBS);
+            TjsBusSub *subs = (TjsBusSub *)realloc(bus->subs,
+                max * sizeof(TjsBusSub));
+
+            if (NULL == subs) return 0;
+
+            bus->subs = subs;
+            bus->maxsubs = max;
+        }
+
+        idx = bus->nsubs++;
+
+        memset(&bus->subs[idx], 0, sizeof(TjsBusSub));
+    }
+
+    TjsBusSub *sub = &bus->subs[idx];
+
+    /* Generation 0 would make token 0 valid */
+    if (0 == (sub->gen = (sub->gen + 1) & 0xffff)) sub->gen = 1;
+
+    sub->flags = flags;
+    sub->event = event;
+    sub->ctx = ctx;
+    sub->len = len - 1;
+    sub->next = -1;
+    sub->last = 0;
+
+    memset(&sub->stats, 0, sizeof(sub->stats));
+
+    snprintf(sub->pattern, TJS_BUS_NAME, "%s", pattern);
+
+    if (NULL != filter) {
+        sub->filter = *filter;
+    } else {
+        memset(&sub->filter, 0, sizeof(TjsBusFilter));
+    }
+
+    unsigned int token = TJS_BUS_TOKEN(idx, sub->gen);
+
+    list->tokens[list->n++] = token;
+
+    /* Keep handler reachable */
+    fn = duk_normalize_index(ctx, fn);
+
+    duk_push_heap_stash(ctx);
+
+    if (!duk_get_prop_string(ctx, -1, TJS_SYM_BUS)) {
+        duk_pop(ctx);
+        duk_push_array(ctx);
+        duk_dup(ctx, -1);
+        duk_put_prop_string(ctx, -3, TJS_SYM_BUS);
+    }
+
+    duk_dup(ctx, fn);
+    duk_put_prop_index(ctx, -2, (duk_uarridx_t)idx);
+    duk_pop_2(ctx);
+
+    bus->stats.subscribed++;
+
+    return token;
+}
+
+/**
+ * Unsubscribe handler; safe to call from handlers
+ *
+ * @param[inout]  bus    A #TjsBus
+ * @param[inout]  ctx    A #duk_context of the handler
+ * @param[in]     token  Token returned by #tjs_bus_subscribe
+ *
+ * @return Either 1 when removed; otherwise 0
+ **/
+
+int tjs_bus_unsubscribe(TjsBus *bus, duk_context *ctx, unsigned int token) {
+    TjsBusSub *sub = tjs_bus_sub(bus, token);
+
+    /* Heaps can't remove handlers of others */
+    if (NULL == sub || ctx != sub->ctx) return 0;
+
+    int idx = TJS_BUS_TOKEN_IDX(token);
+
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_BUS);
+    duk_del_prop_index(ctx, -1, (duk_uarridx_t)idx);
+    duk_pop_2(ctx);
+
+    /* Tokens stay in the list until compacted */
+    TjsBusList *list = &bus->lists[sub->event];
+
+    tjs_bus_release(sub);
+
+    sub->flags = 0;
+    sub->ctx = NULL;
+    sub->next = bus->freesub;
+
+    bus->freesub = idx;
+    bus->stats.unsubscribed++;
+
+    if (list->n < 2 * ++list->dead && 0 == bus->depth) {
+        tjs_bus_compact(bus, list);
+    }
+
+    return 1;
+}
+
+/**
+ * Check whether any subscription matches event
+ *
+ * @param[in]  bus  A #TjsBus
+ * @param[in]  id   Id of the event
+ *
+ * @return Either 1 when subscribed; otherwise 0
+ **/
+
+int tjs_bus_subscribed(TjsBus *bus, int id) {
+    TjsBusList *list = &bus->lists[id];
+
+    if (list->n > list->dead) return 1;
+
+    /* Check patterns */
+    list = &bus->lists[TJS_BUS_ANY];
+
+    for (int i = 0; i < list->n; i++) {
+        TjsBusSub *sub = tjs_bus_sub(bus, list->tokens[i]);
+
+        if (NULL != sub && (0 == (sub->flags & TJS_BUS_FLAG_PREFIX) ||
+                0 == strncmp(bus->names[id], sub->pattern, sub->len)))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Emit event to all matching subscriptions
+ *
+ * Handlers of the event are called in order of subscription, followed
+ * by pattern handlers. Subscriptions added by handlers are called on
+ * the next emit; removed ones aren't called anymore.
+ *
+ * @param[inout]  bus    A #TjsBus
+ * @param[in]     event  A #TjsBusEvent
+ * @param[in]     push   Handler to push arguments per call; may be NULL
+ * @param[inout]  arg    Argument of push
+ *
+ * @return Number of called handlers
+ **/
+
+int tjs_bus_emit(TjsBus *bus, TjsBusEvent *event, TjsBusPush push,
+    void *arg)
+{
+    int ncalls = 0, ids[2] = { event->id, TJS_BUS_ANY };
+
+    if (0 >= event->id || event->id >= bus->nnames) return 0;
+
+    bus->stats.emitted++;
+    bus->depth++;
+
+    for (int j = 0; j < 2; j++) {
+        TjsBusList *list = &bus->lists[ids[j]];
+        int n = list->n; ///< Skip tokens added meanwhile
+
+        /* Tokens may move when handlers subscribe */
+        for (int i = 0; i < n; i++) {
+            unsigned int token = list->tokens[i];
+            TjsBusSub *sub = tjs_bus_sub(bus, token);
+
+            if (NULL != sub && tjs_bus_match(bus, sub, event)) {
+                tjs_bus_deliver(bus, sub, TJS_BUS_TOKEN_IDX(token), event,
+                    push, arg);
+
+                ncalls++;
+            }
+        }
+    }
+
+    /* Compact lists handlers removed tokens from */
+    if (0 == --bus->depth) {
+        for (int j = 0; j < 2; j++) {
+            TjsBusList *list = &bus->lists[ids[j]];
+
+            if (list->n < 2 * list->dead) {
+                tjs_bus_compact(bus, list);
+            }
+        }
+    }
+
+    return ncalls;
+}
+
+/**
+ * Destroy event bus
+ *
+ * @param[inout]  bus  A #TjsBus
+ **/
+
+void tjs_bus_destroy(TjsBus *bus) {
+    if (NULL == bus) return;
+
+    for (int i = 0; i < bus->nsubs; i++) {
+        if (0 < (bus->subs[i].flags & TJS_BUS_FLAG_ACTIVE)) {
+            tjs_bus_release(&bus->subs[i]);
+        }
+    }
+
+    for (int i = 0; i < TJS_BUS_EVENTS; i++) {
+        free(bus->lists[i].tokens);
+    }
+
+    free(bus->subs);
+    free(bus);
+}
+
+/**
+ * Helper to copy string option into buffer
+ *
+ * @param[inout]  ctx   A #duk_context
+ * @param[in]     idx   Stack index of the options
+ * @param[in]     name  Name of the option
+ * @param[inout]  buf   Buffer to copy into
+ * @param[in]     len   Length of buffer
+ *
+ * @return Either 1 when the option is set; otherwise 0
+ **/
+
+static int tjs_bus_option(duk_context *ctx, duk_idx_t idx, const char *name,
+    char *buf, size_t len)
+{
+    int ret = 0;
+
+    if (duk_get_prop_string(ctx, idx, name) && !duk_is_null(ctx, -1)) {
+        snprintf(buf, len, "%s", duk_require_string(ctx, -1));
+
+        ret = 1;
+    }
+
+    duk_pop(ctx);
+
+    return ret;
+}
+
+/**
+ * Helper to translate source of a JS RegExp into POSIX extended syntax;
+ * class escapes are expanded and features ERE lacks are refused
+ *
+ * @param[in]     src  Source of the RegExp
+ * @param[inout]  buf  Buffer for the translated regex
+ * @param[in]     len  Length of buffer
+ *
+ * @return Either NULL on success; otherwise reason of the failure
+ **/
+
+static const char *tjs_bus_regex(const char *src, char *buf, size_t len) {
+    static const struct {
+        char c;
+        const char *outside, *inside;
+    } classes[] = {
+        { 'd', "[0-9]", "0-9" },
+        { 'w', "[[:alnum:]_]", "[:alnum:]_" },
+        { 's', "[[:space:]]", "[:space:]" },
+        { 'D', "[^0-9]", NULL },
+        { 'W', "[^[:alnum:]_]", NULL },
+        { 'S', "[^[:space:]]", NULL }
+    };
+
+    size_t n = 0;
+    int inclass = 0;
+
+    for (const char *c = src; '\0' != *c; c++) {
+        char lit[2] = { *c, '\0' };
+        const char *out = lit;
+        size_t olen = 0;
+
+        if ('\\' == *c) {
+            char esc = *(++c);
+
+            out = NULL;
+
+            for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+                if (esc == classes[i].c) {
+                    out = (inclass ? classes[i].inside : classes[i].outside);
+
+                    if (NULL == out) return "negated class escape inside []";
+                }
+            }
+
+            if (NULL != out) {
+                /* Class escape */
+            } else if ('t' == esc || 'n' == esc || 'r' == esc ||
+                    'f' == esc || 'v' == esc)
+            {
+                lit[0] = ('t' == esc ? '\t' : 'n' == esc ? '\n' :
+                    'r' == esc ? '\r' : 'f' == esc ? '\f' : '\v');
+                out = lit;
+            } else if ('\0' == esc || isalnum((unsigned char)esc)) {
+                return "unsupported escape";
+            } else if (inclass) {
+                /* Backslash is literal in brackets */
+                if (']' == esc || '\\' == esc || '-' == esc || '^' == esc) {
+                    return "unsupported escape inside []";
+                }
+
+                lit[0] = esc;
+                out = lit;
+            } else {
+                /* Escaping ordinary chars is undefined in ERE */
+                lit[0] = esc;
+                out = (NULL != strchr(".[]()*+?{}|^$\\", esc) ? c - 1 : lit);
+                olen = (out == lit ? 1 : 2);
+            }
+        } else if (inclass) {
+            if (']' == *c) inclass = 0;
+        } else if ('[' == *c) {
+            inclass = 1;
+
+            /* JS reads these as empty and any char */
+            if (']' == c[1] || ('^' == c[1] && ']' == c[2])) {
+                return "empty class";
+            }
+        } else if ('(' == *c && '?' == c[1]) {
+            return "unsupported group (?";
+        } else if (NULL != strchr("*+?}", *c) && '?' == c[1]) {
+            return "lazy quantifier";
+        }
+
+        if (0 == olen) olen = strlen(out);
+
+        if (n + olen >= len) return "too long";
+
+        memcpy(buf + n, out, olen);
+        n += olen;
+    }
+
+    buf[n] = '\0';
+
+    return NULL;
+}
+
+/**
+ * Native observe helper; expects event name, handler and optional
+ * options object at given index
+ *
+ * The options window, pid, role, subrole, titleRegex and minIntervalMs
+ * are checked natively, so filtered events never enter JS. titleRegex
+ * is either a POSIX extended regex string or a RegExp object; the
+ * latter is translated and refused when it needs features ERE lacks,
+ * e.g. lookarounds, lazy quantifiers or \b.
+ *
+ * @param[inout]  ctx  A #duk_context
+ * @param[inout]  bus  A #TjsBus
+ * @param[in]     idx  Stack index of the event name
+ **/
+
+duk_ret_t tjs_bus_observe(duk_context *ctx, TjsBus *bus, duk_idx_t idx) {
+    const char *pattern = duk_require_string(ctx, idx);
+    duk_require_function(ctx, idx + 1);
+
+    TjsBusFilter filter;
+    duk_idx_t optIdx = idx + 2;
+
+    memset(&filter, 0, sizeof(TjsBusFilter));
+
+    if (duk_is_object(ctx, optIdx)) {
+        if (duk_get_prop_string(ctx, optIdx, "window")) {
+            filter.window = (unsigned long)duk_require_uint(ctx, -1);
+        }
+
+        if (duk_get_prop_string(ctx, optIdx, "pid")) {
+            filter.pid = duk_require_int(ctx, -1);
+            filter.flags |= TJS_BUS_FILTER_PID;
+        }
+
+        if (duk_get_prop_string(ctx, optIdx, "minIntervalMs")) {
+            filter.interval = duk_require_number(ctx, -1);
+        }
+
+        duk_pop_3(ctx);
+
+        if (tjs_bus_option(ctx, optIdx, "role", filter.role,
+                sizeof(filter.role)))
+        {
+            filter.flags |= TJS_BUS_FILTER_ROLE;
+        }
+
+        if (tjs_bus_option(ctx, optIdx, "subrole", filter.subrole,
+                sizeof(filter.subrole)))
+        {
+            filter.flags |= TJS_BUS_FILTER_SUBROLE;
+        }
+
+        /* Compile title regex once */
+        if (duk_get_prop_string(ctx, optIdx, "titleRegex")) {
+            int cflags = REG_EXTENDED|REG_NOSUB;
+            const char *regex = NULL;
+            char ere[TJS_BUS_REGEX];
+
+            if (duk_is_object(ctx, -1)) {
+                duk_get_prop_string(ctx, -1, "ignoreCase");
+                duk_get_prop_string(ctx, -2, "multiline");
+                duk_get_prop_string(ctx, -3, "source");
+
+                const char *source = duk_require_string(ctx, -1);
+                const char *err = tjs_bus_regex(source, ere, sizeof(ere));
+
+                if (NULL == err && duk_to_boolean(ctx, -2)) {
+                    err = "unsupported flag m";
+                }
+
+                if (NULL != err) {
+                    return duk_error(ctx, DUK_ERR_SYNTAX_ERROR,
+                        "Invalid titleRegex: /%s/: %s", source, err);
+                }
+
+                if (duk_to_boolean(ctx, -3)) cflags |= REG_ICASE;
+
+                duk_pop_3(ctx);
+
+                regex = ere;
+            } else {
+                regex = duk_require_string(ctx, -1);
+            }
+
+            if (0 != regcomp(&filter.title, regex, cflags)) {
+                return duk_error(ctx, DUK_ERR_SYNTAX_ERROR,
+                    "Invalid titleRegex: %s", regex);
+            }
+
+            filter.flags |= TJS_BUS_FILTER_TITLE;
+        }
+
+        duk_pop(ctx);
+    }
+
+    unsigned int token = tjs_bus_subscribe(bus, ctx, pattern, idx + 1,
+        &filter);
+
+    if (0 == token) {
+        if (0 < (filter.flags & TJS_BUS_FILTER_TITLE)) {
+            regfree(&filter.title);
+        }
+
+        return duk_error(ctx, DUK_ERR_TYPE_ERROR, "Unknown event: %s", pattern);
+    }
+
+    TJS_LOG_OBSERVER("Added event: name=%s, token=%u", pattern, token);
+
+    duk_push_uint(ctx, token);
+
+    return 1;
+}
+
+/**
+ * Native unobserve helper; expects token at given index
+ *
+ * @param[inout]  ctx  A #duk_context
+ * @param[inout]  bus  A #TjsBus
+ * @param[in]     idx  Stack index of the token
+ **/
+
+duk_ret_t tjs_bus_unobserve(duk_context *ctx, TjsBus *bus, duk_idx_t idx) {
+    unsigned int token = (unsigned int)duk_require_uint(ctx, idx);
+
+    duk_push_boolean(ctx, tjs_bus_unsubscribe(bus, ctx, token));
+
+    return 1;
+}
+
+/**
+ * Native stats helper; pushes counters of the subscription of the
+ * token at given index or totals when there is no token
+ *
+ * @param[inout]  ctx  A #duk_context
+ * @param[inout]  bus  A #TjsBus
+ * @param[in]     idx  Stack index of the token
+ **/
+
+duk_ret_t tjs_bus_getstats(duk_context *ctx, TjsBus *bus, duk_idx_t idx) {
+    if (!duk_is_valid_index(ctx, idx) || duk_is_undefined(ctx, idx)) {
+        duk_idx_t objIdx = duk_push_object(ctx);
+
+        duk_push_number(ctx, bus->stats.emitted);
+        duk_put_prop_string(ctx, objIdx, "emitted");
+        duk_push_number(ctx, bus->stats.delivered);
+        duk_put_prop_string(ctx, objIdx, "delivered");
+        duk_push_number(ctx, bus->stats.filtered);
+        duk_put_prop_string(ctx, objIdx, "filtered");
+        duk_push_number(ctx, bus->stats.fetches);
+        duk_put_prop_string(ctx, objIdx, "fetches");
+
+        return 1;
+    }
+
+    TjsBusSub *sub = tjs_bus_sub(bus, (unsigned int)duk_require_uint(ctx, idx));
+
+    if (NULL == sub || ctx != sub->ctx) return 0;
+
+    duk_idx_t objIdx = duk_push_object(ctx);
+
+    duk_push_number(ctx, sub->stats.seen);
+    duk_put_prop_string(ctx, objIdx, "seen");
+    duk_push_number(ctx, sub->stats.passed);
+    duk_put_prop_string(ctx, objIdx, "passed");
+    duk_push_number(ctx, sub->stats.dropped);
+    duk_put_prop_string(ctx, objIdx, "dropped");
+
+    return 1;
+}
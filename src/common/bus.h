@@ -0,0 +1,135 @@
+/**
+ * @package TouchJS
+ *
+ * @file Event bus header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_BUS_H
+#define TJS_BUS_H 1
+
+/* Includes */
+#include <regex.h>
+
+#include "../libs/duktape/duktape.h"
+
+/* Flags */
+#define TJS_BUS_FLAG_ACTIVE (1 << 0) ///< Subscription is live
+#define TJS_BUS_FLAG_PREFIX (1 << 1) ///< Pattern ends with *; matches by prefix
+
+#define TJS_BUS_FILTER_PID (1 << 0)
+#define TJS_BUS_FILTER_ROLE (1 << 1)
+#define TJS_BUS_FILTER_SUBROLE (1 << 2)
+#define TJS_BUS_FILTER_TITLE (1 << 3) ///< Title matches compiled regex
+#define TJS_BUS_FILTER_ATTRS (TJS_BUS_FILTER_PID|TJS_BUS_FILTER_ROLE| \
+    TJS_BUS_FILTER_SUBROLE|TJS_BUS_FILTER_TITLE) ///< Need window attributes
+
+/* Defaults */
+#define TJS_BUS_EVENTS 32   ///< Max number of interned event names
+#define TJS_BUS_NAME 24     ///< Max length of event names and patterns
+#define TJS_BUS_ANY 0       ///< Id of *; list of wildcard subscriptions
+#define TJS_BUS_SUBS 0xffff ///< Max number of subscriptions
+
+/* Types */
+typedef struct tjs_bus_attrs_t {
+    int pid;
+
+    char title[64], role[32], subrole[32];
+} TjsBusAttrs;
+
+typedef struct tjs_bus_filter_t {
+    int flags;
+
+    unsigned long window; ///< Window id; 0 matches all
+    int pid;
+    char role[32], subrole[32];
+    regex_t title;
+
+    double interval; ///< Min time between calls in ms; 0 disables
+} TjsBusFilter;
+
+typedef int (*TjsBusFetch)(void *ref, TjsBusAttrs *attrs);
+
+typedef struct tjs_bus_event_t {
+    int id; ///< Interned event id
+    int fetched; ///< Attributes are fetched; -1 when fetch failed
+
+    unsigned long window; ///< Id of subject window; 0 when unknown
+    void *ref; ///< Native window ref of the source
+
+    TjsBusFetch fetch; ///< Fetch attributes on first use; may be NULL
+    struct tjs_bus_attrs_t attrs;
+} TjsBusEvent;
+
+typedef struct tjs_bus_sub_t {
+    int flags;
+    int event;        ///< Event id; #TJS_BUS_ANY for patterns
+    unsigned int gen; ///< Bumped on re-use; stale tokens don't match
+
+    duk_context *ctx; ///< Heap of the handler
+
+    char pattern[TJS_BUS_NAME];
+    int len; ///< Length of prefix for pattern subscriptions
+
+    struct tjs_bus_filter_t filter;
+    double last; ///< Time of last call for min interval
+
+    int next; ///< Next free subscription; -1 otherwise
+
+    /* Stats */
+    struct {
+        unsigned long seen, passed, dropped;
+    } stats;
+} TjsBusSub;
+
+typedef struct tjs_bus_list_t {
+    int n, max;
+    int dead; ///< Tokens of removed subscriptions not compacted yet
+
+    unsigned int *tokens;
+} TjsBusList;
+
+typedef int (*TjsBusPush)(duk_context *ctx, void *arg);
+
+typedef struct tjs_bus_t {
+    int depth; ///< Nesting of emits; lists are compacted at 0
+
+    /* Interned names */
+    int nnames;
+    char names[TJS_BUS_EVENTS][TJS_BUS_NAME];
+
+    struct tjs_bus_list_t lists[TJS_BUS_EVENTS]; ///< Subscriptions by event id
+
+    /* Dense subscriptions; index is part of the token */
+    int nsubs, maxsubs, freesub;
+    struct tjs_bus_sub_t *subs;
+
+    /* Stats */
+    struct {
+        unsigned long subscribed, unsubscribed, emitted, delivered,
+            filtered, fetches, compactions;
+    } stats;
+} TjsBus;
+
+/* Methods */
+TjsBus *tjs_bus_new(void);
+int tjs_bus_intern(TjsBus *bus, const char *name);
+int tjs_bus_lookup(TjsBus *bus, const char *name);
+const char *tjs_bus_name(TjsBus *bus, int id);
+unsigned int tjs_bus_subscribe(TjsBus *bus, duk_context *ctx,
+    const char *pattern, duk_idx_t fn, const TjsBusFilter *filter);
+int tjs_bus_unsubscribe(TjsBus *bus, duk_context *ctx, unsigned int token);
+int tjs_bus_subscribed(TjsBus *bus, int id);
+int tjs_bus_emit(TjsBus *bus, TjsBusEvent *event, TjsBusPush push,
+    void *arg);
+void tjs_bus_destroy(TjsBus *bus);
+
+duk_ret_t tjs_bus_observe(duk_context *ctx, TjsBus *bus, duk_idx_t idx);
+duk_ret_t tjs_bus_unobserve(duk_context *ctx, TjsBus *bus, duk_idx_t idx);
+duk_ret_t tjs_bus_getstats(duk_context *ctx, TjsBus *bus, duk_idx_t idx);
+
+#endif /* TJS_BUS_H */
@@ -0,0 +1,249 @@
+/**
+ * @package TouchJS
+ *
+ * @file Bytecode functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "../touchjs.h"
+
+#include "bytecode.h"
+#include "clock.h"
+
+/* Defines */
+#define TJS_BYTECODE_MAGIC "TJSC"
+#define TJS_BYTECODE_SUFFIX "c" ///< Cache of foo.js is foo.jsc
+
+/* Types */
+typedef struct tjs_bytecode_header_t {
+    char magic[4];
+    uint32_t version; ///< DUK_VERSION
+    uint32_t ptrsize; ///< Bytecode isn't portable between builds
+    uint32_t len;     ///< Source length
+    uint64_t hash;    ///< Source hash
+    uint32_t size;    ///< Bytecode size
+} TjsBytecodeHeader;
+
+/**
+ * Helper to hash source (FNV-1a)
+ *
+ * @param[in]  data  Source data
+ * @param[in]  len   Length of data
+ *
+ * @return Hash of data
+ **/
+
+static uint64_t tjs_bytecode_hash(const char *data, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * Helper to fill header for given source
+ *
+ * @param[out]  header  A #TjsBytecodeHeader
+ * @param[in]   data    Source data
+ * @param[in]   len     Length of data
+ **/
+
+static void tjs_bytecode_header(TjsBytecodeHeader *header,
+    const char *data, size_t len)
+{
+    memset(header, 0, sizeof(TjsBytecodeHeader));
+    memcpy(header->magic, TJS_BYTECODE_MAGIC, sizeof(header->magic));
+
+    header->version = DUK_VERSION;
+    header->ptrsize = sizeof(void *);
+    header->len = (uint32_t)len;
+    header->hash = tjs_bytecode_hash(data, len);
+}
+
+/**
+ * Safe call wrapper for #duk_load_function
+ *
+ * @param[inout]  ctx   A #duk_context
+ * @param[in]     udata Unused
+ **/
+
+static duk_ret_t tjs_bytecode_load_safe(duk_context *ctx, void *udata) {
+    (void) udata;
+
+    duk_load_function(ctx);
+
+    return 1;
+}
+
+/**
+ * Helper to load function from cache file
+ *
+ * @param[inout]  ctx        A #duk_context
+ * @param[in]     cachefile  Name of cache file
+ * @param[in]     header     Expected #TjsBytecodeHeader
+ *
+ * @return Either 1 with function on stack on success; otherwise 0
+ **/
+
+static int tjs_bytecode_load(duk_context *ctx, const char *cachefile,
+    TjsBytecodeHeader *header)
+{
+    TjsBytecodeHeader cached;
+    int ret = 0;
+
+    FILE *fp = fopen(cachefile, "rb");
+
+    if (NULL == fp) return 0;
+
+    /* Compare header; size is the only field we don't know yet */
+    if (1 == fread(&cached, sizeof(TjsBytecodeHeader), 1, fp)) {
+        header->size = cached.size;
+
+        if (0 == memcmp(header, &cached, sizeof(TjsBytecodeHeader))) {
+            void *buf = duk_push_fixed_buffer(ctx, cached.size);
+
+            if (cached.size == fread(buf, 1, cached.size, fp) &&
+                    DUK_EXEC_SUCCESS == duk_safe_call(ctx,
+                        tjs_bytecode_load_safe, NULL, 1, 1))
+            {
+                ret = 1;
+            } else {
+                duk_pop(ctx);
+            }
+        } else {
+            TJS_LOG_DEBUG("Stale cache: file=%s", cachefile);
+        }
+    }
+
+    fclose(fp);
+
+    return ret;
+}
+
+/**
+ * Helper to store function on stack top to cache file
+ *
+ * @param[inout]  ctx        A #duk_context
+ * @param[in]     cachefile  Name of cache file
+ * @param[in]     header     A #TjsBytecodeHeader
+ **/
+
+static void tjs_bytecode_store(duk_context *ctx, const char *cachefile,
+    TjsBytecodeHeader *header)
+{
+    char tmpfile[PATH_MAX + 16];
+    duk_size_t size = 0;
+
+    duk_dup_top(ctx);
+    duk_dump_function(ctx);
+
+    void *buf = duk_get_buffer(ctx, -1, &size);
+
+    header->size = (uint32_t)size;
+
+    /* Write to temp file and rename it to avoid torn reads */
+    snprintf(tmpfile, sizeof(tmpfile), "%s.%d", cachefile, (int)getpid());
+
+    FILE *fp = fopen(tmpfile, "wb");
+
+    if (NULL != fp) {
+        int written = (1 == fwrite(header, sizeof(TjsBytecodeHeader), 1, fp) &&
+            size == fwrite(buf, 1, size, fp));
+
+        if (0 == fclose(fp) && written && 0 == rename(tmpfile, cachefile)) {
+            TJS_LOG_DEBUG("Stored cache: file=%s, size=%lu",
+                cachefile, (unsigned long)size);
+        } else {
+            TJS_LOG_ERROR("Failed to write cache file %s", cachefile);
+
+            unlink(tmpfile);
+        }
+    }
+
+    duk_pop(ctx);
+}
+
+/**
+ * Compile and eval source, optionally via bytecode cache
+ *
+ * @param[inout]  ctx       A #duk_context
+ * @param[in]     filename  Name of the source file
+ * @param[in]     data      Source data
+ * @param[in]     len       Length of data
+ * @param[in]     flags     Bytecode flags
+ * @param[out]    stats     A #TjsBytecodeStats; might be NULL
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+int tjs_bytecode_eval(duk_context *ctx, const char *filename,
+    const char *data, size_t len, int flags, TjsBytecodeStats *stats)
+{
+    TjsBytecodeHeader header;
+    char cachefile[PATH_MAX] = { 0 };
+    int ret = 0;
+
+    double start = tjs_clock_now();
+
+    /* Try cache first */
+    if (0 < (flags & TJS_BYTECODE_CACHE)) {
+        snprintf(cachefile, sizeof(cachefile), "%s%s",
+            filename, TJS_BYTECODE_SUFFIX);
+
+        tjs_bytecode_header(&header, data, len);
+
+        if (tjs_bytecode_load(ctx, cachefile, &header)) {
+            flags |= TJS_BYTECODE_HIT;
+        }
+    }
+
+    /* Compile source otherwise */
+    if (0 == (flags & TJS_BYTECODE_HIT)) {
+        duk_push_string(ctx, filename);
+
+        if (0 != duk_pcompile_lstring_filename(ctx, 0, data, len)) {
+            TJS_LOG_ERROR("Failed to compile file %s: %s",
+                filename, duk_safe_to_string(ctx, -1));
+
+            duk_pop(ctx);
+
+            return -1;
+        }
+
+        if (0 < (flags & TJS_BYTECODE_CACHE)) {
+            tjs_bytecode_store(ctx, cachefile, &header);
+        }
+    }
+
+    double compiled = tjs_clock_now();
+
+    /* Run program */
+    if (DUK_EXEC_SUCCESS != duk_pcall(ctx, 0)) {
+        TJS_LOG_ERROR("Failed to eval file %s: %s",
+            filename, duk_safe_to_string(ctx, -1));
+
+        ret = -1;
+    }
+
+    duk_pop(ctx);
+
+    if (NULL != stats) {
+        stats->flags = flags;
+        stats->compile = compiled - start;
+        stats->exec = tjs_clock_now() - compiled;
+    }
+
+    return ret;
+}
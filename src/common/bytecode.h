@@ -0,0 +1,33 @@
+/**
+ * @package TouchJS
+ *
+ * @file Bytecode header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_BYTECODE_H
+#define TJS_BYTECODE_H 1
+
+/* Includes */
+#include "../libs/duktape/duktape.h"
+
+/* Flags */
+#define TJS_BYTECODE_CACHE (1L << 0) ///< Load from and store to cache file
+#define TJS_BYTECODE_HIT (1L << 1)   ///< Cache file was loaded
+
+/* Types */
+typedef struct tjs_bytecode_stats_t {
+    int flags;
+
+    double compile, exec; ///< In ms; compile includes cache load or store
+} TjsBytecodeStats;
+
+/* Methods */
+int tjs_bytecode_eval(duk_context *ctx, const char *filename,
+    const char *data, size_t len, int flags, TjsBytecodeStats *stats);
+
+#endif /* TJS_BYTECODE_H */
@@ -9,7 +9,77 @@
  * See the file COPYING for details.
  **/
 
+#include <string.h>
+
+#include "../touchjs.h"
+
 #include "callback.h"
+#include "watchdog.h"
+#include "profile.h"
+
+/**
+ * Format label of function for stats and profiles
+ *
+ * @param[inout]  ctx   A #duk_context
+ * @param[in]     idx   Index of function
+ * @param[in]     kind  Kind of callback
+ * @param[inout]  buf   Buffer to fill
+ * @param[in]     len   Length of buffer
+ **/
+
+void tjs_callback_label(duk_context *ctx, duk_idx_t idx, const char *kind,
+        char *buf, size_t len)
+{
+    idx = duk_normalize_index(ctx, idx);
+
+    duk_get_prop_string(ctx, idx, "name");
+    duk_get_prop_string(ctx, idx, "fileName");
+
+    const char *name = duk_get_string_default(ctx, -2, "");
+    const char *file = duk_get_string_default(ctx, -1, NULL);
+
+    snprintf(buf, len, "%s:%s%s%s", kind,
+        ('\0' != *name ? name : "anonymous"),
+        (NULL != file ? "@" : ""), (NULL != file ? file : ""));
+
+    duk_pop_2(ctx);
+}
+
+/**
+ * Call function from native code; every transition into JS goes
+ * through here to be bounded by the watchdog and seen by the profiler
+ *
+ * @param[inout]  ctx    A #duk_context
+ * @param[in]     kind   Kind of callback
+ * @param[in]     nargs  Number of arguments
+ * @param[in]     flags  Call flags
+ *
+ * @return Result of #duk_pcall
+ **/
+
+duk_int_t tjs_callback_pcall(duk_context *ctx, const char *kind, int nargs,
+        int flags)
+{
+    char label[TJS_CALLBACK_LABEL] = { 0 };
+
+    int method = (0 < (flags & TJS_CALLBACK_FLAG_METHOD));
+
+    if (NULL != touch.watchdog || NULL != touch.profile) {
+        tjs_callback_label(ctx, -1 - nargs - method, kind,
+            label, sizeof(label));
+    }
+
+    tjs_profile_enter(touch.profile, label);
+    tjs_watchdog_enter(touch.watchdog, label);
+
+    duk_int_t rc = (method ?
+        duk_pcall_method(ctx, nargs) : duk_pcall(ctx, nargs));
+
+    tjs_watchdog_leave(touch.watchdog);
+    tjs_profile_leave(touch.profile);
+
+    return rc;
+}
 
  /**
   * Helper to call given callback
@@ -25,9 +95,22 @@ void tjs_callback_call(duk_context *ctx, const char *sym, int nargs) {
 
         /* Call if callable */
         if (duk_is_callable(ctx, -1)) {
+            char kind[16] = { 0 };
+
+            /* Kind is the symbol without decoration: \xff__click_cb */
+            snprintf(kind, sizeof(kind), "%.*s",
+                (int)(strlen(sym) - 6), sym + 3);
+
             duk_insert(ctx, -2 - nargs); ///< Insert this context based on number of arguments
-            duk_pcall_method(ctx, nargs);
+
+            if (DUK_EXEC_SUCCESS != tjs_callback_pcall(ctx, kind, nargs,
+                    TJS_CALLBACK_FLAG_METHOD))
+            {
+                TJS_LOG_ERROR("Failed to call callback: %s",
+                    duk_safe_to_string(ctx, -1));
+            }
+
             duk_pop(ctx); ///< Ignore result
         }
     }
-}
\ No newline at end of file
+}
@@ -16,7 +16,17 @@
 #include "../libs/duktape/duktape.h"
 #include "syms.h"
 
+/* Flags */
+#define TJS_CALLBACK_FLAG_METHOD (1 << 0) ///< Call with this binding
+
+/* Defaults */
+#define TJS_CALLBACK_LABEL 96 ///< Max length of callback label
+
 /* Methods */
+void tjs_callback_label(duk_context *ctx, duk_idx_t idx, const char *kind,
+    char *buf, size_t len);
+duk_int_t tjs_callback_pcall(duk_context *ctx, const char *kind, int nargs,
+    int flags);
 void tjs_callback_call(duk_context *ctx, const char *sym, int nargs);
 
 #endif /* TJS_CALLBACK_H */
@@ -0,0 +1,42 @@
+/**
+ * @package TouchJS
+ *
+ * @file Clock functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <time.h>
+
+#include "clock.h"
+
+/**
+ * Get monotonic time
+ *
+ * @return Time in ms
+ **/
+
+double tjs_clock_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0);
+}
+
+/**
+ * Get CPU time of calling thread
+ *
+ * @return Time in ms
+ **/
+
+double tjs_clock_cpu(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return (ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0);
+}
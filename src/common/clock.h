@@ -0,0 +1,19 @@
+/**
+ * @package TouchJS
+ *
+ * @file Clock header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_CLOCK_H
+#define TJS_CLOCK_H 1
+
+/* Methods */
+double tjs_clock_now(void);
+double tjs_clock_cpu(void);
+
+#endif /* TJS_CLOCK_H */
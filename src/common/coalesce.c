@@ -0,0 +1,390 @@
+/**
+ * @package TouchJS
+ *
+ * @file Event coalescing functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../touchjs.h"
+
+#include "coalesce.h"
+#include "registry.h"
+#include "timer.h"
+#include "syms.h"
+
+/* Keys pack window id and event id; window ids are never 0 */
+#define TJS_COALESCE_KEY(WINDOW,EVENT) \
+    ((void *)(uintptr_t)(((WINDOW) << 5) | ((unsigned long)(EVENT) & 0x1f)))
+
+/**
+ * Helper to get due time of entry
+ *
+ * @param[in]  coalesce  A #TjsCoalesce
+ * @param[in]  entry     A #TjsCoalesceEntry
+ *
+ * @return Due time in ms
+ **/
+
+static double tjs_coalesce_entry_due(TjsCoalesce *coalesce,
+    TjsCoalesceEntry *entry)
+{
+    double due = entry->last + coalesce->quiet;
+
+    /* Storms that never go quiet are cut at max delay */
+    if (0 < coalesce->maxdelay && entry->first + coalesce->maxdelay < due) {
+        due = entry->first + coalesce->maxdelay;
+    }
+
+    return due;
+}
+
+/**
+ * Helper to deliver and remove entry
+ *
+ * @param[inout]  coalesce  A #TjsCoalesce
+ * @param[inout]  entry     A #TjsCoalesceEntry
+ * @param[in]     now       Current time in ms
+ **/
+
+static void tjs_coalesce_deliver(TjsCoalesce *coalesce,
+    TjsCoalesceEntry *entry, double now)
+{
+    double lag = now - entry->first;
+
+    tjs_registry_remove(coalesce->bykey,
+        TJS_COALESCE_KEY(entry->window, entry->event));
+
+    coalesce->stats.delivered++;
+    coalesce->stats.lag += lag;
+
+    if (lag > coalesce->stats.maxlag) coalesce->stats.maxlag = lag;
+
+    /* Removed first; handlers may add new events for the same key */
+    if (NULL != coalesce->deliver) coalesce->deliver(entry, coalesce->arg);
+
+    free(entry);
+}
+
+/**
+ * Helper to drop and free entry without delivering it
+ *
+ * @param[inout]  coalesce  A #TjsCoalesce
+ * @param[inout]  entry     A #TjsCoalesceEntry
+ **/
+
+static void tjs_coalesce_drop(TjsCoalesce *coalesce, TjsCoalesceEntry *entry) {
+    tjs_registry_remove(coalesce->bykey,
+        TJS_COALESCE_KEY(entry->window, entry->event));
+
+    coalesce->stats.dropped++;
+
+    if (NULL != coalesce->release) coalesce->release(entry, coalesce->arg);
+
+    free(entry);
+}
+
+/**
+ * Native timer callback; delivers due entries and re-arms
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_coalesce_timer(duk_context *ctx) {
+    duk_push_current_function(ctx);
+    duk_get_prop_string(ctx, -1, "coalesce");
+
+    TjsCoalesce *coalesce = (TjsCoalesce *)duk_get_pointer(ctx, -1);
+
+    duk_pop_2(ctx);
+
+    if (NULL != coalesce) {
+        coalesce->timer = 0;
+
+        tjs_coalesce_flush(coalesce, tjs_timers_now(touch.timers), 0);
+        tjs_coalesce_arm(coalesce, ctx);
+    }
+
+    return 0;
+}
+
+/**
+ * Create new coalescer
+ *
+ * @param[in]  quiet     Quiet period in ms; 0 disables
+ * @param[in]  maxdelay  Max delay in ms; 0 disables
+ *
+ * @return A new #TjsCoalesce
+ **/
+
+TjsCoalesce *tjs_coalesce_new(double quiet, double maxdelay) {
+    TjsCoalesce *coalesce = (TjsCoalesce *)calloc(1, sizeof(TjsCoalesce));
+
+    coalesce->quiet = (0 < quiet ? quiet : 0);
+    coalesce->maxdelay = (0 < maxdelay ? maxdelay : 0);
+    coalesce->bykey = tjs_registry_new();
+
+    return coalesce;
+}
+
+/**
+ * Add event; events of same window and type collapse into one
+ *
+ * @param[inout]  coalesce  A #TjsCoalesce
+ * @param[in]     window    Window id
+ * @param[in]     pid       Process id of the window
+ * @param[in]     event     Interned event id
+ * @param[in]     ref       Native window ref
+ * @param[in]     now       Current time in ms
+ *
+ * @return Either 1 when a new entry keeps ref, 0 when merged or -1 on error
+ **/
+
+int tjs_coalesce_add(TjsCoalesce *coalesce, unsigned long window, int pid,
+    int event, void *ref, double now)
+{
+    void *key = TJS_COALESCE_KEY(window, event);
+
+    coalesce->stats.raw++;
+
+    TjsCoalesceEntry *entry = (TjsCoalesceEntry *)tjs_registry_find(
+        coalesce->bykey, key, NULL);
+
+    if (NULL != entry) {
+        entry->last = now;
+        entry->count++;
+
+        return 0;
+    }
+
+    entry = (TjsCoalesceEntry *)calloc(1, sizeof(TjsCoalesceEntry));
+
+    if (NULL == entry) return -1;
+
+    entry->window = window;
+    entry->pid = pid;
+    entry->event = event;
+    entry->ref = ref;
+    entry->first = entry->last = now;
+    entry->count = 1;
+
+    if (0 > tjs_registry_add(coalesce->bykey, key, entry)) {
+        free(entry);
+
+        return -1;
+    }
+
+    return 1;
+}
+
+/**
+ * Get earliest due time of pending entries
+ *
+ * @param[in]  coalesce  A #TjsCoalesce
+ *
+ * @return Due time in ms or -1 when nothing is pending
+ **/
+
+double tjs_coalesce_due(TjsCoalesce *coalesce) {
+    double due = -1;
+    int size = tjs_registry_size(coalesce->bykey);
+
+    for (int i = 0; i < size; i++) {
+        TjsCoalesceEntry *entry = (TjsCoalesceEntry *)tjs_registry_get(
+            coalesce->bykey, i);
+
+        if (NULL != entry) {
+            double edue = tjs_coalesce_entry_due(coalesce, entry);
+
+            if (0 > due || edue < due) due = edue;
+        }
+    }
+
+    return due;
+}
+
+/**
+ * Deliver due entries
+ *
+ * @param[inout]  coalesce  A #TjsCoalesce
+ * @param[in]     now       Current time in ms
+ * @param[in]     all       Deliver all entries regardless of due time
+ *
+ * @return Number of delivered entries
+ **/
+
+int tjs_coalesce_flush(TjsCoalesce *coalesce, double now, int all) {
+    int delivered = 0;
+
+    /* Registry removal keeps slots, so walking by index is safe */
+    for (int i = 0; i < tjs_registry_size(coalesce->bykey); i++) {
+        TjsCoalesceEntry *entry = (TjsCoalesceEntry *)tjs_registry_get(
+            coalesce->bykey, i);
+
+        if (NULL != entry && (all ||
+                tjs_coalesce_entry_due(coalesce, entry) <= now))
+        {
+            tjs_coalesce_deliver(coalesce, entry, now);
+
+            delivered++;
+        }
+    }
+
+    return delivered;
+}
+
+/**
+ * Deliver all entries of given window, e.g. before it is closed
+ *
+ * @param[inout]  coalesce  A #TjsCoalesce
+ * @param[in]     window    Window id
+ * @param[in]     now       Current time in ms
+ *
+ * @return Number of delivered entries
+ **/
+
+int tjs_coalesce_flush_window(TjsCoalesce *coalesce, unsigned long window,
+    double now)
+{
+    int delivered = 0;
+
+    if (0 == tjs_registry_count(coalesce->bykey)) return 0;
+
+    for (int i = 0; i < tjs_registry_size(coalesce->bykey); i++) {
+        TjsCoalesceEntry *entry = (TjsCoalesceEntry *)tjs_registry_get(
+            coalesce->bykey, i);
+
+        if (NULL != entry && window == entry->window) {
+            tjs_coalesce_deliver(coalesce, entry, now);
+
+            delivered++;
+        }
+    }
+
+    return delivered;
+}
+
+/**
+ * Drop all entries of given app; its windows are gone
+ *
+ * @param[inout]  coalesce  A #TjsCoalesce
+ * @param[in]     pid       Process id
+ *
+ * @return Number of dropped entries
+ **/
+
+int tjs_coalesce_drop_pid(TjsCoalesce *coalesce, int pid) {
+    int dropped = 0;
+
+    if (0 == tjs_registry_count(coalesce->bykey)) return 0;
+
+    for (int i = 0; i < tjs_registry_size(coalesce->bykey); i++) {
+        TjsCoalesceEntry *entry = (TjsCoalesceEntry *)tjs_registry_get(
+            coalesce->bykey, i);
+
+        if (NULL != entry && pid == entry->pid) {
+            tjs_coalesce_drop(coalesce, entry);
+
+            dropped++;
+        }
+    }
+
+    return dropped;
+}
+
+/**
+ * Arm one-shot flush timer for the earliest due entry
+ *
+ * @param[inout]  coalesce  A #TjsCoalesce
+ * @param[inout]  ctx       A #duk_context to keep the timer callback
+ **/
+
+void tjs_coalesce_arm(TjsCoalesce *coalesce, duk_context *ctx) {
+    double now = tjs_timers_now(touch.timers);
+    double delay = (0 < coalesce->maxdelay &&
+        coalesce->maxdelay < coalesce->quiet ?
+        coalesce->maxdelay : coalesce->quiet);
+
+    /* Nothing can be due before now + delay; skip the scan in storms */
+    if (0 != coalesce->timer && coalesce->armed <= now + delay) return;
+
+    double due = tjs_coalesce_due(coalesce);
+
+    if (0 > due) return;
+
+    /* Due times of entries only move later; the timer re-checks */
+    if (0 != coalesce->timer) {
+        if (coalesce->armed <= due) return;
+
+        if (tjs_timers_clear(touch.timers, coalesce->timer)) {
+            duk_push_heap_stash(ctx);
+            duk_get_prop_string(ctx, -1, TJS_SYM_TIMERS);
+            duk_del_prop_index(ctx, -1, (duk_uarridx_t)coalesce->timer);
+            duk_pop_2(ctx);
+        }
+    }
+
+    delay = due - now;
+
+    coalesce->timer = tjs_timers_add(touch.timers, (0 < delay ? delay : 0), 0);
+    coalesce->armed = due;
+
+    /* Store as one-shot timer callback */
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_TIMERS);
+    duk_push_c_function(ctx, tjs_coalesce_timer, 0);
+    duk_push_pointer(ctx, coalesce);
+    duk_put_prop_string(ctx, -2, "coalesce");
+    duk_put_prop_index(ctx, -2, (duk_uarridx_t)coalesce->timer);
+    duk_pop_2(ctx);
+}
+
+/**
+ * Add counters to object at given index
+ *
+ * @param[inout]  ctx       A #duk_context
+ * @param[in]     coalesce  A #TjsCoalesce
+ * @param[in]     objIdx    Stack index of the object
+ **/
+
+void tjs_coalesce_putstats(duk_context *ctx, TjsCoalesce *coalesce,
+    duk_idx_t objIdx)
+{
+    objIdx = duk_normalize_index(ctx, objIdx);
+
+    duk_push_number(ctx, coalesce->stats.raw);
+    duk_put_prop_string(ctx, objIdx, "raw");
+    duk_push_number(ctx, coalesce->stats.delivered);
+    duk_put_prop_string(ctx, objIdx, "coalesced");
+    duk_push_number(ctx, coalesce->stats.dropped);
+    duk_put_prop_string(ctx, objIdx, "dropped");
+    duk_push_int(ctx, tjs_registry_count(coalesce->bykey));
+    duk_put_prop_string(ctx, objIdx, "pending");
+}
+
+/**
+ * Destroy coalescer; pending entries are dropped and their refs released
+ *
+ * @param[inout]  coalesce  A #TjsCoalesce
+ **/
+
+void tjs_coalesce_destroy(TjsCoalesce *coalesce) {
+    if (NULL == coalesce) return;
+
+    for (int i = 0; i < tjs_registry_size(coalesce->bykey); i++) {
+        TjsCoalesceEntry *entry = (TjsCoalesceEntry *)tjs_registry_get(
+            coalesce->bykey, i);
+
+        if (NULL != entry) tjs_coalesce_drop(coalesce, entry);
+    }
+
+    tjs_registry_destroy(coalesce->bykey);
+
+    free(coalesce);
+}
@@ -0,0 +1,71 @@
+/**
+ * @package TouchJS
+ *
+ * @file Event coalescing header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_COALESCE_H
+#define TJS_COALESCE_H 1
+
+/* Includes */
+#include "../libs/duktape/duktape.h"
+
+/* Defaults */
+#define TJS_COALESCE_QUIET 16.0    ///< Deliver after MSEC without new events
+#define TJS_COALESCE_MAXDELAY 50.0 ///< Deliver at latest MSEC after first event
+
+/* Types */
+typedef struct tjs_coalesce_entry_t {
+    unsigned long window;
+    int pid;
+    int event; ///< Interned bus id
+
+    void *ref; ///< Native window ref of first event; kept until delivery
+
+    double first, last; ///< Arrival of first and latest event
+    unsigned long count; ///< Events collapsed into this one
+} TjsCoalesceEntry;
+
+typedef void (*TjsCoalesceFunc)(TjsCoalesceEntry *entry, void *arg);
+
+typedef struct tjs_coalesce_t {
+    double quiet;    ///< Quiet period in ms; 0 disables
+    double maxdelay; ///< Max delay in ms; 0 disables
+
+    unsigned long timer; ///< Id of flush timer; 0 when none
+    double armed;        ///< Due time of flush timer
+
+    TjsCoalesceFunc deliver; ///< Called for due entries; set by the source
+    TjsCoalesceFunc release; ///< Called for dropped entries to free ref
+    void *arg;
+
+    struct tjs_registry_t *bykey; ///< (window, event) -> entry
+
+    /* Stats */
+    struct {
+        unsigned long raw, delivered;
+        unsigned long dropped; ///< Entries of terminated apps or at destroy
+        double lag, maxlag; ///< Total and max time events waited in ms
+    } stats;
+} TjsCoalesce;
+
+/* Methods */
+TjsCoalesce *tjs_coalesce_new(double quiet, double maxdelay);
+int tjs_coalesce_add(TjsCoalesce *coalesce, unsigned long window, int pid,
+    int event, void *ref, double now);
+double tjs_coalesce_due(TjsCoalesce *coalesce);
+int tjs_coalesce_flush(TjsCoalesce *coalesce, double now, int all);
+int tjs_coalesce_flush_window(TjsCoalesce *coalesce, unsigned long window,
+    double now);
+int tjs_coalesce_drop_pid(TjsCoalesce *coalesce, int pid);
+void tjs_coalesce_arm(TjsCoalesce *coalesce, duk_context *ctx);
+void tjs_coalesce_putstats(duk_context *ctx, TjsCoalesce *coalesce,
+    duk_idx_t objIdx);
+void tjs_coalesce_destroy(TjsCoalesce *coalesce);
+
+#endif /* TJS_COALESCE_H */
@@ -0,0 +1,151 @@
+/**
+ * @package TouchJS
+ *
+ * @file Dirty queue functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include "../touchjs.h"
+
+#include "dirty.h"
+
+/**
+ * Create new dirty queue
+ *
+ * @param[in]  handler  Handler to apply pending changes of an item
+ *
+ * @return Either #TjsDirty on success; otherwise NULL
+ **/
+
+TjsDirty *tjs_dirty_new(TjsDirtyHandler handler) {
+    TjsDirty *dirty = (TjsDirty *)calloc(1, sizeof(TjsDirty));
+
+    if (NULL != dirty) {
+        dirty->handler = handler;
+    }
+
+    return dirty;
+}
+
+/**
+ * Mark userdata as dirty
+ *
+ * Update flags are just or'ed into the userdata, so repeated changes
+ * of the same kind collapse into one until the next flush.
+ *
+ * @param[inout]  dirty     A #TjsDirty
+ * @param[inout]  userdata  A #TjsUserdata
+ * @param[in]     flags     Update flags to add
+ **/
+
+void tjs_dirty_mark(TjsDirty *dirty, TjsUserdata *userdata, int flags) {
+    if (NULL == dirty || NULL == userdata) return;
+
+    userdata->flags |= (flags & TJS_FLAGS_UPDATES);
+    dirty->stats.marks++;
+
+    /* Queue only once */
+    if (0 == (userdata->flags & TJS_FLAG_STATE_DIRTY)) {
+        if (dirty->nitems == dirty->maxitems) {
+            int maxitems = (0 == dirty->maxitems ? 16 : dirty->maxitems * 2);
+
+            TjsUserdata **items = (TjsUserdata **)realloc(dirty->items,
+                maxitems * sizeof(TjsUserdata *));
+
+            if (NULL == items) return;
+
+            dirty->items = items;
+            dirty->maxitems = maxitems;
+        }
+
+        dirty->items[dirty->nitems++] = userdata;
+        userdata->flags |= TJS_FLAG_STATE_DIRTY;
+    }
+}
+
+/**
+ * Remove userdata from queue, e.g. before it is destroyed
+ *
+ * @param[inout]  dirty     A #TjsDirty
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+void tjs_dirty_forget(TjsDirty *dirty, TjsUserdata *userdata) {
+    if (NULL == dirty || NULL == userdata ||
+        0 == (userdata->flags & TJS_FLAG_STATE_DIRTY)) return;
+
+    for (int i = 0; i < dirty->nitems; i++) {
+        if (dirty->items[i] == userdata) {
+            dirty->items[i] = dirty->items[--dirty->nitems];
+
+            break;
+        }
+    }
+
+    userdata->flags &= ~TJS_FLAG_STATE_DIRTY;
+}
+
+/**
+ * Apply all pending changes
+ *
+ * @param[inout]  dirty  A #TjsDirty
+ *
+ * @return Number of flushed items
+ **/
+
+int tjs_dirty_flush(TjsDirty *dirty) {
+    int nitems = 0;
+
+    if (NULL == dirty || 0 == dirty->nitems) return 0;
+
+    dirty->stats.flushes++;
+
+    /* Handlers may mark again, so only handle what is queued now */
+    nitems = dirty->nitems;
+
+    for (int i = 0; i < nitems; i++) {
+        TjsUserdata *userdata = dirty->items[i];
+        int pending = (userdata->flags & TJS_FLAGS_UPDATES);
+
+        userdata->flags &= ~TJS_FLAG_STATE_DIRTY;
+
+        if (NULL != dirty->handler) {
+            dirty->handler(userdata);
+        }
+
+        /* Count changes the handler applied aka cleared */
+        pending &= ~(userdata->flags & TJS_FLAGS_UPDATES);
+
+        if (0 < (pending & TJS_FLAG_STATE_COLOR_FG)) dirty->stats.fg++;
+        if (0 < (pending & TJS_FLAG_STATE_COLOR_BG)) dirty->stats.bg++;
+        if (0 < (pending & TJS_FLAG_STATE_VALUE))    dirty->stats.value++;
+    }
+
+    /* Keep items marked during flush for the next round */
+    memmove(dirty->items, dirty->items + nitems,
+        (dirty->nitems - nitems) * sizeof(TjsUserdata *));
+    dirty->nitems -= nitems;
+
+    return nitems;
+}
+
+/**
+ * Destroy dirty queue
+ *
+ * @param[inout]  dirty  A #TjsDirty
+ **/
+
+void tjs_dirty_destroy(TjsDirty *dirty) {
+    if (NULL != dirty) {
+        for (int i = 0; i < dirty->nitems; i++) {
+            dirty->items[i]->flags &= ~TJS_FLAG_STATE_DIRTY;
+        }
+
+        free(dirty->items);
+        free(dirty);
+    }
+}
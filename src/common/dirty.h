@@ -0,0 +1,41 @@
+/**
+ * @package TouchJS
+ *
+ * @file Dirty queue header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_DIRTY_H
+#define TJS_DIRTY_H 1
+
+/* Includes */
+#include "userdata.h"
+
+/* Types */
+typedef void (*TjsDirtyHandler)(TjsUserdata *userdata);
+
+typedef struct tjs_dirty_t {
+    int nitems, maxitems;
+    struct tjs_userdata_t **items;
+
+    TjsDirtyHandler handler;
+
+    /* Stats */
+    struct {
+        unsigned long marks, flushes;
+        unsigned long fg, bg, value; ///< Applied changes
+    } stats;
+} TjsDirty;
+
+/* Methods */
+TjsDirty *tjs_dirty_new(TjsDirtyHandler handler);
+void tjs_dirty_mark(TjsDirty *dirty, TjsUserdata *userdata, int flags);
+void tjs_dirty_forget(TjsDirty *dirty, TjsUserdata *userdata);
+int tjs_dirty_flush(TjsDirty *dirty);
+void tjs_dirty_destroy(TjsDirty *dirty);
+
+#endif /* TJS_DIRTY_H */
@@ -0,0 +1,360 @@
+/**
+ * @package TouchJS
+ *
+ * @file Command executor functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "exec.h"
+#include "registry.h"
+
+/* Defines */
+#define TJS_EXEC_KEY(HASH) ((void *)(uintptr_t)(HASH))
+
+/**
+ * Helper to hash command line and flags (FNV-1a)
+ *
+ * @param[in]  line   Command line
+ * @param[in]  flags  Exec flags
+ *
+ * @return Hash value; never 0
+ **/
+
+static unsigned long tjs_exec_hash(const char *line, int flags) {
+    uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t)flags;
+
+    for (const char *c = line; '\0' != *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return (unsigned long)(0 != hash ? hash : 1);
+}
+
+/**
+ * Helper to free entry
+ *
+ * @param[inout]  exec   A #TjsExec
+ * @param[inout]  entry  A #TjsExecEntry
+ **/
+
+static void tjs_exec_free(TjsExec *exec, TjsExecEntry *entry) {
+    tjs_registry_remove(exec->entries, TJS_EXEC_KEY(entry->hash));
+
+    free(entry->line);
+    free(entry->output);
+    free(entry);
+}
+
+/**
+ * Helper to make room for new entry; drops the oldest completed one
+ *
+ * @param[inout]  exec  A #TjsExec
+ **/
+
+static void tjs_exec_trim(TjsExec *exec) {
+    TjsExecEntry *oldest = NULL;
+
+    if (TJS_EXEC_MAX_ENTRIES > tjs_registry_count(exec->entries)) return;
+
+    for (int i = 0; i < tjs_registry_size(exec->entries); i++) {
+        TjsExecEntry *entry = (TjsExecEntry *)tjs_registry_get(exec->entries, i);
+
+        if (NULL != entry && 0 < entry->stamp &&
+                (NULL == oldest || entry->stamp < oldest->stamp))
+        {
+            oldest = entry;
+        }
+    }
+
+    if (NULL != oldest) tjs_exec_free(exec, oldest);
+}
+
+/**
+ * Create new command executor
+ *
+ * @param[in]  limit  Max concurrent children; 0 is unlimited
+ *
+ * @return A new #TjsExec
+ **/
+
+TjsExec *tjs_exec_new(int limit) {
+    TjsExec *exec = (TjsExec *)calloc(1, sizeof(TjsExec));
+
+    exec->limit = (0 < limit ? limit : 0);
+    exec->entries = tjs_registry_new();
+
+    return exec;
+}
+
+/**
+ * Look up cached or in-flight output of command line
+ *
+ * @param[inout]  exec   A #TjsExec
+ * @param[in]     line   Command line
+ * @param[in]     flags  Exec flags
+ * @param[in]     ttl    Max age of completed output in ms
+ * @param[in]     now    Current time in ms
+ *
+ * @return Either found #TjsExecEntry; otherwise NULL
+ **/
+
+TjsExecEntry *tjs_exec_lookup(TjsExec *exec, const char *line, int flags,
+    double ttl, double now)
+{
+    unsigned long hash = tjs_exec_hash(line, flags);
+
+    TjsExecEntry *entry = (TjsExecEntry *)tjs_registry_find(exec->entries,
+        TJS_EXEC_KEY(hash), NULL);
+
+    /* Collisions just miss */
+    if (NULL != entry && (entry->flags != flags || 0 != strcmp(entry->line, line))) {
+        entry = NULL;
+    }
+
+    if (NULL != entry) {
+        if (0 == entry->stamp) {
+            exec->stats.shared++;
+
+            return entry;
+        }
+
+        if (now - entry->stamp <= ttl) {
+            exec->stats.hits++;
+
+            return entry;
+        }
+
+        exec->stats.expired++;
+
+        tjs_exec_free(exec, entry);
+    }
+
+    exec->stats.misses++;
+
+    return NULL;
+}
+
+/**
+ * Create in-flight entry for command line
+ *
+ * @param[inout]  exec   A #TjsExec
+ * @param[in]     line   Command line
+ * @param[in]     flags  Exec flags
+ * @param[in]     owner  Exec id of the command filling the entry
+ *
+ * @return Either new #TjsExecEntry; otherwise NULL on hash collision
+ **/
+
+TjsExecEntry *tjs_exec_begin(TjsExec *exec, const char *line, int flags,
+    unsigned long owner)
+{
+    unsigned long hash = tjs_exec_hash(line, flags);
+
+    if (NULL != tjs_registry_find(exec->entries, TJS_EXEC_KEY(hash), NULL)) {
+        return NULL;
+    }
+
+    tjs_exec_trim(exec);
+
+    TjsExecEntry *entry = (TjsExecEntry *)calloc(1, sizeof(TjsExecEntry));
+
+    entry->hash = hash;
+    entry->flags = flags;
+    entry->line = strdup(line);
+    entry->owner = owner;
+    entry->status = -1;
+
+    tjs_registry_add(exec->entries, TJS_EXEC_KEY(hash), entry);
+
+    return entry;
+}
+
+/**
+ * Complete entry with output of its command
+ *
+ * @param[inout]  exec    A #TjsExec
+ * @param[inout]  entry   A #TjsExecEntry
+ * @param[in]     output  Collected output
+ * @param[in]     len     Length of output
+ * @param[in]     status  Exit status
+ * @param[in]     now     Current time in ms
+ **/
+
+void tjs_exec_end(TjsExec *exec, TjsExecEntry *entry, const char *output,
+    size_t len, int status, double now)
+{
+    entry->output = (char *)malloc(len + 1);
+    entry->len = len;
+    entry->status = status;
+    entry->stamp = (0 < now ? now : 1);
+
+    if (0 < len) memcpy(entry->output, output, len);
+
+    entry->output[len] = '\0';
+}
+
+/**
+ * Drop entry of failed command
+ *
+ * @param[inout]  exec   A #TjsExec
+ * @param[inout]  entry  A #TjsExecEntry
+ **/
+
+void tjs_exec_abort(TjsExec *exec, TjsExecEntry *entry) {
+    tjs_exec_free(exec, entry);
+}
+
+/**
+ * Queue item until a slot is free
+ *
+ * @param[inout]  exec  A #TjsExec
+ * @param[in]     item  Item to queue
+ **/
+
+void tjs_exec_enqueue(TjsExec *exec, void *item) {
+    if (exec->nqueued == exec->capacity) {
+        int capacity = (0 < exec->capacity ? exec->capacity * 2 : 16);
+        void **queue = (void **)malloc(capacity * sizeof(void *));
+
+        /* Unwrap ring */
+        for (int i = 0; i < exec->nqueued; i++) {
+            queue[i] = exec->queue[(exec->head + i) % exec->capacity];
+        }
+
+        free(exec->queue);
+
+        exec->queue = queue;
+        exec->capacity = capacity;
+        exec->head = 0;
+    }
+
+    exec->queue[(exec->head + exec->nqueued++) % exec->capacity] = item;
+    exec->stats.queued++;
+}
+
+/**
+ * Take oldest queued item
+ *
+ * @param[inout]  exec  A #TjsExec
+ *
+ * @return Either item; otherwise NULL when empty
+ **/
+
+void *tjs_exec_dequeue(TjsExec *exec) {
+    if (0 == exec->nqueued) return NULL;
+
+    void *item = exec->queue[exec->head];
+
+    exec->head = (exec->head + 1) % exec->capacity;
+    exec->nqueued--;
+
+    return item;
+}
+
+/**
+ * Remove queued item
+ *
+ * @param[inout]  exec  A #TjsExec
+ * @param[in]     item  Item to remove
+ *
+ * @return Either 1 when removed; otherwise 0
+ **/
+
+int tjs_exec_remove(TjsExec *exec, void *item) {
+    for (int i = 0; i < exec->nqueued; i++) {
+        if (exec->queue[(exec->head + i) % exec->capacity] != item) continue;
+
+        /* Close gap */
+        for (int j = i; j < exec->nqueued - 1; j++) {
+            exec->queue[(exec->head + j) % exec->capacity] =
+                exec->queue[(exec->head + j + 1) % exec->capacity];
+        }
+
+        exec->nqueued--;
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Split command line into argv in place; handles single and double
+ * quotes but no other shell syntax
+ *
+ * @param[inout]  line  Command line; modified
+ * @param[out]    argv  Argument vector; NULL-terminated
+ * @param[in]     max   Size of argv
+ *
+ * @return Number of arguments
+ **/
+
+int tjs_exec_split(char *line, char **argv, int max) {
+    char *src = line, *dst = line;
+    int argc = 0;
+
+    while (argc < max - 1) {
+        while (' ' == *src || '\t' == *src) src++;
+
+        if ('\0' == *src) break;
+
+        argv[argc++] = dst;
+
+        /* Copy word and strip quotes */
+        char quote = '\0';
+
+        while ('\0' != *src && ('\0' != quote || (' ' != *src && '\t' != *src))) {
+            if ('\0' == quote && ('\'' == *src || '"' == *src)) {
+                quote = *src++;
+            } else if ('\0' != quote && quote == *src) {
+                quote = '\0';
+                src++;
+            } else {
+                *dst++ = *src++;
+            }
+        }
+
+        if ('\0' != *src) src++;
+
+        *dst++ = '\0';
+    }
+
+    argv[argc] = NULL;
+
+    return argc;
+}
+
+/**
+ * Destroy command executor
+ *
+ * @param[inout]  exec  A #TjsExec; might be NULL
+ **/
+
+void tjs_exec_destroy(TjsExec *exec) {
+    if (NULL != exec) {
+        for (int i = 0; i < tjs_registry_size(exec->entries); i++) {
+            TjsExecEntry *entry = (TjsExecEntry *)tjs_registry_get(
+                exec->entries, i);
+
+            if (NULL != entry) {
+                free(entry->line);
+                free(entry->output);
+                free(entry);
+            }
+        }
+
+        tjs_registry_destroy(exec->entries);
+
+        free(exec->queue);
+        free(exec);
+    }
+}
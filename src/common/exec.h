@@ -0,0 +1,72 @@
+/**
+ * @package TouchJS
+ *
+ * @file Command executor header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_EXEC_H
+#define TJS_EXEC_H 1
+
+/* Includes */
+#include <stddef.h>
+
+/* Flags */
+#define TJS_EXEC_FLAG_DIRECT (1 << 0) ///< Exec argv without shell
+
+/* Defines */
+#define TJS_EXEC_LIMIT 8        ///< Default max concurrent children
+#define TJS_EXEC_MAX_ENTRIES 256
+#define TJS_EXEC_MAX_ARGS 64
+
+/* Types */
+typedef struct tjs_exec_entry_t {
+    unsigned long hash;
+    int flags;
+    char *line;
+
+    unsigned long owner; ///< Exec id of the command filling the entry
+    double stamp;        ///< Completion time; 0 while in flight
+
+    char *output;
+    size_t len;
+    int status;
+} TjsExecEntry;
+
+typedef struct tjs_exec_t {
+    int limit; ///< Max concurrent children; 0 is unlimited
+
+    struct tjs_registry_t *entries; ///< Hash -> #TjsExecEntry
+
+    /* Waiting for a free slot */
+    int nqueued, capacity, head;
+    void **queue;
+
+    /* Stats */
+    struct {
+        unsigned long hits, misses, shared, expired, queued;
+    } stats;
+} TjsExec;
+
+/* Methods */
+TjsExec *tjs_exec_new(int limit);
+TjsExecEntry *tjs_exec_lookup(TjsExec *exec, const char *line, int flags,
+    double ttl, double now);
+TjsExecEntry *tjs_exec_begin(TjsExec *exec, const char *line, int flags,
+    unsigned long owner);
+void tjs_exec_end(TjsExec *exec, TjsExecEntry *entry, const char *output,
+    size_t len, int status, double now);
+void tjs_exec_abort(TjsExec *exec, TjsExecEntry *entry);
+
+void tjs_exec_enqueue(TjsExec *exec, void *item);
+void *tjs_exec_dequeue(TjsExec *exec);
+int tjs_exec_remove(TjsExec *exec, void *item);
+
+int tjs_exec_split(char *line, char **argv, int max);
+void tjs_exec_destroy(TjsExec *exec);
+
+#endif /* TJS_EXEC_H */
@@ -0,0 +1,90 @@
+/**
+ * @package TouchJS
+ *
+ * @file Idle gc functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include "../touchjs.h"
+
+#include "gc.h"
+#include "clock.h"
+
+/**
+ * Create new idle gc scheduler
+ *
+ * @param[in]  idle  Quiet time in ms before collecting
+ *
+ * @return A new #TjsGc
+ **/
+
+TjsGc *tjs_gc_new(double idle) {
+    TjsGc *gc = (TjsGc *)calloc(1, sizeof(TjsGc));
+
+    gc->idle = idle;
+    gc->active = tjs_clock_now();
+    gc->pending = 1; ///< Collect garbage of initial script run
+
+    return gc;
+}
+
+/**
+ * Note activity; postpones next run
+ *
+ * @param[inout]  gc  A #TjsGc; might be NULL
+ **/
+
+void tjs_gc_activity(TjsGc *gc) {
+    if (NULL != gc) {
+        gc->active = tjs_clock_now();
+        gc->pending = 1;
+    }
+}
+
+/**
+ * Run gc when idle long enough; once per idle period
+ *
+ * @param[inout]  gc      A #TjsGc; might be NULL
+ * @param[inout]  heaps   Array of #duk_context to collect
+ * @param[in]     nheaps  Number of heaps
+ *
+ * @return Either 1 when collected; otherwise 0
+ **/
+
+int tjs_gc_poll(TjsGc *gc, duk_context **heaps, int nheaps) {
+    if (NULL == gc || !gc->pending) return 0;
+
+    double start = tjs_clock_now();
+
+    if (start - gc->active < gc->idle) return 0;
+
+    for (int i = 0; i < nheaps; i++) {
+        duk_gc(heaps[i], 0);
+    }
+
+    gc->pending = 0;
+    gc->stats.runs++;
+    gc->stats.last = tjs_clock_now() - start;
+    gc->stats.total += gc->stats.last;
+
+    TJS_LOG_DEBUG("Idle gc: runs=%lu, time=%.3fms",
+        gc->stats.runs, gc->stats.last);
+
+    return 1;
+}
+
+/**
+ * Destroy idle gc scheduler
+ *
+ * @param[inout]  gc  A #TjsGc
+ **/
+
+void tjs_gc_destroy(TjsGc *gc) {
+    if (NULL != gc) {
+        free(gc);
+    }
+}
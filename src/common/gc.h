@@ -0,0 +1,37 @@
+/**
+ * @package TouchJS
+ *
+ * @file Idle gc header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_GC_H
+#define TJS_GC_H 1
+
+/* Includes */
+#include "../libs/duktape/duktape.h"
+
+/* Types */
+typedef struct tjs_gc_t {
+    double idle;    ///< Quiet time in ms before collecting
+    double active;  ///< Time of last activity
+    int pending;    ///< Activity since last run
+
+    /* Stats */
+    struct {
+        unsigned long runs;
+        double total, last; ///< Time spent in ms
+    } stats;
+} TjsGc;
+
+/* Methods */
+TjsGc *tjs_gc_new(double idle);
+void tjs_gc_activity(TjsGc *gc);
+int tjs_gc_poll(TjsGc *gc, duk_context **heaps, int nheaps);
+void tjs_gc_destroy(TjsGc *gc);
+
+#endif /* TJS_GC_H */
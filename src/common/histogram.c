@@ -0,0 +1,197 @@
+/**
+ * @package TouchJS
+ *
+ * @file Histogram functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "histogram.h"
+
+/* Defines */
+#define TJS_HISTOGRAM_LINEAR (1 << TJS_HISTOGRAM_SUBBITS)
+#define TJS_HISTOGRAM_HALF (1 << (TJS_HISTOGRAM_SUBBITS - 1))
+
+/**
+ * Helper to get index of most significant bit
+ *
+ * @param[in]  value  Value to check; must be non-zero
+ *
+ * @return Index of the bit
+ **/
+
+static int tjs_histogram_msb(uint64_t value) {
+    int msb = 0;
+
+    while (value >>= 1) msb++;
+
+    return msb;
+}
+
+/**
+ * Helper to map value to bucket
+ *
+ * Values below #TJS_HISTOGRAM_LINEAR are exact, above each power of two
+ * is split into #TJS_HISTOGRAM_HALF linear sub-buckets
+ *
+ * @param[in]  value  Value to map
+ *
+ * @return Index of the bucket
+ **/
+
+static int tjs_histogram_index(uint64_t value) {
+    if (TJS_HISTOGRAM_LINEAR > value) return (int)value;
+
+    int msb = tjs_histogram_msb(value);
+    int shift = msb - (TJS_HISTOGRAM_SUBBITS - 1);
+
+    return TJS_HISTOGRAM_LINEAR +
+        (msb - TJS_HISTOGRAM_SUBBITS) * TJS_HISTOGRAM_HALF +
+        (int)((value >> shift) - TJS_HISTOGRAM_HALF);
+}
+
+/**
+ * Helper to map bucket to highest value it holds
+ *
+ * @param[in]  idx  Index of the bucket
+ *
+ * @return Highest value of the bucket
+ **/
+
+static uint64_t tjs_histogram_value(int idx) {
+    if (TJS_HISTOGRAM_LINEAR > idx) return (uint64_t)idx;
+
+    int msb = (idx - TJS_HISTOGRAM_LINEAR) / TJS_HISTOGRAM_HALF +
+        TJS_HISTOGRAM_SUBBITS;
+    int shift = msb - (TJS_HISTOGRAM_SUBBITS - 1);
+    uint64_t mantissa = (idx - TJS_HISTOGRAM_LINEAR) % TJS_HISTOGRAM_HALF +
+        TJS_HISTOGRAM_HALF;
+
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ * Create new histogram
+ *
+ * @return A new #TjsHistogram
+ **/
+
+TjsHistogram *tjs_histogram_new(void) {
+    TjsHistogram *histogram = (TjsHistogram *)calloc(1, sizeof(TjsHistogram));
+
+    tjs_histogram_reset(histogram);
+
+    return histogram;
+}
+
+/**
+ * Record value
+ *
+ * @param[inout]  histogram  A #TjsHistogram
+ * @param[in]     value      Value to record
+ **/
+
+void tjs_histogram_record(TjsHistogram *histogram, uint64_t value) {
+    histogram->buckets[tjs_histogram_index(value)]++;
+
+    histogram->count++;
+    histogram->sum += value;
+
+    if (value < histogram->min) histogram->min = value;
+    if (value > histogram->max) histogram->max = value;
+}
+
+/**
+ * Get value at percentile
+ *
+ * @param[inout]  histogram   A #TjsHistogram
+ * @param[in]     percentile  Percentile between 0 and 100
+ *
+ * @return Highest value of the bucket containing the percentile
+ **/
+
+uint64_t tjs_histogram_percentile(TjsHistogram *histogram, double percentile) {
+    if (0 == histogram->count) return 0;
+
+    /* Rank of the wanted value, starting at 1 */
+    uint64_t rank = (uint64_t)(percentile / 100.0 * histogram->count + 0.5);
+    uint64_t seen = 0;
+
+    if (0 == rank) rank = 1;
+
+    for (int i = 0; i < TJS_HISTOGRAM_NBUCKETS; i++) {
+        seen += histogram->buckets[i];
+
+        if (seen >= rank) {
+            uint64_t value = tjs_histogram_value(i);
+
+            /* Buckets are coarser than the exact extremes */
+            return (value > histogram->max ? histogram->max : value);
+        }
+    }
+
+    return histogram->max;
+}
+
+/**
+ * Get mean of recorded values
+ *
+ * @param[inout]  histogram  A #TjsHistogram
+ *
+ * @return Mean value
+ **/
+
+double tjs_histogram_mean(TjsHistogram *histogram) {
+    return (0 < histogram->count ? histogram->sum / histogram->count : 0);
+}
+
+/**
+ * Write summary as JSON object
+ *
+ * @param[inout]  histogram  A #TjsHistogram
+ * @param[inout]  fp         File to write to
+ **/
+
+void tjs_histogram_json(TjsHistogram *histogram, FILE *fp) {
+    fprintf(fp, "{\"count\": %llu, \"min\": %llu, \"mean\": %.1f, " \
+        "\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, " \
+        "\"max\": %llu}",
+        (unsigned long long)histogram->count,
+        (unsigned long long)(0 < histogram->count ? histogram->min : 0),
+        tjs_histogram_mean(histogram),
+        (unsigned long long)tjs_histogram_percentile(histogram, 50.0),
+        (unsigned long long)tjs_histogram_percentile(histogram, 90.0),
+        (unsigned long long)tjs_histogram_percentile(histogram, 99.0),
+        (unsigned long long)tjs_histogram_percentile(histogram, 99.9),
+        (unsigned long long)histogram->max);
+}
+
+/**
+ * Reset histogram
+ *
+ * @param[inout]  histogram  A #TjsHistogram
+ **/
+
+void tjs_histogram_reset(TjsHistogram *histogram) {
+    memset(histogram, 0, sizeof(TjsHistogram));
+
+    histogram->min = UINT64_MAX;
+}
+
+/**
+ * Destroy histogram
+ *
+ * @param[inout]  histogram  A #TjsHistogram
+ **/
+
+void tjs_histogram_destroy(TjsHistogram *histogram) {
+    if (NULL != histogram) {
+        free(histogram);
+    }
+}
@@ -0,0 +1,42 @@
+/**
+ * @package TouchJS
+ *
+ * @file Histogram header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_HISTOGRAM_H
+#define TJS_HISTOGRAM_H 1
+
+/* Includes */
+#include <stdio.h>
+#include <stdint.h>
+
+/* Defines */
+#define TJS_HISTOGRAM_SUBBITS 7 ///< 128 sub-buckets; <1% relative error
+#define TJS_HISTOGRAM_NBUCKETS \
+    ((1 << TJS_HISTOGRAM_SUBBITS) + \
+        (64 - TJS_HISTOGRAM_SUBBITS) * (1 << (TJS_HISTOGRAM_SUBBITS - 1)))
+
+/* Types */
+typedef struct tjs_histogram_t {
+    uint64_t count, min, max;
+    double sum;
+
+    uint64_t buckets[TJS_HISTOGRAM_NBUCKETS];
+} TjsHistogram;
+
+/* Methods */
+TjsHistogram *tjs_histogram_new(void);
+void tjs_histogram_record(TjsHistogram *histogram, uint64_t value);
+uint64_t tjs_histogram_percentile(TjsHistogram *histogram, double percentile);
+double tjs_histogram_mean(TjsHistogram *histogram);
+void tjs_histogram_json(TjsHistogram *histogram, FILE *fp);
+void tjs_histogram_reset(TjsHistogram *histogram);
+void tjs_histogram_destroy(TjsHistogram *histogram);
+
+#endif /* TJS_HISTOGRAM_H */
@@ -0,0 +1,199 @@
+/**
+ * @package TouchJS
+ *
+ * @file Loader functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../touchjs.h"
+
+#include "loader.h"
+#include "bytecode.h"
+#include "clock.h"
+
+/* Defines */
+#define TJS_LOADER_SUFFIX ".js"
+
+/**
+ * Map file into memory
+ *
+ * @param[in]   filename  Name of the file
+ * @param[out]  mapping   A #TjsMapping
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+int tjs_loader_map(const char *filename, TjsMapping *mapping) {
+    struct stat st;
+    int ret = -1;
+
+    mapping->data = NULL;
+    mapping->len = 0;
+
+    int fd = open(filename, O_RDONLY);
+
+    if (-1 == fd) return -1;
+
+    if (0 == fstat(fd, &st) && S_ISREG(st.st_mode)) {
+        /* Zero-length mappings aren't allowed */
+        if (0 == st.st_size) {
+            mapping->data = "";
+
+            ret = 0;
+        } else {
+            void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (MAP_FAILED != data) {
+                mapping->data = (const char *)data;
+                mapping->len = st.st_size;
+
+                ret = 0;
+            }
+        }
+    }
+
+    close(fd); ///< Mapping stays valid
+
+    return ret;
+}
+
+/**
+ * Unmap file
+ *
+ * @param[inout]  mapping  A #TjsMapping
+ **/
+
+void tjs_loader_unmap(TjsMapping *mapping) {
+    if (NULL != mapping && 0 < mapping->len) {
+        munmap((void *)mapping->data, mapping->len);
+    }
+
+    mapping->data = NULL;
+    mapping->len = 0;
+}
+
+/**
+ * Helper to load and eval a single file
+ *
+ * @param[inout]  ctx       A #duk_context
+ * @param[in]     filename  Name of the file
+ * @param[in]     flags     Bytecode flags
+ * @param[inout]  stats     A #TjsLoaderStats
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+static int tjs_loader_eval_file(duk_context *ctx, const char *filename,
+    int flags, TjsLoaderStats *stats)
+{
+    TjsMapping mapping;
+    TjsBytecodeStats bcstats;
+
+    TJS_LOG_INFO("Loading file %s", filename);
+
+    double start = tjs_clock_now();
+
+    if (0 != tjs_loader_map(filename, &mapping)) {
+        TJS_LOG_ERROR("Failed to open file %s", filename);
+
+        stats->nfailed++;
+
+        return -1;
+    }
+
+    double load = tjs_clock_now() - start;
+    size_t len = mapping.len;
+
+    /* Hand mapping straight to duktape */
+    int ret = tjs_bytecode_eval(ctx, filename,
+        mapping.data, len, flags, &bcstats);
+
+    tjs_loader_unmap(&mapping);
+
+    if (0 == ret) {
+        TJS_LOG_INFO("Loaded file %s: size=%zu, load=%.3fms, " \
+            "compile=%.3fms, exec=%.3fms, cache=%s",
+            filename, len, load, bcstats.compile, bcstats.exec,
+            (0 < (bcstats.flags & TJS_BYTECODE_HIT) ? "hit" : "miss"));
+
+        stats->nfiles++;
+        stats->bytes += len;
+        stats->load += load;
+        stats->compile += bcstats.compile;
+        stats->exec += bcstats.exec;
+
+        if (0 < (bcstats.flags & TJS_BYTECODE_HIT)) stats->nhits++;
+    } else {
+        stats->nfailed++;
+    }
+
+    return ret;
+}
+
+/**
+ * Helper to filter script files
+ *
+ * @param[in]  entry  A #dirent
+ *
+ * @return Either 1 for scripts; otherwise 0
+ **/
+
+static int tjs_loader_filter(const struct dirent *entry) {
+    size_t len = strlen(entry->d_name);
+    size_t suffix = strlen(TJS_LOADER_SUFFIX);
+
+    return ('.' != entry->d_name[0] && len > suffix &&
+        0 == strcmp(entry->d_name + len - suffix, TJS_LOADER_SUFFIX));
+}
+
+/**
+ * Load and eval file or all scripts of a directory in sorted order
+ *
+ * @param[inout]  ctx    A #duk_context
+ * @param[in]     path   Name of the file or directory
+ * @param[in]     flags  Bytecode flags
+ * @param[inout]  stats  A #TjsLoaderStats
+ *
+ * @return Number of failed files
+ **/
+
+int tjs_loader_eval(duk_context *ctx, const char *path, int flags,
+    TjsLoaderStats *stats)
+{
+    struct stat st;
+    int nfailed = stats->nfailed;
+
+    if (0 == stat(path, &st) && S_ISDIR(st.st_mode)) {
+        struct dirent **entries = NULL;
+
+        int nentries = scandir(path, &entries, tjs_loader_filter, alphasort);
+
+        for (int i = 0; i < nentries; i++) {
+            char filename[PATH_MAX];
+
+            snprintf(filename, sizeof(filename), "%s/%s",
+                path, entries[i]->d_name);
+
+            tjs_loader_eval_file(ctx, filename, flags, stats);
+
+            free(entries[i]);
+        }
+
+        free(entries);
+    } else {
+        tjs_loader_eval_file(ctx, path, flags, stats);
+    }
+
+    return stats->nfailed - nfailed;
+}
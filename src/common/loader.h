@@ -0,0 +1,37 @@
+/**
+ * @package TouchJS
+ *
+ * @file Loader header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_LOADER_H
+#define TJS_LOADER_H 1
+
+/* Includes */
+#include "../libs/duktape/duktape.h"
+
+/* Types */
+typedef struct tjs_mapping_t {
+    const char *data;
+    size_t len;
+} TjsMapping;
+
+typedef struct tjs_loader_stats_t {
+    int nfiles, nfailed, nhits;
+    size_t bytes;
+
+    double load, compile, exec; ///< Sums in ms
+} TjsLoaderStats;
+
+/* Methods */
+int tjs_loader_map(const char *filename, TjsMapping *mapping);
+void tjs_loader_unmap(TjsMapping *mapping);
+int tjs_loader_eval(duk_context *ctx, const char *path, int flags,
+    TjsLoaderStats *stats);
+
+#endif /* TJS_LOADER_H */
@@ -0,0 +1,415 @@
+/**
+ * @package TouchJS
+ *
+ * @file Async logger functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+/* Helpers */
+#define TJS_LOGGER_ALIGN(N) (((N) + 7) & ~(size_t)7)
+#define TJS_LOGGER_BATCH (64 * 1024) ///< Write out once batch is this big
+
+/* Types */
+typedef struct tjs_logger_buf_t {
+    char *data;
+    size_t len, capacity;
+} TjsLoggerBuf;
+
+/**
+ * Make room in output buffer
+ *
+ * @param[inout]  buf   A #TjsLoggerBuf
+ * @param[in]     need  Number of bytes to append
+ **/
+
+static void tjs_logger_reserve(TjsLoggerBuf *buf, size_t need) {
+    if (buf->len + need > buf->capacity) {
+        while (buf->len + need > buf->capacity) buf->capacity *= 2;
+
+        buf->data = (char *)realloc(buf->data, buf->capacity);
+    }
+}
+
+/**
+ * Append string as escaped JSON string
+ *
+ * @param[inout]  buf  A #TjsLoggerBuf
+ * @param[in]     str  String to append
+ * @param[in]     len  Length of string
+ **/
+
+static void tjs_logger_escape(TjsLoggerBuf *buf, const char *str, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+
+    tjs_logger_reserve(buf, len * 6 + 2); ///< Worst case is \u00XX
+
+    char *out = buf->data + buf->len;
+
+    *out++ = '"';
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)str[i];
+
+        switch (c) {
+            case '"':  *out++ = '\\'; *out++ = '"';  break;
+            case '\\': *out++ = '\\'; *out++ = '\\'; break;
+            case '\n': *out++ = '\\'; *out++ = 'n';  break;
+            case '\r': *out++ = '\\'; *out++ = 'r';  break;
+            case '\t': *out++ = '\\'; *out++ = 't';  break;
+            default:
+                if (0x20 > c) {
+                    memcpy(out, "\\u00", 4);
+                    out[4] = hex[c >> 4];
+                    out[5] = hex[c & 0xf];
+                    out += 6;
+                } else {
+                    *out++ = (char)c;
+                }
+        }
+    }
+
+    *out++ = '"';
+
+    buf->len = out - buf->data;
+}
+
+/**
+ * Format record as JSON line
+ *
+ * @param[inout]  buf     A #TjsLoggerBuf
+ * @param[in]     record  A #TjsLoggerRecord
+ **/
+
+static void tjs_logger_format(TjsLoggerBuf *buf, const TjsLoggerRecord *record) {
+    size_t len = record->len - sizeof(TjsLoggerRecord);
+    const char *msg = (const char *)(record + 1);
+
+    /* Message is padded with zeros */
+    while (0 < len && '\0' == msg[len - 1]) len--;
+
+    tjs_logger_reserve(buf, 128);
+
+    buf->len += snprintf(buf->data + buf->len, buf->capacity - buf->len,
+        "{\"ts\":%.6f,\"level\":\"%s\",\"func\":\"%s\",\"line\":%d,\"msg\":",
+        record->ts, record->level, record->func, record->line);
+
+    tjs_logger_escape(buf, msg, len);
+
+    tjs_logger_reserve(buf, 2);
+
+    buf->data[buf->len++] = '}';
+    buf->data[buf->len++] = '\n';
+}
+
+/**
+ * Write out buffer
+ *
+ * @param[inout]  logger  A #TjsLogger
+ * @param[inout]  buf     A #TjsLoggerBuf
+ **/
+
+static void tjs_logger_flush(TjsLogger *logger, TjsLoggerBuf *buf) {
+    size_t off = 0;
+
+    while (off < buf->len) {
+        ssize_t n = write(logger->fd, buf->data + off, buf->len - off);
+
+        if (0 >= n) break; ///< Nothing we can do about it
+
+        off += n;
+    }
+
+    logger->wstats.writes++;
+    logger->wstats.bytes += buf->len;
+    buf->len = 0;
+}
+
+/**
+ * Helper to wake up writer if it waits for records
+ *
+ * @param[inout]  logger  A #TjsLogger
+ **/
+
+static void tjs_logger_wake(TjsLogger *logger) {
+    /* Pairs with the store of sleeping and load of head in the writer */
+    if (atomic_load(&logger->sleeping)) {
+        pthread_mutex_lock(&logger->mutex);
+        pthread_cond_signal(&logger->cond);
+        pthread_mutex_unlock(&logger->mutex);
+    }
+}
+
+/**
+ * Helper to block writer until records arrive or it is stopped
+ *
+ * @param[inout]  logger  A #TjsLogger
+ * @param[in]     tail    Position of writer
+ **/
+
+static void tjs_logger_wait(TjsLogger *logger, size_t tail) {
+    pthread_mutex_lock(&logger->mutex);
+
+    atomic_store(&logger->sleeping, 1);
+
+    /* Re-check after announcing, so a producer can't slip past unseen */
+    while (tail == atomic_load(&logger->head) &&
+            atomic_load(&logger->running))
+    {
+        pthread_cond_wait(&logger->cond, &logger->mutex);
+    }
+
+    atomic_store(&logger->sleeping, 0);
+
+    logger->wstats.wakeups++;
+
+    pthread_mutex_unlock(&logger->mutex);
+}
+
+/**
+ * Writer thread; drains ring until stopped and empty
+ *
+ * Bursts are picked up by polling with exponential backoff, so busy
+ * producers never pay for a signal; once idle the writer blocks
+ *
+ * @param[inout]  arg  A #TjsLogger
+ *
+ * @return Always NULL
+ **/
+
+static void *tjs_logger_run(void *arg) {
+    TjsLogger *logger = (TjsLogger *)arg;
+    TjsLoggerBuf buf = { NULL, 0, TJS_LOGGER_BATCH * 2 };
+
+    buf.data = (char *)malloc(buf.capacity);
+
+    size_t tail = atomic_load_explicit(&logger->tail, memory_order_relaxed);
+    int idle = 0;
+
+    while (1) {
+        size_t head = atomic_load_explicit(&logger->head, memory_order_acquire);
+
+        if (tail == head) {
+            if (0 < buf.len) tjs_logger_flush(logger, &buf);
+
+            if (!atomic_load_explicit(&logger->running, memory_order_acquire) &&
+                    head == atomic_load_explicit(&logger->head,
+                        memory_order_acquire))
+            {
+                break;
+            }
+
+            if (TJS_LOGGER_BACKOFF_STEPS > idle) {
+                long ms = (long)TJS_LOGGER_BACKOFF << idle++;
+                struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+
+                nanosleep(&ts, NULL);
+
+                logger->wstats.wakeups++;
+            } else {
+                tjs_logger_wait(logger, tail);
+            }
+
+            continue;
+        }
+
+        idle = 0;
+
+        while (tail != head) {
+            size_t off = tail & (logger->capacity - 1);
+            size_t contig = logger->capacity - off;
+
+            TjsLoggerRecord *record = (TjsLoggerRecord *)(logger->ring + off);
+
+            /* Skip unused end of ring */
+            if (sizeof(TjsLoggerRecord) > contig || 0 == record->len) {
+                tail += contig;
+
+                continue;
+            }
+
+            tjs_logger_format(&buf, record);
+
+            tail += record->len;
+
+            logger->wstats.lines++;
+
+            if (TJS_LOGGER_BATCH <= buf.len) tjs_logger_flush(logger, &buf);
+        }
+
+        /* Hand space back to producer */
+        atomic_store_explicit(&logger->tail, tail, memory_order_release);
+    }
+
+    free(buf.data);
+
+    return NULL;
+}
+
+/**
+ * Create new logger and start its writer
+ *
+ * @param[in]  path      File to append to; - for stderr
+ * @param[in]  capacity  Size of ring in bytes; rounded up to power of two
+ *
+ * @return Either a new #TjsLogger on success; otherwise NULL
+ **/
+
+TjsLogger *tjs_logger_new(const char *path, size_t capacity) {
+    int fd = (0 == strcmp(path, "-") ? STDERR_FILENO :
+        open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644));
+
+    if (0 > fd) return NULL;
+
+    TjsLogger *logger = (TjsLogger *)calloc(1, sizeof(TjsLogger));
+
+    logger->fd = fd;
+    logger->capacity = 4096;
+
+    while (logger->capacity < capacity) logger->capacity *= 2;
+
+    logger->ring = (char *)calloc(1, logger->capacity);
+
+    atomic_init(&logger->head, 0);
+    atomic_init(&logger->tail, 0);
+    atomic_init(&logger->running, 1);
+    atomic_init(&logger->sleeping, 0);
+
+    pthread_mutex_init(&logger->mutex, NULL);
+    pthread_cond_init(&logger->cond, NULL);
+
+    if (0 != pthread_create(&logger->thread, NULL, tjs_logger_run, logger)) {
+        if (STDERR_FILENO != fd) close(fd);
+
+        pthread_mutex_destroy(&logger->mutex);
+        pthread_cond_destroy(&logger->cond);
+
+        free(logger->ring);
+        free(logger);
+
+        return NULL;
+    }
+
+    return logger;
+}
+
+/**
+ * Push message to ring; never blocks, drops when the writer fell behind
+ *
+ * @param[inout]  logger  A #TjsLogger
+ * @param[in]     level   Static name of level
+ * @param[in]     func    Static name of function
+ * @param[in]     line    Line number
+ * @param[in]     msg     Message
+ * @param[in]     len     Length of message
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+int tjs_logger_push(TjsLogger *logger, const char *level, const char *func,
+        int line, const char *msg, size_t len)
+{
+    size_t need = TJS_LOGGER_ALIGN(sizeof(TjsLoggerRecord) + len);
+
+    if (need > logger->capacity / 2) {
+        logger->stats.oversized++;
+
+        return -1;
+    }
+
+    size_t head = atomic_load_explicit(&logger->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&logger->tail, memory_order_acquire);
+
+    size_t off = head & (logger->capacity - 1);
+    size_t contig = logger->capacity - off;
+    size_t skip = (contig < need ? contig : 0); ///< Record must not wrap
+
+    if (logger->capacity - (head - tail) < skip + need) {
+        logger->stats.dropped++;
+
+        return -1;
+    }
+
+    /* Mark unused end of ring */
+    if (0 < skip) {
+        if (sizeof(TjsLoggerRecord) <= skip) {
+            ((TjsLoggerRecord *)(logger->ring + off))->len = 0;
+        }
+
+        head += skip;
+        off = 0;
+    }
+
+    TjsLoggerRecord *record = (TjsLoggerRecord *)(logger->ring + off);
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    record->len = (uint32_t)need;
+    record->line = line;
+    record->ts = ts.tv_sec + ts.tv_nsec / 1e9;
+    record->level = level;
+    record->func = func;
+
+    char *data = (char *)(record + 1);
+
+    memcpy(data, msg, len);
+    memset(data + len, 0, need - sizeof(TjsLoggerRecord) - len);
+
+    atomic_store(&logger->head, head + need);
+
+    logger->stats.records++;
+    logger->stats.bytes += len;
+
+    tjs_logger_wake(logger);
+
+    return 0;
+}
+
+/**
+ * Stop writer after it drained the ring
+ *
+ * @param[inout]  logger  A #TjsLogger
+ **/
+
+void tjs_logger_stop(TjsLogger *logger) {
+    if (atomic_exchange(&logger->running, 0)) {
+        pthread_mutex_lock(&logger->mutex);
+        pthread_cond_signal(&logger->cond);
+        pthread_mutex_unlock(&logger->mutex);
+
+        pthread_join(logger->thread, NULL);
+    }
+}
+
+/**
+ * Destroy logger; stops writer if still running
+ *
+ * @param[inout]  logger  A #TjsLogger
+ **/
+
+void tjs_logger_destroy(TjsLogger *logger) {
+    if (NULL != logger) {
+        tjs_logger_stop(logger);
+
+        if (STDERR_FILENO != logger->fd) close(logger->fd);
+
+        pthread_mutex_destroy(&logger->mutex);
+        pthread_cond_destroy(&logger->cond);
+
+        free(logger->ring);
+        free(logger);
+    }
+}
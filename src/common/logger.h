@@ -0,0 +1,71 @@
+/**
+ * @package TouchJS
+ *
+ * @file Async logger header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_LOGGER_H
+#define TJS_LOGGER_H 1
+
+/* Includes */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/* Defaults */
+#define TJS_LOGGER_SIZE (4 << 20) ///< Default ring size in bytes; power of two
+#define TJS_LOGGER_BACKOFF 1      ///< First sleep of idle writer in ms; doubles
+#define TJS_LOGGER_BACKOFF_STEPS 4 ///< Sleeps before the writer blocks
+
+/* Types */
+typedef struct tjs_logger_record_t {
+    uint32_t len;     ///< Size of record including message; 0 marks wrap
+    int32_t line;
+    double ts;        ///< Wall clock in s
+    const char *level; ///< Static level name
+    const char *func;  ///< Static function name
+} TjsLoggerRecord;
+
+typedef struct tjs_logger_t {
+    int fd;
+
+    size_t capacity; ///< Size of ring in bytes
+    char *ring;
+
+    /* Single producer, single consumer */
+    _Atomic size_t head; ///< Advanced by producer
+    _Atomic size_t tail; ///< Advanced by writer
+    _Atomic int running;
+    _Atomic int sleeping; ///< Writer waits for records; producer signals
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    /* Stats; producer side */
+    struct {
+        unsigned long records, dropped, oversized;
+        size_t bytes;
+    } stats;
+
+    /* Stats; writer side, read after join */
+    struct {
+        unsigned long lines, writes, wakeups;
+        size_t bytes;
+    } wstats;
+} TjsLogger;
+
+/* Methods */
+TjsLogger *tjs_logger_new(const char *path, size_t capacity);
+int tjs_logger_push(TjsLogger *logger, const char *level, const char *func,
+    int line, const char *msg, size_t len);
+void tjs_logger_stop(TjsLogger *logger);
+void tjs_logger_destroy(TjsLogger *logger);
+
+#endif /* TJS_LOGGER_H */
@@ -0,0 +1,407 @@
+/**
+ * @package TouchJS
+ *
+ * @file Process functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "proc.h"
+
+/* Globals */
+extern char **environ;
+
+/**
+ * Helper to keep proc alive while callbacks run
+ *
+ * @param[inout]  proc  A #TjsProc
+ **/
+
+static void tjs_procs_hold(TjsProc *proc) {
+    proc->holds++;
+}
+
+/**
+ * Helper to let go of proc; frees it when it was removed meanwhile
+ *
+ * @param[inout]  proc  A #TjsProc
+ *
+ * @return Either 1 when proc is still valid; otherwise 0
+ **/
+
+static int tjs_procs_release(TjsProc *proc) {
+    if (0 == --(proc->holds) && 0 < (proc->flags & TJS_PROC_FLAG_REMOVED)) {
+        free(proc);
+
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Helper to find index of proc
+ *
+ * @param[inout]  procs  A #TjsProcs
+ * @param[in]     proc   A #TjsProc
+ *
+ * @return Either index of proc; otherwise -1
+ **/
+
+static int tjs_procs_index(TjsProcs *procs, TjsProc *proc) {
+    for (int i = 0; i < procs->nprocs; i++) {
+        if (procs->procs[i] == proc) return i;
+    }
+
+    return -1;
+}
+
+/**
+ * Helper to read available output; stops when the pipe would block
+ *
+ * The data handler may finish this or any other proc, so the proc is
+ * held until the loop is done
+ *
+ * @param[inout]  procs  A #TjsProcs
+ * @param[inout]  proc   A #TjsProc
+ *
+ * @return Either 1 when proc is still valid; otherwise 0
+ **/
+
+static int tjs_procs_read(TjsProcs *procs, TjsProc *proc) {
+    char buf[TJS_PROC_CHUNK];
+
+    tjs_procs_hold(proc);
+
+    while (-1 != proc->fd) {
+        ssize_t len = read(proc->fd, buf, sizeof(buf));
+
+        if (0 < len) {
+            procs->stats.reads++;
+            procs->stats.bytes += len;
+
+            if (NULL != procs->data) {
+                procs->data(proc, buf, len, procs->arg);
+            }
+        } else if (0 == len || (EINTR != errno && EAGAIN != errno)) {
+            if (NULL != procs->watch) {
+                procs->watch(proc->fd, 0, procs->arg);
+            }
+
+            close(proc->fd);
+
+            proc->fd = -1;
+            proc->flags |= TJS_PROC_FLAG_EOF;
+        } else if (EAGAIN == errno) {
+            break;
+        }
+    }
+
+    return tjs_procs_release(proc);
+}
+
+/**
+ * Helper to reap child
+ *
+ * @param[inout]  proc     A #TjsProc
+ * @param[in]     options  Options for waitpid
+ *
+ * @return Either 1 when reaped; otherwise 0
+ **/
+
+static int tjs_procs_reap(TjsProc *proc, int options) {
+    int status = 0;
+    pid_t pid;
+
+    while (-1 == (pid = waitpid(proc->pid, &status, options)) && EINTR == errno);
+
+    if (pid != proc->pid) return 0;
+
+    proc->flags |= TJS_PROC_FLAG_EXITED;
+    proc->status = (WIFEXITED(status) ? WEXITSTATUS(status) :
+        128 + WTERMSIG(status));
+
+    return 1;
+}
+
+/**
+ * Helper to remove exited proc and notify; held procs are freed by
+ * their last holder
+ *
+ * @param[inout]  procs  A #TjsProcs
+ * @param[inout]  proc   A #TjsProc
+ **/
+
+static void tjs_procs_remove(TjsProcs *procs, TjsProc *proc) {
+    int idx = tjs_procs_index(procs, proc);
+
+    if (-1 == idx) return;
+
+    procs->procs[idx] = procs->procs[--(procs->nprocs)];
+    procs->stats.exited++;
+
+    proc->flags |= TJS_PROC_FLAG_REMOVED;
+
+    /* Exit handler may finish other procs and reorder the table */
+    tjs_procs_hold(proc);
+
+    if (NULL != procs->exit) {
+        procs->exit(proc, procs->arg);
+    }
+
+    tjs_procs_release(proc);
+}
+
+/**
+ * Create new process table
+ *
+ * @return A new #TjsProcs
+ **/
+
+TjsProcs *tjs_procs_new(void) {
+    TjsProcs *procs = (TjsProcs *)calloc(1, sizeof(TjsProcs));
+
+    procs->wakefd = -1;
+
+    return procs;
+}
+
+/**
+ * Spawn child with stdout connected to a non-blocking pipe
+ *
+ * @param[inout]  procs     A #TjsProcs
+ * @param[in]     argv      NULL-terminated argument vector
+ * @param[in]     userdata  Userdata of the caller
+ *
+ * @return Either new #TjsProc; otherwise NULL and errno is set
+ **/
+
+TjsProc *tjs_procs_spawn(TjsProcs *procs, char *const argv[], void *userdata) {
+    posix_spawn_file_actions_t actions;
+    int fds[2], err;
+    pid_t pid;
+
+    if (-1 == pipe(fds)) {
+        procs->stats.failed++;
+
+        return NULL;
+    }
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+
+    err = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    if (0 != err) {
+        close(fds[0]);
+
+        procs->stats.failed++;
+        errno = err;
+
+        return NULL;
+    }
+
+    /* Parent end must neither block nor leak into later children */
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+    TjsProc *proc = (TjsProc *)calloc(1, sizeof(TjsProc));
+
+    proc->id = ++(procs->lastid);
+    proc->pid = pid;
+    proc->fd = fds[0];
+    proc->status = -1;
+    proc->userdata = userdata;
+
+    if (procs->nprocs == procs->capacity) {
+        procs->capacity = (0 < procs->capacity ? procs->capacity * 2 : 8);
+        procs->procs = (TjsProc **)realloc(procs->procs,
+            procs->capacity * sizeof(TjsProc *));
+    }
+
+    procs->procs[procs->nprocs++] = proc;
+    procs->stats.spawned++;
+
+    if (NULL != procs->watch) {
+        procs->watch(proc->fd, 1, procs->arg);
+    }
+
+    return proc;
+}
+
+/**
+ * Wait for output of all procs with one poll and dispatch it
+ *
+ * @param[inout]  procs    A #TjsProcs
+ * @param[in]     timeout  Timeout in ms; -1 blocks, 0 returns immediately
+ *
+ * @return Number of procs with activity; includes a readable wake fd
+ **/
+
+int tjs_procs_poll(TjsProcs *procs, int timeout) {
+    struct pollfd fds[procs->nprocs + 1];
+    int nfds = 0, nready = 0;
+
+    for (int i = 0; i < procs->nprocs; i++) {
+        if (-1 != procs->procs[i]->fd) {
+            fds[nfds].fd = procs->procs[i]->fd;
+            fds[nfds].events = POLLIN;
+            fds[nfds].revents = 0;
+            nfds++;
+        } else if (0 > timeout || TJS_PROC_REAP_INTERVAL < timeout) {
+            timeout = TJS_PROC_REAP_INTERVAL; ///< Closed output but still running
+        }
+    }
+
+    /* Caller drains it; never matches a proc below */
+    if (-1 != procs->wakefd) {
+        fds[nfds].fd = procs->wakefd;
+        fds[nfds].events = POLLIN;
+        fds[nfds].revents = 0;
+        nfds++;
+    }
+
+    procs->stats.polls++;
+
+    if (0 < nfds || 0 < timeout) {
+        nready = poll(fds, nfds, timeout);
+
+        if (0 > nready) nready = 0;
+    }
+
+    /* Read output; callbacks may spawn or finish procs, so match by fd */
+    for (int i = 0; i < nfds && 0 < nready; i++) {
+        if (0 == (fds[i].revents & (POLLIN|POLLHUP|POLLERR))) continue;
+
+        for (int j = 0; j < procs->nprocs; j++) {
+            if (procs->procs[j]->fd == fds[i].fd) {
+                tjs_procs_read(procs, procs->procs[j]);
+
+                break;
+            }
+        }
+    }
+
+    /* Reap children without output; handlers may reorder the table */
+    for (int i = procs->nprocs - 1; 0 <= i; i--) {
+        if (i >= procs->nprocs) continue;
+
+        TjsProc *proc = procs->procs[i];
+
+        if (0 < (proc->flags & TJS_PROC_FLAG_EOF) && tjs_procs_reap(proc, WNOHANG)) {
+            tjs_procs_remove(procs, proc);
+        }
+    }
+
+    return nready;
+}
+
+/**
+ * Block until proc is done; drains output and reaps it
+ *
+ * Handlers may finish other procs or this one again, which then
+ * drains and reaps it right there
+ *
+ * @param[inout]  procs  A #TjsProcs
+ * @param[inout]  proc   A #TjsProc; invalid afterwards
+ **/
+
+void tjs_procs_finish(TjsProcs *procs, TjsProc *proc) {
+    if (-1 == tjs_procs_index(procs, proc)) return;
+
+    tjs_procs_hold(proc);
+
+    while (-1 != proc->fd) {
+        struct pollfd pfd = { .fd = proc->fd, .events = POLLIN };
+
+        if (0 < poll(&pfd, 1, -1)) tjs_procs_read(procs, proc);
+    }
+
+    if (0 == (proc->flags & TJS_PROC_FLAG_REMOVED)) {
+        if (0 == (proc->flags & TJS_PROC_FLAG_EXITED)) {
+            tjs_procs_reap(proc, 0);
+        }
+
+        tjs_procs_remove(procs, proc);
+    }
+
+    tjs_procs_release(proc);
+}
+
+/**
+ * Get number of running procs
+ *
+ * @param[inout]  procs  A #TjsProcs; might be NULL
+ *
+ * @return Number of procs
+ **/
+
+int tjs_procs_count(TjsProcs *procs) {
+    return (NULL != procs ? procs->nprocs : 0);
+}
+
+/**
+ * Get number of procs that closed their output but aren't reaped yet;
+ * those need polling until they exit
+ *
+ * @param[inout]  procs  A #TjsProcs; might be NULL
+ *
+ * @return Number of procs
+ **/
+
+int tjs_procs_reaping(TjsProcs *procs) {
+    int nreaping = 0;
+
+    for (int i = 0; NULL != procs && i < procs->nprocs; i++) {
+        if (-1 == procs->procs[i]->fd) nreaping++;
+    }
+
+    return nreaping;
+}
+
+/**
+ * Destroy process table; running children are terminated
+ *
+ * @param[inout]  procs  A #TjsProcs; might be NULL
+ **/
+
+void tjs_procs_destroy(TjsProcs *procs) {
+    if (NULL != procs) {
+        for (int i = 0; i < procs->nprocs; i++) {
+            TjsProc *proc = procs->procs[i];
+
+            if (-1 != proc->fd) {
+                if (NULL != procs->watch) {
+                    procs->watch(proc->fd, 0, procs->arg);
+                }
+
+                close(proc->fd);
+            }
+
+            kill(proc->pid, SIGTERM);
+            tjs_procs_reap(proc, 0);
+
+            free(proc);
+        }
+
+        free(procs->procs);
+        free(procs);
+    }
+}
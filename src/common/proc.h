@@ -0,0 +1,75 @@
+/**
+ * @package TouchJS
+ *
+ * @file Process header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_PROC_H
+#define TJS_PROC_H 1
+
+/* Includes */
+#include <sys/types.h>
+
+/* Flags */
+#define TJS_PROC_FLAG_EOF    (1 << 0) ///< Output pipe is closed
+#define TJS_PROC_FLAG_EXITED (1 << 1) ///< Child is reaped
+#define TJS_PROC_FLAG_REMOVED (1 << 2) ///< Out of the table; freed on last release
+
+/* Defines */
+#define TJS_PROC_CHUNK 4096
+#define TJS_PROC_REAP_INTERVAL 10 ///< Poll timeout in ms while reaping
+
+/* Types */
+struct tjs_proc_t;
+
+typedef void (*TjsProcDataFunc)(struct tjs_proc_t *proc, const char *buf,
+    size_t len, void *arg);
+typedef void (*TjsProcExitFunc)(struct tjs_proc_t *proc, void *arg);
+typedef void (*TjsProcWatchFunc)(int fd, int watch, void *arg);
+
+typedef struct tjs_proc_t {
+    int flags;
+
+    unsigned long id;
+    pid_t pid;
+    int fd;     ///< Read end of stdout; -1 when closed
+    int status; ///< Exit code or 128 + signal
+    int holds;  ///< Reads or finishes on the stack; defers free
+
+    void *userdata;
+} TjsProc;
+
+typedef struct tjs_procs_t {
+    int nprocs, capacity;
+    struct tjs_proc_t **procs;
+
+    unsigned long lastid;
+
+    TjsProcDataFunc data;
+    TjsProcExitFunc exit;
+    TjsProcWatchFunc watch; ///< Called when an output pipe opens or closes
+    void *arg;
+
+    int wakefd; ///< Polled along to end the wait early; -1 when none
+
+    /* Stats */
+    struct {
+        unsigned long spawned, exited, failed, polls, reads, bytes;
+    } stats;
+} TjsProcs;
+
+/* Methods */
+TjsProcs *tjs_procs_new(void);
+TjsProc *tjs_procs_spawn(TjsProcs *procs, char *const argv[], void *userdata);
+int tjs_procs_poll(TjsProcs *procs, int timeout);
+void tjs_procs_finish(TjsProcs *procs, TjsProc *proc);
+int tjs_procs_count(TjsProcs *procs);
+int tjs_procs_reaping(TjsProcs *procs);
+void tjs_procs_destroy(TjsProcs *procs);
+
+#endif /* TJS_PROC_H */
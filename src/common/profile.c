@@ -0,0 +1,317 @@
+/**
+ * @package TouchJS
+ *
+ * @file Callback profiler functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../touchjs.h"
+
+#include "profile.h"
+#include "clock.h"
+
+/**
+ * Find or add child node with given label
+ *
+ * @param[inout]  profile  A #TjsProfile
+ * @param[in]     parent   Index of parent node
+ * @param[in]     label    Label of frame
+ *
+ * @return Index of node
+ **/
+
+static int tjs_profile_node(TjsProfile *profile, int parent, const char *label) {
+    for (int i = profile->nodes[parent].child; -1 != i;
+            i = profile->nodes[i].sibling)
+    {
+        if (0 == strcmp(profile->nodes[i].label, label)) return i;
+    }
+
+    if (profile->nnodes == profile->capacity) {
+        profile->capacity *= 2;
+        profile->nodes = (TjsProfileNode *)realloc(profile->nodes,
+            profile->capacity * sizeof(TjsProfileNode));
+    }
+
+    int idx = profile->nnodes++;
+    TjsProfileNode *node = &profile->nodes[idx];
+
+    memset(node, 0, sizeof(TjsProfileNode));
+
+    snprintf(node->label, sizeof(node->label), "%s", label);
+
+    /* Separators of collapsed stacks must not appear in frames */
+    for (char *c = node->label; '\0' != *c; c++) {
+        if (';' == *c || '\n' == *c) *c = '_';
+    }
+
+    node->parent = parent;
+    node->child = -1;
+    node->sibling = profile->nodes[parent].child;
+
+    profile->nodes[parent].child = idx;
+
+    return idx;
+}
+
+/**
+ * Create new profiler
+ *
+ * @param[in]  path  Output file for collapsed stacks; - for stdout
+ *
+ * @return A new #TjsProfile
+ **/
+
+TjsProfile *tjs_profile_new(const char *path) {
+    TjsProfile *profile = (TjsProfile *)calloc(1, sizeof(TjsProfile));
+
+    profile->path = strdup(path);
+    profile->capacity = 64;
+    profile->nodes = (TjsProfileNode *)calloc(profile->capacity,
+        sizeof(TjsProfileNode));
+
+    /* Root */
+    profile->nnodes = 1;
+    profile->nodes[0].parent = -1;
+    profile->nodes[0].child = -1;
+    profile->nodes[0].sibling = -1;
+
+    return profile;
+}
+
+/**
+ * Enter frame of native to JS transition
+ *
+ * @param[inout]  profile  A #TjsProfile; might be NULL
+ * @param[in]     label    Label of frame
+ **/
+
+void tjs_profile_enter(TjsProfile *profile, const char *label) {
+    if (NULL == profile) return;
+
+    int level = profile->depth++;
+
+    /* Too deep to track */
+    if (TJS_PROFILE_DEPTH <= level) {
+        profile->stats.dropped++;
+
+        return;
+    }
+
+    profile->stack[level].node = tjs_profile_node(profile,
+        (0 < level ? profile->stack[level - 1].node : 0), label);
+    profile->stack[level].children = 0;
+    profile->stack[level].cpu = tjs_clock_cpu();
+    profile->stack[level].start = tjs_clock_now();
+
+    profile->stats.calls++;
+}
+
+/**
+ * Leave current frame and record its times
+ *
+ * @param[inout]  profile  A #TjsProfile; might be NULL
+ **/
+
+void tjs_profile_leave(TjsProfile *profile) {
+    if (NULL == profile || 0 == profile->depth) return;
+
+    int level = --profile->depth;
+
+    if (TJS_PROFILE_DEPTH <= level) return;
+
+    double elapsed = tjs_clock_now() - profile->stack[level].start;
+
+    TjsProfileNode *node = &profile->nodes[profile->stack[level].node];
+
+    node->calls++;
+    node->total += elapsed;
+    node->self += elapsed - profile->stack[level].children;
+    node->cpu += tjs_clock_cpu() - profile->stack[level].cpu;
+
+    if (elapsed > node->max) node->max = elapsed;
+
+    if (0 < level) {
+        profile->stack[level - 1].children += elapsed;
+    }
+}
+
+/**
+ * Sample current frame; called by the interrupt handler of the
+ * executor every few hundred thousand opcodes
+ *
+ * @param[in]  udata  Heap userdata; unused
+ **/
+
+void tjs_profile_sample(void *udata) {
+    TjsProfile *profile = touch.profile;
+
+    (void)udata;
+
+    if (NULL == profile || 0 == profile->depth) return;
+
+    int level = (TJS_PROFILE_DEPTH < profile->depth ?
+        TJS_PROFILE_DEPTH : profile->depth) - 1;
+
+    profile->nodes[profile->stack[level].node].samples++;
+    profile->stats.samples++;
+}
+
+/**
+ * Sum up nodes by label; sorted by self time
+ *
+ * @param[inout]  profile  A #TjsProfile
+ * @param[inout]  rows     Array to fill
+ * @param[in]     max      Size of array
+ *
+ * @return Number of rows
+ **/
+
+int tjs_profile_summary(TjsProfile *profile, TjsProfileRow *rows, int max) {
+    int nrows = 0;
+
+    TjsProfileRow *all = (TjsProfileRow *)calloc(profile->nnodes,
+        sizeof(TjsProfileRow));
+
+    for (int i = 1; i < profile->nnodes; i++) {
+        TjsProfileNode *node = &profile->nodes[i];
+        TjsProfileRow *row = NULL;
+
+        for (int j = 0; j < nrows && NULL == row; j++) {
+            if (0 == strcmp(all[j].label, node->label)) row = &all[j];
+        }
+
+        if (NULL == row) {
+            row = &all[nrows++];
+            row->label = node->label;
+        }
+
+        row->calls += node->calls;
+        row->samples += node->samples;
+        row->self += node->self;
+        row->cpu += node->cpu;
+
+        if (node->max > row->max) row->max = node->max;
+
+        /* Recursion would count nested time twice */
+        int nested = 0;
+
+        for (int p = node->parent; 0 < p && !nested;
+                p = profile->nodes[p].parent)
+        {
+            nested = (0 == strcmp(profile->nodes[p].label, node->label));
+        }
+
+        if (!nested) row->total += node->total;
+    }
+
+    /* Insertion sort; lists are short */
+    for (int i = 1; i < nrows; i++) {
+        TjsProfileRow row = all[i];
+        int j = i;
+
+        for (; 0 < j && all[j - 1].self < row.self; j--) {
+            all[j] = all[j - 1];
+        }
+
+        all[j] = row;
+    }
+
+    if (nrows > max) nrows = max;
+
+    memcpy(rows, all, nrows * sizeof(TjsProfileRow));
+
+    free(all);
+
+    return nrows;
+}
+
+/**
+ * Write collapsed stacks with self time in us, as read by
+ * flamegraph.pl and speedscope
+ *
+ * @param[inout]  profile  A #TjsProfile
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+int tjs_profile_write(TjsProfile *profile) {
+    int path[TJS_PROFILE_DEPTH];
+
+    FILE *fp = (0 == strcmp(profile->path, "-") ?
+        stdout : fopen(profile->path, "w"));
+
+    if (NULL == fp) {
+        TJS_LOG_ERROR("Failed to open %s", profile->path);
+
+        return -1;
+    }
+
+    for (int i = 1; i < profile->nnodes; i++) {
+        unsigned long weight = (unsigned long)(profile->nodes[i].self * 1000.0);
+
+        if (0 == weight) continue;
+
+        /* Collect path from root */
+        int depth = 0;
+
+        for (int n = i; 0 < n; n = profile->nodes[n].parent) {
+            path[depth++] = n;
+        }
+
+        for (int d = depth - 1; 0 <= d; d--) {
+            fprintf(fp, "%s%s", profile->nodes[path[d]].label,
+                (0 < d ? ";" : ""));
+        }
+
+        fprintf(fp, " %lu\n", weight);
+    }
+
+    if (stdout != fp) fclose(fp);
+
+    return 0;
+}
+
+/**
+ * Log summary table of the slowest frames
+ *
+ * @param[inout]  profile  A #TjsProfile
+ **/
+
+void tjs_profile_report(TjsProfile *profile) {
+    TjsProfileRow rows[TJS_PROFILE_TOP];
+
+    int nrows = tjs_profile_summary(profile, rows, TJS_PROFILE_TOP);
+
+    TJS_LOG_INFO("Profile: calls=%lu, samples=%lu, dropped=%lu, frames=%d, " \
+        "file=%s", profile->stats.calls, profile->stats.samples,
+        profile->stats.dropped, profile->nnodes - 1, profile->path);
+
+    for (int i = 0; i < nrows; i++) {
+        TJS_LOG_INFO("Profile: #%d %s: calls=%lu, self=%.3fms, " \
+            "total=%.3fms, max=%.3fms, cpu=%.3fms, samples=%lu", i + 1,
+            rows[i].label, rows[i].calls, rows[i].self, rows[i].total,
+            rows[i].max, rows[i].cpu, rows[i].samples);
+    }
+}
+
+/**
+ * Destroy profiler
+ *
+ * @param[inout]  profile  A #TjsProfile
+ **/
+
+void tjs_profile_destroy(TjsProfile *profile) {
+    if (NULL != profile) {
+        free(profile->nodes);
+        free(profile->path);
+        free(profile);
+    }
+}
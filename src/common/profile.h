@@ -0,0 +1,69 @@
+/**
+ * @package TouchJS
+ *
+ * @file Callback profiler header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_PROFILE_H
+#define TJS_PROFILE_H 1
+
+/* Defaults */
+#define TJS_PROFILE_DEPTH 32  ///< Max tracked nesting of callbacks
+#define TJS_PROFILE_LABEL 96  ///< Max length of frame label
+#define TJS_PROFILE_TOP 10    ///< Rows of summary table
+
+/* Types */
+typedef struct tjs_profile_node_t {
+    char label[TJS_PROFILE_LABEL]; ///< Kind, function name and file
+
+    int parent, child, sibling; ///< Call tree; -1 when none
+
+    unsigned long calls, samples;
+    double total, self, max; ///< Wall time in ms
+    double cpu;              ///< CPU time in ms
+} TjsProfileNode;
+
+typedef struct tjs_profile_t {
+    char *path; ///< Output file for collapsed stacks
+
+    /* Call tree; node 0 is the root */
+    int nnodes, capacity;
+    TjsProfileNode *nodes;
+
+    /* Open frames */
+    int depth;
+    struct {
+        int node;
+        double start, cpu;
+        double children; ///< Wall time spent in nested frames
+    } stack[TJS_PROFILE_DEPTH];
+
+    /* Stats */
+    struct {
+        unsigned long calls, samples, dropped;
+    } stats;
+} TjsProfile;
+
+typedef struct tjs_profile_row_t {
+    const char *label;
+
+    unsigned long calls, samples;
+    double total, self, max, cpu;
+} TjsProfileRow;
+
+/* Methods */
+TjsProfile *tjs_profile_new(const char *path);
+void tjs_profile_enter(TjsProfile *profile, const char *label);
+void tjs_profile_leave(TjsProfile *profile);
+void tjs_profile_sample(void *udata);
+int tjs_profile_summary(TjsProfile *profile, TjsProfileRow *rows, int max);
+int tjs_profile_write(TjsProfile *profile);
+void tjs_profile_report(TjsProfile *profile);
+void tjs_profile_destroy(TjsProfile *profile);
+
+#endif /* TJS_PROFILE_H */
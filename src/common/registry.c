@@ -0,0 +1,327 @@
+/**
+ * @package TouchJS
+ *
+ * @file Registry functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "registry.h"
+
+/* Defines */
+#define TJS_REGISTRY_EMPTY (-1)
+#define TJS_REGISTRY_MIN_SLOTS 16
+#define TJS_REGISTRY_MIN_BUCKETS 32
+
+/**
+ * Helper to hash given key
+ *
+ * @param[in]  key   Key to hash
+ * @param[in]  mask  Bucket mask
+ *
+ * @return Bucket of the key
+ **/
+
+static int tjs_registry_hash(void *key, int mask) {
+    uint64_t hash = (uint64_t)(uintptr_t)key;
+
+    /* Pointers are aligned, so mix the upper bits down (fibonacci hashing) */
+    hash ^= (hash >> 4);
+    hash *= 0x9E3779B97F4A7C15ULL;
+
+    return (int)(hash >> 32) & mask;
+}
+
+/**
+ * Helper to find the bucket of given key
+ *
+ * @param[in]  registry  A #TjsRegistry
+ * @param[in]  key       Key to find
+ *
+ * @return Either bucket on success; otherwise -1
+ **/
+
+static int tjs_registry_bucket(TjsRegistry *registry, void *key) {
+    int mask = registry->nbuckets - 1;
+    int bucket = tjs_registry_hash(key, mask);
+
+    /* Probe until we hit an empty bucket */
+    while (TJS_REGISTRY_EMPTY != registry->buckets[bucket]) {
+        if (registry->slots[registry->buckets[bucket]].key == key) {
+            return bucket;
+        }
+
+        bucket = (bucket + 1) & mask;
+    }
+
+    return -1;
+}
+
+/**
+ * Helper to insert slot into buckets
+ *
+ * @param[inout]  registry  A #TjsRegistry
+ * @param[in]     idx       Slot index
+ **/
+
+static void tjs_registry_link(TjsRegistry *registry, int idx) {
+    int mask = registry->nbuckets - 1;
+    int bucket = tjs_registry_hash(registry->slots[idx].key, mask);
+
+    while (TJS_REGISTRY_EMPTY != registry->buckets[bucket]) {
+        bucket = (bucket + 1) & mask;
+    }
+
+    registry->buckets[bucket] = idx;
+}
+
+/**
+ * Helper to resize buckets and rehash all live slots
+ *
+ * @param[inout]  registry  A #TjsRegistry
+ * @param[in]     nbuckets  New number of buckets; must be a power of two
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+static int tjs_registry_rehash(TjsRegistry *registry, int nbuckets) {
+    int *buckets = (int *)malloc(nbuckets * sizeof(int));
+
+    if (NULL == buckets) return -1;
+
+    for (int i = 0; i < nbuckets; i++) {
+        buckets[i] = TJS_REGISTRY_EMPTY;
+    }
+
+    free(registry->buckets);
+
+    registry->buckets = buckets;
+    registry->nbuckets = nbuckets;
+
+    /* Re-link live slots */
+    for (int i = 0; i < registry->nslots; i++) {
+        if (NULL != registry->slots[i].key) {
+            tjs_registry_link(registry, i);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Create new registry
+ *
+ * @return Either #TjsRegistry on success; otherwise NULL
+ **/
+
+TjsRegistry *tjs_registry_new(void) {
+    TjsRegistry *registry = (TjsRegistry *)calloc(1, sizeof(TjsRegistry));
+
+    if (NULL != registry) {
+        registry->freeslot = TJS_REGISTRY_EMPTY;
+
+        if (0 != tjs_registry_rehash(registry, TJS_REGISTRY_MIN_BUCKETS)) {
+            free(registry);
+
+            registry = NULL;
+        }
+    }
+
+    return registry;
+}
+
+/**
+ * Add value with given key to registry
+ *
+ * @param[inout]  registry  A #TjsRegistry
+ * @param[in]     key       Key of the value; must not be NULL
+ * @param[in]     value     Value to store
+ *
+ * @return Either slot index on success; otherwise -1
+ **/
+
+int tjs_registry_add(TjsRegistry *registry, void *key, void *value) {
+    int idx = -1;
+
+    if (NULL == registry || NULL == key) return -1;
+
+    /* Keep load factor below 1/2 */
+    if ((registry->count + 1) * 2 > registry->nbuckets) {
+        if (0 != tjs_registry_rehash(registry, registry->nbuckets * 2)) {
+            return -1;
+        }
+    }
+
+    /* Re-use free slot or append a new one */
+    if (TJS_REGISTRY_EMPTY != registry->freeslot) {
+        idx = registry->freeslot;
+        registry->freeslot = registry->slots[idx].next;
+    } else {
+        if (registry->nslots == registry->maxslots) {
+            int maxslots = (0 == registry->maxslots ?
+                TJS_REGISTRY_MIN_SLOTS : registry->maxslots * 2);
+
+            TjsRegistrySlot *slots = (TjsRegistrySlot *)realloc(
+                registry->slots, maxslots * sizeof(TjsRegistrySlot));
+
+            if (NULL == slots) return -1;
+
+            registry->slots = slots;
+            registry->maxslots = maxslots;
+        }
+
+        idx = registry->nslots++;
+    }
+
+    registry->slots[idx].key = key;
+    registry->slots[idx].value = value;
+    registry->slots[idx].next = TJS_REGISTRY_EMPTY;
+    registry->count++;
+
+    tjs_registry_link(registry, idx);
+
+    return idx;
+}
+
+/**
+ * Find value based on key
+ *
+ * @param[in]   registry  A #TjsRegistry
+ * @param[in]   key       Key to find
+ * @param[out]  idx       Slot index of found value; otherwise -1
+ *
+ * @return Either found value; otherwise NULL
+ **/
+
+void *tjs_registry_find(TjsRegistry *registry, void *key, int *idx) {
+    int bucket = -1;
+
+    if (NULL != registry && NULL != key) {
+        bucket = tjs_registry_bucket(registry, key);
+    }
+
+    if (-1 == bucket) {
+        if (NULL != idx) *idx = -1;
+
+        return NULL;
+    }
+
+    if (NULL != idx) *idx = registry->buckets[bucket];
+
+    return registry->slots[registry->buckets[bucket]].value;
+}
+
+/**
+ * Get value based on slot index
+ *
+ * @param[in]  registry  A #TjsRegistry
+ * @param[in]  idx       Slot index
+ *
+ * @return Either found value; otherwise NULL
+ **/
+
+void *tjs_registry_get(TjsRegistry *registry, int idx) {
+    if (NULL != registry && 0 <= idx && idx < registry->nslots &&
+            NULL != registry->slots[idx].key)
+    {
+        return registry->slots[idx].value;
+    }
+
+    return NULL;
+}
+
+/**
+ * Remove value based on key
+ *
+ * @param[inout]  registry  A #TjsRegistry
+ * @param[in]     key       Key to remove
+ *
+ * @return Either removed value; otherwise NULL
+ **/
+
+void *tjs_registry_remove(TjsRegistry *registry, void *key) {
+    void *value = NULL;
+    int bucket = -1;
+
+    if (NULL != registry && NULL != key) {
+        bucket = tjs_registry_bucket(registry, key);
+    }
+
+    if (-1 != bucket) {
+        int mask = registry->nbuckets - 1;
+        int idx = registry->buckets[bucket];
+
+        value = registry->slots[idx].value;
+
+        /* Put slot on free-list */
+        registry->slots[idx].key = NULL;
+        registry->slots[idx].value = NULL;
+        registry->slots[idx].next = registry->freeslot;
+        registry->freeslot = idx;
+        registry->count--;
+
+        /* Backward-shift deletion keeps probe chains intact without tombstones */
+        int hole = bucket, next = (bucket + 1) & mask;
+
+        while (TJS_REGISTRY_EMPTY != registry->buckets[next]) {
+            int home = tjs_registry_hash(
+                registry->slots[registry->buckets[next]].key, mask);
+
+            /* Move entry if its home isn't in (hole, next] */
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                registry->buckets[hole] = registry->buckets[next];
+                hole = next;
+            }
+
+            next = (next + 1) & mask;
+        }
+
+        registry->buckets[hole] = TJS_REGISTRY_EMPTY;
+    }
+
+    return value;
+}
+
+/**
+ * Get number of slots; iteration bound for #tjs_registry_get
+ *
+ * @param[in]  registry  A #TjsRegistry
+ *
+ * @return Number of slots
+ **/
+
+int tjs_registry_size(TjsRegistry *registry) {
+    return (NULL != registry ? registry->nslots : 0);
+}
+
+/**
+ * Get number of live values
+ *
+ * @param[in]  registry  A #TjsRegistry
+ *
+ * @return Number of values
+ **/
+
+int tjs_registry_count(TjsRegistry *registry) {
+    return (NULL != registry ? registry->count : 0);
+}
+
+/**
+ * Destroy registry
+ *
+ * @param[inout]  registry  A #TjsRegistry
+ **/
+
+void tjs_registry_destroy(TjsRegistry *registry) {
+    if (NULL != registry) {
+        free(registry->slots);
+        free(registry->buckets);
+        free(registry);
+    }
+}
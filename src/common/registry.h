@@ -0,0 +1,45 @@
+/**
+ * @package TouchJS
+ *
+ * @file Registry header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_REGISTRY_H
+#define TJS_REGISTRY_H 1
+
+/* Types */
+typedef struct tjs_registry_slot_t {
+    void *key;
+    void *value;
+
+    int next; ///< Next free slot; -1 otherwise
+} TjsRegistrySlot;
+
+typedef struct tjs_registry_t {
+    int count;
+
+    /* Dense slots */
+    int nslots, maxslots, freeslot;
+    struct tjs_registry_slot_t *slots;
+
+    /* Open-addressing hash: key -> slot */
+    int nbuckets;
+    int *buckets;
+} TjsRegistry;
+
+/* Methods */
+TjsRegistry *tjs_registry_new(void);
+int tjs_registry_add(TjsRegistry *registry, void *key, void *value);
+void *tjs_registry_find(TjsRegistry *registry, void *key, int *idx);
+void *tjs_registry_get(TjsRegistry *registry, int idx);
+void *tjs_registry_remove(TjsRegistry *registry, void *key);
+int tjs_registry_size(TjsRegistry *registry);
+int tjs_registry_count(TjsRegistry *registry);
+void tjs_registry_destroy(TjsRegistry *registry);
+
+#endif /* TJS_REGISTRY_H */
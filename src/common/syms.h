@@ -17,5 +17,14 @@
 #define TJS_SYM_SLIDE_CB "\xff" "__slide_cb"
 #define TJS_SYM_EVENT_CB "\xff" "__event_cb"
 #define TJS_SYM_USERDATA "\xff" "__userdata"
+#define TJS_SYM_TIMERS "\xff" "__timers"
+#define TJS_SYM_COMMANDS "\xff" "__commands"
+#define TJS_SYM_DATA_CB "\xff" "__data_cb"
+#define TJS_SYM_EXIT_CB "\xff" "__exit_cb"
+#define TJS_SYM_ERROR_CB "\xff" "__error_cb"
+#define TJS_SYM_WAITERS "\xff" "__waiters"
+#define TJS_SYM_OUTPUT "\xff" "__output"
+#define TJS_SYM_BUS "\xff" "__bus"
+#define TJS_SYM_QUERIES "\xff" "__queries"
 
 #endif /* TJS_SYMS_H */
\ No newline at end of file
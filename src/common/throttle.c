@@ -0,0 +1,150 @@
+/**
+ * @package TouchJS
+ *
+ * @file Event throttle functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+
+#include "throttle.h"
+
+/**
+ * Helper to account delivery
+ *
+ * @param[inout]  throttle  A #TjsThrottle
+ * @param[in]     now       Current time in ms
+ * @param[in]     since     Arrival of delivered value
+ **/
+
+static void tjs_throttle_deliver(TjsThrottle *throttle, double now,
+    double since)
+{
+    double lag = now - since;
+
+    throttle->last = now;
+    throttle->flags &= ~TJS_THROTTLE_FLAG_PENDING;
+
+    throttle->stats.delivered++;
+    throttle->stats.lag += lag;
+
+    if (lag > throttle->stats.maxlag) throttle->stats.maxlag = lag;
+}
+
+/**
+ * Create new throttle
+ *
+ * @param[in]  maxhz     Max deliveries per second; 0 is unlimited
+ * @param[in]  debounce  Quiet time before delivery in ms; 0 disables
+ * @param[in]  flags     Throttle flags
+ *
+ * @return A new #TjsThrottle
+ **/
+
+TjsThrottle *tjs_throttle_new(double maxhz, double debounce, int flags) {
+    TjsThrottle *throttle = (TjsThrottle *)calloc(1, sizeof(TjsThrottle));
+
+    throttle->flags = (flags & TJS_THROTTLE_FLAG_TRAILING);
+    throttle->interval = (0 < maxhz ? 1000.0 / maxhz : 0);
+    throttle->debounce = (0 < debounce ? debounce : 0);
+    throttle->last = -throttle->interval;
+
+    return throttle;
+}
+
+/**
+ * Handle incoming value; leading values pass when the interval is
+ * over, others replace the pending value
+ *
+ * @param[inout]  throttle  A #TjsThrottle
+ * @param[in]     value     New value
+ * @param[in]     now       Current time in ms
+ *
+ * @return Either #TJS_THROTTLE_DELIVER, #TJS_THROTTLE_DEFER when a
+ *         pending value is due at throttle->due or #TJS_THROTTLE_DROP
+ **/
+
+int tjs_throttle_event(TjsThrottle *throttle, double value, double now) {
+    throttle->stats.events++;
+
+    /* Debounce waits for quiet */
+    if (0 < throttle->debounce) {
+        if (0 < (throttle->flags & TJS_THROTTLE_FLAG_PENDING)) {
+            throttle->stats.coalesced++;
+        }
+
+        throttle->flags |= TJS_THROTTLE_FLAG_PENDING;
+        throttle->value = value;
+        throttle->since = now;
+        throttle->due = now + throttle->debounce;
+
+        return TJS_THROTTLE_DEFER;
+    }
+
+    if (now - throttle->last >= throttle->interval) {
+        /* Replaces pending value */
+        if (0 < (throttle->flags & TJS_THROTTLE_FLAG_PENDING)) {
+            throttle->stats.coalesced++;
+        }
+
+        tjs_throttle_deliver(throttle, now, now);
+
+        return TJS_THROTTLE_DELIVER;
+    }
+
+    if (0 == (throttle->flags & TJS_THROTTLE_FLAG_TRAILING)) {
+        throttle->stats.coalesced++;
+
+        return TJS_THROTTLE_DROP;
+    }
+
+    if (0 < (throttle->flags & TJS_THROTTLE_FLAG_PENDING)) {
+        throttle->stats.coalesced++;
+    }
+
+    throttle->flags |= TJS_THROTTLE_FLAG_PENDING;
+    throttle->value = value;
+    throttle->since = now;
+    throttle->due = throttle->last + throttle->interval;
+
+    return TJS_THROTTLE_DEFER;
+}
+
+/**
+ * Take pending value when due
+ *
+ * @param[inout]  throttle  A #TjsThrottle
+ * @param[in]     now       Current time in ms
+ * @param[out]    value     Pending value
+ *
+ * @return Either #TJS_THROTTLE_DELIVER, #TJS_THROTTLE_DEFER when the
+ *         value isn't due before throttle->due or #TJS_THROTTLE_DROP
+ **/
+
+int tjs_throttle_due(TjsThrottle *throttle, double now, double *value) {
+    if (0 == (throttle->flags & TJS_THROTTLE_FLAG_PENDING)) {
+        return TJS_THROTTLE_DROP;
+    }
+
+    if (now < throttle->due) return TJS_THROTTLE_DEFER;
+
+    *value = throttle->value;
+
+    tjs_throttle_deliver(throttle, now, throttle->since);
+
+    return TJS_THROTTLE_DELIVER;
+}
+
+/**
+ * Destroy throttle
+ *
+ * @param[inout]  throttle  A #TjsThrottle; might be NULL
+ **/
+
+void tjs_throttle_destroy(TjsThrottle *throttle) {
+    free(throttle);
+}
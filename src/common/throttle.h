@@ -0,0 +1,51 @@
+/**
+ * @package TouchJS
+ *
+ * @file Event throttle header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_THROTTLE_H
+#define TJS_THROTTLE_H 1
+
+/* Flags */
+#define TJS_THROTTLE_FLAG_TRAILING (1 << 0) ///< Deliver last coalesced value
+#define TJS_THROTTLE_FLAG_PENDING (1 << 1)  ///< Value waits for delivery
+
+/* Results */
+#define TJS_THROTTLE_DROP 0    ///< Coalesced; nothing to do
+#define TJS_THROTTLE_DELIVER 1 ///< Deliver value now
+#define TJS_THROTTLE_DEFER 2   ///< Deliver pending value at due time
+
+/* Types */
+typedef struct tjs_throttle_t {
+    int flags;
+
+    double interval; ///< Min time between deliveries in ms; 0 disables
+    double debounce; ///< Quiet time before delivery in ms; 0 disables
+
+    double last;  ///< Time of last delivery
+    double due;   ///< Due time of pending value
+    double since; ///< Arrival of pending value
+    double value; ///< Pending value
+
+    unsigned long timer; ///< Id of trailing timer; 0 when none
+
+    /* Stats */
+    struct {
+        unsigned long events, delivered, coalesced;
+        double lag, maxlag; ///< Total and max time values waited in ms
+    } stats;
+} TjsThrottle;
+
+/* Methods */
+TjsThrottle *tjs_throttle_new(double maxhz, double debounce, int flags);
+int tjs_throttle_event(TjsThrottle *throttle, double value, double now);
+int tjs_throttle_due(TjsThrottle *throttle, double now, double *value);
+void tjs_throttle_destroy(TjsThrottle *throttle);
+
+#endif /* TJS_THROTTLE_H */
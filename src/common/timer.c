@@ -0,0 +1,332 @@
+/**
+ * @package TouchJS
+ *
+ * @file Timer scheduler functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "timer.h"
+#include "clock.h"
+#include "registry.h"
+
+/* Defines */
+#define TJS_TIMERS_KEY(ID) ((void *)(uintptr_t)(ID))
+
+/**
+ * Helper to swap two heap positions
+ *
+ * @param[inout]  timers  A #TjsTimers
+ * @param[in]     a       First position
+ * @param[in]     b       Second position
+ **/
+
+static void tjs_timers_swap(TjsTimers *timers, int a, int b) {
+    TjsTimer *tmp = timers->heap[a];
+
+    timers->heap[a] = timers->heap[b];
+    timers->heap[b] = tmp;
+
+    timers->heap[a]->pos = a;
+    timers->heap[b]->pos = b;
+}
+
+/**
+ * Helper to restore heap order upwards
+ *
+ * @param[inout]  timers  A #TjsTimers
+ * @param[in]     pos     Position to start at
+ **/
+
+static void tjs_timers_up(TjsTimers *timers, int pos) {
+    while (0 < pos) {
+        int parent = (pos - 1) / 2;
+
+        if (timers->heap[parent]->deadline <= timers->heap[pos]->deadline) break;
+
+        tjs_timers_swap(timers, parent, pos);
+
+        pos = parent;
+    }
+}
+
+/**
+ * Helper to restore heap order downwards
+ *
+ * @param[inout]  timers  A #TjsTimers
+ * @param[in]     pos     Position to start at
+ **/
+
+static void tjs_timers_down(TjsTimers *timers, int pos) {
+    while (1) {
+        int left = 2 * pos + 1, right = left + 1, min = pos;
+
+        if (left < timers->nheap &&
+                timers->heap[left]->deadline < timers->heap[min]->deadline)
+        {
+            min = left;
+        }
+
+        if (right < timers->nheap &&
+                timers->heap[right]->deadline < timers->heap[min]->deadline)
+        {
+            min = right;
+        }
+
+        if (min == pos) break;
+
+        tjs_timers_swap(timers, pos, min);
+
+        pos = min;
+    }
+}
+
+/**
+ * Helper to remove timer from heap
+ *
+ * @param[inout]  timers  A #TjsTimers
+ * @param[in]     timer   A #TjsTimer
+ **/
+
+static void tjs_timers_unlink(TjsTimers *timers, TjsTimer *timer) {
+    int pos = timer->pos, last = --(timers->nheap);
+
+    if (pos != last) {
+        tjs_timers_swap(timers, pos, last);
+        tjs_timers_down(timers, pos);
+        tjs_timers_up(timers, pos);
+    }
+}
+
+/**
+ * Helper to re-arm platform timer when the earliest wakeup changed;
+ * the earliest deadline may be delayed by the slack to catch later ones
+ *
+ * @param[inout]  timers  A #TjsTimers
+ **/
+
+static void tjs_timers_rearm(TjsTimers *timers) {
+    double wakeup = (0 < timers->nheap ?
+        timers->heap[0]->deadline + timers->slack : -1);
+
+    if (wakeup != timers->armed) {
+        timers->armed = wakeup;
+        timers->stats.rearms++;
+
+        if (NULL != timers->arm) {
+            timers->arm(tjs_timers_delay(timers), timers->armarg);
+        }
+    }
+}
+
+/**
+ * Create new timer scheduler
+ *
+ * @param[in]  slack  Coalescing window in ms
+ * @param[in]  flags  Scheduler flags
+ *
+ * @return A new #TjsTimers
+ **/
+
+TjsTimers *tjs_timers_new(double slack, int flags) {
+    TjsTimers *timers = (TjsTimers *)calloc(1, sizeof(TjsTimers));
+
+    timers->flags = flags;
+    timers->slack = (0 < slack ? slack : 0);
+    timers->armed = -1;
+    timers->byid = tjs_registry_new();
+
+    return timers;
+}
+
+/**
+ * Get current time of scheduler clock
+ *
+ * @param[inout]  timers  A #TjsTimers
+ *
+ * @return Time in ms
+ **/
+
+double tjs_timers_now(TjsTimers *timers) {
+    return (0 < (timers->flags & TJS_TIMERS_FLAG_FAKE) ?
+        timers->fake : tjs_clock_now());
+}
+
+/**
+ * Advance fake clock
+ *
+ * @param[inout]  timers  A #TjsTimers
+ * @param[in]     msec    Time to advance in ms
+ **/
+
+void tjs_timers_advance(TjsTimers *timers, double msec) {
+    if (0 < msec) timers->fake += msec;
+}
+
+/**
+ * Add timer
+ *
+ * @param[inout]  timers    A #TjsTimers
+ * @param[in]     delay     Delay in ms
+ * @param[in]     interval  Repeat interval in ms; 0 for one-shots
+ *
+ * @return Id of the new timer
+ **/
+
+unsigned long tjs_timers_add(TjsTimers *timers, double delay, double interval) {
+    TjsTimer *timer = (TjsTimer *)calloc(1, sizeof(TjsTimer));
+
+    if (delay < TJS_TIMERS_MIN_DELAY) delay = TJS_TIMERS_MIN_DELAY;
+    if (0 < interval && interval < TJS_TIMERS_MIN_DELAY) {
+        interval = TJS_TIMERS_MIN_DELAY;
+    }
+
+    timer->id = ++(timers->lastid);
+    timer->deadline = tjs_timers_now(timers) + delay;
+    timer->interval = (0 < interval ? interval : 0);
+
+    /* Grow heap */
+    if (timers->nheap == timers->capacity) {
+        timers->capacity = (0 < timers->capacity ? timers->capacity * 2 : 16);
+        timers->heap = (TjsTimer **)realloc(timers->heap,
+            timers->capacity * sizeof(TjsTimer *));
+    }
+
+    timer->pos = timers->nheap++;
+    timers->heap[timer->pos] = timer;
+
+    tjs_timers_up(timers, timer->pos);
+    tjs_registry_add(timers->byid, TJS_TIMERS_KEY(timer->id), timer);
+
+    timers->stats.scheduled++;
+
+    tjs_timers_rearm(timers);
+
+    return timer->id;
+}
+
+/**
+ * Clear timer
+ *
+ * @param[inout]  timers  A #TjsTimers
+ * @param[in]     id      Timer id
+ *
+ * @return Either 1 when cleared; otherwise 0
+ **/
+
+int tjs_timers_clear(TjsTimers *timers, unsigned long id) {
+    TjsTimer *timer = (TjsTimer *)tjs_registry_remove(timers->byid,
+        TJS_TIMERS_KEY(id));
+
+    if (NULL == timer) return 0;
+
+    tjs_timers_unlink(timers, timer);
+
+    free(timer);
+
+    timers->stats.cleared++;
+
+    tjs_timers_rearm(timers);
+
+    return 1;
+}
+
+/**
+ * Run all due timers; intervals are re-scheduled before their callback runs,
+ * so callbacks may clear them
+ *
+ * @param[inout]  timers  A #TjsTimers
+ * @param[in]     func    A #TjsTimerFunc called per due timer
+ * @param[inout]  arg     Argument passed to func
+ *
+ * @return Number of fired timers
+ **/
+
+int tjs_timers_run(TjsTimers *timers, TjsTimerFunc func, void *arg) {
+    double now = tjs_timers_now(timers);
+    int nfired = 0;
+
+    timers->stats.wakeups++;
+
+    while (0 < timers->nheap && timers->heap[0]->deadline <= now) {
+        TjsTimer *timer = timers->heap[0];
+        unsigned long id = timer->id;
+        int repeat = (0 < timer->interval);
+
+        if (repeat) {
+            timer->deadline += timer->interval;
+
+            /* Skip missed periods instead of firing in a burst */
+            if (timer->deadline <= now) timer->deadline = now + timer->interval;
+
+            tjs_timers_down(timers, 0);
+        } else {
+            tjs_registry_remove(timers->byid, TJS_TIMERS_KEY(id));
+            tjs_timers_unlink(timers, timer);
+
+            free(timer);
+        }
+
+        nfired++;
+        timers->stats.fired++;
+
+        func(id, repeat, arg);
+    }
+
+    tjs_timers_rearm(timers);
+
+    return nfired;
+}
+
+/**
+ * Get delay until next wakeup
+ *
+ * @param[inout]  timers  A #TjsTimers
+ *
+ * @return Either delay in ms; otherwise -1 when no timers are pending
+ **/
+
+double tjs_timers_delay(TjsTimers *timers) {
+    if (0 > timers->armed) return -1;
+
+    double delay = timers->armed - tjs_timers_now(timers);
+
+    return (0 < delay ? delay : 0);
+}
+
+/**
+ * Get number of pending timers
+ *
+ * @param[inout]  timers  A #TjsTimers
+ *
+ * @return Number of timers
+ **/
+
+int tjs_timers_count(TjsTimers *timers) {
+    return (NULL != timers ? timers->nheap : 0);
+}
+
+/**
+ * Destroy timer scheduler
+ *
+ * @param[inout]  timers  A #TjsTimers; might be NULL
+ **/
+
+void tjs_timers_destroy(TjsTimers *timers) {
+    if (NULL != timers) {
+        for (int i = 0; i < timers->nheap; i++) {
+            free(timers->heap[i]);
+        }
+
+        tjs_registry_destroy(timers->byid);
+
+        free(timers->heap);
+        free(timers);
+    }
+}
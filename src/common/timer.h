@@ -0,0 +1,66 @@
+/**
+ * @package TouchJS
+ *
+ * @file Timer scheduler header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_TIMER_H
+#define TJS_TIMER_H 1
+
+/* Flags */
+#define TJS_TIMERS_FLAG_FAKE (1 << 0) ///< Time only moves on advance
+
+/* Defines */
+#define TJS_TIMERS_MIN_DELAY 1.0 ///< Timers added while running fire next run
+#define TJS_TIMERS_SLACK 10.0    ///< Default coalescing window in ms
+
+/* Types */
+typedef void (*TjsTimerFunc)(unsigned long id, int repeat, void *arg);
+typedef void (*TjsTimerArmFunc)(double delay, void *arg);
+
+typedef struct tjs_timer_t {
+    unsigned long id;
+    double deadline, interval; ///< Interval is 0 for one-shots
+
+    int pos; ///< Index in heap
+} TjsTimer;
+
+typedef struct tjs_timers_t {
+    int flags;
+    double slack;  ///< Coalescing window in ms
+    double fake;   ///< Time of fake clock
+    double armed;  ///< Armed wakeup; negative when disarmed
+
+    unsigned long lastid;
+
+    int nheap, capacity;
+    struct tjs_timer_t **heap; ///< Min-heap by deadline
+    struct tjs_registry_t *byid;
+
+    TjsTimerArmFunc arm; ///< Called when the earliest wakeup changes
+    void *armarg;
+
+    /* Stats */
+    struct {
+        unsigned long scheduled, fired, cleared, wakeups, rearms;
+        unsigned long errors; ///< Failed callbacks; counted by the caller
+    } stats;
+} TjsTimers;
+
+/* Methods */
+TjsTimers *tjs_timers_new(double slack, int flags);
+double tjs_timers_now(TjsTimers *timers);
+void tjs_timers_advance(TjsTimers *timers, double msec);
+unsigned long tjs_timers_add(TjsTimers *timers, double delay, double interval);
+int tjs_timers_clear(TjsTimers *timers, unsigned long id);
+int tjs_timers_run(TjsTimers *timers, TjsTimerFunc func, void *arg);
+double tjs_timers_delay(TjsTimers *timers);
+int tjs_timers_count(TjsTimers *timers);
+void tjs_timers_destroy(TjsTimers *timers);
+
+#endif /* TJS_TIMER_H */
@@ -12,6 +12,26 @@
 #include "../touchjs.h"
 
 #include "userdata.h"
+#include "alloc.h"
+
+/* Globals */
+static TjsUserdataStats stats = { { 0 } };
+static TjsUserdataHook hooks[TJS_USERDATA_NTYPES] = { NULL };
+
+/**
+ * Helper to update per-type counts
+ *
+ * @param[in]  flags  Userdata flags
+ * @param[in]  delta  Value to add
+ **/
+
+static void tjs_userdata_count(int flags, long delta) {
+    for (int i = 0; i < TJS_USERDATA_NTYPES; i++) {
+        if (0 < (flags & (1L << i))) {
+            stats.live[i] += delta;
+        }
+    }
+}
 
 /**
  * Native userdata destructor
@@ -20,13 +40,21 @@
  **/
 
 static duk_ret_t tjs_userdata_dtor(duk_context *ctx) {
-    /* Get userdata */
-    TjsUserdata *userdata = tjs_userdata_get(ctx,
-        TJS_FLAGS_WIDGETS);
+    /* Finalizers get the object as argument */
+    duk_get_prop_string(ctx, 0, TJS_SYM_USERDATA);
+
+    TjsUserdata *userdata = (TjsUserdata *)duk_get_pointer(ctx, -1);
+    duk_pop(ctx);
+
+    stats.finalized++;
 
     if (NULL != userdata) {
         TJS_LOG_OBJ(userdata);
 
+        /* Clear ref in case the object is rescued */
+        duk_push_pointer(ctx, NULL);
+        duk_put_prop_string(ctx, 0, TJS_SYM_USERDATA);
+
         tjs_userdata_destroy(userdata);
     }
 
@@ -34,7 +62,24 @@ static duk_ret_t tjs_userdata_dtor(duk_context *ctx) {
 }
 
 /**
- * Create new userdata
+ * Helper to get allocator heap of context
+ *
+ * @param[inout]  ctx  A #duk_context
+ *
+ * @return Either #TjsAllocHeap; otherwise NULL
+ **/
+
+static TjsAllocHeap *tjs_userdata_heap(duk_context *ctx) {
+    duk_memory_functions funcs;
+
+    duk_get_memory_functions(ctx, &funcs);
+
+    return (tjs_alloc_duk_alloc == funcs.alloc_func ?
+        (TjsAllocHeap *)funcs.udata : NULL);
+}
+
+/**
+ * Create new userdata; it counts against the limit of the heap
  *
  * @param[inout]  ctx       A #duk_context
  * @param[in]     flags     Context flags
@@ -45,10 +90,22 @@ static duk_ret_t tjs_userdata_dtor(duk_context *ctx) {
 
  TjsUserdata *tjs_userdata_new(duk_context *ctx, int flags, size_t datasize) {
     /* Create new userdata */
-    TjsUserdata *userdata = (TjsUserdata *)calloc(1, datasize);
+    TjsAllocHeap *heap = tjs_userdata_heap(ctx);
+    TjsUserdata *userdata = (TjsUserdata *)(NULL != heap ?
+        tjs_alloc_heap_typed(heap, datasize) :
+        tjs_alloc_typed(touch.alloc, datasize));
+
+    if (NULL == userdata) {
+        TJS_LOG_ERROR("Failed to allocate userdata: size=%zu", datasize);
+
+        return NULL;
+    }
 
     userdata->flags = flags;
 
+    stats.created++;
+    tjs_userdata_count(flags, 1);
+
     /* Store pointer ref */
     duk_push_this(ctx);
     duk_push_pointer(ctx, userdata);
@@ -95,6 +152,8 @@ TjsUserdata *tjs_userdata_from(duk_context *ctx, int flag) {
     TjsUserdata *userdata = (TjsUserdata *)duk_get_pointer(ctx, -1);
     duk_pop(ctx);
 
+    if (NULL == userdata) return NULL;
+
     TJS_LOG_OBJ(userdata);
 
     return (0 < (userdata->flags & flag) ? userdata : NULL);
@@ -110,7 +169,7 @@ TjsUserdata *tjs_userdata_from(duk_context *ctx, int flag) {
 void tjs_userdata_init(duk_context *ctx, TjsUserdata *userdata) {
     /* Register destructor */
     duk_push_this(ctx);
-    duk_push_c_function(ctx, tjs_userdata_dtor, 0);
+    duk_push_c_function(ctx, tjs_userdata_dtor, 1);
     duk_set_finalizer(ctx, -2);
     duk_pop(ctx);
 
@@ -129,6 +188,41 @@ void tjs_userdata_init(duk_context *ctx, TjsUserdata *userdata) {
 
 void tjs_userdata_destroy(TjsUserdata *userdata) {
     if (NULL != userdata) {
-        free(userdata);
+        /* Call type hooks to release native resources */
+        for (int i = 0; i < TJS_USERDATA_NTYPES; i++) {
+            if (NULL != hooks[i] && 0 < (userdata->flags & (1L << i))) {
+                hooks[i](userdata);
+            }
+        }
+
+        stats.destroyed++;
+        tjs_userdata_count(userdata->flags, -1);
+
+        tjs_alloc_free(touch.alloc, userdata);
     }
+}
+
+/**
+ * Set destroy hook for type
+ *
+ * @param[in]  flag  A single TJS_FLAG_TYPE_* flag
+ * @param[in]  hook  A #TjsUserdataHook; NULL removes it
+ **/
+
+void tjs_userdata_hook(int flag, TjsUserdataHook hook) {
+    for (int i = 0; i < TJS_USERDATA_NTYPES; i++) {
+        if ((1L << i) == flag) {
+            hooks[i] = hook;
+        }
+    }
+}
+
+/**
+ * Get userdata stats
+ *
+ * @return A #TjsUserdataStats
+ **/
+
+const TjsUserdataStats *tjs_userdata_stats(void) {
+    return &stats;
 }
\ No newline at end of file
@@ -16,11 +16,21 @@
 #include "../libs/duktape/duktape.h"
 #include "syms.h"
 
+/* Defines */
+#define TJS_USERDATA_NTYPES 16 ///< Bits of TJS_FLAG_TYPE_* to count
+
 /* Types */
 typedef struct tjs_userdata_t {
     int flags;
 } TjsUserdata;
 
+typedef void (*TjsUserdataHook)(TjsUserdata *userdata);
+
+typedef struct tjs_userdata_stats_t {
+    long live[TJS_USERDATA_NTYPES]; ///< Live objects per type bit
+    unsigned long created, destroyed, finalized;
+} TjsUserdataStats;
+
 /* Methods */
 TjsUserdata *tjs_userdata_new(duk_context *ctx, int flags, size_t datasize);
 TjsUserdata *tjs_userdata_get(duk_context *ctx, int flag);
@@ -28,5 +38,7 @@ TjsUserdata *tjs_userdata_from(duk_context *ctx, int flag);
 
 void tjs_userdata_init(duk_context *ctx, TjsUserdata *userdata);
 void tjs_userdata_destroy(TjsUserdata *userdata);
+void tjs_userdata_hook(int flag, TjsUserdataHook hook);
+const TjsUserdataStats *tjs_userdata_stats(void);
 
 #endif /* TJS_USERDATA_H */
\ No newline at end of file
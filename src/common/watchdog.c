@@ -0,0 +1,206 @@
+/**
+ * @package TouchJS
+ *
+ * @file Execution watchdog functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../touchjs.h"
+
+#include "watchdog.h"
+#include "clock.h"
+
+/**
+ * Find or add handler stats
+ *
+ * @param[inout]  watchdog  A #TjsWatchdog
+ * @param[in]     label     Label of handler
+ *
+ * @return Index into handlers
+ **/
+
+static int tjs_watchdog_handler(TjsWatchdog *watchdog, const char *label) {
+    for (int i = 0; i < watchdog->nhandlers; i++) {
+        if (0 == strcmp(watchdog->handlers[i].label, label)) return i;
+    }
+
+    /* Last slot collects everything once full */
+    if (TJS_WATCHDOG_HANDLERS == watchdog->nhandlers) {
+        snprintf(watchdog->handlers[TJS_WATCHDOG_HANDLERS - 1].label,
+            TJS_WATCHDOG_LABEL, "%s", "other");
+
+        return TJS_WATCHDOG_HANDLERS - 1;
+    }
+
+    snprintf(watchdog->handlers[watchdog->nhandlers].label,
+        TJS_WATCHDOG_LABEL, "%s", label);
+
+    return watchdog->nhandlers++;
+}
+
+/**
+ * Create new watchdog
+ *
+ * @param[in]  budget  Time budget per callback in ms; 0 disables
+ *
+ * @return A new #TjsWatchdog
+ **/
+
+TjsWatchdog *tjs_watchdog_new(double budget) {
+    TjsWatchdog *watchdog = (TjsWatchdog *)calloc(1, sizeof(TjsWatchdog));
+
+    watchdog->budget = budget;
+
+    return watchdog;
+}
+
+/**
+ * Enter callback; the budget starts with the outermost one
+ *
+ * @param[inout]  watchdog  A #TjsWatchdog; might be NULL
+ * @param[in]     label     Label of callback for stats
+ **/
+
+void tjs_watchdog_enter(TjsWatchdog *watchdog, const char *label) {
+    if (NULL == watchdog) return;
+
+    int level = watchdog->depth++;
+
+    if (TJS_WATCHDOG_DEPTH <= level) return; ///< Too deep to track
+
+    watchdog->stack[level].handler = tjs_watchdog_handler(watchdog, label);
+
+    /* Outermost callback owns the budget */
+    if (0 == level) {
+        watchdog->flags &= ~(TJS_WATCHDOG_FLAG_EXPIRED|TJS_WATCHDOG_FLAG_ABORT);
+        watchdog->deadline = tjs_clock_now() + watchdog->budget;
+    }
+
+    watchdog->stats.calls++;
+    watchdog->stack[level].cpu = tjs_clock_cpu();
+}
+
+/**
+ * Leave callback and record its CPU time
+ *
+ * @param[inout]  watchdog  A #TjsWatchdog; might be NULL
+ **/
+
+void tjs_watchdog_leave(TjsWatchdog *watchdog) {
+    if (NULL == watchdog || 0 == watchdog->depth) return;
+
+    int level = --watchdog->depth;
+
+    if (TJS_WATCHDOG_DEPTH <= level) return;
+
+    double cpu = tjs_clock_cpu() - watchdog->stack[level].cpu;
+
+    TjsWatchdogHandler *handler =
+        &watchdog->handlers[watchdog->stack[level].handler];
+
+    handler->calls++;
+    handler->cpu += cpu;
+
+    if (cpu > handler->maxcpu) handler->maxcpu = cpu;
+
+    if (0 == level && 0 < (watchdog->flags & TJS_WATCHDOG_FLAG_EXPIRED)) {
+        handler->timeouts++;
+
+        TJS_LOG_ERROR("Watchdog: %s ran over budget of %.0fms (cpu=%.3fms)",
+            handler->label, watchdog->budget, cpu);
+    }
+}
+
+/**
+ * Check whether current callback ran out of time; called by the
+ * interrupt handler of the executor.
+ *
+ * The first expiry throws a RangeError the script can still catch and
+ * grants another budget to clean up; the second one keeps throwing
+ * until control is back in the outermost callback.
+ *
+ * @param[in]  udata  Heap userdata; unused
+ *
+ * @return Either 1 when the callback should be aborted; otherwise 0
+ **/
+
+int tjs_watchdog_check(void *udata) {
+    TjsWatchdog *watchdog = touch.watchdog;
+
+    (void)udata;
+
+    if (NULL == watchdog || 0 == watchdog->depth || 0 >= watchdog->budget) {
+        return 0;
+    }
+
+    if (0 < (watchdog->flags & TJS_WATCHDOG_FLAG_ABORT)) return 1;
+
+    watchdog->stats.checks++;
+
+    double now = tjs_clock_now();
+
+    if (now <= watchdog->deadline) return 0;
+
+    if (0 < (watchdog->flags & TJS_WATCHDOG_FLAG_EXPIRED)) {
+        watchdog->flags |= TJS_WATCHDOG_FLAG_ABORT;
+        watchdog->stats.aborts++;
+    } else {
+        watchdog->flags |= TJS_WATCHDOG_FLAG_EXPIRED;
+        watchdog->stats.timeouts++;
+        watchdog->deadline = now + watchdog->budget;
+    }
+
+    return 1;
+}
+
+/**
+ * Collect handlers sorted by max CPU time
+ *
+ * @param[inout]  watchdog  A #TjsWatchdog
+ * @param[inout]  handlers  Array to fill
+ * @param[in]     max       Size of array
+ *
+ * @return Number of collected handlers
+ **/
+
+int tjs_watchdog_slowest(TjsWatchdog *watchdog, TjsWatchdogHandler **handlers,
+        int max)
+{
+    int n = 0;
+
+    for (int i = 0; i < watchdog->nhandlers; i++) {
+        TjsWatchdogHandler *handler = &watchdog->handlers[i];
+
+        /* Insertion sort; lists are short */
+        int j = (n < max ? n++ : max);
+
+        while (0 < j && handlers[j - 1]->maxcpu < handler->maxcpu) {
+            if (j < max) handlers[j] = handlers[j - 1];
+
+            j--;
+        }
+
+        if (j < max) handlers[j] = handler;
+    }
+
+    return n;
+}
+
+/**
+ * Destroy watchdog
+ *
+ * @param[inout]  watchdog  A #TjsWatchdog
+ **/
+
+void tjs_watchdog_destroy(TjsWatchdog *watchdog) {
+    if (NULL != watchdog) {
+        free(watchdog);
+    }
+}
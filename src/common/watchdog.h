@@ -0,0 +1,64 @@
+/**
+ * @package TouchJS
+ *
+ * @file Execution watchdog header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_WATCHDOG_H
+#define TJS_WATCHDOG_H 1
+
+/* Defaults */
+#define TJS_WATCHDOG_BUDGET 1000  ///< Default time budget per callback in ms
+#define TJS_WATCHDOG_HANDLERS 64  ///< Max tracked handlers; last slot collects the rest
+#define TJS_WATCHDOG_DEPTH 16     ///< Max tracked nesting of callbacks
+#define TJS_WATCHDOG_LABEL 96     ///< Max length of handler label
+
+/* Flags */
+#define TJS_WATCHDOG_FLAG_EXPIRED (1 << 0) ///< Budget used up; thrown once
+#define TJS_WATCHDOG_FLAG_ABORT (1 << 1)   ///< Grace used up; keep throwing
+
+/* Types */
+typedef struct tjs_watchdog_handler_t {
+    char label[TJS_WATCHDOG_LABEL]; ///< Kind, function name and file
+
+    unsigned long calls, timeouts;
+    double cpu, maxcpu; ///< Total and max CPU time in ms
+} TjsWatchdogHandler;
+
+typedef struct tjs_watchdog_t {
+    int flags;
+
+    double budget;   ///< Time budget of outermost callback in ms; 0 disables
+    double deadline; ///< Wall clock time the current budget ends
+
+    /* Nesting */
+    int depth;
+    struct {
+        int handler;   ///< Index into handlers
+        double cpu;    ///< CPU time at entry
+    } stack[TJS_WATCHDOG_DEPTH];
+
+    int nhandlers;
+    TjsWatchdogHandler handlers[TJS_WATCHDOG_HANDLERS];
+
+    /* Stats */
+    struct {
+        unsigned long calls, checks, timeouts, aborts;
+    } stats;
+} TjsWatchdog;
+
+/* Methods */
+TjsWatchdog *tjs_watchdog_new(double budget);
+void tjs_watchdog_enter(TjsWatchdog *watchdog, const char *label);
+void tjs_watchdog_leave(TjsWatchdog *watchdog);
+int tjs_watchdog_check(void *udata);
+int tjs_watchdog_slowest(TjsWatchdog *watchdog, TjsWatchdogHandler **handlers,
+    int max);
+void tjs_watchdog_destroy(TjsWatchdog *watchdog);
+
+#endif /* TJS_WATCHDOG_H */
@@ -38,6 +38,7 @@ extern void DFRSystemModalShowsCloseBoxWhenFrontMost(BOOL);
 @end
 
 @interface AppDelegate : NSObject <NSApplicationDelegate, NSTouchBarDelegate>
+- (void)setReaping:(int)nprocs;
 @end
 
 #endif /* TJS_DELEGATE_H */
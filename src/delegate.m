@@ -0,0 +1,459 @@
+/**
+ * @package TouchJS
+ *
+ * @file AppDelegate functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#import <Cocoa/Cocoa.h>
+
+#include "touchjs.h"
+#include "delegate.h"
+#include "embed.h"
+
+#include "touchbar.h"
+
+#include "common/gc.h"
+#include "common/timer.h"
+#include "common/proc.h"
+#include "common/profile.h"
+#include "common/bus.h"
+#include "common/coalesce.h"
+#include "common/logger.h"
+
+#include "wm/wincache.h"
+#include "wm/query.h"
+
+/* Globals */
+static NSTouchBar *touchBar = NULL;
+static NSTimer *wakeup = NULL; ///< Single run-loop source for script timers
+static NSTimer *reaper = NULL; ///< Polls commands that closed their output
+static CFMutableDictionaryRef watched = NULL; ///< Fd -> #CFFileDescriptorRef
+static CFFileDescriptorRef queried = NULL; ///< Wakeup pipe of query workers
+
+/**
+ * Handle readable command output; descriptors fire once and are
+ * re-enabled while their pipe is still watched
+ *
+ * @param[in]  fdRef  A #CFFileDescriptorRef
+ * @param[in]  types  Fired callback types
+ * @param[in]  info   Unused
+ **/
+
+static void tjs_delegate_readable(CFFileDescriptorRef fdRef,
+    CFOptionFlags types, void *info)
+{
+    CFRetain(fdRef); ///< Closing the pipe in the poll drops it
+
+    tjs_command_poll(0); ///< One non-blocking poll for all pipes
+
+    if (CFFileDescriptorIsValid(fdRef)) {
+        CFFileDescriptorEnableCallBacks(fdRef, kCFFileDescriptorReadCallBack);
+    }
+
+    CFRelease(fdRef);
+
+    [(AppDelegate *)[NSApp delegate]
+        setReaping: tjs_procs_reaping(touch.procs)];
+}
+
+/**
+ * Deliver finished queries when the workers wake the run loop
+ *
+ * @param[in]  fdRef  A #CFFileDescriptorRef
+ * @param[in]  types  Fired callback types
+ * @param[in]  info   Unused
+ **/
+
+static void tjs_delegate_queried(CFFileDescriptorRef fdRef,
+    CFOptionFlags types, void *info)
+{
+    /* Apply changes made by the callbacks */
+    if (0 < tjs_query_poll() && 0 == touch.tick) {
+        tjs_touchbar_flush();
+    }
+
+    CFFileDescriptorEnableCallBacks(fdRef, kCFFileDescriptorReadCallBack);
+}
+
+/**
+ * Add or remove run-loop source of command output pipe
+ *
+ * @param[in]  fd     Read end of the pipe
+ * @param[in]  watch  Whether to watch or forget the pipe
+ * @param[in]  arg    Unused
+ **/
+
+static void tjs_delegate_watch(int fd, int watch, void *arg) {
+    const void *key = (const void *)(intptr_t)fd;
+
+    if (watch) {
+        CFFileDescriptorRef fdRef = CFFileDescriptorCreate(kCFAllocatorDefault,
+            fd, false, tjs_delegate_readable, NULL);
+        CFRunLoopSourceRef sourceRef = CFFileDescriptorCreateRunLoopSource(
+            kCFAllocatorDefault, fdRef, 0);
+
+        CFRunLoopAddSource(CFRunLoopGetMain(), sourceRef,
+            kCFRunLoopCommonModes);
+        CFRelease(sourceRef);
+
+        CFFileDescriptorEnableCallBacks(fdRef, kCFFileDescriptorReadCallBack);
+        CFDictionarySetValue(watched, key, fdRef);
+        CFRelease(fdRef);
+    } else {
+        CFFileDescriptorRef fdRef = (CFFileDescriptorRef)CFDictionaryGetValue(
+            watched, key);
+
+        /* Invalidation removes the run-loop source as well */
+        if (NULL != fdRef) {
+            CFFileDescriptorInvalidate(fdRef);
+            CFDictionaryRemoveValue(watched, key);
+        }
+    }
+}
+
+/**
+ * Re-arm wakeup timer for earliest deadline
+ *
+ * @param[in]  delay  Delay in ms; negative disarms
+ * @param[in]  arg    Unused
+ **/
+
+static void tjs_delegate_arm(double delay, void *arg) {
+    [wakeup setFireDate: (0 > delay ? [NSDate distantFuture] :
+        [NSDate dateWithTimeIntervalSinceNow: (delay / 1000.0)])];
+}
+
+@implementation AppDelegate
+
+/**
+ * Handle group touchbar
+ **/
+
+- (NSTouchBar *)groupTouchBar {
+    NSMutableArray *array;
+
+    /* Create if required */
+    if (NULL == touchBar) {
+        NSTouchBar *groupTouchBar = [[NSTouchBar alloc] init];
+
+        array = [NSMutableArray arrayWithCapacity: 1];
+
+        groupTouchBar.delegate = self;
+        groupTouchBar.defaultItemIdentifiers = array;
+
+        touchBar = groupTouchBar;
+    } else {
+        array = [NSMutableArray arrayWithCapacity: 1];
+    }
+
+    /* Collect identifiers */
+    for (int i = 0; i < tjs_embed_count(); i++) {
+        TjsEmbed *embed = tjs_embed_get(i);
+
+        /* Exclude free slots and items with a parent */
+        if (NULL != embed && NULL == embed->parent) {
+            [array addObject: [NSString stringWithUTF8String: embed->identifier]];
+        }
+    }
+
+    [array addObject: kQuit];
+
+    touchBar.defaultItemIdentifiers = array;
+
+    return touchBar;
+}
+
+/**
+ * Set group touch bar
+ *
+ * @param[inout]  groupTouchBar  Touchbar to add to window
+ **/
+
+-(void)setGroupTouchBar:(NSTouchBar*)groupTouchBar {
+    touchBar = groupTouchBar;
+}
+
+/**
+ * Handle send event: button
+ *
+ * @param[in]  sender  Sender of this event
+ **/
+
+- (void)button:(id)sender {
+    tjs_touchbar_click([sender tag]);
+}
+
+/**
+ * Handle send event: slider
+ *
+ * @param[in]  sender  Sender of this event
+ **/
+
+- (void)slider:(id)sender {
+    tjs_touchbar_slide([sender tag], [((NSSlider *)sender) doubleValue]);
+}
+
+/**
+ * Handle timer event: flush
+ *
+ * @param[in]  timer  Timer of this event
+ **/
+
+- (void)flush:(NSTimer *)timer {
+    tjs_touchbar_flush();
+}
+
+/**
+ * Handle timer event: idle gc
+ *
+ * @param[in]  timer  Timer of this event
+ **/
+
+- (void)collect:(NSTimer *)timer {
+    tjs_gc_poll(touch.gc, touch.heaps, touch.nheaps);
+}
+
+/**
+ * Handle timer event: script timers
+ *
+ * @param[in]  timer  Timer of this event
+ **/
+
+- (void)wakeup:(NSTimer *)timer {
+    tjs_global_timers_run(); ///< Re-arms via tjs_delegate_arm
+}
+
+/**
+ * Handle timer event: reap commands
+ *
+ * @param[in]  timer  Timer of this event
+ **/
+
+- (void)reap:(NSTimer *)timer {
+    tjs_command_poll(0);
+
+    [self setReaping: tjs_procs_reaping(touch.procs)];
+}
+
+/**
+ * Start or stop reaping of commands that closed their output
+ *
+ * @param[in]  nprocs  Number of commands without output pipe
+ **/
+
+- (void)setReaping:(int)nprocs {
+    if (0 < nprocs && NULL == reaper) {
+        reaper = [NSTimer scheduledTimerWithTimeInterval:
+            (TJS_PROC_REAP_INTERVAL / 1000.0) target: self
+            selector: @selector(reap:) userInfo: nil repeats: YES];
+    } else if (0 == nprocs && NULL != reaper) {
+        [reaper invalidate];
+
+        reaper = NULL;
+    }
+}
+
+/**
+ * Handle send event: present
+ *
+ * @param[in]  sender  Sender of this event
+ **/
+
+- (void)present:(id)sender {
+    if (@available(macOS 10.14, *)) {
+        [NSTouchBar presentSystemModalTouchBar: self.groupTouchBar
+            systemTrayItemIdentifier: kGroupButton];
+    } else {
+        [NSTouchBar presentSystemModalFunctionBar: self.groupTouchBar
+            systemTrayItemIdentifier: kGroupButton];
+    }
+}
+
+/**
+ * Make items for identifiers
+ *
+ * @param[in]  identifier  Touch item identifier
+ **/
+
+- (NSTouchBarItem *)touchBar:(NSTouchBar *)touchBar
+       makeItemForIdentifier:(NSTouchBarItemIdentifier)identifier
+{
+    NSCustomTouchBarItem *item = NULL;
+
+    /* Check identifiers */
+    if ([identifier isEqualToString: kQuit]) {
+        item = [[NSCustomTouchBarItem alloc] initWithIdentifier: kQuit];
+
+        item.view = [NSButton buttonWithTitle:@"Quit"
+            target:[NSApplication sharedApplication]
+            action: @selector(terminate:)];
+    } else {
+        /* Create widgets */
+        for (int i = 0; i < tjs_embed_count(); i++) {
+            TjsEmbed *embed = tjs_embed_get(i);
+
+            if (NULL != embed && 0 == strcmp([identifier UTF8String], embed->identifier)) {
+                item = [[NSCustomTouchBarItem alloc]
+                    initWithIdentifier: identifier];
+
+                tjs_embed_configure(embed);
+                tjs_embed_update(embed);
+
+                item.view = (NSView *)embed->view;
+            }
+        }
+    }
+
+    return item;
+}
+
+/**
+ * Handle application launch finish
+ *
+ * @param[inout]  aNotification  Notification sent to app
+ **/
+
+- (void)applicationDidFinishLaunching:(NSNotification *)aNotification {
+    DFRSystemModalShowsCloseBoxWhenFrontMost(YES);
+
+    NSCustomTouchBarItem *item = [[NSCustomTouchBarItem alloc]
+        initWithIdentifier: kGroupButton];
+
+    NSMutableAttributedString *aString = [[NSMutableAttributedString alloc]
+        initWithString: @"\U0001F4A9"];
+
+    NSButton *aButton = [NSButton buttonWithTitle:@"tjs"
+        target: self action: @selector(present:)];
+
+    CTFontRef aFont = CTFontCreateWithName((__bridge CFStringRef)@"AppleColorEmoji", 0.0f, NULL);
+
+    if (aFont) {
+        [aString addAttribute: (__bridge NSString *)kCTFontAttributeName
+            value: (__bridge id)aFont
+            range: NSMakeRange(0, MIN([aString length], 1))];
+
+        CFRelease(aFont);
+    }
+
+    [aButton setAttributedTitle: aString];
+
+    item.view = aButton;
+
+    //item.view = [NSButton buttonWithTitle:@"\U0001F4A9"
+    //    target: self action: @selector(present:)];
+
+
+    [NSTouchBarItem addSystemTrayItem: item];
+
+    DFRElementSetControlStripPresenceForIdentifier(kGroupButton, YES);
+
+    /* Flush updates periodically instead of after each dispatch */
+    if (0 < touch.tick) {
+        [NSTimer scheduledTimerWithTimeInterval: (touch.tick / 1000.0)
+            target: self selector: @selector(flush:) userInfo: nil repeats: YES];
+    }
+
+    /* Timers of the initial script run might be pending already */
+    wakeup = [NSTimer scheduledTimerWithTimeInterval: DBL_MAX
+        target: self selector: @selector(wakeup:) userInfo: nil repeats: YES];
+
+    touch.timers->arm = tjs_delegate_arm;
+
+    tjs_delegate_arm(tjs_timers_delay(touch.timers), NULL);
+
+    /* Commands of the initial script run might be running already */
+    watched = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL,
+        &kCFTypeDictionaryValueCallBacks);
+
+    touch.procs->watch = tjs_delegate_watch;
+
+    for (int i = 0; i < touch.procs->nprocs; i++) {
+        if (-1 != touch.procs->procs[i]->fd) {
+            tjs_delegate_watch(touch.procs->procs[i]->fd, 1, NULL);
+        }
+    }
+
+    [self setReaping: tjs_procs_reaping(touch.procs)];
+
+    /* Finished queries wake the run loop; deadlines use a script timer */
+    if (-1 != tjs_query_fd()) {
+        queried = CFFileDescriptorCreate(kCFAllocatorDefault, tjs_query_fd(),
+            false, tjs_delegate_queried, NULL);
+
+        CFRunLoopSourceRef sourceRef = CFFileDescriptorCreateRunLoopSource(
+            kCFAllocatorDefault, queried, 0);
+
+        CFRunLoopAddSource(CFRunLoopGetMain(), sourceRef,
+            kCFRunLoopCommonModes);
+        CFRelease(sourceRef);
+
+        CFFileDescriptorEnableCallBacks(queried, kCFFileDescriptorReadCallBack);
+    }
+
+    /* Check for idle periods; polling at half the period bounds the delay */
+    if (NULL != touch.gc) {
+        [NSTimer scheduledTimerWithTimeInterval: (touch.gc->idle / 2000.0)
+            target: self selector: @selector(collect:) userInfo: nil repeats: YES];
+    }
+}
+
+/**
+ * Handle application termination
+ *
+ * @param[inout]  aNotification  Notification sent to app
+ **/
+
+- (void)applicationWillTerminate:(NSNotification *)aNotification {
+    /* Quit exits from within the run loop; main never gets to tidy up */
+    if (NULL != touch.profile) {
+        tjs_profile_write(touch.profile);
+        tjs_profile_report(touch.profile);
+    }
+
+    /* Pipe is closed with the query workers */
+    if (NULL != queried) {
+        CFFileDescriptorInvalidate(queried);
+        CFRelease(queried);
+
+        queried = NULL;
+    }
+
+    /* Stop query workers and app observers; both use the primary heap */
+    tjs_wm_deinit();
+
+    tjs_touchbar_deinit();
+    tjs_embed_deinit();
+
+    for (int i = 0; i < touch.nheaps; i++) {
+        duk_destroy_heap(touch.heaps[i]);
+    }
+
+    touch.ctx = NULL;
+    touch.nheaps = 0;
+
+    /* Finalizers release windows through the cache */
+    tjs_wincache_deinit();
+
+    tjs_bus_destroy(touch.bus);
+    tjs_coalesce_destroy(touch.coalesce);
+
+    touch.bus = NULL;
+    touch.coalesce = NULL;
+
+    [touchBar release];
+
+    touchBar = NULL;
+
+    /* Drain log last; the writer thread dies with the process */
+    TjsLogger *logger = touch.logger;
+
+    touch.logger = NULL;
+
+    tjs_logger_destroy(logger);
+}
+@end
@@ -0,0 +1,250 @@
+/**
+ * @package TouchJS
+ *
+ * @file Embed functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include "touchjs.h"
+#include "embed.h"
+#include "widgets/widget.h"
+
+#include "common/registry.h"
+
+/* Globals */
+static TjsRegistry *embedded = NULL;
+static const TjsBackend *backend = NULL;
+
+/**
+ * Create new embed item; pops object from stack top
+ *
+ * @param[inout]  ctx       A #duk_context of the owning heap
+ * @param[inout]  userdata  A #TjsUserdata
+ * @param[inout]  parent    A #TjsUserdata
+ **/
+
+TjsEmbed *tjs_embed_new(duk_context *ctx, TjsUserdata *userdata,
+    TjsUserdata *parent)
+{
+    /* Create new embed */
+    TjsEmbed *embed = (TjsEmbed *)calloc(1, sizeof(TjsEmbed));
+
+    /* Store in registry; the object is consumed either way */
+    if (NULL == embed ||
+            -1 == (embed->idx = tjs_registry_add(embedded, userdata, embed)))
+    {
+        free(embed);
+        duk_pop(ctx);
+
+        return NULL;
+    }
+
+    embed->flags = TJS_FLAG_TYPE_EMBED;
+    embed->ctx = ctx;
+    embed->userdata = userdata;
+    embed->parent = parent;
+
+    snprintf(embed->identifier, sizeof(embed->identifier),
+        "org.subforge.embed%d", embed->idx);
+
+    /* Store global in context */
+    duk_put_global_string(ctx, embed->identifier);
+
+    return embed;
+}
+
+/**
+ * Create view of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+void tjs_embed_create(TjsEmbed *embed) {
+    /* Sanity check */
+    if (NULL != embed &&
+            0 < (embed->flags & TJS_FLAG_TYPE_EMBED) &&
+            0 == (embed->flags & TJS_FLAG_STATE_CREATED) &&
+            NULL != embed->userdata)
+    {
+        backend->create(embed);
+
+        /* Mark as ready and update it */
+        embed->flags |= TJS_FLAG_STATE_CREATED;
+    }
+}
+
+/**
+ * Update embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+void tjs_embed_update(TjsEmbed *embed) {
+    if (NULL != embed && 0 < (embed->flags & TJS_FLAG_TYPE_EMBED)) {
+        tjs_embed_color(embed);
+        tjs_embed_value(embed);
+    }
+}
+
+/**
+ * Configure view of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+ void tjs_embed_configure(TjsEmbed *embed) {
+    /* Sanity check */
+    if (NULL != embed &&
+        0 < (embed->flags & TJS_FLAG_TYPE_EMBED) &&
+        0 == (embed->flags & TJS_FLAG_STATE_CONFIGURED) && NULL != embed->userdata)
+    {
+        backend->configure(embed);
+
+        /* Mark as configured */
+        embed->flags |= TJS_FLAG_STATE_CONFIGURED;
+    }
+ }
+
+/**
+ * Update color of touch item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+void tjs_embed_color(TjsEmbed *embed) {
+    /* Sanity checks */
+    if (NULL != embed &&
+        0 < (embed->flags & TJS_FLAG_TYPE_EMBED) && NULL != embed->userdata &&
+        0 < (embed->userdata->flags & TJS_FLAGS_COLORS))
+    {
+        TjsWidget *widget = (TjsWidget *)(embed->userdata);
+
+        if (0 < (widget->flags & TJS_FLAG_STATE_COLOR_FG)) {
+            backend->color(embed, TJS_FLAG_STATE_COLOR_FG, &(widget->colors.fg));
+        }
+
+        if (0 < (widget->flags & TJS_FLAG_STATE_COLOR_BG)) {
+            backend->color(embed, TJS_FLAG_STATE_COLOR_BG, &(widget->colors.bg));
+        }
+
+        /* Remove flags if ready */
+        if (0 < (embed->flags & TJS_FLAG_STATE_CREATED)) {
+            widget->flags &= ~TJS_FLAGS_COLORS;
+        }
+    }
+}
+
+/**
+ * Update value of embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+void tjs_embed_value(TjsEmbed *embed) {
+    /* Sanity check */
+    if (NULL != embed &&
+        0 < (embed->flags & TJS_FLAG_TYPE_EMBED) && NULL != embed->userdata &&
+        0 < (embed->userdata->flags & TJS_FLAG_STATE_VALUE))
+    {
+        TjsWidget *widget = (TjsWidget *)(embed->userdata);
+
+        backend->value(embed, &(widget->value));
+
+        /* Remove flags if ready */
+        if (0 < (embed->flags & TJS_FLAG_STATE_CREATED)) {
+            widget->flags &= ~TJS_FLAG_STATE_VALUE;
+        }
+    }
+}
+
+/**
+ * Destroy given embed item
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ **/
+
+void tjs_embed_destroy(TjsEmbed *embed) {
+    if (NULL != embed && 0 < (embed->flags & TJS_FLAG_TYPE_EMBED)) {
+        /* Overwrite global string with null aka remove it */
+        duk_push_null(embed->ctx);
+        duk_put_global_string(embed->ctx, embed->identifier);
+
+        if (0 < (embed->flags & TJS_FLAG_STATE_CREATED)) {
+            backend->destroy(embed);
+        }
+
+        /* Release slot for re-use; userdata belongs to its JS object */
+        tjs_registry_remove(embedded, embed->userdata);
+
+        free(embed);
+    }
+}
+
+/**
+ * Get count of element slots
+ *
+ * Slots of destroyed items are re-used, so #tjs_embed_get can return
+ * NULL for indices below this count
+ *
+ * @return Number of element slots
+ **/
+
+int tjs_embed_count(void) {
+    return tjs_registry_size(embedded);
+}
+
+/**
+ * Find embed item based on userdata
+ *
+ * @param[in]   userdata  A #TjsUserdata
+ * @param[out]  idx       Idx of found item; otherwise -1
+ *
+ * @return Either found #TjsEmbed; otherwise NULL
+ **/
+
+TjsEmbed *tjs_embed_find(TjsUserdata *userdata, int *idx) {
+    return (TjsEmbed *)tjs_registry_find(embedded, userdata, idx);
+}
+
+/**
+ * Get embed based on index
+ *
+ * @param[in]  idx  Index to get
+ *
+ * @return Either found #TjsEmbed; otherwise #NULL
+ **/
+
+TjsEmbed *tjs_embed_get(int idx) {
+    return (TjsEmbed *)tjs_registry_get(embedded, idx);
+}
+
+/**
+ * Init embeddng
+ *
+ * @param[in]  renderer  A #TjsBackend to render embed items
+ **/
+
+void tjs_embed_init(const TjsBackend *renderer) {
+    backend = renderer;
+    embedded = tjs_registry_new();
+}
+
+/**
+ * Deinit embeddng
+ **/
+
+void tjs_embed_deinit(void) {
+    for (int i = 0; i < tjs_embed_count(); i++) {
+        TjsEmbed *embed = tjs_embed_get(i);
+
+        tjs_embed_destroy(embed);
+    }
+
+    tjs_registry_destroy(embedded);
+
+    embedded = NULL;
+}
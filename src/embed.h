@@ -13,25 +13,39 @@
 #define TJS_EMBED_H 1
 
 /* Includes */
-#import <Cocoa/Cocoa.h>
-
 #include "libs/duktape/duktape.h"
 #include "common/userdata.h"
+#include "common/value.h"
+#include "widgets/widget.h"
 
 /* Types */
 typedef struct tjs_embed_t {
     int idx, flags;
 
+    duk_context *ctx; ///< Owning heap; callbacks are dispatched there
+
     struct tjs_userdata_t *userdata;
     struct tjs_userdata_t *parent;
 
-    /* Obj-c */
-    NSTouchBarItemIdentifier identifier;
-    NSView *view;
+    char identifier[32];
+
+    /* Backend */
+    void *view;
 } TjsEmbed;
 
+typedef struct tjs_backend_t {
+    const char *name;
+
+    void (*create)(TjsEmbed *embed);
+    void (*configure)(TjsEmbed *embed);
+    void (*color)(TjsEmbed *embed, int flag, TjsColor *color);
+    void (*value)(TjsEmbed *embed, TjsValue *value);
+    void (*destroy)(TjsEmbed *embed);
+} TjsBackend;
+
 /* Methods */
-TjsEmbed *tjs_embed_new(TjsUserdata *userdata, TjsUserdata *parent);
+TjsEmbed *tjs_embed_new(duk_context *ctx, TjsUserdata *userdata,
+    TjsUserdata *parent);
 void tjs_embed_create(TjsEmbed *embed);
 void tjs_embed_configure(TjsEmbed *embed);
 void tjs_embed_update(TjsEmbed *embed);
@@ -43,7 +57,7 @@ TjsEmbed *tjs_embed_find(TjsUserdata *userdata, int *idx);
 TjsEmbed *tjs_embed_get(int idx);
 int tjs_embed_count();
 
-void tjs_embed_init(void);
+void tjs_embed_init(const TjsBackend *backend);
 void tjs_embed_deinit(void);
 
-#endif /* TJS_EMBED_H */
\ No newline at end of file
+#endif /* TJS_EMBED_H */
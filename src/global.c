@@ -14,6 +14,34 @@
 #include "touchbar.h"
 
 #include "common/userdata.h"
+#include "common/alloc.h"
+#include "common/gc.h"
+#include "common/timer.h"
+#include "common/callback.h"
+#include "common/watchdog.h"
+#include "common/syms.h"
+
+#include "wm/wincache.h"
+#include "wm/query.h"
+
+/* Types */
+typedef struct tjs_global_type_t {
+    int flag;
+    const char *name;
+} TjsGlobalType;
+
+/* Globals */
+static const TjsGlobalType types[] = {
+    { TJS_FLAG_TYPE_COMMAND, "command" },
+    { TJS_FLAG_TYPE_WM, "wm" },
+    { TJS_FLAG_TYPE_SCREEN, "screen" },
+    { TJS_FLAG_TYPE_WIN, "win" },
+    { TJS_FLAG_TYPE_SNAPSHOT, "snapshot" },
+    { TJS_FLAG_TYPE_LABEL, "label" },
+    { TJS_FLAG_TYPE_BUTTON, "button" },
+    { TJS_FLAG_TYPE_SLIDER, "slider" },
+    { TJS_FLAG_TYPE_SCRUBBER, "scrubber" }
+};
 
 /**
  * Native print method
@@ -109,6 +137,361 @@ static duk_ret_t tjs_global_detach(duk_context *ctx) {
     return 0;
 }
 
+/**
+ * Native allocstats method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_global_allocstats(duk_context *ctx) {
+    TjsAlloc *alloc = touch.alloc;
+
+    if (NULL == alloc) return 0;
+
+    /* Push stats object */
+    duk_idx_t idx = duk_push_object(ctx);
+
+    duk_push_string(ctx, (TJS_ALLOC_MODE_POOL == alloc->mode ?
+        "pool" : "malloc"));
+    duk_put_prop_string(ctx, idx, "mode");
+    duk_push_number(ctx, alloc->stats.live);
+    duk_put_prop_string(ctx, idx, "live");
+    duk_push_number(ctx, alloc->stats.peak);
+    duk_put_prop_string(ctx, idx, "peak");
+    duk_push_number(ctx, alloc->stats.slabbytes);
+    duk_put_prop_string(ctx, idx, "slabs");
+    duk_push_number(ctx, alloc->stats.allocs);
+    duk_put_prop_string(ctx, idx, "allocs");
+    duk_push_number(ctx, alloc->stats.frees);
+    duk_put_prop_string(ctx, idx, "frees");
+    duk_push_number(ctx, alloc->stats.reallocs);
+    duk_put_prop_string(ctx, idx, "reallocs");
+    duk_push_number(ctx, alloc->stats.large);
+    duk_put_prop_string(ctx, idx, "large");
+    duk_push_number(ctx, tjs_alloc_rate(alloc));
+    duk_put_prop_string(ctx, idx, "rate");
+
+    return 1;
+}
+
+/**
+ * Native memstats method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_global_memstats(duk_context *ctx) {
+    const TjsUserdataStats *stats = tjs_userdata_stats();
+
+    duk_idx_t idx = duk_push_object(ctx);
+
+    /* Heap of the caller; total covers all heaps */
+    duk_memory_functions funcs;
+
+    duk_get_memory_functions(ctx, &funcs);
+
+    if (NULL != touch.alloc && tjs_alloc_duk_alloc == funcs.alloc_func) {
+        TjsAllocHeap *heap = (TjsAllocHeap *)funcs.udata;
+
+        duk_push_number(ctx, heap->live);
+        duk_put_prop_string(ctx, idx, "heap");
+        duk_push_number(ctx, heap->peak);
+        duk_put_prop_string(ctx, idx, "peak");
+        duk_push_number(ctx, heap->limit);
+        duk_put_prop_string(ctx, idx, "limit");
+        duk_push_number(ctx, heap->denied);
+        duk_put_prop_string(ctx, idx, "denied");
+        duk_push_number(ctx, touch.alloc->stats.live);
+        duk_put_prop_string(ctx, idx, "total");
+    }
+
+    duk_push_number(ctx, tjs_alloc_rss());
+    duk_put_prop_string(ctx, idx, "rss");
+
+    /* Live objects by native type */
+    duk_idx_t objidx = duk_push_object(ctx);
+
+    for (int i = 0; i < (int)(sizeof(types) / sizeof(types[0])); i++) {
+        for (int bit = 0; bit < TJS_USERDATA_NTYPES; bit++) {
+            if ((1L << bit) == types[i].flag) {
+                duk_push_number(ctx, stats->live[bit]);
+                duk_put_prop_string(ctx, objidx, types[i].name);
+            }
+        }
+    }
+
+    duk_put_prop_string(ctx, idx, "objects");
+
+    duk_push_number(ctx, stats->created);
+    duk_put_prop_string(ctx, idx, "created");
+    duk_push_number(ctx, stats->destroyed);
+    duk_put_prop_string(ctx, idx, "destroyed");
+    duk_push_number(ctx, stats->finalized);
+    duk_put_prop_string(ctx, idx, "finalized");
+
+    /* Idle gc */
+    if (NULL != touch.gc) {
+        duk_push_number(ctx, touch.gc->stats.runs);
+        duk_put_prop_string(ctx, idx, "gcRuns");
+        duk_push_number(ctx, touch.gc->stats.total);
+        duk_put_prop_string(ctx, idx, "gcTime");
+    }
+
+    /* Window identity cache */
+    const TjsWincacheStats *wstats = tjs_wincache_stats();
+    duk_idx_t winidx = duk_push_object(ctx);
+
+    duk_push_int(ctx, tjs_wincache_count());
+    duk_put_prop_string(ctx, winidx, "size");
+    duk_push_number(ctx, wstats->hits);
+    duk_put_prop_string(ctx, winidx, "hits");
+    duk_push_number(ctx, wstats->misses);
+    duk_put_prop_string(ctx, winidx, "misses");
+    duk_push_number(ctx, wstats->evictions);
+    duk_put_prop_string(ctx, winidx, "evictions");
+    duk_push_number(ctx, wstats->finalized);
+    duk_put_prop_string(ctx, winidx, "finalized");
+    duk_push_int(ctx, tjs_wincache_attrcount());
+    duk_put_prop_string(ctx, winidx, "attrs");
+    duk_push_number(ctx, wstats->attrhits);
+    duk_put_prop_string(ctx, winidx, "attrHits");
+    duk_push_number(ctx, wstats->attrmisses);
+    duk_put_prop_string(ctx, winidx, "attrMisses");
+
+    duk_put_prop_string(ctx, idx, "wincache");
+
+    return 1;
+}
+
+/**
+ * Helper to add timer and keep its callback
+ *
+ * @param[inout]  ctx     A #duk_context
+ * @param[in]     repeat  Whether to repeat the timer
+ **/
+
+static duk_ret_t tjs_global_add_timer(duk_context *ctx, int repeat) {
+    duk_require_function(ctx, 0);
+
+    double delay = duk_get_number_default(ctx, 1, 0);
+
+    unsigned long id = tjs_timers_add(touch.timers, delay,
+        (repeat ? delay : 0));
+
+    /* Keep callback reachable until the timer is done */
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_TIMERS);
+    duk_dup(ctx, 0);
+    duk_put_prop_index(ctx, -2, (duk_uarridx_t)id);
+    duk_pop_2(ctx);
+
+    duk_push_number(ctx, id);
+
+    return 1;
+}
+
+/**
+ * Helper to call callback of fired timer; ids are shared by all heaps
+ * and the callback is stored in the stash of the heap that added it
+ *
+ * @param[in]     id      Timer id
+ * @param[in]     repeat  Whether the timer repeats
+ * @param[inout]  arg     Unused
+ **/
+
+static void tjs_global_fire_timer(unsigned long id, int repeat, void *arg) {
+    duk_context *ctx = NULL;
+
+    (void)arg;
+
+    for (int i = 0; i < touch.nheaps && NULL == ctx; i++) {
+        duk_push_heap_stash(touch.heaps[i]);
+        duk_get_prop_string(touch.heaps[i], -1, TJS_SYM_TIMERS);
+
+        if (duk_has_prop_index(touch.heaps[i], -1, (duk_uarridx_t)id)) {
+            ctx = touch.heaps[i];
+        } else {
+            duk_pop_2(touch.heaps[i]);
+        }
+    }
+
+    if (NULL == ctx) return;
+
+    duk_get_prop_index(ctx, -1, (duk_uarridx_t)id);
+
+    /* One-shots are done now */
+    if (!repeat) {
+        duk_del_prop_index(ctx, -2, (duk_uarridx_t)id);
+    }
+
+    if (duk_is_callable(ctx, -1)) {
+        if (DUK_EXEC_SUCCESS != tjs_callback_pcall(ctx,
+                "timer", 0, 0))
+        {
+            TJS_LOG_ERROR("Failed to call timer %lu: %s", id,
+                duk_safe_to_string(ctx, -1));
+
+            touch.timers->stats.errors++;
+        }
+    }
+
+    duk_pop_3(ctx);
+}
+
+/**
+ * Run due timers of all heaps
+ *
+ * @return Number of fired timers
+ **/
+
+int tjs_global_timers_run(void) {
+    int nfired = tjs_timers_run(touch.timers, tjs_global_fire_timer, NULL);
+
+    if (0 < nfired) {
+        tjs_gc_activity(touch.gc);
+
+        /* Apply changes made by the callbacks */
+        if (0 == touch.tick) {
+            tjs_touchbar_flush();
+        }
+    }
+
+    return nfired;
+}
+
+/**
+ * Native setTimeout method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_global_settimeout(duk_context *ctx) {
+    return tjs_global_add_timer(ctx, 0);
+}
+
+/**
+ * Native setInterval method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_global_setinterval(duk_context *ctx) {
+    return tjs_global_add_timer(ctx, 1);
+}
+
+/**
+ * Native clearTimer method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_global_cleartimer(duk_context *ctx) {
+    unsigned long id = (unsigned long)duk_require_number(ctx, 0);
+
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_TIMERS);
+
+    /* Ids are shared by all heaps; only clear timers of this one */
+    if (duk_has_prop_index(ctx, -1, (duk_uarridx_t)id) &&
+            tjs_timers_clear(touch.timers, id))
+    {
+        duk_del_prop_index(ctx, -1, (duk_uarridx_t)id);
+    }
+
+    duk_pop_2(ctx);
+
+    return 0;
+}
+
+/**
+ * Native timerstats method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_global_timerstats(duk_context *ctx) {
+    duk_idx_t idx = duk_push_object(ctx);
+
+    duk_push_int(ctx, tjs_timers_count(touch.timers));
+    duk_put_prop_string(ctx, idx, "pending");
+    duk_push_number(ctx, touch.timers->stats.scheduled);
+    duk_put_prop_string(ctx, idx, "scheduled");
+    duk_push_number(ctx, touch.timers->stats.fired);
+    duk_put_prop_string(ctx, idx, "fired");
+    duk_push_number(ctx, touch.timers->stats.cleared);
+    duk_put_prop_string(ctx, idx, "cleared");
+    duk_push_number(ctx, touch.timers->stats.wakeups);
+    duk_put_prop_string(ctx, idx, "wakeups");
+    duk_push_number(ctx, touch.timers->stats.rearms);
+    duk_put_prop_string(ctx, idx, "rearms");
+    duk_push_number(ctx, tjs_timers_now(touch.timers));
+    duk_put_prop_string(ctx, idx, "now");
+
+    return 1;
+}
+
+/**
+ * Native querystats method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_global_querystats(duk_context *ctx) {
+    tjs_query_putstats(ctx, duk_push_object(ctx));
+
+    return 1;
+}
+
+/**
+ * Native watchdog method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_global_watchdog(duk_context *ctx) {
+    TjsWatchdog *watchdog = touch.watchdog;
+    TjsWatchdogHandler *handlers[TJS_WATCHDOG_HANDLERS];
+
+    duk_idx_t idx = duk_push_object(ctx);
+
+    if (NULL == watchdog) return 1;
+
+    duk_push_number(ctx, watchdog->budget);
+    duk_put_prop_string(ctx, idx, "budget");
+    duk_push_number(ctx, watchdog->stats.calls);
+    duk_put_prop_string(ctx, idx, "calls");
+    duk_push_number(ctx, watchdog->stats.timeouts);
+    duk_put_prop_string(ctx, idx, "timeouts");
+    duk_push_number(ctx, watchdog->stats.aborts);
+    duk_put_prop_string(ctx, idx, "aborts");
+
+    /* Handlers; slowest first */
+    int n = tjs_watchdog_slowest(watchdog, handlers, TJS_WATCHDOG_HANDLERS);
+
+    duk_idx_t arridx = duk_push_array(ctx);
+
+    for (int i = 0; i < n; i++) {
+        duk_idx_t objidx = duk_push_object(ctx);
+
+        duk_push_string(ctx, handlers[i]->label);
+        duk_put_prop_string(ctx, objidx, "name");
+        duk_push_number(ctx, handlers[i]->calls);
+        duk_put_prop_string(ctx, objidx, "calls");
+        duk_push_number(ctx, handlers[i]->timeouts);
+        duk_put_prop_string(ctx, objidx, "timeouts");
+        duk_push_number(ctx, handlers[i]->cpu);
+        duk_put_prop_string(ctx, objidx, "cpu");
+        duk_push_number(ctx, handlers[i]->maxcpu);
+        duk_put_prop_string(ctx, objidx, "maxCpu");
+
+        duk_put_prop_index(ctx, arridx, i);
+    }
+
+    duk_put_prop_string(ctx, idx, "handlers");
+
+    return 1;
+}
+
 /**
  * Native quit method
  *
@@ -145,6 +528,32 @@ void tjs_global_init(duk_context *ctx) {
     duk_push_c_function(ctx, tjs_global_detach, 1);
     duk_put_global_string(ctx, "tjs_rgb");
 
+    duk_push_c_function(ctx, tjs_global_allocstats, 0);
+    duk_put_global_string(ctx, "tjs_allocstats");
+
+    duk_push_c_function(ctx, tjs_global_memstats, 0);
+    duk_put_global_string(ctx, "tjs_memstats");
+
+    duk_push_c_function(ctx, tjs_global_watchdog, 0);
+    duk_put_global_string(ctx, "tjs_watchdog");
+
+    duk_push_c_function(ctx, tjs_global_settimeout, 2);
+    duk_put_global_string(ctx, "tjs_setTimeout");
+    duk_push_c_function(ctx, tjs_global_setinterval, 2);
+    duk_put_global_string(ctx, "tjs_setInterval");
+    duk_push_c_function(ctx, tjs_global_cleartimer, 1);
+    duk_put_global_string(ctx, "tjs_clearTimer");
+    duk_push_c_function(ctx, tjs_global_timerstats, 0);
+    duk_put_global_string(ctx, "tjs_timerstats");
+    duk_push_c_function(ctx, tjs_global_querystats, 0);
+    duk_put_global_string(ctx, "tjs_querystats");
+
+    /* Callbacks of pending timers */
+    duk_push_heap_stash(ctx);
+    duk_push_object(ctx);
+    duk_put_prop_string(ctx, -2, TJS_SYM_TIMERS);
+    duk_pop(ctx);
+
     duk_push_c_function(ctx, tjs_global_quit, 0);
     duk_put_global_string(ctx, "tjs_quit");
 }
\ No newline at end of file
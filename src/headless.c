@@ -0,0 +1,766 @@
+/**
+ * @package TouchJS
+ *
+ * @file Headless main functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include "touchjs.h"
+#include "embed.h"
+#include "touchbar.h"
+#include "loadgen.h"
+
+#include "common/bytecode.h"
+#include "common/loader.h"
+#include "common/alloc.h"
+#include "common/gc.h"
+#include "common/timer.h"
+#include "common/proc.h"
+#include "common/exec.h"
+#include "common/clock.h"
+#include "common/watchdog.h"
+#include "common/profile.h"
+#include "common/logger.h"
+#include "common/bus.h"
+#include "common/coalesce.h"
+#include "common/userdata.h"
+#include "common/histogram.h"
+
+#include "backends/headless.h"
+
+#include "wm/fake.h"
+#include "wm/wincache.h"
+#include "wm/apps.h"
+#include "wm/query.h"
+
+/* Types */
+typedef struct tjs_headless_options_t {
+    int mode, idle, count, dump, synth, tflags, nexec, nheaps;
+    double rate, slack, runfor, budget, quiet, maxdelay;
+    size_t limit;
+
+    int nfiles;
+    char **files;
+
+    const char *replay, *json, *tracefile, *profile, *logfile;
+
+    TjsLoadgen *loadgen;
+} TjsHeadlessOptions;
+
+/* Globals */
+TjsTouch touch;
+
+/******************************
+ *           Helper           *
+ ******************************/
+
+/**
+ * Print usage info
+ **/
+
+static void tjs_usage(void) {
+    fprintf(stderr, "Usage: %s [OPTIONS]\n\n" \
+           "Options:\n" \
+           "  -A NUM            Query window attributes on NUM worker\n" \
+           "                    threads (default 4, max 16)\n" \
+           "  -a MODE           Allocator: pool (default) or malloc\n" \
+           "  -b MSEC           Abort callbacks running longer than MSEC;\n" \
+           "                    0 disables (default 1000)\n" \
+           "  -C QUIET[:MAXDELAY]\n" \
+           "                    Collapse window move and resize storms;\n" \
+           "                    deliver after QUIET ms without events or\n" \
+           "                    MAXDELAY ms after the first one\n" \
+           "  -c                Cache compiled bytecode next to FILE\n" \
+           "  -e EVENT          Inject event after loading:\n" \
+           "                      click:IDX       => Click embed IDX\n" \
+           "                      slide:IDX:VALUE => Slide embed IDX to VALUE\n" \
+           "                    can be given multiple times\n" \
+           "  -F                Use fake clock for timers; time jumps\n" \
+           "                    to the next wakeup\n" \
+           "  -G MSEC           Run gc after MSEC of idle time\n" \
+           "  -f FILE|DIR       Eval file or all *.js files of DIR;\n" \
+           "                    can be given multiple times\n" \
+           "  -g TYPE           Generate click or slide events across\n" \
+           "                    all buttons or sliders\n" \
+           "  -h                Show this help and exit\n" \
+           "  -I NUM            Load files round-robin into NUM isolated\n" \
+           "                    heaps (default 1, max 8)\n" \
+           "  -j FILE           Write latency histograms as JSON to FILE\n" \
+           "                    or - for stdout\n" \
+           "  -L                Dump backend op log to stdout\n" \
+           "  -m SIZE[K|M|G]    Cap memory of each heap and its userdata\n" \
+           "                    at SIZE\n" \
+           "  -n COUNT          Number of generated events (default 1000)\n" \
+           "  -o FILE           Log JSON lines from a writer thread to\n" \
+           "                    FILE or - for stderr\n" \
+           "  -p FILE           Profile callbacks; write collapsed stacks\n" \
+           "                    for flame graphs to FILE or - for stdout\n" \
+           "  -r RATE           Generated events per second; 0 dispatches\n" \
+           "                    back-to-back (default)\n" \
+           "  -R FILE           Replay recorded trace FILE\n" \
+           "  -S MSEC           Coalesce timers due within MSEC\n" \
+           "                    (default 10)\n" \
+           "  -T FILE           Record dispatched events to trace FILE\n" \
+           "  -t MSEC           Flush widget updates every MSEC\n" \
+           "                    instead of after each event\n" \
+           "  -v                Show version info and exit\n" \
+           "  -x NUM            Run at most NUM commands at once; 0 is\n" \
+           "                    unlimited (default 8)\n" \
+           "  -w MSEC           Run timers and commands for MSEC\n" \
+           "                    after all events\n" \
+           "  -l LEVEL[:RATE][,LEVEL[:RATE]]\n" \
+           "                    Set logging levels and rate limits in\n" \
+           "                    messages per second, see touchjs -h\n" \
+           "  -d                Print all debugging messages\n\n" \
+           "\nPlease report bugs at %s\n",
+        PKG_NAME, PKG_BUGREPORT);
+}
+
+/**
+ * Print version info
+ **/
+
+static void tjs_version(void) {
+  fprintf(stderr, "%s v%s (headless) - Copyright (c) 2019 Christoph Kappel\n" \
+         "Released under the GNU General Public License\n",
+        PKG_NAME, PKG_VERSION);
+}
+
+/**
+ * Present top-level embed items like the touchbar does
+ **/
+
+static void tjs_headless_present(void) {
+    for (int i = 0; i < tjs_embed_count(); i++) {
+        TjsEmbed *embed = tjs_embed_get(i);
+
+        if (NULL != embed && NULL == embed->parent) {
+            tjs_embed_configure(embed);
+            tjs_embed_update(embed);
+        }
+    }
+}
+
+/**
+ * Run timers, commands and queries for given time; waits in one poll on
+ * command output and finished queries until the next timer is due
+ *
+ * @param[in]  duration  Time to run in ms
+ **/
+
+static void tjs_headless_run(double duration) {
+    TjsTimers *timers = touch.timers;
+    double start = tjs_clock_now();
+    double end = tjs_timers_now(timers) + duration;
+
+    while (0 == (touch.flags & TJS_TOUCH_FLAG_QUIT)) {
+        double now = tjs_timers_now(timers);
+        double delay = tjs_timers_delay(timers);
+
+        /* Timers past the end don't count */
+        if (0 <= delay && end < now + delay) delay = -1;
+
+        if (0 < tjs_procs_count(touch.procs)) {
+            if (end <= now) break;
+
+            double wait = (0 <= delay ? delay : end - now);
+            int nready = tjs_command_poll((int)(wait + 0.5));
+
+            if (0 == nready && 0 < (timers->flags & TJS_TIMERS_FLAG_FAKE)) {
+                tjs_timers_advance(timers, (0 <= delay ? delay : 0));
+            }
+        } else if (0 > delay) {
+            break;
+        } else if (0 < (timers->flags & TJS_TIMERS_FLAG_FAKE)) {
+            tjs_timers_advance(timers, delay);
+        } else if (0 < delay) {
+            struct pollfd pfd = { .fd = tjs_query_fd(), .events = POLLIN };
+
+            /* Plain sleep when queries aren't available */
+            poll(&pfd, 1, (int)(delay + 0.5));
+        }
+
+        /* Also drains wakeups of late results nobody waits for */
+        if (0 < tjs_query_poll() && 0 == touch.tick) {
+            tjs_touchbar_flush();
+        }
+
+        tjs_global_timers_run();
+    }
+
+    TJS_LOG_INFO("Timers: pending=%d, scheduled=%lu, fired=%lu, " \
+        "cleared=%lu, wakeups=%lu, rearms=%lu, errors=%lu, elapsed=%.3fms",
+        tjs_timers_count(timers), timers->stats.scheduled, timers->stats.fired,
+        timers->stats.cleared, timers->stats.wakeups, timers->stats.rearms,
+        timers->stats.errors, tjs_clock_now() - start);
+    TJS_LOG_INFO("Commands: running=%d, spawned=%lu, exited=%lu, " \
+        "failed=%lu, polls=%lu, reads=%lu, bytes=%lu, queued=%lu, " \
+        "hits=%lu, misses=%lu, shared=%lu, expired=%lu",
+        tjs_procs_count(touch.procs), touch.procs->stats.spawned,
+        touch.procs->stats.exited, touch.procs->stats.failed,
+        touch.procs->stats.polls, touch.procs->stats.reads,
+        touch.procs->stats.bytes, touch.exec->stats.queued,
+        touch.exec->stats.hits, touch.exec->stats.misses,
+        touch.exec->stats.shared, touch.exec->stats.expired);
+}
+
+/**
+ * Log writer
+ *
+ * @param[in]  msg  Formatted log message
+ **/
+
+void tjs_log_write(const char *msg) {
+    fprintf(stderr, "%s\n", msg);
+}
+
+/**
+ * Terminate app
+ **/
+
+void tjs_exit() {
+    touch.flags |= TJS_TOUCH_FLAG_QUIT; ///< Heap is destroyed in main
+}
+
+/**
+ * Native ops function; pushes backend op counts
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_headless_ops(duk_context *ctx) {
+    static const char *names[] = {
+        "create", "configure", "fg", "bg", "value", "destroy"
+    };
+
+    duk_idx_t objIdx = duk_push_object(ctx);
+
+    for (int op = 0; op < TJS_HEADLESS_OP_MAX; op++) {
+        duk_push_number(ctx, tjs_headless_count(op));
+        duk_put_prop_string(ctx, objIdx, names[op]);
+    }
+
+    return 1;
+}
+
+/**
+ * Create heap and register all objects
+ *
+ * @return A new #duk_context
+ **/
+
+static duk_context *tjs_headless_heap(void) {
+    /* Each heap is accounted and limited on its own */
+    TjsAllocHeap *heap = tjs_alloc_heap_new(touch.alloc);
+
+    if (NULL == heap) return NULL;
+
+    duk_context *ctx = duk_create_heap(tjs_alloc_duk_alloc,
+        tjs_alloc_duk_realloc, tjs_alloc_duk_free, heap, tjs_fatal);
+
+    if (NULL == ctx) return NULL;
+
+    /* Register objects; wm needs the platform */
+    tjs_global_init(ctx);
+    tjs_command_init(ctx);
+
+    tjs_scrubber_init(ctx);
+    tjs_label_init(ctx);
+    tjs_button_init(ctx);
+    tjs_slider_init(ctx);
+
+    /* Fake window source stands in for AX */
+    tjs_fake_init(ctx);
+    tjs_snapshot_init(ctx);
+
+    /* Backend op counts for tests */
+    duk_push_c_function(ctx, tjs_headless_ops, 0);
+    duk_put_global_string(ctx, "tjs_headless_ops");
+
+    touch.heaps[touch.nheaps++] = ctx;
+
+    return ctx;
+}
+
+/**
+ * Parse commandline arguments
+ *
+ * @param[in]     argc  Number of arguments
+ * @param[inout]  argv  Arguments array
+ * @param[out]    opts  A #TjsHeadlessOptions
+ *
+ * @return Either 0 to run, 1 to exit with success; otherwise -1
+ **/
+
+static int tjs_headless_options(int argc, char *argv[],
+    TjsHeadlessOptions *opts)
+{
+    int c;
+
+    memset(opts, 0, sizeof(TjsHeadlessOptions));
+
+    opts->mode = TJS_ALLOC_MODE_POOL;
+    opts->count = 1000;
+    opts->synth = -1;
+    opts->nexec = TJS_EXEC_LIMIT;
+    opts->nheaps = 1;
+    opts->slack = TJS_TIMERS_SLACK;
+    opts->budget = TJS_WATCHDOG_BUDGET;
+    opts->files = (char **)calloc(argc, sizeof(char *));
+    opts->loadgen = tjs_loadgen_new();
+
+    while (-1 != (c = getopt(argc, argv, "A:a:b:cC:de:f:Fg:G:hI:j:Ll:m:n:o:p:r:R:S:t:T:vw:x:"))) {
+        switch (c) {
+            case 'A': touch.workers = atoi(optarg);            break;
+            case 'a':
+                opts->mode = (0 == strcmp(optarg, "malloc") ?
+                    TJS_ALLOC_MODE_MALLOC : TJS_ALLOC_MODE_POOL);
+                break;
+            case 'b': opts->budget = atof(optarg);             break;
+            case 'c': touch.flags |= TJS_TOUCH_FLAG_CACHE;     break;
+            case 'C':
+                if (1 > sscanf(optarg, "%lf:%lf", &opts->quiet,
+                        &opts->maxdelay))
+                {
+                    TJS_LOG_ERROR("Invalid coalesce spec %s", optarg);
+
+                    return -1;
+                }
+                break;
+            case 'd': touch.loglevel |= TJS_LOGLEVEL_DEBUG;    break;
+            case 'e':
+                if (0 != tjs_loadgen_parse(opts->loadgen, optarg)) {
+                    TJS_LOG_ERROR("Invalid event %s", optarg);
+
+                    return -1;
+                }
+                break;
+            case 'f': opts->files[opts->nfiles++] = optarg;    break;
+            case 'F': opts->tflags |= TJS_TIMERS_FLAG_FAKE;    break;
+            case 'g':
+                opts->synth = (0 == strcmp(optarg, "click") ?
+                    TJS_LOADGEN_CLICK : TJS_LOADGEN_SLIDE);
+                break;
+            case 'G': opts->idle = atoi(optarg);               break;
+            case 'h': tjs_usage();                             return 1;
+            case 'I': opts->nheaps = atoi(optarg);             break;
+            case 'j': opts->json = optarg;                     break;
+            case 'L': opts->dump = 1;                          break;
+            case 'l': touch.loglevel = tjs_log_level(optarg);  break;
+            case 'm': opts->limit = tjs_alloc_parse_size(optarg); break;
+            case 'n': opts->count = atoi(optarg);              break;
+            case 'o': opts->logfile = optarg;                  break;
+            case 'p': opts->profile = optarg;                  break;
+            case 'r': opts->rate = atof(optarg);               break;
+            case 'R': opts->replay = optarg;                   break;
+            case 'S': opts->slack = atof(optarg);              break;
+            case 't': touch.tick = atoi(optarg);               break;
+            case 'T': opts->tracefile = optarg;                break;
+            case 'v': tjs_version();                           return 1;
+            case 'w': opts->runfor = atof(optarg);             break;
+            case 'x': opts->nexec = atoi(optarg);              break;
+        }
+    }
+
+    /* The first one is the primary heap */
+    if (1 > opts->nheaps || TJS_HEAPS_MAX < opts->nheaps) {
+        TJS_LOG_ERROR("Invalid number of heaps %d (1-%d)", opts->nheaps,
+            TJS_HEAPS_MAX);
+
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Create subsystems and heaps
+ *
+ * @param[in]  opts  A #TjsHeadlessOptions
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+static int tjs_headless_init(const TjsHeadlessOptions *opts) {
+    if (NULL != opts->logfile && NULL == (touch.logger =
+            tjs_logger_new(opts->logfile, TJS_LOGGER_SIZE)))
+    {
+        TJS_LOG_ERROR("Failed to open %s", opts->logfile);
+
+        return -1;
+    }
+
+    /* Create allocator first; heap and userdata share it */
+    touch.alloc = tjs_alloc_new(opts->mode);
+    touch.alloc->limit = opts->limit;
+
+    if (0 < opts->idle) {
+        touch.gc = tjs_gc_new(opts->idle);
+    }
+
+    touch.timers = tjs_timers_new(opts->slack, opts->tflags);
+    touch.procs = tjs_procs_new();
+    touch.exec = tjs_exec_new(opts->nexec);
+    touch.bus = tjs_bus_new();
+
+    if (0 < opts->quiet || 0 < opts->maxdelay) {
+        touch.coalesce = tjs_coalesce_new(opts->quiet, opts->maxdelay);
+    }
+
+    if (0 < opts->budget) {
+        touch.watchdog = tjs_watchdog_new(opts->budget);
+    }
+
+    if (NULL != opts->profile) {
+        touch.profile = tjs_profile_new(opts->profile);
+    }
+
+    /* Create duk contexts; cache hooks must exist before any window */
+    tjs_wincache_init(&tjs_win_source_fake);
+
+    for (int i = 0; i < opts->nheaps; i++) {
+        if (NULL == tjs_headless_heap()) {
+            TJS_LOG_ERROR("Failed to create heap");
+
+            return -1;
+        }
+    }
+
+    touch.ctx = touch.heaps[0];
+
+    /* Finished queries end the wait for command output */
+    touch.procs->wakefd = tjs_query_fd();
+
+    return 0;
+}
+
+/**
+ * Eval files round-robin over heaps
+ *
+ * @param[in]  opts  A #TjsHeadlessOptions
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+static int tjs_headless_load(const TjsHeadlessOptions *opts) {
+    TjsLoaderStats stats = { 0 };
+
+    if (0 == opts->nfiles) return 0;
+
+    for (int i = 0; i < opts->nfiles; i++) {
+        tjs_loader_eval(touch.heaps[i % touch.nheaps], opts->files[i],
+            (0 < (touch.flags & TJS_TOUCH_FLAG_CACHE) ?
+                TJS_BYTECODE_CACHE : 0), &stats);
+    }
+
+    TJS_LOG_INFO("Loaded %d files (%d failed, %d cached): bytes=%zu, " \
+        "load=%.3fms, compile=%.3fms, exec=%.3fms",
+        stats.nfiles, stats.nfailed, stats.nhits, stats.bytes,
+        stats.load, stats.compile, stats.exec);
+
+    tjs_touchbar_flush();
+
+    return (0 < stats.nfailed ? -1 : 0);
+}
+
+/**
+ * Inject events, then run timers and commands
+ *
+ * @param[inout]  opts  A #TjsHeadlessOptions
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+static int tjs_headless_events(TjsHeadlessOptions *opts) {
+    TjsLoadgen *loadgen = opts->loadgen;
+    int ret = 0;
+
+    /* Build event stream; targets exist only after loading */
+    if (NULL != opts->replay && 0 > tjs_loadgen_load(loadgen, opts->replay)) {
+        ret = -1;
+    }
+
+    if (-1 != opts->synth && 0 > tjs_loadgen_synth(loadgen, opts->synth,
+            opts->rate, opts->count))
+    {
+        TJS_LOG_ERROR("No targets for generated events");
+
+        ret = -1;
+    }
+
+    /* Inject events and time callbacks */
+    loadgen->window = tjs_fake_replay;
+
+    if (NULL != opts->tracefile) {
+        tjs_loadgen_trace_open(opts->tracefile);
+    }
+
+    tjs_loadgen_run(loadgen);
+    tjs_loadgen_report(loadgen);
+
+    if (NULL != opts->json) {
+        FILE *fp = (0 == strcmp(opts->json, "-") ?
+            stdout : fopen(opts->json, "w"));
+
+        if (NULL != fp) {
+            tjs_loadgen_json(loadgen, fp);
+
+            if (stdout != fp) fclose(fp);
+        } else {
+            TJS_LOG_ERROR("Failed to open %s", opts->json);
+
+            ret = -1;
+        }
+    }
+
+    tjs_loadgen_destroy(loadgen);
+
+    opts->loadgen = NULL;
+
+    if (0 < opts->runfor) {
+        tjs_headless_run(opts->runfor);
+    }
+
+    /* Events sent by timers are recorded too */
+    tjs_loadgen_trace_close();
+
+    /* Deliver trailing frames before teardown */
+    if (NULL != touch.coalesce) {
+        tjs_coalesce_flush(touch.coalesce, tjs_timers_now(touch.timers), 1);
+    }
+
+    if (0 < touch.timers->stats.errors) ret = -1;
+
+    return ret;
+}
+
+/**
+ * Log stats of all subsystems and write profile
+ *
+ * @param[in]  opts  A #TjsHeadlessOptions
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+static int tjs_headless_report(const TjsHeadlessOptions *opts) {
+    int ret = 0;
+
+    TJS_LOG_INFO("Backend ops: create=%lu, configure=%lu, fg=%lu, bg=%lu, " \
+        "value=%lu, destroy=%lu",
+        tjs_headless_count(TJS_HEADLESS_OP_CREATE),
+        tjs_headless_count(TJS_HEADLESS_OP_CONFIGURE),
+        tjs_headless_count(TJS_HEADLESS_OP_COLOR_FG),
+        tjs_headless_count(TJS_HEADLESS_OP_COLOR_BG),
+        tjs_headless_count(TJS_HEADLESS_OP_VALUE),
+        tjs_headless_count(TJS_HEADLESS_OP_DESTROY));
+
+    if (opts->dump) {
+        tjs_headless_dump(stdout);
+    }
+
+    TJS_LOG_INFO("Alloc: mode=%s, live=%zu, peak=%zu, slabs=%zu, " \
+        "allocs=%lu, frees=%lu, reallocs=%lu, large=%lu, denied=%lu, " \
+        "rate=%.0f/s",
+        (TJS_ALLOC_MODE_POOL == touch.alloc->mode ? "pool" : "malloc"),
+        touch.alloc->stats.live, touch.alloc->stats.peak,
+        touch.alloc->stats.slabbytes, touch.alloc->stats.allocs,
+        touch.alloc->stats.frees, touch.alloc->stats.reallocs,
+        touch.alloc->stats.large, touch.alloc->stats.denied,
+        tjs_alloc_rate(touch.alloc));
+
+    for (int i = 0; 1 < touch.alloc->nheaps && i < touch.alloc->nheaps; i++) {
+        TjsAllocHeap *heap = &(touch.alloc->heaps[i]);
+
+        TJS_LOG_INFO("Alloc: heap #%d: live=%zu, peak=%zu, limit=%zu, " \
+            "denied=%lu", heap->id, heap->live, heap->peak, heap->limit,
+            heap->denied);
+    }
+
+    if (NULL != touch.gc) {
+        TJS_LOG_INFO("Idle gc: runs=%lu, total=%.3fms",
+            touch.gc->stats.runs, touch.gc->stats.total);
+    }
+
+    if (NULL != touch.watchdog) {
+        TjsWatchdogHandler *slowest[3];
+
+        int n = tjs_watchdog_slowest(touch.watchdog, slowest, 3);
+
+        TJS_LOG_INFO("Watchdog: budget=%.0fms, calls=%lu, checks=%lu, " \
+            "timeouts=%lu, aborts=%lu",
+            touch.watchdog->budget, touch.watchdog->stats.calls,
+            touch.watchdog->stats.checks, touch.watchdog->stats.timeouts,
+            touch.watchdog->stats.aborts);
+
+        for (int i = 0; i < n; i++) {
+            TJS_LOG_INFO("Watchdog: #%d %s: calls=%lu, timeouts=%lu, " \
+                "cpu=%.3fms, max=%.3fms", i + 1, slowest[i]->label,
+                slowest[i]->calls, slowest[i]->timeouts, slowest[i]->cpu,
+                slowest[i]->maxcpu);
+        }
+    }
+
+    TJS_LOG_INFO("Events: emitted=%lu, delivered=%lu, filtered=%lu, " \
+        "fetches=%lu, subscribed=%lu, unsubscribed=%lu, compactions=%lu",
+        touch.bus->stats.emitted, touch.bus->stats.delivered,
+        touch.bus->stats.filtered, touch.bus->stats.fetches,
+        touch.bus->stats.subscribed, touch.bus->stats.unsubscribed,
+        touch.bus->stats.compactions);
+
+    const TjsAppsStats *astats = tjs_apps_stats();
+
+    TJS_LOG_INFO("Apps: tracked=%d, launched=%lu, terminated=%lu, " \
+        "attached=%lu, retries=%lu, failed=%lu, binds=%lu, unbinds=%lu, " \
+        "unbound=%lu", tjs_apps_count(), astats->launched, astats->terminated,
+        astats->attached, astats->retries, astats->failed, astats->binds,
+        astats->unbinds, astats->unbound);
+
+    const TjsQueryStats *qstats = tjs_query_stats();
+
+    if (0 < qstats->submitted) {
+        TJS_LOG_INFO("Queries: workers=%d, submitted=%lu, ok=%lu, " \
+            "failed=%lu, timeouts=%lu, late=%lu, pending=%d, maxqueued=%lu, " \
+            "p50=%.3fms, p99=%.3fms, max=%.3fms", tjs_query_workers(),
+            qstats->submitted, qstats->ok, qstats->failed, qstats->timeouts,
+            qstats->late, tjs_query_pending(), qstats->maxqueued,
+            tjs_histogram_percentile(qstats->latency, 50) / 1000.0,
+            tjs_histogram_percentile(qstats->latency, 99) / 1000.0,
+            qstats->latency->max / 1000.0);
+    }
+
+    if (NULL != touch.coalesce) {
+        TJS_LOG_INFO("Coalesce: quiet=%.0fms, maxdelay=%.0fms, raw=%lu, " \
+            "delivered=%lu, lag=%.3fms, maxlag=%.3fms",
+            touch.coalesce->quiet, touch.coalesce->maxdelay,
+            touch.coalesce->stats.raw, touch.coalesce->stats.delivered,
+            (0 < touch.coalesce->stats.delivered ? touch.coalesce->stats.lag /
+                touch.coalesce->stats.delivered : 0),
+            touch.coalesce->stats.maxlag);
+    }
+
+    if (NULL != touch.profile) {
+        if (0 != tjs_profile_write(touch.profile)) ret = -1;
+
+        tjs_profile_report(touch.profile);
+    }
+
+    return ret;
+}
+
+/**
+ * Tear down heaps and subsystems
+ *
+ * Query workers and app observers keep timers on the primary heap, so
+ * they stop before the heaps go. Heap finalizers still release windows
+ * through the cache and kill commands, so the cache and procs stay until
+ * all heaps are destroyed.
+ *
+ * @param[inout]  opts  A #TjsHeadlessOptions
+ **/
+
+static void tjs_headless_deinit(TjsHeadlessOptions *opts) {
+    tjs_touchbar_deinit();
+    tjs_embed_deinit();
+    tjs_fake_deinit();
+
+    for (int i = 0; i < touch.nheaps; i++) {
+        duk_destroy_heap(touch.heaps[i]);
+    }
+
+    touch.ctx = NULL;
+    touch.nheaps = 0;
+
+    tjs_wincache_deinit();
+
+    const TjsUserdataStats *ustats = tjs_userdata_stats();
+
+    TJS_LOG_DEBUG("Userdata: created=%lu, destroyed=%lu, finalized=%lu",
+        ustats->created, ustats->destroyed, ustats->finalized);
+
+    if (NULL != touch.alloc && 0 < touch.alloc->stats.live) {
+        TJS_LOG_DEBUG("Unfreed after heap destroy: live=%zu",
+            touch.alloc->stats.live);
+    }
+
+    tjs_procs_destroy(touch.procs);
+    tjs_exec_destroy(touch.exec);
+    tjs_bus_destroy(touch.bus);
+    tjs_coalesce_destroy(touch.coalesce);
+    tjs_watchdog_destroy(touch.watchdog);
+    tjs_profile_destroy(touch.profile);
+    tjs_timers_destroy(touch.timers);
+    tjs_gc_destroy(touch.gc);
+    tjs_alloc_destroy(touch.alloc);
+    tjs_headless_reset();
+
+    tjs_loadgen_destroy(opts->loadgen);
+    free(opts->files);
+
+    /* Stop writer; later messages are logged synchronously */
+    if (NULL != touch.logger) {
+        TjsLogger *logger = touch.logger;
+
+        touch.logger = NULL;
+
+        tjs_logger_stop(logger);
+
+        TJS_LOG_INFO("Log: records=%lu, dropped=%lu, oversized=%lu, " \
+            "limited=%lu, lines=%lu, writes=%lu, wakeups=%lu, bytes=%zu",
+            logger->stats.records, logger->stats.dropped,
+            logger->stats.oversized, tjs_log_dropped(), logger->wstats.lines,
+            logger->wstats.writes, logger->wstats.wakeups,
+            logger->wstats.bytes);
+
+        tjs_logger_destroy(logger);
+    }
+}
+
+/**
+ * Main entry point
+
+ * @param[in]     argc  Number of arguments
+ * @param[inout]  argv  Arguments array
+ **/
+
+int main(int argc, char *argv[]) {
+    TjsHeadlessOptions opts;
+    int ret = 0;
+
+    /* Set default loglevels */
+    touch.loglevel = (
+        TJS_LOGLEVEL_INFO|
+        TJS_LOGLEVEL_DUK|
+        TJS_LOGLEVEL_PRINT|
+        TJS_LOGLEVEL_ERROR
+    );
+
+    tjs_embed_init(&tjs_backend_headless);
+    tjs_touchbar_init();
+
+    switch (tjs_headless_options(argc, argv, &opts)) {
+        case 1:  return 0;
+        case -1: return 1;
+    }
+
+    if (0 != tjs_headless_init(&opts)) return 1;
+
+    /* Eval files after debug/loglevel is set */
+    if (0 != tjs_headless_load(&opts)) ret = 1;
+
+    tjs_headless_present();
+
+    if (0 != tjs_headless_events(&opts)) ret = 1;
+    if (0 != tjs_headless_report(&opts)) ret = 1;
+
+    tjs_headless_deinit(&opts);
+
+    return ret;
+}
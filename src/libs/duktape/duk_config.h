@@ -3097,6 +3097,23 @@ typedef struct duk_hthread duk_context;
 
 /* __OVERRIDE_DEFINES__ */
 
+/* TouchJS watchdog and profiler; bound and sample callbacks */
+#define DUK_USE_INTERRUPT_COUNTER
+#define DUK_USE_EXEC_TIMEOUT_CHECK(udata) \
+    (tjs_profile_sample((udata)), tjs_watchdog_check((udata)))
+
+void tjs_profile_sample(void *udata);
+int tjs_watchdog_check(void *udata);
+
+/* TouchJS build profiles; selected with PROFILE=debug|release|size */
+#if defined(TJS_PROFILE_DEBUG)
+#include "profiles/debug.h"
+#elif defined(TJS_PROFILE_RELEASE)
+#include "profiles/release.h"
+#elif defined(TJS_PROFILE_SIZE)
+#include "profiles/size.h"
+#endif
+
 /*
  *  Conditional includes
  */
@@ -0,0 +1,24 @@
+/**
+ * @package TouchJS
+ *
+ * @file Duktape config overrides: debug profile
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+/* Catch API misuse early; slow */
+#define DUK_USE_ASSERTIONS
+
+/* Plain doubles keep values easy to inspect */
+#undef DUK_USE_FASTINT
+
+/* No debug prints; they need a debug log writer */
+#undef DUK_USE_DEBUG
+#undef DUK_USE_DEBUG_LEVEL
+#define DUK_USE_DEBUG_LEVEL 0
+
+#undef DUK_USE_LITCACHE_SIZE
+#define DUK_USE_LITCACHE_SIZE 256
@@ -0,0 +1,26 @@
+/**
+ * @package TouchJS
+ *
+ * @file Duktape config overrides: release profile
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#undef DUK_USE_ASSERTIONS
+
+/* Integer fast path; slider values and colors are ints */
+#define DUK_USE_FASTINT
+
+/* No debug prints */
+#undef DUK_USE_DEBUG
+#undef DUK_USE_DEBUG_LEVEL
+#define DUK_USE_DEBUG_LEVEL 0
+
+/* Callbacks touch the same few property names over and over */
+#undef DUK_USE_LITCACHE_SIZE
+#define DUK_USE_LITCACHE_SIZE 1024
+
+#define DUK_USE_JSON_STRINGIFY_FASTPATH
@@ -0,0 +1,27 @@
+/**
+ * @package TouchJS
+ *
+ * @file Duktape config overrides: size profile
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#undef DUK_USE_ASSERTIONS
+
+/* Fastint adds code to every arithmetic op */
+#undef DUK_USE_FASTINT
+
+/* No debug prints */
+#undef DUK_USE_DEBUG
+#undef DUK_USE_DEBUG_LEVEL
+#define DUK_USE_DEBUG_LEVEL 0
+
+/* Prefer small code over fast paths */
+#define DUK_USE_PREFER_SIZE
+#define DUK_USE_EXEC_PREFER_SIZE
+
+#undef DUK_USE_LITCACHE_SIZE
+#define DUK_USE_LITCACHE_SIZE 64
@@ -0,0 +1,486 @@
+/**
+ * @package TouchJS
+ *
+ * @file Load generator functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <time.h>
+
+#include "touchjs.h"
+#include "touchbar.h"
+#include "embed.h"
+#include "loadgen.h"
+
+#include "common/clock.h"
+#include "common/gc.h"
+#include "common/timer.h"
+#include "common/proc.h"
+
+/* Defines */
+#define TJS_LOADGEN_NS(MS) ((uint64_t)((MS) * 1000000.0))
+
+/* Globals */
+static FILE *trace = NULL;
+static double tracestart = 0;
+
+static const char *typenames[TJS_LOADGEN_MAX] = {
+    "click", "slide", "move", "resize"
+};
+
+static const char *winevents[TJS_LOADGEN_MAX] = {
+    NULL, NULL, "win_move", "win_resize"
+};
+
+/**
+ * Create new load generator
+ *
+ * @return A new #TjsLoadgen
+ **/
+
+TjsLoadgen *tjs_loadgen_new(void) {
+    TjsLoadgen *loadgen = (TjsLoadgen *)calloc(1, sizeof(TjsLoadgen));
+
+    for (int i = 0; i < TJS_LOADGEN_MAX; i++) {
+        loadgen->latency[i] = tjs_histogram_new();
+    }
+
+    loadgen->lag = tjs_histogram_new();
+
+    return loadgen;
+}
+
+/**
+ * Append event to stream
+ *
+ * @param[inout]  loadgen  A #TjsLoadgen
+ * @param[in]     at       Offset from start in ms
+ * @param[in]     type     Event type
+ * @param[in]     idx      Index of the embed item or window id
+ * @param[in]     value    Slide value or first value of window events
+ *
+ * @return Appended #TjsLoadgenEvent
+ **/
+
+TjsLoadgenEvent *tjs_loadgen_add(TjsLoadgen *loadgen, double at, int type,
+    int idx, double value)
+{
+    /* Grow array */
+    if (loadgen->nevents == loadgen->maxevents) {
+        loadgen->maxevents = (0 == loadgen->maxevents ?
+            64 : loadgen->maxevents * 2);
+        loadgen->events = (TjsLoadgenEvent *)realloc(loadgen->events,
+            loadgen->maxevents * sizeof(TjsLoadgenEvent));
+    }
+
+    TjsLoadgenEvent *event = &(loadgen->events[loadgen->nevents++]);
+
+    event->at = at;
+    event->type = type;
+    event->idx = idx;
+    event->value = value;
+    event->value2 = 0;
+
+    return event;
+}
+
+/**
+ * Parse and append single event
+ *
+ * Format is either click:IDX or slide:IDX:VALUE
+ *
+ * @param[inout]  loadgen  A #TjsLoadgen
+ * @param[in]     str      Event string
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+int tjs_loadgen_parse(TjsLoadgen *loadgen, const char *str) {
+    int idx = 0;
+    double value = 0;
+
+    if (1 == sscanf(str, "click:%d", &idx)) {
+        tjs_loadgen_add(loadgen, 0, TJS_LOADGEN_CLICK, idx, 0);
+    } else if (2 == sscanf(str, "slide:%d:%lf", &idx, &value)) {
+        tjs_loadgen_add(loadgen, 0, TJS_LOADGEN_SLIDE, idx, value);
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Append synthetic events round-robin across all matching embed items
+ *
+ * Clicks go to buttons, slides to sliders with a 0-100 sweep per item
+ *
+ * @param[inout]  loadgen  A #TjsLoadgen
+ * @param[in]     type     Event type
+ * @param[in]     rate     Events per second; 0 dispatches back-to-back
+ * @param[in]     count    Number of events
+ *
+ * @return Either number of target items; otherwise -1
+ **/
+
+int tjs_loadgen_synth(TjsLoadgen *loadgen, int type, double rate, int count) {
+    int ntargets = 0, flag = (TJS_LOADGEN_CLICK == type ?
+        TJS_FLAG_TYPE_BUTTON : TJS_FLAG_TYPE_SLIDER);
+    int *targets = (int *)calloc(tjs_embed_count() + 1, sizeof(int));
+
+    /* Collect targets */
+    for (int i = 0; i < tjs_embed_count(); i++) {
+        TjsEmbed *embed = tjs_embed_get(i);
+
+        if (NULL != embed && NULL != embed->userdata &&
+                0 < (embed->userdata->flags & flag))
+        {
+            targets[ntargets++] = i;
+        }
+    }
+
+    if (0 < ntargets) {
+        double interval = (0 < rate ? 1000.0 / rate : 0);
+        double base = (0 < loadgen->nevents ?
+            loadgen->events[loadgen->nevents - 1].at : 0);
+
+        for (int i = 0; i < count; i++) {
+            int step = (i / ntargets) % 200;
+
+            tjs_loadgen_add(loadgen, base + (i + 1) * interval, type,
+                targets[i % ntargets], (100 >= step ? step : 200 - step));
+        }
+    }
+
+    free(targets);
+
+    return (0 < ntargets ? ntargets : -1);
+}
+
+/**
+ * Load recorded event stream
+ *
+ * Each line is `MS click IDX`, `MS slide IDX VALUE`, `MS move ID X Y` or
+ * `MS resize ID WIDTH HEIGHT`; # starts a comment
+ *
+ * @param[inout]  loadgen   A #TjsLoadgen
+ * @param[in]     filename  Name of the trace file
+ *
+ * @return Either number of loaded events; otherwise -1
+ **/
+
+int tjs_loadgen_load(TjsLoadgen *loadgen, const char *filename) {
+    char line[128], type[16];
+    int idx = 0, nevents = 0, lineno = 0;
+    double at = 0, value = 0, value2 = 0;
+
+    FILE *fp = fopen(filename, "r");
+
+    if (NULL == fp) {
+        TJS_LOG_ERROR("Failed to open trace %s", filename);
+
+        return -1;
+    }
+
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        lineno++;
+
+        if ('#' == line[0] || '\n' == line[0]) continue;
+
+        int nfields = sscanf(line, "%lf %15s %d %lf %lf", &at, type, &idx,
+            &value, &value2);
+
+        if (3 <= nfields && 0 == strcmp(type, "click")) {
+            tjs_loadgen_add(loadgen, at, TJS_LOADGEN_CLICK, idx, 0);
+        } else if (4 == nfields && 0 == strcmp(type, "slide")) {
+            tjs_loadgen_add(loadgen, at, TJS_LOADGEN_SLIDE, idx, value);
+        } else if (5 == nfields && 0 == strcmp(type, "move")) {
+            tjs_loadgen_add(loadgen, at, TJS_LOADGEN_MOVE, idx,
+                value)->value2 = value2;
+        } else if (5 == nfields && 0 == strcmp(type, "resize")) {
+            tjs_loadgen_add(loadgen, at, TJS_LOADGEN_RESIZE, idx,
+                value)->value2 = value2;
+        } else {
+            TJS_LOG_ERROR("Invalid trace line %s:%d", filename, lineno);
+
+            continue;
+        }
+
+        nevents++;
+    }
+
+    fclose(fp);
+
+    return nevents;
+}
+
+/**
+ * Helper to wait until given time
+ *
+ * @param[in]  until  Monotonic time in ms
+ **/
+
+static void tjs_loadgen_wait(double until) {
+    double remaining;
+
+    while (0 < (remaining = until - tjs_clock_now())) {
+        struct timespec ts;
+
+        /* Gaps in the stream are idle time; wake up when gc is due */
+        if (NULL != touch.gc && touch.gc->pending) {
+            if (tjs_gc_poll(touch.gc, touch.heaps, touch.nheaps)) continue;
+
+            double due = touch.gc->active + touch.gc->idle - tjs_clock_now();
+
+            if (0 < due && due < remaining) remaining = due;
+        }
+
+        /* Run script timers in gaps too; fake clocks don't follow the stream */
+        if (NULL != touch.timers &&
+                0 == (touch.timers->flags & TJS_TIMERS_FLAG_FAKE))
+        {
+            double delay = tjs_timers_delay(touch.timers);
+
+            if (0 == delay) {
+                tjs_global_timers_run();
+
+                continue;
+            }
+
+            if (0 < delay && delay < remaining) remaining = delay;
+        }
+
+        /* Wait on command output instead of sleeping */
+        if (0 < tjs_procs_count(touch.procs)) {
+            tjs_command_poll((int)(remaining + 0.5));
+
+            continue;
+        }
+
+        ts.tv_sec = (time_t)(remaining / 1000.0);
+        ts.tv_nsec = (long)((remaining - ts.tv_sec * 1000.0) * 1000000.0);
+
+        nanosleep(&ts, NULL);
+    }
+}
+
+/**
+ * Replay event stream and record dispatch latency
+ *
+ * @param[inout]  loadgen  A #TjsLoadgen
+ **/
+
+void tjs_loadgen_run(TjsLoadgen *loadgen) {
+    double start = tjs_clock_now();
+
+    for (int i = 0; i < loadgen->nevents; i++) {
+        TjsLoadgenEvent *event = &(loadgen->events[i]);
+
+        /* Stop when a script called tjs_exit */
+        if (0 < (touch.flags & TJS_TOUCH_FLAG_QUIT)) break;
+
+        /* Window events need a source; others an embed item */
+        if (NULL != winevents[event->type] ? NULL == loadgen->window :
+                NULL == tjs_embed_get(event->idx))
+        {
+            loadgen->nmissing++;
+
+            continue;
+        }
+
+        /* Pace stream */
+        double now = tjs_clock_now();
+
+        if (0 < event->at) {
+            double scheduled = start + event->at;
+
+            if (now < scheduled) {
+                tjs_loadgen_wait(scheduled);
+
+                now = tjs_clock_now();
+            }
+
+            tjs_histogram_record(loadgen->lag,
+                TJS_LOADGEN_NS(now - scheduled));
+        }
+
+        if (TJS_LOADGEN_CLICK == event->type) {
+            tjs_touchbar_click(event->idx);
+        } else if (TJS_LOADGEN_SLIDE == event->type) {
+            tjs_touchbar_slide(event->idx, event->value);
+        } else if (0 > loadgen->window(winevents[event->type],
+                (unsigned long)event->idx, event->value, event->value2))
+        {
+            loadgen->nmissing++;
+
+            continue;
+        }
+
+        /* Include deferred flush in latency; window handlers don't flush */
+        if (0 < touch.tick || NULL != winevents[event->type]) {
+            tjs_touchbar_flush();
+        }
+
+        tjs_histogram_record(loadgen->latency[event->type],
+            TJS_LOADGEN_NS(tjs_clock_now() - now));
+    }
+
+    loadgen->elapsed = tjs_clock_now() - start;
+}
+
+/**
+ * Log latency summary
+ *
+ * @param[inout]  loadgen  A #TjsLoadgen
+ **/
+
+void tjs_loadgen_report(TjsLoadgen *loadgen) {
+    for (int i = 0; i < TJS_LOADGEN_MAX; i++) {
+        TjsHistogram *histogram = loadgen->latency[i];
+
+        if (0 == histogram->count) continue;
+
+        TJS_LOG_INFO("Latency %s: count=%llu, p50=%.3fus, p99=%.3fus, " \
+            "p999=%.3fus, max=%.3fus", typenames[i],
+            (unsigned long long)histogram->count,
+            tjs_histogram_percentile(histogram, 50.0) / 1000.0,
+            tjs_histogram_percentile(histogram, 99.0) / 1000.0,
+            tjs_histogram_percentile(histogram, 99.9) / 1000.0,
+            histogram->max / 1000.0);
+    }
+
+    if (0 < loadgen->lag->count) {
+        TJS_LOG_INFO("Schedule lag: p50=%.3fus, p99=%.3fus, max=%.3fus",
+            tjs_histogram_percentile(loadgen->lag, 50.0) / 1000.0,
+            tjs_histogram_percentile(loadgen->lag, 99.0) / 1000.0,
+            loadgen->lag->max / 1000.0);
+    }
+
+    if (0 < loadgen->nmissing) {
+        TJS_LOG_ERROR("Skipped %lu events without embed item or window",
+            loadgen->nmissing);
+    }
+}
+
+/**
+ * Write histograms as JSON; values are in ns
+ *
+ * @param[inout]  loadgen  A #TjsLoadgen
+ * @param[inout]  fp       File to write to
+ **/
+
+void tjs_loadgen_json(TjsLoadgen *loadgen, FILE *fp) {
+    unsigned long ndispatched = 0;
+
+    for (int i = 0; i < TJS_LOADGEN_MAX; i++) {
+        ndispatched += loadgen->latency[i]->count;
+    }
+
+    fprintf(fp, "{\n  \"unit\": \"ns\",\n  \"elapsed_ms\": %.3f,\n" \
+        "  \"events\": %lu,\n  \"missing\": %lu,\n  \"rate\": %.1f,\n" \
+        "  \"latency\": {\n",
+        loadgen->elapsed, ndispatched, loadgen->nmissing,
+        (0 < loadgen->elapsed ? ndispatched * 1000.0 / loadgen->elapsed : 0));
+
+    for (int i = 0; i < TJS_LOADGEN_MAX; i++) {
+        fprintf(fp, "    \"%s\": ", typenames[i]);
+        tjs_histogram_json(loadgen->latency[i], fp);
+        fprintf(fp, "%s\n", (TJS_LOADGEN_MAX - 1 > i ? "," : ""));
+    }
+
+    fprintf(fp, "  },\n  \"lag\": ");
+    tjs_histogram_json(loadgen->lag, fp);
+    fprintf(fp, "\n}\n");
+}
+
+/**
+ * Destroy load generator
+ *
+ * @param[inout]  loadgen  A #TjsLoadgen
+ **/
+
+void tjs_loadgen_destroy(TjsLoadgen *loadgen) {
+    if (NULL != loadgen) {
+        for (int i = 0; i < TJS_LOADGEN_MAX; i++) {
+            tjs_histogram_destroy(loadgen->latency[i]);
+        }
+
+        tjs_histogram_destroy(loadgen->lag);
+
+        free(loadgen->events);
+        free(loadgen);
+    }
+}
+
+/**
+ * Start recording dispatched events in trace format
+ *
+ * @param[in]  filename  Name of the trace file
+ **/
+
+void tjs_loadgen_trace_open(const char *filename) {
+    trace = fopen(filename, "w");
+
+    if (NULL == trace) {
+        TJS_LOG_ERROR("Failed to open trace %s", filename);
+
+        return;
+    }
+
+    tracestart = tjs_clock_now();
+
+    fprintf(trace, "# %s trace: MS click IDX | MS slide IDX VALUE | " \
+        "MS move ID X Y | MS resize ID WIDTH HEIGHT\n", PKG_NAME);
+}
+
+/**
+ * Record dispatched event if tracing
+ *
+ * @param[in]  type   Event type
+ * @param[in]  idx    Index of the embed item
+ * @param[in]  value  Slide value
+ **/
+
+void tjs_loadgen_trace(int type, int idx, double value) {
+    if (NULL == trace) return;
+
+    double at = tjs_clock_now() - tracestart;
+
+    if (TJS_LOADGEN_CLICK == type) {
+        fprintf(trace, "%.3f click %d\n", at, idx);
+    } else {
+        fprintf(trace, "%.3f slide %d %g\n", at, idx, value);
+    }
+}
+
+/**
+ * Record window event if tracing
+ *
+ * @param[in]  type  Either #TJS_LOADGEN_MOVE or #TJS_LOADGEN_RESIZE
+ * @param[in]  id    Window id
+ * @param[in]  a     Either x or width
+ * @param[in]  b     Either y or height
+ **/
+
+void tjs_loadgen_trace_window(int type, unsigned long id, double a, double b) {
+    if (NULL == trace) return;
+
+    fprintf(trace, "%.3f %s %lu %g %g\n", tjs_clock_now() - tracestart,
+        typenames[type], id, a, b);
+}
+
+/**
+ * Stop recording
+ **/
+
+void tjs_loadgen_trace_close(void) {
+    if (NULL != trace) {
+        fclose(trace);
+
+        trace = NULL;
+    }
+}
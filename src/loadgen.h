@@ -0,0 +1,68 @@
+/**
+ * @package TouchJS
+ *
+ * @file Load generator header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_LOADGEN_H
+#define TJS_LOADGEN_H 1
+
+/* Includes */
+#include <stdio.h>
+
+#include "common/histogram.h"
+
+/* Event types */
+#define TJS_LOADGEN_CLICK 0
+#define TJS_LOADGEN_SLIDE 1
+#define TJS_LOADGEN_MOVE 2   ///< Window moved; values are x and y
+#define TJS_LOADGEN_RESIZE 3 ///< Window resized; values are width and height
+#define TJS_LOADGEN_MAX 4
+
+/* Types */
+typedef struct tjs_loadgen_event_t {
+    double at; ///< Offset from start in ms; 0 dispatches immediately
+    int type, idx; ///< Index of the embed item or window id
+    double value, value2; ///< Second value is for window events only
+} TjsLoadgenEvent;
+
+typedef int (*TjsLoadgenWindowFunc)(const char *event, unsigned long id,
+    double a, double b);
+
+typedef struct tjs_loadgen_t {
+    int nevents, maxevents;
+    struct tjs_loadgen_event_t *events;
+
+    TjsLoadgenWindowFunc window; ///< Dispatches window events; NULL skips them
+
+    /* Stats */
+    double elapsed;
+    unsigned long nmissing; ///< Events without embed item or window
+
+    struct tjs_histogram_t *latency[TJS_LOADGEN_MAX]; ///< Dispatch in ns
+    struct tjs_histogram_t *lag; ///< Start behind schedule in ns
+} TjsLoadgen;
+
+/* Methods */
+TjsLoadgen *tjs_loadgen_new(void);
+TjsLoadgenEvent *tjs_loadgen_add(TjsLoadgen *loadgen, double at, int type,
+    int idx, double value);
+int tjs_loadgen_parse(TjsLoadgen *loadgen, const char *str);
+int tjs_loadgen_synth(TjsLoadgen *loadgen, int type, double rate, int count);
+int tjs_loadgen_load(TjsLoadgen *loadgen, const char *filename);
+void tjs_loadgen_run(TjsLoadgen *loadgen);
+void tjs_loadgen_report(TjsLoadgen *loadgen);
+void tjs_loadgen_json(TjsLoadgen *loadgen, FILE *fp);
+void tjs_loadgen_destroy(TjsLoadgen *loadgen);
+
+void tjs_loadgen_trace_open(const char *filename);
+void tjs_loadgen_trace(int type, int idx, double value);
+void tjs_loadgen_trace_window(int type, unsigned long id, double a, double b);
+void tjs_loadgen_trace_close(void);
+
+#endif /* TJS_LOADGEN_H */
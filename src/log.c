@@ -0,0 +1,256 @@
+/**
+ * @package TouchJS
+ *
+ * @file Log functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "touchjs.h"
+
+#include "common/logger.h"
+#include "common/clock.h"
+
+/* Levels by bit */
+static const char *names[] = {
+    "info", "debug", "error", "duk", "print", "event", "observer"
+};
+
+/* Rate limits by bit; token bucket */
+static struct {
+    double rate;   ///< Messages per second; 0 is unlimited
+    double tokens; ///< Available messages
+    double stamp;  ///< Time of last refill in ms
+    unsigned long dropped;
+} limits[sizeof(names) / sizeof(names[0])];
+
+/**
+ * Get bit of level
+ *
+ * @param[in]  level  Log level
+ *
+ * @return Either bit of level; otherwise -1
+ **/
+
+static int tjs_log_bit(int level) {
+    for (int bit = 0; bit < (int)(sizeof(names) / sizeof(names[0])); bit++) {
+        if ((1 << bit) == level) return bit;
+    }
+
+    return -1;
+}
+
+/**
+ * Check rate limit of level
+ *
+ * @param[in]  bit  Bit of level
+ *
+ * @return Either 1 when message may pass; otherwise 0
+ **/
+
+static int tjs_log_admit(int bit) {
+    if (0 >= limits[bit].rate) return 1;
+
+    double now = tjs_clock_now();
+
+    /* Refill; burst is one second worth of messages */
+    limits[bit].tokens += (now - limits[bit].stamp) * limits[bit].rate / 1000.0;
+    limits[bit].stamp = now;
+
+    if (limits[bit].tokens > limits[bit].rate) {
+        limits[bit].tokens = limits[bit].rate;
+    }
+
+    if (1.0 > limits[bit].tokens) {
+        limits[bit].dropped++;
+
+        return 0;
+    }
+
+    limits[bit].tokens -= 1.0;
+
+    return 1;
+}
+
+/**
+ * Log handler
+ *
+ * @param[in]  level  Log level
+ * @param[in]  func   Name of the calling function
+ * @param[in]  line   Line number of the call
+ * @param[in]  fmt    Message format
+ * @param[in]  ...    Variadic arguments
+ **/
+
+void tjs_log(int level, const char *func, int line, const char *fmt, ...) {
+    va_list ap;
+    char stackbuf[512], *buf = stackbuf;
+
+    int bit = tjs_log_bit(level);
+
+    /* Check loglevel */
+    if (0 == (touch.loglevel & level) || -1 == bit) return;
+
+    if (!tjs_log_admit(bit)) return;
+
+    /* Get variadic arguments; long messages go to the heap */
+    va_start(ap, fmt);
+    int len = vsnprintf(stackbuf, sizeof(stackbuf), fmt, ap);
+    va_end(ap);
+
+    if (0 > len) return;
+
+    if ((int)sizeof(stackbuf) <= len) {
+        buf = (char *)malloc(len + 1);
+
+        va_start(ap, fmt);
+        vsnprintf(buf, len + 1, fmt, ap);
+        va_end(ap);
+    }
+
+    if (NULL != touch.logger) {
+        tjs_logger_push(touch.logger, names[bit], func, line, buf, len);
+    } else {
+        char *msg = (char *)malloc(len + strlen(func) + 32);
+
+        switch (level) {
+            case TJS_LOGLEVEL_INFO:
+            case TJS_LOGLEVEL_PRINT:
+                sprintf(msg, "[%s] %s", (TJS_LOGLEVEL_INFO == level ?
+                    "INFO" : "PRINT"), buf);
+                break;
+            case TJS_LOGLEVEL_DUK:
+                sprintf(msg, "[DUK %s:%d] %s", func, line, buf);
+                break;
+            case TJS_LOGLEVEL_DEBUG:
+                sprintf(msg, "[DEBUG %s:%d] %s", func, line, buf);
+                break;
+            case TJS_LOGLEVEL_ERROR:
+                sprintf(msg, "[ERROR %s:%d] %s", func, line, buf);
+                break;
+            case TJS_LOGLEVEL_EVENT:
+                sprintf(msg, "[EVENT %s:%d] %s", func, line, buf);
+                break;
+            case TJS_LOGLEVEL_OBSERVER:
+                sprintf(msg, "[OBSERVER %s:%d] %s", func, line, buf);
+                break;
+        }
+
+        tjs_log_write(msg);
+
+        free(msg);
+    }
+
+    if (stackbuf != buf) free(buf);
+}
+
+/**
+ * Get number of messages dropped by rate limits
+ *
+ * @return Number of dropped messages
+ **/
+
+unsigned long tjs_log_dropped(void) {
+    unsigned long dropped = 0;
+
+    for (int bit = 0; bit < (int)(sizeof(names) / sizeof(names[0])); bit++) {
+        dropped += limits[bit].dropped;
+    }
+
+    return dropped;
+}
+
+/**
+ * Parse loglevel string; each level can have a rate limit in
+ * messages per second like event:100
+ *
+ * @param[in]  str  Loglevel string
+ *
+ * @return Parsed loglevel
+ **/
+
+int tjs_log_level(const char *str) {
+    int level = 0;
+    char *tokens = NULL, *tok = NULL;
+
+    tokens = strdup(str);
+    tok    = strtok((char *)tokens, ",");
+
+    /* Parse levels */
+    while (tok) {
+        int matched = 0;
+
+        if (0 == strncasecmp(tok, "duk", 3)) {
+            matched = TJS_LOGLEVEL_DUK;
+        } else if (0 == strncasecmp(tok, "info", 4)) {
+            matched = TJS_LOGLEVEL_INFO;
+        } else if (0 == strncasecmp(tok, "debug", 5)) {
+            matched = TJS_LOGLEVEL_DEBUG;
+        } else if (0 == strncasecmp(tok, "error", 5)) {
+            matched = TJS_LOGLEVEL_ERROR;
+        } else if (0 == strncasecmp(tok, "event", 5)) {
+            matched = TJS_LOGLEVEL_EVENT;
+        } else if (0 == strncasecmp(tok, "print", 5)) {
+            matched = TJS_LOGLEVEL_PRINT;
+        } else if (0 == strncasecmp(tok, "observer", 8)) {
+            matched = TJS_LOGLEVEL_OBSERVER;
+        }
+
+        /* Rate limit */
+        char *rate = strchr(tok, ':');
+
+        if (0 != matched && NULL != rate) {
+            int bit = tjs_log_bit(matched);
+
+            limits[bit].rate = atof(rate + 1);
+            limits[bit].tokens = limits[bit].rate;
+            limits[bit].stamp = tjs_clock_now();
+        }
+
+        level |= matched;
+
+        tok = strtok(NULL, ",");
+    }
+
+  free(tokens);
+
+  return level;
+}
+
+/**
+ * Fatal error handler
+ *
+ * @param[in]  userdata  Userdata added to heap
+ * @param[in]  msg       Message to log
+ **/
+
+void tjs_fatal(void *userdata, const char *msg) {
+    (void) userdata; ///< Not unused anymore..
+
+    TJS_LOG_DUK("Fatal error on line: %s", (msg ? msg : "No message"));
+
+    abort();
+}
+
+/**
+ * Helper to dump the duktape stack
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+void tjs_dump_stack(const char *func, int line, duk_context *ctx) {
+    duk_push_context_dump(ctx);
+
+    tjs_log(TJS_LOGLEVEL_DUK, func, line,
+        "%s", duk_safe_to_string(ctx, -1));
+
+    duk_pop(ctx);
+}
@@ -0,0 +1,311 @@
+/**
+ * @package TouchJS
+ *
+ * @file Touchbar functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include "touchjs.h"
+#include "touchbar.h"
+#include "embed.h"
+#include "loadgen.h"
+
+#include "widgets/widget.h"
+#include "common/callback.h"
+#include "common/dirty.h"
+#include "common/gc.h"
+#include "common/timer.h"
+#include "common/throttle.h"
+#include "common/syms.h"
+
+/* Globals */
+static TjsDirty *dirty = NULL;
+
+/**
+ * Dispatch click to embed item
+ *
+ * @param[in]  idx  Index of the embed item
+ **/
+
+void tjs_touchbar_click(int idx) {
+    /* Get touch item */
+    TjsEmbed *embed = tjs_embed_get(idx);
+
+    if (NULL != embed && NULL != embed->userdata) {
+        TJS_LOG_DEBUG("flags=%d, idx=%d", embed->userdata->flags, idx);
+
+        tjs_loadgen_trace(TJS_LOADGEN_CLICK, idx, 0);
+        tjs_gc_activity(touch.gc);
+
+        /* Get object and call callback if any */
+        duk_get_global_string(embed->ctx, embed->identifier);
+
+        if (duk_is_object(embed->ctx, -1)) {
+            tjs_callback_call(embed->ctx, TJS_SYM_CLICK_CB, 0);
+        } else {
+            duk_pop(embed->ctx); ///< Tidy up
+        }
+
+        /* Apply changes made by the callback */
+        if (0 == touch.tick) {
+            tjs_touchbar_flush();
+        }
+    }
+}
+
+/**
+ * Helper to pass slider value to the slide callback
+ *
+ * @param[inout]  embed  A #TjsEmbed
+ * @param[in]     value  Value of the slider
+ **/
+
+static void tjs_touchbar_deliver(TjsEmbed *embed, double value) {
+    /* Get object and call callback */
+    duk_get_global_string(embed->ctx, embed->identifier);
+
+    if (duk_is_object(embed->ctx, -1)) {
+        duk_push_int(embed->ctx, value);
+        tjs_callback_call(embed->ctx, TJS_SYM_SLIDE_CB, 1);
+    } else {
+        duk_pop(embed->ctx); ///< Tidy up
+    }
+
+    /* Apply changes made by the callback */
+    if (0 == touch.tick) {
+        tjs_touchbar_flush();
+    }
+}
+
+/**
+ * Helper to schedule delivery of pending slider value; pops timer
+ * callback from stack top
+ *
+ * @param[inout]  ctx       A #duk_context of the owning heap
+ * @param[inout]  throttle  A #TjsThrottle
+ **/
+
+static void tjs_touchbar_schedule(duk_context *ctx, TjsThrottle *throttle) {
+    double delay = throttle->due - tjs_timers_now(touch.timers);
+
+    throttle->timer = tjs_timers_add(touch.timers, (0 < delay ? delay : 0), 0);
+
+    /* Store as one-shot timer callback */
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_TIMERS);
+    duk_dup(ctx, -3);
+    duk_put_prop_index(ctx, -2, (duk_uarridx_t)throttle->timer);
+    duk_pop_3(ctx);
+}
+
+/**
+ * Native timer callback; delivers pending slider value when due
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_touchbar_trailing(duk_context *ctx) {
+    duk_push_current_function(ctx);
+    duk_get_prop_string(ctx, -1, "idx");
+
+    TjsEmbed *embed = tjs_embed_get(duk_get_int(ctx, -1));
+
+    duk_pop(ctx);
+
+    if (NULL != embed && ctx == embed->ctx && NULL != embed->userdata &&
+            0 < (embed->userdata->flags & TJS_FLAG_TYPE_SLIDER))
+    {
+        TjsThrottle *throttle = ((TjsWidget *)embed->userdata)->throttle;
+        double value = 0;
+
+        if (NULL != throttle) {
+            throttle->timer = 0;
+
+            switch (tjs_throttle_due(throttle,
+                    tjs_timers_now(touch.timers), &value))
+            {
+                case TJS_THROTTLE_DELIVER:
+                    tjs_touchbar_deliver(embed, value);
+                    break;
+                case TJS_THROTTLE_DEFER:
+                    /* Debounced again; reuse this callback */
+                    duk_dup_top(ctx);
+                    tjs_touchbar_schedule(ctx, throttle);
+                    break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Helper to defer delivery of pending slider value
+ *
+ * @param[inout]  embed     A #TjsEmbed
+ * @param[inout]  throttle  A #TjsThrottle
+ **/
+
+static void tjs_touchbar_defer(TjsEmbed *embed, TjsThrottle *throttle) {
+    /* Due time only moves later, so the timer checks it when fired */
+    if (0 != throttle->timer) return;
+
+    duk_push_c_function(embed->ctx, tjs_touchbar_trailing, 0);
+    duk_push_int(embed->ctx, embed->idx);
+    duk_put_prop_string(embed->ctx, -2, "idx");
+
+    tjs_touchbar_schedule(embed->ctx, throttle);
+}
+
+/**
+ * Dispatch slide to embed item; throttled sliders coalesce values
+ * here before entering the callback
+ *
+ * @param[in]  idx    Index of the embed item
+ * @param[in]  value  New value of the slider
+ **/
+
+void tjs_touchbar_slide(int idx, double value) {
+    /* Get touch item */
+    TjsEmbed *embed = tjs_embed_get(idx);
+
+    if (NULL != embed && NULL != embed->userdata) {
+        TjsWidget *widget = (TjsWidget *)embed->userdata;
+
+        /* Update value */
+        if (0 < (widget->flags & TJS_FLAG_TYPE_SLIDER)) {
+            widget->value.asInt = value;
+        }
+
+        TJS_LOG_DEBUG("obj=%p, flags=%d, idx=%d, value=%f",
+            widget, widget->flags, idx, value);
+
+        tjs_loadgen_trace(TJS_LOADGEN_SLIDE, idx, value);
+        tjs_gc_activity(touch.gc);
+
+        if (0 < (widget->flags & TJS_FLAG_TYPE_SLIDER) &&
+                NULL != widget->throttle)
+        {
+            switch (tjs_throttle_event(widget->throttle, value,
+                    tjs_timers_now(touch.timers)))
+            {
+                case TJS_THROTTLE_DROP:
+                    return;
+                case TJS_THROTTLE_DEFER:
+                    tjs_touchbar_defer(embed, widget->throttle);
+                    return;
+            }
+        }
+
+        tjs_touchbar_deliver(embed, value);
+    }
+}
+
+/**
+ * Attach embed item to touchbar
+ *
+ * @param[inout]  ctx       A #duk_context
+ * @param[inout]  userdata  A #TjsUserdata
+ * @param[inout]  parent    A #TjsUserdata
+ **/
+
+void tjs_touchbar_attach(duk_context *ctx, TjsUserdata *userdata,
+    TjsUserdata *parent)
+{
+    if (NULL != userdata) {
+        TJS_LOG_OBJ(userdata);
+
+        /* Create new embed */
+        TjsEmbed *embed = tjs_embed_new(ctx, userdata, parent);
+
+        tjs_embed_create(embed);
+    }
+}
+
+/**
+ * Detach embed item based on userdata
+ *
+ * @param[inout]  ctx       A #duk_context
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+void tjs_touchbar_detach(duk_context *ctx, TjsUserdata *userdata) {
+    if (NULL != userdata) {
+        TJS_LOG_OBJ(userdata);
+
+        /* Find embed item */
+        TjsEmbed *embed = tjs_embed_find(userdata, NULL);
+
+        if (NULL != embed) {
+            tjs_dirty_forget(dirty, userdata);
+            tjs_embed_destroy(embed);
+        }
+    }
+}
+
+/**
+ * Mark touchbar item for update based on state and userdata
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+void tjs_touchbar_update(TjsUserdata *userdata) {
+    if (NULL != userdata && 0 < (userdata->flags & TJS_FLAGS_ATTACHABLE)) {
+        TJS_LOG_OBJ(userdata);
+
+        /* Queue only attached items; others are updated on creation */
+        if (NULL != tjs_embed_find(userdata, NULL)) {
+            tjs_dirty_mark(dirty, userdata, userdata->flags);
+        }
+    }
+}
+
+/**
+ * Helper to apply pending changes of userdata
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+static void tjs_touchbar_apply(TjsUserdata *userdata) {
+    TjsEmbed *embed = tjs_embed_find(userdata, NULL);
+
+    if (NULL != embed) {
+        tjs_embed_update(embed);
+    }
+}
+
+/**
+ * Apply all pending updates
+ **/
+
+void tjs_touchbar_flush(void) {
+    int nitems = tjs_dirty_flush(dirty);
+
+    if (0 < nitems) {
+        TJS_LOG_DEBUG("Flushed: items=%d, marks=%lu, fg=%lu, bg=%lu, value=%lu",
+            nitems, dirty->stats.marks, dirty->stats.fg,
+            dirty->stats.bg, dirty->stats.value);
+    }
+}
+
+/**
+ * Init touchbar
+ **/
+
+void tjs_touchbar_init(void) {
+    dirty = tjs_dirty_new(tjs_touchbar_apply);
+}
+
+/**
+ * Deinit touchbar
+ **/
+
+void tjs_touchbar_deinit(void) {
+    tjs_dirty_destroy(dirty);
+
+    dirty = NULL;
+}
@@ -21,5 +21,11 @@
 void tjs_touchbar_attach(duk_context *ctx, TjsUserdata *userdata, TjsUserdata *parent);
 void tjs_touchbar_detach(duk_context *ctx, TjsUserdata *userdata);
 void tjs_touchbar_update(TjsUserdata *userdata);
+void tjs_touchbar_click(int idx);
+void tjs_touchbar_slide(int idx, double value);
+void tjs_touchbar_flush(void);
+
+void tjs_touchbar_init(void);
+void tjs_touchbar_deinit(void);
 
 #endif /* TJS_TOUCHBAR_H */
\ No newline at end of file
@@ -29,12 +29,15 @@
 #define TJS_FLAG_TYPE_WM (1L << 2)
 #define TJS_FLAG_TYPE_SCREEN (1L << 3)
 #define TJS_FLAG_TYPE_WIN (1L << 4)
+#define TJS_FLAG_TYPE_SNAPSHOT (1L << 5)
 
 #define TJS_FLAG_TYPE_LABEL  (1L << 10)
 #define TJS_FLAG_TYPE_BUTTON (1L << 11)
 #define TJS_FLAG_TYPE_SLIDER  (1L << 12)
 #define TJS_FLAG_TYPE_SCRUBBER  (1L << 13)
 
+#define TJS_FLAG_STATE_PENDING (1L << 24)
+#define TJS_FLAG_STATE_DIRTY (1L << 25)
 #define TJS_FLAG_STATE_COLOR_FG (1L << 26)
 #define TJS_FLAG_STATE_COLOR_BG (1L << 27)
 #define TJS_FLAG_STATE_VALUE (1L << 28)
@@ -49,7 +52,14 @@
 #define TJS_FLAGS_COLORS \
     (TJS_FLAG_STATE_COLOR_FG|TJS_FLAG_STATE_COLOR_BG)
 #define TJS_FLAGS_UPDATES \
-    (TJS_FLAG_COLORS|TJS_FLAG_STATE_VALUE)
+    (TJS_FLAGS_COLORS|TJS_FLAG_STATE_VALUE)
+
+/* Heaps */
+#define TJS_HEAPS_MAX 8 ///< Max number of isolated heaps
+
+/* Touch flags */
+#define TJS_TOUCH_FLAG_CACHE (1L << 0)
+#define TJS_TOUCH_FLAG_QUIT (1L << 1)
 
 /* Loglevel */
 #define TJS_LOGLEVEL_INFO (1L << 0)
@@ -63,38 +73,62 @@
 /* Macros */
 #define TJS_DSTACK(CTX) \
     tjs_dump_stack(__FUNCTION__, __LINE__, CTX);
+#define TJS_LOG(LEVEL, FMT, ...) \
+    do { \
+        if (0 < (touch.loglevel & (LEVEL))) \
+            tjs_log((LEVEL), __FUNCTION__, __LINE__, FMT, ##__VA_ARGS__); \
+    } while (0)
 #define TJS_LOG_INFO(FMT, ...) \
-    tjs_log(TJS_LOGLEVEL_INFO, __FUNCTION__, __LINE__, FMT, ##__VA_ARGS__);
+    TJS_LOG(TJS_LOGLEVEL_INFO, FMT, ##__VA_ARGS__)
 #define TJS_LOG_DEBUG(FMT, ...) \
-    tjs_log(TJS_LOGLEVEL_DEBUG, __FUNCTION__, __LINE__, FMT, ##__VA_ARGS__);
+    TJS_LOG(TJS_LOGLEVEL_DEBUG, FMT, ##__VA_ARGS__)
 #define TJS_LOG_ERROR(FMT, ...) \
-    tjs_log(TJS_LOGLEVEL_ERROR, __FUNCTION__, __LINE__, FMT, ##__VA_ARGS__);
+    TJS_LOG(TJS_LOGLEVEL_ERROR, FMT, ##__VA_ARGS__)
 #define TJS_LOG_DUK(FMT, ...) \
-    tjs_log(TJS_LOGLEVEL_DUK, __FUNCTION__, __LINE__, FMT, ##__VA_ARGS__);
+    TJS_LOG(TJS_LOGLEVEL_DUK, FMT, ##__VA_ARGS__)
 #define TJS_LOG_PRINT(FMT, ...) \
-    tjs_log(TJS_LOGLEVEL_PRINT, __FUNCTION__, __LINE__, FMT, ##__VA_ARGS__);
+    TJS_LOG(TJS_LOGLEVEL_PRINT, FMT, ##__VA_ARGS__)
 #define TJS_LOG_EVENT(FMT, ...) \
-    tjs_log(TJS_LOGLEVEL_EVENT, __FUNCTION__, __LINE__, FMT, ##__VA_ARGS__);
+    TJS_LOG(TJS_LOGLEVEL_EVENT, FMT, ##__VA_ARGS__)
 #define TJS_LOG_OBSERVER(FMT, ...) \
-    tjs_log(TJS_LOGLEVEL_OBSERVER, __FUNCTION__, __LINE__, FMT, ##__VA_ARGS__);
+    TJS_LOG(TJS_LOGLEVEL_OBSERVER, FMT, ##__VA_ARGS__)
 #define TJS_LOG_OBJ(OBJ) \
-    tjs_log(TJS_LOGLEVEL_DEBUG, __FUNCTION__, __LINE__, "obj=%p, flags=%d", OBJ, OBJ->flags);
+    TJS_LOG(TJS_LOGLEVEL_DEBUG, "obj=%p, flags=%d", OBJ, OBJ->flags)
 
 /* Types */
 typedef struct tjs_touch_t {
     int flags;
     int loglevel;
-
-    duk_context *ctx;
+    int tick; ///< Update flush interval in ms; 0 flushes after each dispatch
+    int workers; ///< Attribute query threads; 0 uses the default
+
+    duk_context *ctx; ///< Primary heap; same as first of heaps
+    duk_context *heaps[TJS_HEAPS_MAX]; ///< Isolated heaps; scripts don't share globals or gc
+    int nheaps;
+    struct tjs_alloc_t *alloc; ///< Shared by heap and userdata
+    struct tjs_gc_t *gc; ///< Idle gc; NULL when disabled
+    struct tjs_timers_t *timers; ///< Script timers
+    struct tjs_procs_t *procs; ///< Running commands
+    struct tjs_exec_t *exec; ///< Command slots and output cache
+    struct tjs_watchdog_t *watchdog; ///< Callback time budget; NULL when disabled
+    struct tjs_profile_t *profile; ///< Callback profiler; NULL when disabled
+    struct tjs_logger_t *logger; ///< Async JSON log; NULL logs synchronously
+    struct tjs_bus_t *bus; ///< Event subscriptions of all heaps
+    struct tjs_coalesce_t *coalesce; ///< Window move/resize storms; NULL when disabled
 } TjsTouch;
 
 /* Globals */
-TjsTouch touch;
+extern TjsTouch touch;
 
-/* touchjs.m */
+/* log.c */
 void tjs_log(int level, const char *func, int line, const char *fmt, ...);
+int tjs_log_level(const char *str);
+unsigned long tjs_log_dropped(void);
 void tjs_fatal(void *userdata, const char *msg);
 void tjs_dump_stack(const char *func, int line, duk_context *ctx);
+
+/* touchjs.m, headless.c */
+void tjs_log_write(const char *msg);
 void tjs_exit(void);
 
 /******************************
@@ -103,9 +137,11 @@ void tjs_exit(void);
 
 /* global.c */
 void tjs_global_init(duk_context *ctx);
+int tjs_global_timers_run(void);
 
-/* command.m */
+/* command.c */
 void tjs_command_init(duk_context *ctx);
+int tjs_command_poll(int timeout);
 
 /******************************
  *             WM             *
@@ -121,6 +157,9 @@ void tjs_screen_init(duk_context *ctx);
 /* win.m */
 void tjs_win_init(duk_context *ctx);
 
+/* snapshot.c */
+void tjs_snapshot_init(duk_context *ctx);
+
 /******************************
  *          Widgets           *
  ******************************/
@@ -16,8 +16,29 @@
 #include "touchjs.h"
 #include "delegate.h"
 #include "embed.h"
+#include "touchbar.h"
 
 #include "common/callback.h"
+#include "common/bytecode.h"
+#include "common/loader.h"
+#include "common/alloc.h"
+#include "common/gc.h"
+#include "common/timer.h"
+#include "common/proc.h"
+#include "common/exec.h"
+#include "common/watchdog.h"
+#include "common/profile.h"
+#include "common/logger.h"
+#include "common/bus.h"
+#include "common/coalesce.h"
+
+#include "backends/cocoa.h"
+
+#include "wm/win.h"
+#include "wm/wincache.h"
+
+/* Globals */
+TjsTouch touch;
 
 /******************************
  *           Helper           *
@@ -30,10 +51,39 @@
  static void tjs_usage(void) {
     NSLog(@"Usage: %s [OPTIONS]\n\n" \
            "Options:\n" \
-           "  -f FILE           Eval file \n" \
+           "  -A NUM            Query window attributes on NUM worker\n" \
+           "                    threads (default 4, max 16)\n" \
+           "  -a MODE           Allocator: pool (default) or malloc\n" \
+           "  -b MSEC           Abort callbacks running longer than MSEC;\n" \
+           "                    0 disables (default 1000)\n" \
+           "  -C QUIET[:MAXDELAY]\n" \
+           "                    Collapse window move and resize storms;\n" \
+           "                    deliver after QUIET ms without events or\n" \
+           "                    MAXDELAY ms after the first one; 0\n" \
+           "                    disables (default 16:50)\n" \
+           "  -c                Cache compiled bytecode next to FILE\n" \
+           "  -G MSEC           Run gc after MSEC of idle time\n" \
+           "  -f FILE|DIR       Eval file or all *.js files of DIR;\n" \
+           "                    can be given multiple times\n" \
            "  -h                Show this help and exit\n" \
+           "  -I NUM            Load files round-robin into NUM isolated\n" \
+           "                    heaps (default 1, max 8)\n" \
+           "  -m SIZE[K|M|G]    Cap memory of each heap and its userdata\n" \
+           "                    at SIZE\n" \
+           "  -o FILE           Log JSON lines from a writer thread to\n" \
+           "                    FILE or - for stderr\n" \
+           "  -p FILE           Profile callbacks; write collapsed stacks\n" \
+           "                    for flame graphs to FILE or - for stdout\n" \
+           "  -S MSEC           Coalesce timers due within MSEC\n" \
+           "                    (default 10)\n" \
+           "  -t MSEC           Flush widget updates every MSEC\n" \
+           "                    instead of after each event\n" \
            "  -v                Show version info and exit\n" \
-           "  -l LEVEL[,LEVEL]  Set logging levels:\n" \
+           "  -x NUM            Run at most NUM commands at once; 0 is\n" \
+           "                    unlimited (default 8)\n" \
+           "  -l LEVEL[:RATE][,LEVEL[:RATE]]\n" \
+           "                    Set logging levels and rate limits in\n" \
+           "                    messages per second:\n" \
            "                      duk      => Duktape logging\n" \
            "                      info     => General information (default)\n" \
            "                      debug    => All debugging messages (noisy!)\n" \
@@ -58,170 +108,59 @@ static void tjs_version(void) {
 }
 
 /**
- * Log handler
+ * Log writer
  *
- * @param[in]  level  Log level
- * @param[in]  func   Name of the calling function
- * @param[in]  line   Line number of the call
- * @param[in]  fmt    Message format
- * @param[in]  ...    Variadic arguments
+ * @param[in]  msg  Formatted log message
  **/
 
-void tjs_log(int level, const char *func, int line, const char *fmt, ...) {
-    va_list ap;
-    char buf[255];
-    int guard;
-
-    /* Check loglevel */
-    if(0 == (touch.loglevel & level)) return;
-
-    /* Get variadic arguments */
-    va_start(ap, fmt);
-    vsnprintf(buf, sizeof(buf), fmt, ap);
-    va_end(ap);
-
-    switch (level) {
-        case TJS_LOGLEVEL_DUK:
-            NSLog(@"[DUK %s:%d] %s", func, line, buf);
-            break;
-        case TJS_LOGLEVEL_INFO:
-            NSLog(@"[INFO] %s", buf);
-            break;
-        case TJS_LOGLEVEL_DEBUG:
-            NSLog(@"[DEBUG %s:%d] %s", func, line, buf);
-            break;
-        case TJS_LOGLEVEL_ERROR:
-            NSLog(@"[ERROR %s:%d] %s", func, line, buf);
-            break;
-        case TJS_LOGLEVEL_EVENT:
-            NSLog(@"[EVENT %s:%d] %s", func, line, buf);
-            break;
-        case TJS_LOGLEVEL_OBSERVER:
-            NSLog(@"[OBSERVER %s:%d] %s", func, line, buf);
-            break;
-        case TJS_LOGLEVEL_PRINT:
-            NSLog(@"[PRINT] %s", buf);
-            break;
-    }
-}
-
-/**
- * Parse loglevel string
- *
- * @param[in]  str  Loglevel string
- *
- * @return Parsed loglevel
- **/
-
-static int tjs_level(const char *str) {
-    int level = 0;
-    char *tokens = NULL, *tok = NULL;
-
-    tokens = strdup(str);
-    tok    = strtok((char *)tokens, ",");
-
-    /* Parse levels */
-    while (tok) {
-        if (0 == strncasecmp(tok, "duk", 3)) {
-            level |= TJS_LOGLEVEL_DUK;
-        } else if (0 == strncasecmp(tok, "info", 4)) {
-            level |= TJS_LOGLEVEL_INFO;
-        } else if (0 == strncasecmp(tok, "debug", 5)) {
-            level |= TJS_LOGLEVEL_DEBUG;
-        } else if (0 == strncasecmp(tok, "error", 5)) {
-            level |= TJS_LOGLEVEL_ERROR;
-        } else if (0 == strncasecmp(tok, "event", 5)) {
-            level |= TJS_LOGLEVEL_EVENT;
-        } else if (0 == strncasecmp(tok, "print", 5)) {
-            level |= TJS_LOGLEVEL_PRINT;
-        } else if (0 == strncasecmp(tok, "observer", 8)) {
-            level |= TJS_LOGLEVEL_OBSERVER;
-        }
-
-        tok = strtok(NULL, ",");
-    }
-
-  free(tokens);
-
-  return level;
-}
-
-/**
- * Fatal error handler
- *
- * @param[in]  userdata  Userdata added to heap
- * @param[in]  msg       Message to log
- **/
-
-void tjs_fatal(void *userdata, const char *msg) {
-    (void) userdata; ///< Not unused anymore..
-
-    TJS_LOG_DUK("Fatal error on line: %s", (msg ? msg : "No message"));
-
-    abort();
-}
-
-/**
- * Helper to dump the duktape stack
- *
- * @param[inout]  ctx  A #duk_context
- **/
-
-void tjs_dump_stack(const char *func, int line, duk_context *ctx) {
-    duk_push_context_dump(ctx);
-
-    tjs_log(TJS_LOGLEVEL_DUK, func, line,
-        "%s", duk_safe_to_string(ctx, -1));
-
-    duk_pop(ctx);
+void tjs_log_write(const char *msg) {
+    NSLog(@"%s", msg);
 }
 
 /**
- * Terminate app
+ * Terminate app; scripts call this from within a heap, so the heaps are
+ * destroyed in applicationWillTerminate: once they returned
  **/
 
 void tjs_exit() {
-    duk_destroy_heap(touch.ctx);
-
-    [NSApp terminate: NULL];
+    [NSApp performSelector: @selector(terminate:) withObject: nil
+        afterDelay: 0];
 }
 
-/******************************
- *             I/O            *
- ******************************/
-
 /**
- * Read and eval file
+ * Create heap and register all objects
  *
- * @param[in]  source  Name of file to load
+ * @return A new #duk_context
  **/
 
-static void tjs_eval_file(char *source) {
-    TJS_LOG_INFO("Loading file %s", source);
+static duk_context *tjs_heap(void) {
+    /* Each heap is accounted and limited on its own */
+    TjsAllocHeap *heap = tjs_alloc_heap_new(touch.alloc);
 
-    /* Load file */
-    NSFileHandle *file = [NSFileHandle fileHandleForReadingAtPath:
-        [NSString stringWithUTF8String: source]];
+    if (NULL == heap) return NULL;
 
-    if (NULL == file) {
-        TJS_LOG_ERROR("Failed to open file file %s", source);
+    duk_context *ctx = duk_create_heap(tjs_alloc_duk_alloc,
+        tjs_alloc_duk_realloc, tjs_alloc_duk_free, heap, tjs_fatal);
 
-        return;
-    }
+    if (NULL == ctx) return NULL;
 
-    /* Read and convert data */
-    NSData *buffer = [file readDataToEndOfFile];
-    NSString *data = [[NSString alloc] initWithData: buffer
-        encoding: NSUTF8StringEncoding];
+    /* Register objects */
+    tjs_global_init(ctx);
+    tjs_command_init(ctx);
 
-    [file closeFile];
+    tjs_wm_init(ctx);
+    tjs_win_init(ctx);
+    tjs_screen_init(ctx);
+    tjs_snapshot_init(ctx);
 
-    if (NULL != data) {
-        /* Just eval the content */
-        TJS_LOG_INFO("Eval'ing file %s", source);
+    tjs_scrubber_init(ctx);
+    tjs_label_init(ctx);
+    tjs_button_init(ctx);
+    tjs_slider_init(ctx);
 
-        duk_eval_string_noresult(touch.ctx, (char *)[data UTF8String]);
-    }
+    touch.heaps[touch.nheaps++] = ctx;
+
+    return ctx;
 }
 
 /**
@@ -244,53 +183,131 @@ int main(int argc, char *argv[]) {
         TJS_LOGLEVEL_ERROR
     );
 
-    tjs_embed_init();
-
-    /* Create duk context */
-    touch.ctx = duk_create_heap(NULL, NULL, NULL, NULL, tjs_fatal);
-
-    /* Register objects */
-    tjs_global_init(touch.ctx);
-    tjs_command_init(touch.ctx);
-
-    tjs_wm_init(touch.ctx);
-    tjs_win_init(touch.ctx);
-    tjs_screen_init(touch.ctx);
-
-    tjs_scrubber_init(touch.ctx);
-    tjs_label_init(touch.ctx);
-    tjs_button_init(touch.ctx);
-    tjs_slider_init(touch.ctx);
+    tjs_embed_init(&tjs_backend_cocoa);
+    tjs_touchbar_init();
 
     /* Commandline arguments */
-    int c, fileOptId = -1;
-
-    while (-1 != (c = getopt(argc, argv, "df:hl:v"))) {
+    int c, mode = TJS_ALLOC_MODE_POOL, idle = 0, nfiles = 0;
+    int nexec = TJS_EXEC_LIMIT, nheaps = 1;
+    double slack = TJS_TIMERS_SLACK, budget = TJS_WATCHDOG_BUDGET;
+    double quiet = TJS_COALESCE_QUIET, maxdelay = TJS_COALESCE_MAXDELAY;
+    size_t limit = 0;
+    char **files = (char **)calloc(argc, sizeof(char *));
+    const char *profile = NULL, *logfile = NULL;
+
+    while (-1 != (c = getopt(argc, argv, "A:a:b:cC:df:G:hI:l:m:o:p:S:t:vx:"))) {
         switch (c) {
+            case 'A': touch.workers = atoi(optarg);         break;
+            case 'a':
+                mode = (0 == strcmp(optarg, "malloc") ?
+                    TJS_ALLOC_MODE_MALLOC : TJS_ALLOC_MODE_POOL);
+                break;
+            case 'b': budget = atof(optarg);                break;
+            case 'c': touch.flags |= TJS_TOUCH_FLAG_CACHE;  break;
+            case 'C':
+                maxdelay = 0;
+
+                if (1 > sscanf(optarg, "%lf:%lf", &quiet, &maxdelay)) {
+                    TJS_LOG_ERROR("Invalid coalesce spec %s", optarg);
+
+                    return 1;
+                }
+                break;
             case 'd': touch.loglevel |= TJS_LOGLEVEL_DEBUG; break;
-            case 'f': fileOptId = optind - 1;               break;
+            case 'f': files[nfiles++] = optarg;             break;
+            case 'G': idle = atoi(optarg);                  break;
             case 'h': tjs_usage();                          return 0;
-            case 'l': touch.loglevel = tjs_level(optarg);   break;
+            case 'I': nheaps = atoi(optarg);                break;
+            case 'l': touch.loglevel = tjs_log_level(optarg); break;
+            case 'm': limit = tjs_alloc_parse_size(optarg); break;
+            case 'o': logfile = optarg;                     break;
+            case 'p': profile = optarg;                     break;
+            case 'S': slack = atof(optarg);                 break;
+            case 't': touch.tick = atoi(optarg);            break;
             case 'v': tjs_version();                        return 0;
+            case 'x': nexec = atoi(optarg);                 break;
         }
     }
 
-    /* Eval file after debug/loglevel is set */
-    if (-1 != fileOptId) {
-        tjs_eval_file(argv[fileOptId]);
+    if (NULL != logfile &&
+            NULL == (touch.logger = tjs_logger_new(logfile, TJS_LOGGER_SIZE)))
+    {
+        TJS_LOG_ERROR("Failed to open %s", logfile);
+
+        return 1;
+    }
+
+    /* Create allocator first; heap and userdata share it */
+    touch.alloc = tjs_alloc_new(mode);
+    touch.alloc->limit = limit;
+
+    if (0 < idle) {
+        touch.gc = tjs_gc_new(idle);
+    }
+
+    touch.timers = tjs_timers_new(slack, 0);
+    touch.procs = tjs_procs_new();
+    touch.exec = tjs_exec_new(nexec);
+    touch.bus = tjs_bus_new();
+
+    if (0 < quiet || 0 < maxdelay) {
+        touch.coalesce = tjs_coalesce_new(quiet, maxdelay);
+    }
+
+    if (0 < budget) {
+        touch.watchdog = tjs_watchdog_new(budget);
+    }
+
+    if (NULL != profile) {
+        touch.profile = tjs_profile_new(profile);
     }
 
+    /* Create duk contexts; the first one is the primary heap */
+    if (1 > nheaps || TJS_HEAPS_MAX < nheaps) {
+        TJS_LOG_ERROR("Invalid number of heaps %d (1-%d)", nheaps,
+            TJS_HEAPS_MAX);
+
+        return 1;
+    }
+
+    tjs_wincache_init(&tjs_win_source_ax);
+
+    for (int i = 0; i < nheaps; i++) {
+        if (NULL == tjs_heap()) {
+            TJS_LOG_ERROR("Failed to create heap");
+
+            return 1;
+        }
+    }
+
+    touch.ctx = touch.heaps[0];
+
+    /* Eval files after debug/loglevel is set; round-robin over heaps */
+    if (0 < nfiles) {
+        TjsLoaderStats stats = { 0 };
+
+        for (int i = 0; i < nfiles; i++) {
+            tjs_loader_eval(touch.heaps[i % touch.nheaps], files[i],
+                (0 < (touch.flags & TJS_TOUCH_FLAG_CACHE) ?
+                    TJS_BYTECODE_CACHE : 0), &stats);
+        }
+
+        TJS_LOG_INFO("Loaded %d files (%d failed, %d cached): bytes=%zu, " \
+            "load=%.3fms, compile=%.3fms, exec=%.3fms",
+            stats.nfiles, stats.nfailed, stats.nhits, stats.bytes,
+            stats.load, stats.compile, stats.exec);
+
+        tjs_touchbar_flush();
+    }
+
+    free(files);
+
     /* Create and run application */
     AppDelegate *delegate = [[AppDelegate alloc] init];
 
     [NSApp setDelegate: delegate];
     [NSApp setActivationPolicy: NSApplicationActivationPolicyAccessory];
-    [NSApp run];
-
-    /* Tidy up */
-    tjs_embed_deinit();
-    tjs_wm_deinit();
-    tjs_exit();
+    [NSApp run]; ///< Tidied up in applicationWillTerminate:
 
     return 0;
 }
\ No newline at end of file
@@ -178,4 +178,6 @@ void tjs_button_init(duk_context *ctx) {
 
     duk_put_prop_string(ctx, -2, "prototype");
     duk_put_global_string(ctx, "TjsButton");
+
+    tjs_userdata_hook(TJS_FLAG_TYPE_BUTTON, tjs_widget_hook);
 }
\ No newline at end of file
@@ -11,6 +11,8 @@
 
 #include "../touchjs.h"
 
+#include "../touchbar.h"
+
 #include "widget.h"
 
 #include "../common/userdata.h"
@@ -69,6 +71,38 @@ static duk_ret_t tjs_label_prototype_getvalue(duk_context *ctx) {
     return 0;
 }
 
+/**
+ * Native setValue prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_label_prototype_setvalue(duk_context *ctx) {
+    const char *value = duk_require_string(ctx, -1);
+
+    /* Get userdata */
+    TjsWidget *widget = (TjsWidget *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_LABEL);
+
+    /* Skip unchanged values; polled labels mostly are */
+    if (NULL != widget && 0 != strcmp(widget->value.asChar, value)) {
+        free(widget->value.asChar);
+
+        widget->flags |= TJS_FLAG_STATE_VALUE;
+        widget->value.asChar = strdup(value);
+
+        TJS_LOG_DEBUG("flags=%d, value=%s",
+            widget->flags, widget->value.asChar);
+
+        tjs_touchbar_update((TjsUserdata *)widget);
+    }
+
+    /* Allow fluid.. */
+    duk_push_this(ctx);
+
+    return 1;
+}
+
 /**
  * Native toString prototype method
  *
@@ -106,6 +140,8 @@ void tjs_label_init(duk_context *ctx) {
     /* Register methods */
     duk_push_c_function(ctx, tjs_label_prototype_getvalue, 0);
     duk_put_prop_string(ctx, -2, "getValue");
+    duk_push_c_function(ctx, tjs_label_prototype_setvalue, 1);
+    duk_put_prop_string(ctx, -2, "setValue");
 
     duk_push_c_function(ctx, tjs_label_prototype_tostring, 0);
     duk_put_prop_string(ctx, -2, "toString");
@@ -115,4 +151,6 @@ void tjs_label_init(duk_context *ctx) {
 
     duk_put_prop_string(ctx, -2, "prototype");
     duk_put_global_string(ctx, "TjsLabel");
+
+    tjs_userdata_hook(TJS_FLAG_TYPE_LABEL, tjs_widget_hook);
 }
\ No newline at end of file
@@ -11,10 +11,29 @@
 
 #include "../touchjs.h"
 
+#include "../touchbar.h"
 #include "widget.h"
 
 #include "../common/callback.h"
 #include "../common/userdata.h"
+#include "../common/throttle.h"
+
+/**
+ * Userdata hook; releases slide policy
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+static void tjs_slider_hook(TjsUserdata *userdata) {
+    TjsWidget *widget = (TjsWidget *)userdata;
+
+    /* Pending timers find no value and just expire */
+    if (NULL != widget->throttle) {
+        tjs_throttle_destroy(widget->throttle);
+
+        widget->throttle = NULL;
+    }
+}
 
 /**
  * Native constructor
@@ -48,14 +67,19 @@ static duk_ret_t tjs_slider_ctor(duk_context *ctx) {
 }
 
 /**
- * Native bind prototype method
+ * Native bind prototype method; takes optional slide policy
+ * { maxHz: NUM, debounce: MSEC, trailing: bool }
+ *
+ * Throttled sliders pass at most maxHz values per second to the
+ * callback; debounced ones wait until values stop changing for
+ * debounce ms. With trailing (default) the last value always arrives.
  *
  * @param[inout]  ctx  A #duk_context
  **/
 
 static duk_ret_t tjs_slider_prototype_bind(duk_context *ctx) {
     /* Sanity check */
-    duk_require_function(ctx, -1);
+    duk_require_function(ctx, 0);
 
     /* Get userdata */
     TjsWidget *widget = (TjsWidget *)tjs_userdata_get(ctx,
@@ -66,9 +90,37 @@ static duk_ret_t tjs_slider_prototype_bind(duk_context *ctx) {
 
         /* Store slide callback */
         duk_push_this(ctx);
-        duk_swap_top(ctx, -2);
+        duk_dup(ctx, 0);
         duk_put_prop_string(ctx, -2, TJS_SYM_SLIDE_CB);
         duk_pop(ctx);
+
+        /* Replace slide policy */
+        tjs_slider_hook((TjsUserdata *)widget);
+
+        if (duk_is_object(ctx, 1)) {
+            double maxhz = 0, debounce = 0;
+            int flags = TJS_THROTTLE_FLAG_TRAILING;
+
+            if (duk_get_prop_string(ctx, 1, "maxHz")) {
+                maxhz = duk_require_number(ctx, -1);
+            }
+
+            if (duk_get_prop_string(ctx, 1, "debounce")) {
+                debounce = duk_require_number(ctx, -1);
+            }
+
+            if (duk_get_prop_string(ctx, 1, "trailing") &&
+                    !duk_to_boolean(ctx, -1))
+            {
+                flags &= ~TJS_THROTTLE_FLAG_TRAILING;
+            }
+
+            duk_pop_3(ctx);
+
+            if (0 < maxhz || 0 < debounce) {
+                widget->throttle = tjs_throttle_new(maxhz, debounce, flags);
+            }
+        }
     }
 
     /* Allow fluid.. */
@@ -119,6 +171,8 @@ static duk_ret_t tjs_slider_prototype_setpercent(duk_context *ctx) {
 
         TJS_LOG_DEBUG("flags=%d, percent=%d",
             widget->flags, widget->value.asInt);
+
+        tjs_touchbar_update((TjsUserdata *)widget);
     }
 
     /* Allow fluid.. */
@@ -127,6 +181,39 @@ static duk_ret_t tjs_slider_prototype_setpercent(duk_context *ctx) {
     return 1;
 }
 
+/**
+ * Native getStats prototype method; counts of slide policy
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_slider_prototype_getstats(duk_context *ctx) {
+    /* Get userdata */
+    TjsWidget *widget = (TjsWidget *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_SLIDER);
+
+    if (NULL != widget && NULL != widget->throttle) {
+        TjsThrottle *throttle = widget->throttle;
+        duk_idx_t idx = duk_push_object(ctx);
+
+        duk_push_number(ctx, throttle->stats.events);
+        duk_put_prop_string(ctx, idx, "events");
+        duk_push_number(ctx, throttle->stats.delivered);
+        duk_put_prop_string(ctx, idx, "delivered");
+        duk_push_number(ctx, throttle->stats.coalesced);
+        duk_put_prop_string(ctx, idx, "coalesced");
+        duk_push_number(ctx, (0 < throttle->stats.delivered ?
+            throttle->stats.lag / throttle->stats.delivered : 0));
+        duk_put_prop_string(ctx, idx, "lag");
+        duk_push_number(ctx, throttle->stats.maxlag);
+        duk_put_prop_string(ctx, idx, "maxLag");
+
+        return 1;
+    }
+
+    return 0;
+}
+
 /**
  * Native toString prototype method
  *
@@ -162,7 +249,7 @@ void tjs_slider_init(duk_context *ctx) {
     duk_push_object(ctx);
 
     /* Register methods */
-    duk_push_c_function(ctx, tjs_slider_prototype_bind, 1);
+    duk_push_c_function(ctx, tjs_slider_prototype_bind, 2);
     duk_put_prop_string(ctx, -2, "bind");
 
     duk_push_c_function(ctx, tjs_slider_prototype_getpercent, 0);
@@ -171,6 +258,9 @@ void tjs_slider_init(duk_context *ctx) {
     duk_push_c_function(ctx, tjs_slider_prototype_setpercent, 1);
     duk_put_prop_string(ctx, -2, "setPercent");
 
+    duk_push_c_function(ctx, tjs_slider_prototype_getstats, 0);
+    duk_put_prop_string(ctx, -2, "getStats");
+
     duk_push_c_function(ctx, tjs_widget_prototype_setbgcolor, 3);
     duk_put_prop_string(ctx, -2, "setBgColor");
 
@@ -179,4 +269,6 @@ void tjs_slider_init(duk_context *ctx) {
 
     duk_put_prop_string(ctx, -2, "prototype");
     duk_put_global_string(ctx, "TjsSlider");
+
+    tjs_userdata_hook(TJS_FLAG_TYPE_SLIDER, tjs_slider_hook);
 }
\ No newline at end of file
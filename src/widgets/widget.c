@@ -15,6 +15,20 @@
 
 #include "widget.h"
 
+/**
+ * Userdata hook; releases string value of labels and buttons
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+void tjs_widget_hook(TjsUserdata *userdata) {
+    TjsWidget *widget = (TjsWidget *)userdata;
+
+    free(widget->value.asChar);
+
+    widget->value.asChar = NULL;
+}
+
  /**
   * Helper to set the control color
   *
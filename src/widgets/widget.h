@@ -33,9 +33,13 @@ typedef struct tjs_widget_t {
     } colors;
 
     union tjs_value_t value;
+
+    struct tjs_throttle_t *throttle; ///< Slide policy of sliders; NULL otherwise
 } TjsWidget;
 
 /* Methods */
+void tjs_widget_hook(TjsUserdata *userdata);
+
 duk_ret_t tjs_widget_prototype_setfgcolor(duk_context *ctx);
 duk_ret_t tjs_widget_prototype_setbgcolor(duk_context *ctx);
 
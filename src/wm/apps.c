@@ -0,0 +1,487 @@
+/**
+ * @package TouchJS
+ *
+ * @file Application observer functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../touchjs.h"
+
+#include "apps.h"
+#include "wincache.h"
+
+#include "../common/registry.h"
+#include "../common/bus.h"
+#include "../common/coalesce.h"
+#include "../common/timer.h"
+#include "../common/syms.h"
+
+/* Globals */
+static const TjsAppSource *source = NULL;
+static TjsRegistry *bypid = NULL; ///< Pid -> #TjsApp
+static TjsAppsStats stats = { 0 };
+
+static duk_context *timerctx = NULL; ///< Keeps the retry timer callback
+static unsigned long timer = 0;      ///< Id of retry timer; 0 when none
+static double armed = 0;             ///< Due time of retry timer
+
+static unsigned int events = 0; ///< Mask of bindable event ids
+static unsigned int kept = 0;   ///< Mask of event ids bound without subscriptions
+static unsigned int wanted = 0; ///< Mask of event ids to bind
+
+static const char *states[] = { "pending", "attached", "failed" };
+
+/**
+ * Helper to bind and unbind notifications of attached app
+ *
+ * @param[inout]  app  A #TjsApp
+ *
+ * @return Number of changed notifications
+ **/
+
+static int tjs_apps_rebind(TjsApp *app) {
+    int nchanged = 0;
+
+    if (TJS_APPS_STATE_ATTACHED != app->state || wanted == app->bound) {
+        return 0;
+    }
+
+    for (int id = 0; id < TJS_BUS_EVENTS; id++) {
+        unsigned int bit = (1u << id);
+
+        if (0 < (wanted & bit) && 0 == (app->bound & bit)) {
+            /* Retried on next sync when the app refuses */
+            if (0 == source->bind(app->observer, app->pid, id)) {
+                app->bound |= bit;
+                stats.binds++;
+                nchanged++;
+            }
+        } else if (0 == (wanted & bit) && 0 < (app->bound & bit)) {
+            source->unbind(app->observer, app->pid, id);
+
+            app->bound &= ~bit;
+            stats.unbinds++;
+            nchanged++;
+        }
+    }
+
+    return nchanged;
+}
+
+/**
+ * Helper to try attaching observer; failures back off exponentially
+ *
+ * @param[inout]  app  A #TjsApp
+ * @param[in]     now  Current time in ms
+ **/
+
+static void tjs_apps_attach(TjsApp *app, double now) {
+    app->observer = source->attach(app->pid);
+
+    if (NULL != app->observer) {
+        app->state = TJS_APPS_STATE_ATTACHED;
+        app->stats.window = now;
+        stats.attached++;
+
+        tjs_apps_rebind(app);
+
+        TJS_LOG_OBSERVER("App attached: pid=%d, name=%s, attempts=%d",
+            app->pid, app->name, app->attempts);
+
+        return;
+    }
+
+    if (TJS_APPS_RETRIES <= ++(app->attempts)) {
+        app->state = TJS_APPS_STATE_FAILED;
+        stats.failed++;
+
+        TJS_LOG_ERROR("Failed to observe app: pid=%d, name=%s",
+            app->pid, app->name);
+    } else {
+        app->due = now + TJS_APPS_BACKOFF * (1 << (app->attempts - 1));
+    }
+}
+
+/**
+ * Native timer callback; retries pending attaches and re-arms
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_apps_timer(duk_context *ctx) {
+    (void)ctx;
+
+    timer = 0;
+
+    tjs_apps_poll();
+
+    return 0;
+}
+
+/**
+ * Helper to arm one-shot retry timer for the earliest pending app
+ **/
+
+static void tjs_apps_arm(void) {
+    double due = -1;
+
+    if (NULL == timerctx) return;
+
+    for (int i = 0; i < tjs_registry_size(bypid); i++) {
+        TjsApp *app = (TjsApp *)tjs_registry_get(bypid, i);
+
+        if (NULL != app && TJS_APPS_STATE_PENDING == app->state &&
+                (0 > due || app->due < due))
+        {
+            due = app->due;
+        }
+    }
+
+    if (0 > due || (0 != timer && armed <= due)) return;
+
+    if (0 != timer && tjs_timers_clear(touch.timers, timer)) {
+        duk_push_heap_stash(timerctx);
+        duk_get_prop_string(timerctx, -1, TJS_SYM_TIMERS);
+        duk_del_prop_index(timerctx, -1, (duk_uarridx_t)timer);
+        duk_pop_2(timerctx);
+    }
+
+    double delay = due - tjs_timers_now(touch.timers);
+
+    timer = tjs_timers_add(touch.timers, (0 < delay ? delay : 0), 0);
+    armed = due;
+
+    /* Store as one-shot timer callback */
+    duk_push_heap_stash(timerctx);
+    duk_get_prop_string(timerctx, -1, TJS_SYM_TIMERS);
+    duk_push_c_function(timerctx, tjs_apps_timer, 0);
+    duk_put_prop_index(timerctx, -2, (duk_uarridx_t)timer);
+    duk_pop_2(timerctx);
+}
+
+/**
+ * Mark event as bindable by the source
+ *
+ * @param[in]  id  Interned event id
+ **/
+
+void tjs_apps_event_add(int id) {
+    if (0 <= id && TJS_BUS_EVENTS > id) events |= (1u << id);
+}
+
+/**
+ * Mark event as always bound; the window cache relies on it even when
+ * no script subscribed
+ *
+ * @param[in]  id  Interned event id
+ **/
+
+void tjs_apps_event_keep(int id) {
+    if (0 <= id && TJS_BUS_EVENTS > id) {
+        events |= (1u << id);
+        kept |= (1u << id);
+        wanted |= (1u << id);
+    }
+}
+
+/**
+ * Track launched app and attach observer; launching twice is harmless
+ *
+ * @param[in]  pid   Process id
+ * @param[in]  name  Name of the app; may be NULL
+ *
+ * @return Either #TjsApp of the pid; otherwise NULL
+ **/
+
+TjsApp *tjs_apps_launch(int pid, const char *name) {
+    TjsApp *app = tjs_apps_find(pid);
+
+    if (NULL != app || 0 >= pid) return app;
+
+    app = (TjsApp *)calloc(1, sizeof(TjsApp));
+
+    if (NULL == app) return NULL;
+
+    app->pid = pid;
+    app->state = TJS_APPS_STATE_PENDING;
+    app->launched = tjs_timers_now(touch.timers);
+
+    snprintf(app->name, sizeof(app->name), "%s", (NULL != name ? name : ""));
+
+    if (0 > tjs_registry_add(bypid, (void *)(uintptr_t)pid, app)) {
+        free(app);
+
+        return NULL;
+    }
+
+    stats.launched++;
+
+    tjs_apps_attach(app, app->launched);
+    tjs_apps_arm();
+
+    return app;
+}
+
+/**
+ * Detach observer of terminated app and forget it; windows go away
+ * without close notifications, so their cached attributes and pending
+ * coalesced events go too
+ *
+ * @param[in]  pid  Process id
+ *
+ * @return Either 1 when app was tracked; otherwise 0
+ **/
+
+int tjs_apps_terminate(int pid) {
+    TjsApp *app = (TjsApp *)tjs_registry_remove(bypid,
+        (void *)(uintptr_t)pid);
+
+    /* Pending frames would be delivered with stale windows */
+    if (NULL != touch.coalesce) {
+        tjs_coalesce_drop_pid(touch.coalesce, pid);
+    }
+
+    if (NULL == app) return 0;
+
+    /* Notifications go away with the observer */
+    if (TJS_APPS_STATE_ATTACHED == app->state) {
+        source->detach(app->observer, app->pid);
+
+        stats.detached++;
+    }
+
+    tjs_wincache_purge(pid);
+
+    stats.terminated++;
+
+    TJS_LOG_OBSERVER("App terminated: pid=%d, name=%s, events=%lu",
+        app->pid, app->name, app->stats.events);
+
+    free(app);
+
+    return 1;
+}
+
+/**
+ * Find tracked app
+ *
+ * @param[in]  pid  Process id
+ *
+ * @return Either found #TjsApp; otherwise NULL
+ **/
+
+TjsApp *tjs_apps_find(int pid) {
+    return (TjsApp *)tjs_registry_find(bypid, (void *)(uintptr_t)pid, NULL);
+}
+
+/**
+ * Bind kept notifications and those that have subscriptions and
+ * unbind the rest; call after subscriptions change
+ *
+ * @return Number of changed notifications
+ **/
+
+int tjs_apps_sync(void) {
+    int nchanged = 0;
+
+    if (NULL == source) return 0;
+
+    wanted = kept;
+
+    for (int id = 0; id < TJS_BUS_EVENTS; id++) {
+        if (0 < (events & (1u << id)) && tjs_bus_subscribed(touch.bus, id)) {
+            wanted |= (1u << id);
+        }
+    }
+
+    for (int i = 0; i < tjs_registry_size(bypid); i++) {
+        TjsApp *app = (TjsApp *)tjs_registry_get(bypid, i);
+
+        if (NULL != app) nchanged += tjs_apps_rebind(app);
+    }
+
+    return nchanged;
+}
+
+/**
+ * Account notification of app
+ *
+ * @param[in]  pid  Process id
+ * @param[in]  id   Interned event id
+ *
+ * @return Either 1 when the notification is bound; otherwise 0
+ **/
+
+int tjs_apps_event(int pid, int id) {
+    TjsApp *app = tjs_apps_find(pid);
+
+    if (NULL == app || 0 > id || TJS_BUS_EVENTS <= id ||
+            0 == (app->bound & (1u << id)))
+    {
+        stats.unbound++;
+
+        return 0;
+    }
+
+    double now = tjs_timers_now(touch.timers);
+
+    /* Close rate window */
+    if (TJS_APPS_WINDOW <= now - app->stats.window) {
+        app->stats.rate = app->stats.inwindow * 1000.0 /
+            (now - app->stats.window);
+
+        if (app->stats.rate > app->stats.peak) {
+            app->stats.peak = app->stats.rate;
+        }
+
+        app->stats.window = now;
+        app->stats.inwindow = 0;
+    }
+
+    app->stats.events++;
+    app->stats.inwindow++;
+
+    return 1;
+}
+
+/**
+ * Retry due attaches
+ *
+ * @return Number of attached apps
+ **/
+
+int tjs_apps_poll(void) {
+    int nattached = 0;
+    double now = tjs_timers_now(touch.timers);
+
+    for (int i = 0; i < tjs_registry_size(bypid); i++) {
+        TjsApp *app = (TjsApp *)tjs_registry_get(bypid, i);
+
+        if (NULL != app && TJS_APPS_STATE_PENDING == app->state &&
+                app->due <= now)
+        {
+            stats.retries++;
+
+            tjs_apps_attach(app, now);
+
+            if (TJS_APPS_STATE_ATTACHED == app->state) nattached++;
+        }
+    }
+
+    tjs_apps_arm();
+
+    return nattached;
+}
+
+/**
+ * Get number of tracked apps
+ *
+ * @return Number of apps
+ **/
+
+int tjs_apps_count(void) {
+    return tjs_registry_count(bypid);
+}
+
+/**
+ * Get counters
+ *
+ * @return A #TjsAppsStats
+ **/
+
+const TjsAppsStats *tjs_apps_stats(void) {
+    return &stats;
+}
+
+/**
+ * Push array of tracked apps with their event rates
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+void tjs_apps_push(duk_context *ctx) {
+    double now = tjs_timers_now(touch.timers);
+    duk_idx_t aryIdx = duk_push_array(ctx);
+    int napps = 0;
+
+    for (int i = 0; i < tjs_registry_size(bypid); i++) {
+        TjsApp *app = (TjsApp *)tjs_registry_get(bypid, i);
+
+        if (NULL == app) continue;
+
+        duk_idx_t objIdx = duk_push_object(ctx);
+
+        duk_push_int(ctx, app->pid);
+        duk_put_prop_string(ctx, objIdx, "pid");
+        duk_push_string(ctx, app->name);
+        duk_put_prop_string(ctx, objIdx, "name");
+        duk_push_string(ctx, states[app->state]);
+        duk_put_prop_string(ctx, objIdx, "state");
+        duk_push_int(ctx, app->attempts);
+        duk_put_prop_string(ctx, objIdx, "attempts");
+        duk_push_number(ctx, app->stats.events);
+        duk_put_prop_string(ctx, objIdx, "events");
+
+        /* Quiet apps don't close their window; stale rates read as 0 */
+        duk_push_number(ctx, (2 * TJS_APPS_WINDOW > now - app->stats.window ?
+            app->stats.rate : 0));
+        duk_put_prop_string(ctx, objIdx, "rate");
+        duk_push_number(ctx, app->stats.peak);
+        duk_put_prop_string(ctx, objIdx, "peak");
+
+        /* Names of bound notifications */
+        duk_idx_t boundIdx = duk_push_array(ctx);
+        int nbound = 0;
+
+        for (int id = 0; id < TJS_BUS_EVENTS; id++) {
+            if (0 < (app->bound & (1u << id))) {
+                duk_push_string(ctx, tjs_bus_name(touch.bus, id));
+                duk_put_prop_index(ctx, boundIdx, nbound++);
+            }
+        }
+
+        duk_put_prop_string(ctx, objIdx, "bound");
+        duk_put_prop_index(ctx, aryIdx, napps++);
+    }
+}
+
+/**
+ * Init app observer tracking
+ *
+ * @param[in]     appsource  A #TjsAppSource
+ * @param[inout]  ctx        A #duk_context to keep the retry timer
+ **/
+
+void tjs_apps_init(const TjsAppSource *appsource, duk_context *ctx) {
+    source = appsource;
+    timerctx = ctx;
+    bypid = tjs_registry_new();
+}
+
+/**
+ * Deinit app observer tracking; detaches all observers
+ **/
+
+void tjs_apps_deinit(void) {
+    for (int i = 0; i < tjs_registry_size(bypid); i++) {
+        TjsApp *app = (TjsApp *)tjs_registry_get(bypid, i);
+
+        if (NULL != app) tjs_apps_terminate(app->pid);
+    }
+
+    tjs_registry_destroy(bypid);
+
+    bypid = NULL;
+    source = NULL;
+    timerctx = NULL;
+    timer = 0;
+    events = kept = wanted = 0;
+}
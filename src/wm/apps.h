@@ -0,0 +1,70 @@
+/**
+ * @package TouchJS
+ *
+ * @file Application observer header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_APPS_H
+#define TJS_APPS_H 1
+
+/* Includes */
+#include "../libs/duktape/duktape.h"
+
+#include "source.h"
+
+/* States */
+#define TJS_APPS_STATE_PENDING 0  ///< Launched; observer not attached yet
+#define TJS_APPS_STATE_ATTACHED 1 ///< Observer attached; notifications bound on demand
+#define TJS_APPS_STATE_FAILED 2   ///< Gave up attaching after retries
+
+/* Defaults */
+#define TJS_APPS_RETRIES 5     ///< Attach attempts before giving up
+#define TJS_APPS_BACKOFF 50.0  ///< First retry delay in ms; doubles per attempt
+#define TJS_APPS_WINDOW 1000.0 ///< Rate window in ms
+
+/* Types */
+typedef struct tjs_app_t {
+    int pid, state;
+    int attempts; ///< Failed attach attempts
+    char name[32];
+
+    void *observer; ///< Source observer while attached
+    unsigned int bound; ///< Mask of bound event ids
+
+    double launched, due; ///< Launch time and next attach attempt in ms
+
+    /* Stats */
+    struct {
+        unsigned long events, inwindow;
+        double window; ///< Start of current rate window
+        double rate, peak; ///< Events per second of last and busiest window
+    } stats;
+} TjsApp;
+
+typedef struct tjs_apps_stats_t {
+    unsigned long launched, terminated, attached, detached, failed, retries;
+    unsigned long binds, unbinds, unbound;
+} TjsAppsStats;
+
+/* Methods */
+void tjs_apps_event_add(int id);
+void tjs_apps_event_keep(int id);
+TjsApp *tjs_apps_launch(int pid, const char *name);
+int tjs_apps_terminate(int pid);
+TjsApp *tjs_apps_find(int pid);
+int tjs_apps_sync(void);
+int tjs_apps_event(int pid, int id);
+int tjs_apps_poll(void);
+int tjs_apps_count(void);
+const TjsAppsStats *tjs_apps_stats(void);
+void tjs_apps_push(duk_context *ctx);
+
+void tjs_apps_init(const TjsAppSource *source, duk_context *ctx);
+void tjs_apps_deinit(void);
+
+#endif /* TJS_APPS_H */
@@ -0,0 +1,1196 @@
+/**
+ * @package TouchJS
+ *
+ * @file Fake window source functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../touchjs.h"
+#include "../loadgen.h"
+
+#include "fake.h"
+#include "wincache.h"
+#include "snapshot.h"
+#include "apps.h"
+#include "query.h"
+
+#include "../common/registry.h"
+#include "../common/userdata.h"
+#include "../common/bus.h"
+#include "../common/coalesce.h"
+#include "../common/timer.h"
+
+/* Globals */
+static TjsRegistry *windows = NULL; ///< Id -> open #TjsFakeWindow
+static TjsRegistry *procs = NULL;   ///< Pid -> running #TjsFakeProc
+
+/* Query workers read windows and procs; guards writes of both */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *events[] = {
+    "win_open", "win_move", "win_focus", "win_title", "win_close", "win_resize"
+};
+
+static int evmove = -1, evresize = -1, evclose = -1, evtitle = -1; ///< Interned ids
+
+/**
+ * Helper to drop a reference of a fake window
+ *
+ * @param[inout]  window  A #TjsFakeWindow
+ **/
+
+static void tjs_fake_release(TjsFakeWindow *window) {
+    if (0 == --(window->refs)) {
+        free(window);
+    }
+}
+
+/**
+ * Helper to find open fake window
+ *
+ * @param[in]  id  Window id
+ *
+ * @return Either found #TjsFakeWindow; otherwise NULL
+ **/
+
+static TjsFakeWindow *tjs_fake_find(unsigned long id) {
+    return (TjsFakeWindow *)tjs_registry_find(windows,
+        (void *)(uintptr_t)id, NULL);
+}
+
+/**
+ * Get window id
+ *
+ * @param[in]  ref  A #TjsFakeWindow
+ *
+ * @return Window id
+ **/
+
+static unsigned long tjs_fake_source_id(void *ref) {
+    return ((TjsFakeWindow *)ref)->id;
+}
+
+/**
+ * Bind fake window to window object
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ * @param[in]     ref       A #TjsFakeWindow
+ **/
+
+static void tjs_fake_source_bind(TjsUserdata *userdata, void *ref) {
+    TjsFakeWindow *window = (TjsFakeWindow *)ref;
+
+    window->refs++;
+
+    ((TjsFakeWin *)userdata)->window = window;
+}
+
+/**
+ * Release fake window of window object
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+static void tjs_fake_source_unbind(TjsUserdata *userdata) {
+    TjsFakeWin *win = (TjsFakeWin *)userdata;
+
+    if (NULL != win->window) {
+        tjs_fake_release(win->window);
+
+        win->window = NULL;
+    }
+}
+
+/**
+ * Compare fake window with the one of window object
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ * @param[in]     ref       A #TjsFakeWindow
+ *
+ * @return Either 1 when equal; otherwise 0
+ **/
+
+static int tjs_fake_source_equal(TjsUserdata *userdata, void *ref) {
+    return (((TjsFakeWin *)userdata)->window == (TjsFakeWindow *)ref);
+}
+
+/**
+ * Bulk fetch open fake windows into snapshot
+ *
+ * @param[inout]  snapshot  A #TjsSnapshot
+ *
+ * @return Number of windows
+ **/
+
+static int tjs_fake_source_snapshot(TjsSnapshot *snapshot) {
+    for (int i = 0; i < tjs_registry_size(windows); i++) {
+        TjsFakeWindow *window = (TjsFakeWindow *)tjs_registry_get(windows, i);
+
+        if (NULL == window) continue;
+
+        TjsSnapshotWin *win = tjs_snapshot_add(snapshot);
+
+        if (NULL == win) break;
+
+        win->id = window->id;
+        win->flags = window->flags;
+        win->pid = window->pid;
+        win->x = window->x;
+        win->y = window->y;
+        win->width = window->width;
+        win->height = window->height;
+
+        snprintf(win->title, sizeof(win->title), "%s", window->title);
+        snprintf(win->role, sizeof(win->role), "%s", window->role);
+        snprintf(win->subrole, sizeof(win->subrole), "%s", window->subrole);
+    }
+
+    return snapshot->nwins;
+}
+
+/**
+ * Fetch filter attributes of fake window
+ *
+ * @param[in]     ref    A #TjsFakeWindow
+ * @param[inout]  attrs  A #TjsBusAttrs
+ *
+ * @return Always 0
+ **/
+
+static int tjs_fake_source_attrs(void *ref, TjsBusAttrs *attrs) {
+    TjsFakeWindow *window = (TjsFakeWindow *)ref;
+
+    attrs->pid = window->pid;
+
+    snprintf(attrs->title, sizeof(attrs->title), "%s", window->title);
+    snprintf(attrs->role, sizeof(attrs->role), "%s", window->role);
+    snprintf(attrs->subrole, sizeof(attrs->subrole), "%s", window->subrole);
+
+    return 0;
+}
+
+/**
+ * Helper to read frame array at index
+ *
+ * @param[inout]  ctx     A #duk_context
+ * @param[in]     idx     Stack index of array
+ * @param[inout]  window  A #TjsFakeWindow
+ **/
+
+static void tjs_fake_read_frame(duk_context *ctx, duk_idx_t idx,
+    TjsFakeWindow *window)
+{
+    int *fields[] = { &window->x, &window->y, &window->width, &window->height };
+    int values[4];
+
+    for (int i = 0; i < 4; i++) {
+        duk_get_prop_index(ctx, idx, i);
+        values[i] = duk_to_int(ctx, -1);
+        duk_pop(ctx);
+    }
+
+    /* Coercion may throw; don't hold the lock meanwhile */
+    pthread_mutex_lock(&lock);
+
+    for (int i = 0; i < 4; i++) {
+        *fields[i] = values[i];
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+/* Source */
+const TjsWinSource tjs_win_source_fake = {
+    .name = "fake",
+    .ctor = "TjsFakeWin",
+    .id = tjs_fake_source_id,
+    .bind = tjs_fake_source_bind,
+    .unbind = tjs_fake_source_unbind,
+    .equal = tjs_fake_source_equal,
+    .snapshot = tjs_fake_source_snapshot,
+    .attrs = tjs_fake_source_attrs
+};
+
+/**
+ * Keep fake window alive while queried
+ *
+ * @param[inout]  ref  A #TjsFakeWindow
+ **/
+
+static void tjs_fake_query_retain(void *ref) {
+    ((TjsFakeWindow *)ref)->refs++;
+}
+
+/**
+ * Drop fake window after query
+ *
+ * @param[inout]  ref  A #TjsFakeWindow
+ **/
+
+static void tjs_fake_query_release(void *ref) {
+    tjs_fake_release((TjsFakeWindow *)ref);
+}
+
+/**
+ * Fetch attribute of fake window on a query worker; the injected latency
+ * of the app stands in for a busy or hung AX server and is cut at the
+ * timeout like the AX messaging timeout does
+ *
+ * @param[in]     ref      A #TjsFakeWindow
+ * @param[in]     pid      Process id
+ * @param[in]     attr     Attribute id
+ * @param[inout]  value    A #TjsQueryValue
+ * @param[in]     timeout  Time left in ms
+ *
+ * @return Query status
+ **/
+
+static int tjs_fake_query_fetch(void *ref, int pid, int attr,
+    TjsQueryValue *value, double timeout)
+{
+    TjsFakeWindow *window = (TjsFakeWindow *)ref;
+    double latency = 0;
+
+    pthread_mutex_lock(&lock);
+
+    TjsFakeProc *proc = (TjsFakeProc *)tjs_registry_find(procs,
+        (void *)(uintptr_t)pid, NULL);
+
+    if (NULL != proc) {
+        latency = proc->latency;
+        proc->stats.queries++;
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    if (0 < latency) {
+        double delay = (latency < timeout ? latency : timeout);
+        struct timespec ts;
+
+        ts.tv_sec = (time_t)(delay / 1000.0);
+        ts.tv_nsec = (long)((delay - ts.tv_sec * 1000.0) * 1000000.0);
+
+        nanosleep(&ts, NULL);
+
+        if (latency >= timeout) return TJS_QUERY_STATUS_TIMEOUT;
+    }
+
+    int status = TJS_QUERY_STATUS_OK;
+
+    pthread_mutex_lock(&lock);
+
+    if (!window->open) {
+        status = TJS_QUERY_STATUS_FAILED;
+    } else if (TJS_QUERY_ATTR_FRAME == attr) {
+        value->frame[0] = window->x;
+        value->frame[1] = window->y;
+        value->frame[2] = window->width;
+        value->frame[3] = window->height;
+    } else {
+        const char *str = (TJS_QUERY_ATTR_TITLE == attr ? window->title :
+            TJS_QUERY_ATTR_ROLE == attr ? window->role : window->subrole);
+
+        snprintf(value->str, sizeof(value->str), "%s", str);
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    return status;
+}
+
+/* Source */
+const TjsQuerySource tjs_query_source_fake = {
+    .name = "fake",
+    .retain = tjs_fake_query_retain,
+    .release = tjs_fake_query_release,
+    .fetch = tjs_fake_query_fetch
+};
+
+/**
+ * Attach observer to fake process
+ *
+ * @param[in]  pid  Process id
+ *
+ * @return Either #TjsFakeProc as observer; otherwise NULL
+ **/
+
+static void *tjs_fake_app_attach(int pid) {
+    TjsFakeProc *proc = (TjsFakeProc *)tjs_registry_find(procs,
+        (void *)(uintptr_t)pid, NULL);
+
+    if (NULL == proc) return NULL;
+
+    proc->stats.attaches++;
+
+    /* Not ready yet */
+    if (0 < proc->failattach) {
+        proc->failattach--;
+
+        return NULL;
+    }
+
+    proc->attached = 1;
+
+    return proc;
+}
+
+/**
+ * Detach observer of fake process
+ *
+ * @param[inout]  observer  A #TjsFakeProc
+ * @param[in]     pid       Process id
+ **/
+
+static void tjs_fake_app_detach(void *observer, int pid) {
+    TjsFakeProc *proc = (TjsFakeProc *)observer;
+
+    (void)pid;
+
+    proc->attached = 0;
+    proc->bound = 0;
+}
+
+/**
+ * Bind notification of fake process
+ *
+ * @param[inout]  observer  A #TjsFakeProc
+ * @param[in]     pid       Process id
+ * @param[in]     event     Interned event id
+ *
+ * @return Always 0
+ **/
+
+static int tjs_fake_app_bind(void *observer, int pid, int event) {
+    TjsFakeProc *proc = (TjsFakeProc *)observer;
+
+    (void)pid;
+
+    proc->bound |= (1u << event);
+    proc->stats.binds++;
+
+    return 0;
+}
+
+/**
+ * Unbind notification of fake process
+ *
+ * @param[inout]  observer  A #TjsFakeProc
+ * @param[in]     pid       Process id
+ * @param[in]     event     Interned event id
+ **/
+
+static void tjs_fake_app_unbind(void *observer, int pid, int event) {
+    TjsFakeProc *proc = (TjsFakeProc *)observer;
+
+    (void)pid;
+
+    proc->bound &= ~(1u << event);
+    proc->stats.unbinds++;
+}
+
+/* Source */
+const TjsAppSource tjs_app_source_fake = {
+    .name = "fake",
+    .attach = tjs_fake_app_attach,
+    .detach = tjs_fake_app_detach,
+    .bind = tjs_fake_app_bind,
+    .unbind = tjs_fake_app_unbind
+};
+
+/**
+ * Helper to start fake process and track it
+ *
+ * @param[in]  pid         Process id
+ * @param[in]  name        Name of the app
+ * @param[in]  failattach  Number of attach attempts to fail
+ *
+ * @return Either new #TjsFakeProc; otherwise NULL when running
+ **/
+
+static TjsFakeProc *tjs_fake_spawn(int pid, const char *name, int failattach) {
+    if (NULL != tjs_registry_find(procs, (void *)(uintptr_t)pid, NULL)) {
+        return NULL;
+    }
+
+    TjsFakeProc *proc = (TjsFakeProc *)calloc(1, sizeof(TjsFakeProc));
+
+    proc->pid = pid;
+    proc->failattach = failattach;
+
+    snprintf(proc->name, sizeof(proc->name), "%s", name);
+
+    pthread_mutex_lock(&lock);
+    tjs_registry_add(procs, (void *)(uintptr_t)pid, proc);
+    pthread_mutex_unlock(&lock);
+    tjs_apps_launch(pid, name);
+
+    return proc;
+}
+
+/**
+ * Native constructor
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_win_ctor(duk_context *ctx) {
+    /* Sanity check */
+    if (!duk_is_constructor_call(ctx)) {
+        return DUK_RET_TYPE_ERROR;
+    }
+
+    /* Create new userdata */
+    TjsFakeWin *win = (TjsFakeWin *)tjs_userdata_new(ctx,
+        TJS_FLAG_TYPE_WIN, sizeof(TjsFakeWin));
+
+    if (NULL == win) {
+        return DUK_RET_TYPE_ERROR;
+    }
+
+    tjs_userdata_init(ctx, (TjsUserdata *)win);
+
+    return 0;
+}
+
+/**
+ * Native fake win getId prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_win_prototype_getid(duk_context *ctx) {
+    TjsFakeWin *win = (TjsFakeWin *)tjs_userdata_get(ctx, TJS_FLAG_TYPE_WIN);
+
+    if (NULL != win && NULL != win->window) {
+        duk_push_number(ctx, win->window->id);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native fake win getTitle prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_win_prototype_gettitle(duk_context *ctx) {
+    TjsFakeWin *win = (TjsFakeWin *)tjs_userdata_get(ctx, TJS_FLAG_TYPE_WIN);
+
+    if (NULL != win && NULL != win->window) {
+        duk_push_string(ctx, win->window->title);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native fake win getFrame prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_win_prototype_getframe(duk_context *ctx) {
+    TjsFakeWin *win = (TjsFakeWin *)tjs_userdata_get(ctx, TJS_FLAG_TYPE_WIN);
+
+    if (NULL != win && NULL != win->window) {
+        int fields[] = { win->window->x, win->window->y,
+            win->window->width, win->window->height };
+        duk_idx_t aryIdx = duk_push_array(ctx);
+
+        for (int i = 0; i < 4; i++) {
+            duk_push_int(ctx, fields[i]);
+            duk_put_prop_index(ctx, aryIdx, i);
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native fake win fetch prototype method; queries attribute on a worker
+ * and returns a handle with then(onValue, onError)
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_win_prototype_fetch(duk_context *ctx) {
+    const char *name = duk_require_string(ctx, 0);
+    double timeout = duk_get_number_default(ctx, 1, 0);
+    int attr = tjs_query_attr(name);
+
+    if (0 > attr) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Unknown attribute: %s",
+            name);
+    }
+
+    TjsFakeWin *win = (TjsFakeWin *)tjs_userdata_get(ctx, TJS_FLAG_TYPE_WIN);
+
+    if (NULL != win && NULL != win->window) {
+        return tjs_query_push(ctx, win->window, win->window->pid, attr,
+            timeout);
+    }
+
+    return 0;
+}
+
+/**
+ * Native fake win isOpen prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_win_prototype_isopen(duk_context *ctx) {
+    TjsFakeWin *win = (TjsFakeWin *)tjs_userdata_get(ctx, TJS_FLAG_TYPE_WIN);
+
+    duk_push_boolean(ctx, (NULL != win && NULL != win->window &&
+        win->window->open));
+
+    return 1;
+}
+
+/**
+ * Native open method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_open(duk_context *ctx) {
+    unsigned long id = (unsigned long)duk_require_uint(ctx, 0);
+    const char *title = duk_require_string(ctx, 1);
+
+    if (0 == id || NULL != tjs_fake_find(id)) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Invalid window id: %lu", id);
+    }
+
+    /* Source holds one reference while open */
+    TjsFakeWindow *window = (TjsFakeWindow *)calloc(1, sizeof(TjsFakeWindow));
+
+    window->id = id;
+    window->refs = 1;
+    window->open = 1;
+    window->pid = 1000 + (int)(id % 100);
+    window->flags = (TJS_SNAPSHOT_FLAG_NORMAL|TJS_SNAPSHOT_FLAG_MOVABLE|
+        TJS_SNAPSHOT_FLAG_RESIZABLE);
+    window->width = 800;
+    window->height = 600;
+
+    if (duk_is_array(ctx, 2)) {
+        tjs_fake_read_frame(ctx, 2, window);
+    }
+
+    snprintf(window->title, sizeof(window->title), "%s", title);
+    snprintf(window->role, sizeof(window->role), "AXWindow");
+    snprintf(window->subrole, sizeof(window->subrole), "AXStandardWindow");
+
+    /* Options override defaults */
+    if (duk_is_object(ctx, 3)) {
+        if (duk_get_prop_string(ctx, 3, "pid")) {
+            window->pid = duk_to_int(ctx, -1);
+        }
+
+        if (duk_get_prop_string(ctx, 3, "role")) {
+            snprintf(window->role, sizeof(window->role), "%s",
+                duk_to_string(ctx, -1));
+        }
+
+        if (duk_get_prop_string(ctx, 3, "subrole")) {
+            snprintf(window->subrole, sizeof(window->subrole), "%s",
+                duk_to_string(ctx, -1));
+        }
+
+        duk_pop_3(ctx);
+    }
+
+    tjs_registry_add(windows, (void *)(uintptr_t)id, window);
+
+    /* Windows belong to running apps */
+    if (0 < window->pid && NULL == tjs_registry_find(procs,
+            (void *)(uintptr_t)window->pid, NULL))
+    {
+        char name[32];
+
+        snprintf(name, sizeof(name), "app%d", window->pid);
+
+        tjs_fake_spawn(window->pid, name, 0);
+    }
+
+    return 0;
+}
+
+/**
+ * Native launch method; failAttach makes the first attaches fail and
+ * latency delays attribute queries
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_launch(duk_context *ctx) {
+    int pid = duk_require_int(ctx, 0);
+    const char *name = duk_require_string(ctx, 1);
+    int failattach = 0;
+    double latency = 0;
+
+    if (duk_is_object(ctx, 2)) {
+        if (duk_get_prop_string(ctx, 2, "failAttach")) {
+            failattach = duk_to_int(ctx, -1);
+        }
+
+        if (duk_get_prop_string(ctx, 2, "latency")) {
+            latency = duk_to_number(ctx, -1);
+        }
+
+        duk_pop_2(ctx);
+    }
+
+    TjsFakeProc *proc = NULL;
+
+    if (0 >= pid || NULL == (proc = tjs_fake_spawn(pid, name, failattach))) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Invalid pid: %d", pid);
+    }
+
+    pthread_mutex_lock(&lock);
+    proc->latency = latency;
+    pthread_mutex_unlock(&lock);
+
+    return 0;
+}
+
+/**
+ * Native setLatency method; delays attribute queries of the app like a
+ * busy or hung one
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_setlatency(duk_context *ctx) {
+    int pid = duk_require_int(ctx, 0);
+    double latency = duk_require_number(ctx, 1);
+
+    pthread_mutex_lock(&lock);
+
+    TjsFakeProc *proc = (TjsFakeProc *)tjs_registry_find(procs,
+        (void *)(uintptr_t)pid, NULL);
+
+    if (NULL != proc) proc->latency = latency;
+
+    pthread_mutex_unlock(&lock);
+
+    if (NULL == proc) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Unknown pid: %d", pid);
+    }
+
+    return 0;
+}
+
+/**
+ * Native terminate method; windows go away without events like AX
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_terminate(duk_context *ctx) {
+    int pid = duk_require_int(ctx, 0);
+
+    pthread_mutex_lock(&lock);
+
+    TjsFakeProc *proc = (TjsFakeProc *)tjs_registry_remove(procs,
+        (void *)(uintptr_t)pid);
+
+    pthread_mutex_unlock(&lock);
+
+    if (NULL == proc) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Unknown pid: %d", pid);
+    }
+
+    for (int i = 0; i < tjs_registry_size(windows); i++) {
+        TjsFakeWindow *window = (TjsFakeWindow *)tjs_registry_get(windows, i);
+
+        if (NULL != window && pid == window->pid) {
+            tjs_registry_remove(windows, (void *)(uintptr_t)window->id);
+
+            pthread_mutex_lock(&lock);
+            window->open = 0;
+            pthread_mutex_unlock(&lock);
+
+            tjs_fake_release(window);
+        }
+    }
+
+    tjs_apps_terminate(pid);
+
+    free(proc);
+
+    return 0;
+}
+
+/**
+ * Native getApps method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_getapps(duk_context *ctx) {
+    tjs_apps_push(ctx);
+
+    return 1;
+}
+
+/**
+ * Native move method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_move(duk_context *ctx) {
+    unsigned long id = (unsigned long)duk_require_uint(ctx, 0);
+    duk_require_object(ctx, 1);
+
+    TjsFakeWindow *window = tjs_fake_find(id);
+
+    if (NULL == window) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Unknown window id: %lu", id);
+    }
+
+    tjs_fake_read_frame(ctx, 1, window);
+
+    return 0;
+}
+
+/**
+ * Native setTitle method; like AX, no event is sent
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_settitle(duk_context *ctx) {
+    unsigned long id = (unsigned long)duk_require_uint(ctx, 0);
+    const char *title = duk_require_string(ctx, 1);
+
+    TjsFakeWindow *window = tjs_fake_find(id);
+
+    if (NULL == window) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Unknown window id: %lu", id);
+    }
+
+    pthread_mutex_lock(&lock);
+    snprintf(window->title, sizeof(window->title), "%s", title);
+    pthread_mutex_unlock(&lock);
+
+    return 0;
+}
+
+/**
+ * Native snapshot method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_snapshot(duk_context *ctx) {
+    tjs_snapshot_push(ctx, &tjs_win_source_fake);
+
+    return 1;
+}
+
+/**
+ * Native diff method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_diff(duk_context *ctx) {
+    duk_require_object(ctx, 0);
+
+    if (!tjs_snapshot_push_since(ctx, &tjs_win_source_fake, 0)) {
+        return duk_error(ctx, DUK_ERR_TYPE_ERROR, "Snapshot expected");
+    }
+
+    return 1;
+}
+
+/**
+ * Bus handler; pushes window object of event
+ *
+ * @param[inout]  ctx  A #duk_context
+ * @param[inout]  arg  A #TjsFakeWindow
+ *
+ * @return Number of pushed arguments
+ **/
+
+static int tjs_fake_push_win(duk_context *ctx, void *arg) {
+    tjs_wincache_push(ctx, arg);
+
+    return 1;
+}
+
+/**
+ * Helper to call subscribed handlers of all heaps
+ *
+ * @param[inout]  window  A #TjsFakeWindow
+ * @param[in]     id      Interned event id
+ **/
+
+static void tjs_fake_deliver(TjsFakeWindow *window, int id) {
+    TjsBusEvent event = { 0 };
+
+    event.id = id;
+    event.window = window->id;
+    event.ref = window;
+    event.fetch = tjs_wincache_attrs;
+
+    tjs_bus_emit(touch.bus, &event, tjs_fake_push_win, window);
+}
+
+/**
+ * Coalescer handler; delivers collapsed event with the latest frame
+ *
+ * @param[inout]  entry  A #TjsCoalesceEntry
+ * @param[inout]  arg    Unused
+ **/
+
+static void tjs_fake_deliver_coalesced(TjsCoalesceEntry *entry, void *arg) {
+    TjsFakeWindow *window = (TjsFakeWindow *)entry->ref;
+
+    (void)arg;
+
+    if (window->open) tjs_fake_deliver(window, entry->event);
+
+    tjs_fake_release(window);
+}
+
+/**
+ * Coalescer handler; drops the window of an undelivered event
+ *
+ * @param[inout]  entry  A #TjsCoalesceEntry
+ * @param[inout]  arg    Unused
+ **/
+
+static void tjs_fake_release_coalesced(TjsCoalesceEntry *entry, void *arg) {
+    (void)arg;
+
+    tjs_fake_release((TjsFakeWindow *)entry->ref);
+}
+
+/**
+ * Helper to dispatch event like the AX observer does
+ *
+ * @param[inout]  window  A #TjsFakeWindow
+ * @param[in]     id      Interned event id
+ **/
+
+static void tjs_fake_dispatch(TjsFakeWindow *window, int id) {
+    /* Like AX, only notifications bound by the app observer arrive */
+    int bound = tjs_apps_event(window->pid, id);
+
+    /* Cached attributes are stale after title changes */
+    if (bound && evtitle == id) {
+        tjs_wincache_invalidate(window);
+    }
+
+    /* Collapse move and resize storms; frame is read on delivery */
+    if (NULL != touch.coalesce && 0 != window->id &&
+            (evmove == id || evresize == id))
+    {
+        if (bound) {
+            if (1 == tjs_coalesce_add(touch.coalesce, window->id,
+                    window->pid, id, window, tjs_timers_now(touch.timers)))
+            {
+                window->refs++;
+            }
+
+            tjs_coalesce_arm(touch.coalesce, touch.ctx);
+        }
+
+        return;
+    }
+
+    /* Pending frames of the window go first */
+    if (NULL != touch.coalesce) {
+        tjs_coalesce_flush_window(touch.coalesce, window->id,
+            tjs_timers_now(touch.timers));
+    }
+
+    if (bound) tjs_fake_deliver(window, id);
+
+    /* Close window after handlers saw it */
+    if (evclose == id) {
+        if (bound) tjs_wincache_evict(window);
+
+        tjs_registry_remove(windows, (void *)(uintptr_t)window->id);
+
+        pthread_mutex_lock(&lock);
+        window->open = 0;
+        pthread_mutex_unlock(&lock);
+
+        tjs_fake_release(window);
+    }
+}
+
+/**
+ * Native emit method; dispatches event like the AX observer does
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_emit(duk_context *ctx) {
+    const char *eventName = duk_require_string(ctx, 0);
+    unsigned long id = (unsigned long)duk_require_uint(ctx, 1);
+
+    TjsFakeWindow *window = tjs_fake_find(id);
+
+    if (NULL == window) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Unknown window id: %lu", id);
+    }
+
+    int event = tjs_bus_lookup(touch.bus, eventName);
+
+    /* Record drags and resizes for replay */
+    if (evmove == event) {
+        tjs_loadgen_trace_window(TJS_LOADGEN_MOVE, id, window->x, window->y);
+    } else if (evresize == event) {
+        tjs_loadgen_trace_window(TJS_LOADGEN_RESIZE, id,
+            window->width, window->height);
+    }
+
+    tjs_fake_dispatch(window, event);
+
+    return 0;
+}
+
+/**
+ * Native observe method; returns token for unobserve
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_observe(duk_context *ctx) {
+    duk_ret_t ret = tjs_bus_observe(ctx, touch.bus, 0);
+
+    /* Bind notifications of the event on all apps */
+    tjs_apps_sync();
+
+    return ret;
+}
+
+/**
+ * Native unobserve method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_unobserve(duk_context *ctx) {
+    duk_ret_t ret = tjs_bus_unobserve(ctx, touch.bus, 0);
+
+    tjs_apps_sync();
+
+    return ret;
+}
+
+/**
+ * Native getStats method; counters of the token or totals
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_getstats(duk_context *ctx) {
+    int totals = (!duk_is_valid_index(ctx, 0) || duk_is_undefined(ctx, 0));
+    duk_ret_t ret = tjs_bus_getstats(ctx, touch.bus, 0);
+
+    /* Totals include the raw events before coalescing */
+    if (NULL != touch.coalesce && totals) {
+        tjs_coalesce_putstats(ctx, touch.coalesce, -1);
+    }
+
+    return ret;
+}
+
+/**
+ * Native getWindows method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_fake_getwindows(duk_context *ctx) {
+    duk_idx_t aryIdx = duk_push_array(ctx);
+    int nwins = 0;
+
+    for (int i = 0; i < tjs_registry_size(windows); i++) {
+        TjsFakeWindow *window = (TjsFakeWindow *)tjs_registry_get(windows, i);
+
+        if (NULL != window) {
+            tjs_wincache_push(ctx, window);
+            duk_put_prop_index(ctx, aryIdx, nwins++);
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Replay window event; updates frame and dispatches it
+ *
+ * @param[in]  eventName  Either win_move or win_resize
+ * @param[in]  id         Window id
+ * @param[in]  a          Either x or width
+ * @param[in]  b          Either y or height
+ *
+ * @return Either 0 on success; otherwise -1 for unknown windows
+ **/
+
+int tjs_fake_replay(const char *eventName, unsigned long id, double a,
+    double b)
+{
+    TjsFakeWindow *window = tjs_fake_find(id);
+
+    if (NULL == window) return -1;
+
+    int event = tjs_bus_lookup(touch.bus, eventName);
+
+    pthread_mutex_lock(&lock);
+
+    if (evmove == event) {
+        window->x = (int)a;
+        window->y = (int)b;
+    } else if (evresize == event) {
+        window->width = (int)a;
+        window->height = (int)b;
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    if (evmove == event) {
+        tjs_loadgen_trace_window(TJS_LOADGEN_MOVE, id, a, b);
+    } else if (evresize == event) {
+        tjs_loadgen_trace_window(TJS_LOADGEN_RESIZE, id, a, b);
+    }
+
+    tjs_fake_dispatch(window, event);
+
+    return 0;
+}
+
+/**
+ * Init fake window source
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+void tjs_fake_init(duk_context *ctx) {
+    /* Windows are shared by all heaps */
+    if (NULL == windows) {
+        windows = tjs_registry_new();
+        procs = tjs_registry_new();
+
+        tjs_apps_init(&tjs_app_source_fake, ctx);
+        tjs_query_init(&tjs_query_source_fake, ctx, touch.workers);
+
+        for (int i = 0; i < (int)(sizeof(events) / sizeof(events[0])); i++) {
+            tjs_apps_event_add(tjs_bus_intern(touch.bus, events[i]));
+        }
+
+        evmove = tjs_bus_lookup(touch.bus, "win_move");
+        evresize = tjs_bus_lookup(touch.bus, "win_resize");
+        evclose = tjs_bus_lookup(touch.bus, "win_close");
+        evtitle = tjs_bus_lookup(touch.bus, "win_title");
+
+        /* Cache eviction and invalidation mustn't depend on subscriptions */
+        tjs_apps_event_keep(evclose);
+        tjs_apps_event_keep(evtitle);
+
+        if (NULL != touch.coalesce) {
+            touch.coalesce->deliver = tjs_fake_deliver_coalesced;
+            touch.coalesce->release = tjs_fake_release_coalesced;
+        }
+    }
+
+    /* Register constructor */
+    duk_push_c_function(ctx, tjs_fake_win_ctor, 0);
+    duk_push_object(ctx);
+
+    /* Register methods */
+    duk_push_c_function(ctx, tjs_fake_win_prototype_getid, 0);
+    duk_put_prop_string(ctx, -2, "getId");
+    duk_push_c_function(ctx, tjs_fake_win_prototype_gettitle, 0);
+    duk_put_prop_string(ctx, -2, "getTitle");
+    duk_push_c_function(ctx, tjs_fake_win_prototype_getframe, 0);
+    duk_put_prop_string(ctx, -2, "getFrame");
+    duk_push_c_function(ctx, tjs_fake_win_prototype_isopen, 0);
+    duk_put_prop_string(ctx, -2, "isOpen");
+    duk_push_c_function(ctx, tjs_fake_win_prototype_fetch, 2);
+    duk_put_prop_string(ctx, -2, "fetch");
+
+    duk_put_prop_string(ctx, -2, "prototype");
+    duk_put_global_string(ctx, "TjsFakeWin");
+
+    /* Register driver */
+    duk_push_c_function(ctx, tjs_fake_open, 4);
+    duk_put_global_string(ctx, "tjs_fake_open");
+    duk_push_c_function(ctx, tjs_fake_move, 2);
+    duk_put_global_string(ctx, "tjs_fake_move");
+    duk_push_c_function(ctx, tjs_fake_snapshot, 0);
+    duk_put_global_string(ctx, "tjs_fake_snapshot");
+    duk_push_c_function(ctx, tjs_fake_diff, 1);
+    duk_put_global_string(ctx, "tjs_fake_diff");
+    duk_push_c_function(ctx, tjs_fake_emit, 2);
+    duk_put_global_string(ctx, "tjs_fake_emit");
+    duk_push_c_function(ctx, tjs_fake_observe, 3);
+    duk_put_global_string(ctx, "tjs_fake_observe");
+    duk_push_c_function(ctx, tjs_fake_unobserve, 1);
+    duk_put_global_string(ctx, "tjs_fake_unobserve");
+    duk_push_c_function(ctx, tjs_fake_getstats, DUK_VARARGS);
+    duk_put_global_string(ctx, "tjs_fake_getStats");
+    duk_push_c_function(ctx, tjs_fake_settitle, 2);
+    duk_put_global_string(ctx, "tjs_fake_setTitle");
+    duk_push_c_function(ctx, tjs_fake_getwindows, 0);
+    duk_put_global_string(ctx, "tjs_fake_getWindows");
+    duk_push_c_function(ctx, tjs_fake_launch, 3);
+    duk_put_global_string(ctx, "tjs_fake_launch");
+    duk_push_c_function(ctx, tjs_fake_terminate, 1);
+    duk_put_global_string(ctx, "tjs_fake_terminate");
+    duk_push_c_function(ctx, tjs_fake_getapps, 0);
+    duk_put_global_string(ctx, "tjs_fake_getApps");
+    duk_push_c_function(ctx, tjs_fake_setlatency, 2);
+    duk_put_global_string(ctx, "tjs_fake_setLatency");
+}
+
+/**
+ * Deinit fake window source
+ **/
+
+void tjs_fake_deinit(void) {
+    /* Workers read windows and procs; stop them first */
+    tjs_query_deinit();
+    tjs_apps_deinit();
+
+    for (int i = 0; i < tjs_registry_size(procs); i++) {
+        free(tjs_registry_get(procs, i));
+    }
+
+    tjs_registry_destroy(procs);
+
+    procs = NULL;
+
+    for (int i = 0; i < tjs_registry_size(windows); i++) {
+        TjsFakeWindow *window = (TjsFakeWindow *)tjs_registry_get(windows, i);
+
+        if (NULL != window) tjs_fake_release(window);
+    }
+
+    tjs_registry_destroy(windows);
+
+    windows = NULL;
+}
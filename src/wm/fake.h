@@ -0,0 +1,62 @@
+/**
+ * @package TouchJS
+ *
+ * @file Fake window source header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_FAKE_H
+#define TJS_FAKE_H 1
+
+/* Includes */
+#include "../libs/duktape/duktape.h"
+
+#include "source.h"
+
+/* Types */
+typedef struct tjs_fake_window_t {
+    unsigned long id;
+    int refs, open;
+    int flags, pid;
+    int x, y, width, height;
+
+    char title[64], role[32], subrole[32];
+} TjsFakeWindow;
+
+typedef struct tjs_fake_proc_t {
+    int pid;
+    int failattach; ///< Attach attempts left to fail, like AX right after launch
+    int attached;
+    unsigned int bound; ///< Mask of bound event ids
+    double latency; ///< Injected delay of attribute queries in ms
+
+    char name[32];
+
+    /* Stats */
+    struct {
+        unsigned long attaches, binds, unbinds, queries;
+    } stats;
+} TjsFakeProc;
+
+typedef struct tjs_fake_win_t {
+    int flags;
+
+    struct tjs_fake_window_t *window;
+} TjsFakeWin;
+
+/* Globals */
+extern const TjsWinSource tjs_win_source_fake;
+extern const TjsAppSource tjs_app_source_fake;
+extern const TjsQuerySource tjs_query_source_fake;
+
+/* Methods */
+void tjs_fake_init(duk_context *ctx);
+void tjs_fake_deinit(void);
+int tjs_fake_replay(const char *eventName, unsigned long id, double a,
+    double b);
+
+#endif /* TJS_FAKE_H */
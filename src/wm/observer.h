@@ -15,14 +15,21 @@
 #import <Cocoa/Cocoa.h>
 
 /* Types */
+struct tjs_bus_t;
+
 typedef void (*TjsObserverHandler)(CFStringRef notificationRef,
     AXUIElementRef elemRef);
 
 /* Methods */
 CFStringRef tjs_observer_translate_event_to_ref(const char *eventName);
 const char *tjs_observer_translate_ref_to_event(CFStringRef eventRef);
+int tjs_observer_translate_ref_to_id(CFStringRef eventRef);
+void tjs_observer_intern(struct tjs_bus_t *bus);
 AXObserverRef tjs_observer_create_from_pid(pid_t pid);
-void tjs_observer_bind(AXObserverRef observerRef, AXUIElementRef appRef,
+void tjs_observer_destroy(AXObserverRef observerRef);
+int tjs_observer_bind(AXObserverRef observerRef, AXUIElementRef appRef,
     const char *eventName, TjsObserverHandler handler);
+void tjs_observer_unbind(AXObserverRef observerRef, AXUIElementRef appRef,
+    const char *eventName);
 
 #endif /* TJS_OBSERVER_H */
\ No newline at end of file
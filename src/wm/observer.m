@@ -13,18 +13,22 @@
 
 #include "attr.h"
 #include "observer.h"
+#include "apps.h"
+
+#include "../common/bus.h"
 
 struct {
     char eventName[13];
     int len;
     CFStringRef eventRef;
+    int id; ///< Interned bus id
 } events[] = {
-    { "win_open", 11, kAXWindowCreatedNotification },
-    { "win_move", 11, kAXWindowMovedNotification },
-    { "win_focus", 12, kAXFocusedWindowChangedNotification },
-    { "win_title", 12, kAXTitleChangedNotification },
-    { "win_close", 12, kAXUIElementDestroyedNotification },
-    { "win_resize", 13, kAXWindowResizedNotification }
+    { "win_open", 11, kAXWindowCreatedNotification, -1 },
+    { "win_move", 11, kAXWindowMovedNotification, -1 },
+    { "win_focus", 12, kAXFocusedWindowChangedNotification, -1 },
+    { "win_title", 12, kAXTitleChangedNotification, -1 },
+    { "win_close", 12, kAXUIElementDestroyedNotification, -1 },
+    { "win_resize", 13, kAXWindowResizedNotification, -1 }
 };
 
 #define LENGTH(ary) (sizeof(ary) / sizeof(ary[0]))
@@ -65,6 +69,40 @@ const char *tjs_observer_translate_ref_to_event(CFStringRef eventRef) {
     return NULL;
 }
 
+/**
+ * Translate event references to interned bus ids
+ *
+ * @param[in]  eventRef  Event reference to to translate
+ *
+ * @return Found id; otherwise -1
+ **/
+
+int tjs_observer_translate_ref_to_id(CFStringRef eventRef) {
+    for (int i = 0; i < LENGTH(events); i++) {
+        if (eventRef == events[i].eventRef ||
+                kCFCompareEqualTo == CFStringCompare(events[i].eventRef, eventRef, 0))
+        {
+            return events[i].id;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Intern event names so dispatch works on ids; all of them are bindable
+ *
+ * @param[inout]  bus  A #TjsBus
+ **/
+
+void tjs_observer_intern(TjsBus *bus) {
+    for (int i = 0; i < LENGTH(events); i++) {
+        events[i].id = tjs_bus_intern(bus, events[i].eventName);
+
+        tjs_apps_event_add(events[i].id);
+    }
+}
+
 /**
  * Helper to call observer callbacks
  *
@@ -88,7 +126,7 @@ static void tjs_observer_callback(AXObserverRef observerRef,
  *
  * @param[in] . pid . Process id
  *
- * @return Newly created observer
+ * @return Either newly created observer; otherwise NULL
  **/
 
 AXObserverRef tjs_observer_create_from_pid(pid_t pid) {
@@ -107,6 +145,19 @@ AXObserverRef tjs_observer_create_from_pid(pid_t pid) {
     return observerRef;
 }
 
+ /**
+  * Destroy observer and remove it from the run loop
+  *
+  * @param[in]  observerRef  Observer reference
+  **/
+
+void tjs_observer_destroy(AXObserverRef observerRef) {
+    CFRunLoopRemoveSource(CFRunLoopGetCurrent(),
+        AXObserverGetRunLoopSource(observerRef), kCFRunLoopDefaultMode);
+
+    CFRelease(observerRef);
+}
+
  /**
   * Bind observer notification
   *
@@ -114,16 +165,48 @@ AXObserverRef tjs_observer_create_from_pid(pid_t pid) {
   * @param[in]  appRef       Application reference
   * @param[in]  eventName    Name of the event
   * @param[in]  handler      Handler to call
+  *
+  * @return Either 0 on success; otherwise -1
   **/
 
-void tjs_observer_bind(AXObserverRef observerRef, AXUIElementRef appRef,
+int tjs_observer_bind(AXObserverRef observerRef, AXUIElementRef appRef,
         const char *eventName, TjsObserverHandler handler)
 {
     CFStringRef notificationRef = tjs_observer_translate_event_to_ref(eventName);
+
+    if (NULL == notificationRef) return -1;
+
     AXError result = AXObserverAddNotification(observerRef, appRef,
         notificationRef, (__bridge void *)handler);
 
-    if (kAXErrorSuccess == result) {
+    /* Already bound counts as bound */
+    if (kAXErrorSuccess == result ||
+            kAXErrorNotificationAlreadyRegistered == result)
+    {
         TJS_LOG_OBSERVER("Notification added: name=%s", eventName);
+
+        return 0;
+    }
+
+    return -1;
+}
+
+ /**
+  * Unbind observer notification
+  *
+  * @param[in]  observerRef  Observer reference
+  * @param[in]  appRef       Application reference
+  * @param[in]  eventName    Name of the event
+  **/
+
+void tjs_observer_unbind(AXObserverRef observerRef, AXUIElementRef appRef,
+        const char *eventName)
+{
+    CFStringRef notificationRef = tjs_observer_translate_event_to_ref(eventName);
+
+    if (NULL != notificationRef && kAXErrorSuccess ==
+            AXObserverRemoveNotification(observerRef, appRef, notificationRef))
+    {
+        TJS_LOG_OBSERVER("Notification removed: name=%s", eventName);
     }
 }
\ No newline at end of file
@@ -0,0 +1,792 @@
+/**
+ * @package TouchJS
+ *
+ * @file Async attribute query functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "../touchjs.h"
+
+#include "query.h"
+
+#include "../common/histogram.h"
+#include "../common/callback.h"
+#include "../common/clock.h"
+#include "../common/timer.h"
+#include "../common/syms.h"
+
+/* Types */
+typedef struct tjs_query_queue_t {
+    int pid, nqueued;
+
+    TjsQuery *head, *tail; ///< Waiting queries in submit order
+    TjsQuery *running;     ///< On a worker; at most one per pid
+
+    struct tjs_query_queue_t *next;
+} TjsQueryQueue;
+
+/* Globals */
+static const TjsQuerySource *source = NULL;
+static TjsQueryStats stats = { 0 };
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ready = PTHREAD_COND_INITIALIZER;
+static pthread_t threads[TJS_QUERY_WORKERS_MAX];
+static int nworkers = 0, nthreads = 0; ///< Configured and started workers
+static int quit = 0;
+
+/* Guarded by lock */
+static TjsQueryQueue *queues = NULL; ///< One per pid with queries
+static TjsQueryQueue *cursor = NULL; ///< Last served queue
+static int nqueues = 0;
+static TjsQuery *done = NULL, *donetail = NULL; ///< Finished on workers
+static int wakefds[2] = { -1, -1 }; ///< Workers write when done gets filled
+
+/* Main thread */
+static duk_context *timerctx = NULL; ///< Keeps the deadline timer callback
+static unsigned long timer = 0;      ///< Id of deadline timer; 0 when none
+static double armed = 0;             ///< Deadline the timer is armed for
+static unsigned long lastid = 0;
+static int pending = 0; ///< Submitted and not yet delivered
+
+static const char *attrs[] = { "title", "role", "subrole", "frame" };
+static const char *statuses[] = { "ok", "failed", "timeout" };
+
+/**
+ * Helper to pick next queue round-robin; lock must be held
+ *
+ * Queues with a query on a worker are skipped, so a hung app holds one
+ * worker at most while the others keep serving the rest
+ *
+ * @return Either #TjsQueryQueue with a runnable query; otherwise NULL
+ **/
+
+static TjsQueryQueue *tjs_query_next(void) {
+    TjsQueryQueue *queue = (NULL != cursor && NULL != cursor->next ?
+        cursor->next : queues);
+
+    for (int i = 0; i < nqueues; i++) {
+        if (NULL != queue->head && NULL == queue->running) {
+            cursor = queue;
+
+            return queue;
+        }
+
+        queue = (NULL != queue->next ? queue->next : queues);
+    }
+
+    return NULL;
+}
+
+/**
+ * Worker thread; runs queries and hands them back to the main thread
+ *
+ * @param[inout]  arg  Unused
+ *
+ * @return Always NULL
+ **/
+
+static void *tjs_query_run(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&lock);
+
+    while (!quit) {
+        TjsQueryQueue *queue = tjs_query_next();
+
+        if (NULL == queue) {
+            pthread_cond_wait(&ready, &lock);
+
+            continue;
+        }
+
+        TjsQuery *query = queue->head;
+
+        queue->head = query->next;
+        queue->nqueued--;
+        queue->running = query;
+
+        if (NULL == queue->head) queue->tail = NULL;
+
+        query->next = NULL;
+
+        double timeout = query->deadline - tjs_clock_now();
+
+        /* Don't bother the app when the caller gave up already */
+        if (0 < timeout) {
+            pthread_mutex_unlock(&lock);
+
+            int status = source->fetch(query->ref, query->pid, query->attr,
+                &query->value, timeout);
+
+            pthread_mutex_lock(&lock);
+
+            query->status = status;
+        } else {
+            query->status = TJS_QUERY_STATUS_TIMEOUT;
+        }
+
+        queue->running = NULL;
+
+        if (NULL != donetail) {
+            donetail->next = query;
+        } else {
+            done = query;
+
+            /* One byte per batch; a full pipe has a wakeup pending anyway */
+            if (-1 != wakefds[1]) {
+                ssize_t n = write(wakefds[1], "", 1);
+
+                (void)n;
+            }
+        }
+
+        donetail = query;
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    return NULL;
+}
+
+/**
+ * Helper to start worker threads
+ *
+ * @return Either 0 on success; otherwise -1 when no worker started
+ **/
+
+static int tjs_query_start(void) {
+    while (nthreads < nworkers) {
+        if (0 != pthread_create(&threads[nthreads], NULL,
+                tjs_query_run, NULL))
+        {
+            TJS_LOG_ERROR("Failed to start query worker #%d", nthreads);
+
+            break;
+        }
+
+        nthreads++;
+    }
+
+    return (0 < nthreads ? 0 : -1);
+}
+
+/**
+ * Native timer callback; times out overdue queries and re-arms
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_query_timer(duk_context *ctx) {
+    (void)ctx;
+
+    timer = 0;
+
+    tjs_query_poll();
+
+    return 0;
+}
+
+/**
+ * Helper to arm one-shot timer for the earliest deadline; results are
+ * picked up when the workers wake the main thread
+ *
+ * @param[in]  due  Deadline in ms; negative when nothing is pending
+ **/
+
+static void tjs_query_arm(double due) {
+    if (NULL == timerctx || 0 > due || (0 != timer && armed <= due)) return;
+
+    if (0 != timer && tjs_timers_clear(touch.timers, timer)) {
+        duk_push_heap_stash(timerctx);
+        duk_get_prop_string(timerctx, -1, TJS_SYM_TIMERS);
+        duk_del_prop_index(timerctx, -1, (duk_uarridx_t)timer);
+        duk_pop_2(timerctx);
+    }
+
+    double delay = due - tjs_clock_now();
+
+    timer = tjs_timers_add(touch.timers, (0 < delay ? delay : 0), 0);
+    armed = due;
+
+    /* Store as one-shot timer callback */
+    duk_push_heap_stash(timerctx);
+    duk_get_prop_string(timerctx, -1, TJS_SYM_TIMERS);
+    duk_push_c_function(timerctx, tjs_query_timer, 0);
+    duk_put_prop_index(timerctx, -2, (duk_uarridx_t)timer);
+    duk_pop_2(timerctx);
+}
+
+/**
+ * Helper to call callback of settled handle on stack top; pops handle
+ *
+ * Callbacks are dropped before the call, so each runs once at most;
+ * this is the handle
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static void tjs_query_call(duk_context *ctx) {
+    duk_get_prop_string(ctx, -1, "status");
+
+    int ok = (0 == strcmp(duk_to_string(ctx, -1),
+        statuses[TJS_QUERY_STATUS_OK]));
+
+    duk_pop(ctx);
+
+    duk_get_prop_string(ctx, -1, (ok ? TJS_SYM_DATA_CB : TJS_SYM_ERROR_CB));
+    duk_del_prop_string(ctx, -2, TJS_SYM_DATA_CB);
+    duk_del_prop_string(ctx, -2, TJS_SYM_ERROR_CB);
+
+    if (!duk_is_callable(ctx, -1)) {
+        duk_pop_2(ctx);
+
+        return;
+    }
+
+    /* Call with handle as this */
+    duk_dup(ctx, -2);
+    duk_get_prop_string(ctx, -1, (ok ? "value" : "error"));
+
+    if (DUK_EXEC_SUCCESS != tjs_callback_pcall(ctx, "query", 1,
+            TJS_CALLBACK_FLAG_METHOD))
+    {
+        TJS_LOG_ERROR("Failed to call callback: %s",
+            duk_safe_to_string(ctx, -1));
+    }
+
+    duk_pop_2(ctx);
+}
+
+/**
+ * Native then method of query handles; callbacks of settled handles run
+ * right away
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_query_then(duk_context *ctx) {
+    duk_push_this(ctx);
+
+    if (duk_is_callable(ctx, 0)) {
+        duk_dup(ctx, 0);
+        duk_put_prop_string(ctx, -2, TJS_SYM_DATA_CB);
+    }
+
+    if (duk_is_callable(ctx, 1)) {
+        duk_dup(ctx, 1);
+        duk_put_prop_string(ctx, -2, TJS_SYM_ERROR_CB);
+    }
+
+    if (duk_has_prop_string(ctx, -1, "status")) {
+        duk_dup_top(ctx);
+        tjs_query_call(ctx);
+    }
+
+    return 1;
+}
+
+/**
+ * Helper to settle handle of query and call its callback
+ *
+ * @param[inout]  query   A #TjsQuery
+ * @param[in]     status  Status to deliver
+ **/
+
+static void tjs_query_deliver(TjsQuery *query, int status) {
+    duk_context *ctx = query->ctx;
+    double elapsed = tjs_clock_now() - query->submitted;
+
+    pending--;
+
+    switch (status) {
+        case TJS_QUERY_STATUS_OK:      stats.ok++;       break;
+        case TJS_QUERY_STATUS_TIMEOUT: stats.timeouts++; break;
+        default:                       stats.failed++;
+    }
+
+    tjs_histogram_record(stats.latency, (uint64_t)(elapsed * 1000.0));
+
+    /* Take handle out of the stash */
+    duk_push_heap_stash(ctx);
+    duk_get_prop_string(ctx, -1, TJS_SYM_QUERIES);
+    duk_get_prop_index(ctx, -1, (duk_uarridx_t)query->id);
+    duk_del_prop_index(ctx, -2, (duk_uarridx_t)query->id);
+    duk_remove(ctx, -2);
+    duk_remove(ctx, -2);
+
+    if (!duk_is_object(ctx, -1)) {
+        duk_pop(ctx);
+
+        return;
+    }
+
+    duk_push_string(ctx, statuses[status]);
+    duk_put_prop_string(ctx, -2, "status");
+    duk_push_number(ctx, elapsed);
+    duk_put_prop_string(ctx, -2, "elapsed");
+
+    if (TJS_QUERY_STATUS_OK == status) {
+        if (TJS_QUERY_ATTR_FRAME == query->attr) {
+            duk_idx_t aryIdx = duk_push_array(ctx);
+
+            for (int i = 0; i < 4; i++) {
+                duk_push_number(ctx, query->value.frame[i]);
+                duk_put_prop_index(ctx, aryIdx, i);
+            }
+        } else {
+            duk_push_string(ctx, query->value.str);
+        }
+
+        duk_put_prop_string(ctx, -2, "value");
+    } else {
+        duk_push_error_object(ctx, DUK_ERR_ERROR, "%s: attr=%s, pid=%d",
+            (TJS_QUERY_STATUS_TIMEOUT == status ? "Timeout" : "Failed"),
+            attrs[query->attr], query->pid);
+        duk_put_prop_string(ctx, -2, "error");
+    }
+
+    tjs_query_call(ctx);
+}
+
+/**
+ * Helper to free query; drops the source reference
+ *
+ * @param[inout]  query  A #TjsQuery
+ **/
+
+static void tjs_query_free(TjsQuery *query) {
+    source->release(query->ref);
+
+    free(query);
+}
+
+/**
+ * Get attribute id by name
+ *
+ * @param[in]  name  Name of the attribute
+ *
+ * @return Either attribute id; otherwise -1
+ **/
+
+int tjs_query_attr(const char *name) {
+    for (int i = 0; i < TJS_QUERY_ATTR_MAX; i++) {
+        if (0 == strcmp(attrs[i], name)) return i;
+    }
+
+    return -1;
+}
+
+/**
+ * Queue query and push handle; call its then(onValue, onError) method to
+ * get the result on the main thread
+ *
+ * @param[inout]  ctx      A #duk_context
+ * @param[in]     ref      Native window ref
+ * @param[in]     pid      Process id of the window
+ * @param[in]     attr     Attribute id
+ * @param[in]     timeout  Timeout in ms; 0 uses the default
+ *
+ * @return Number of pushed values
+ **/
+
+duk_ret_t tjs_query_push(duk_context *ctx, void *ref, int pid, int attr,
+    double timeout)
+{
+    if (NULL == source || 0 > attr || TJS_QUERY_ATTR_MAX <= attr) {
+        return duk_error(ctx, DUK_ERR_ERROR, "Query not available");
+    }
+
+    /* Workers start with the first query */
+    if (0 == nthreads && 0 != tjs_query_start()) {
+        return duk_error(ctx, DUK_ERR_ERROR, "Failed to start query workers");
+    }
+
+    TjsQuery *query = (TjsQuery *)calloc(1, sizeof(TjsQuery));
+
+    query->id = ++lastid;
+    query->pid = pid;
+    query->attr = attr;
+    query->ref = ref;
+    query->ctx = ctx;
+    query->submitted = tjs_clock_now();
+    query->deadline = query->submitted +
+        (0 < timeout ? timeout : TJS_QUERY_TIMEOUT);
+
+    source->retain(ref);
+
+    /* Create handle */
+    duk_idx_t objIdx = duk_push_object(ctx);
+
+    duk_push_number(ctx, query->id);
+    duk_put_prop_string(ctx, objIdx, "id");
+    duk_push_int(ctx, pid);
+    duk_put_prop_string(ctx, objIdx, "pid");
+    duk_push_string(ctx, attrs[attr]);
+    duk_put_prop_string(ctx, objIdx, "attr");
+    duk_push_c_function(ctx, tjs_query_then, 2);
+    duk_put_prop_string(ctx, objIdx, "then");
+
+    /* Keep handle until delivery */
+    duk_push_heap_stash(ctx);
+
+    if (!duk_get_prop_string(ctx, -1, TJS_SYM_QUERIES)) {
+        duk_pop(ctx);
+        duk_push_object(ctx);
+        duk_dup_top(ctx);
+        duk_put_prop_string(ctx, -3, TJS_SYM_QUERIES);
+    }
+
+    duk_dup(ctx, objIdx);
+    duk_put_prop_index(ctx, -2, (duk_uarridx_t)query->id);
+    duk_pop_2(ctx);
+
+    /* Append to queue of pid */
+    pthread_mutex_lock(&lock);
+
+    TjsQueryQueue *queue = queues;
+
+    while (NULL != queue && pid != queue->pid) queue = queue->next;
+
+    if (NULL == queue) {
+        queue = (TjsQueryQueue *)calloc(1, sizeof(TjsQueryQueue));
+
+        queue->pid = pid;
+        queue->next = queues;
+
+        queues = queue;
+        nqueues++;
+    }
+
+    if (NULL != queue->tail) {
+        queue->tail->next = query;
+    } else {
+        queue->head = query;
+    }
+
+    queue->tail = query;
+
+    if (++(queue->nqueued) > (int)stats.maxqueued) {
+        stats.maxqueued = queue->nqueued;
+    }
+
+    pthread_cond_signal(&ready);
+    pthread_mutex_unlock(&lock);
+
+    pending++;
+    stats.submitted++;
+
+    tjs_query_arm(query->deadline);
+
+    return 1;
+}
+
+/**
+ * Deliver finished queries and time out overdue ones
+ *
+ * Queries still waiting in their pid queue are dropped at their deadline;
+ * queries on a worker get their timeout right away and the late result is
+ * discarded when the app answers
+ *
+ * @return Number of delivered queries
+ **/
+
+int tjs_query_poll(void) {
+    TjsQuery *finished = NULL, *overdue = NULL, *overduetail = NULL;
+    TjsQuery *expired = NULL;
+    double now = tjs_clock_now(), due = -1;
+    int ndelivered = 0;
+    char buf[64];
+
+    /* Drain wakeups before taking the list; a late byte only wakes again */
+    while (-1 != wakefds[0] && 0 < read(wakefds[0], buf, sizeof(buf)));
+
+    pthread_mutex_lock(&lock);
+
+    finished = done;
+    done = donetail = NULL;
+
+    TjsQueryQueue **link = &queues;
+
+    while (NULL != *link) {
+        TjsQueryQueue *queue = *link;
+        TjsQuery **qlink = &queue->head;
+
+        queue->tail = NULL;
+
+        while (NULL != *qlink) {
+            TjsQuery *query = *qlink;
+
+            if (query->deadline <= now) {
+                *qlink = query->next;
+                queue->nqueued--;
+
+                query->next = NULL;
+
+                if (NULL != overduetail) {
+                    overduetail->next = query;
+                } else {
+                    overdue = query;
+                }
+
+                overduetail = query;
+            } else {
+                if (0 > due || query->deadline < due) due = query->deadline;
+
+                queue->tail = query;
+                qlink = &query->next;
+            }
+        }
+
+        TjsQuery *running = queue->running;
+
+        if (NULL != running && !running->expired) {
+            if (running->deadline <= now) {
+                running->expired = 1;
+                running->nextexpired = expired;
+
+                expired = running;
+            } else if (0 > due || running->deadline < due) {
+                due = running->deadline;
+            }
+        }
+
+        /* Forget idle queues of quiet or terminated apps */
+        if (NULL == queue->head && NULL == queue->running) {
+            *link = queue->next;
+
+            if (cursor == queue) cursor = NULL;
+
+            free(queue);
+            nqueues--;
+        } else {
+            link = &queue->next;
+        }
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    /* Hung apps first; worker owns these until the app answers */
+    for (TjsQuery *query = expired; NULL != query; query = query->nextexpired) {
+        tjs_query_deliver(query, TJS_QUERY_STATUS_TIMEOUT);
+        ndelivered++;
+    }
+
+    while (NULL != overdue) {
+        TjsQuery *query = overdue;
+
+        overdue = query->next;
+
+        tjs_query_deliver(query, TJS_QUERY_STATUS_TIMEOUT);
+        tjs_query_free(query);
+        ndelivered++;
+    }
+
+    while (NULL != finished) {
+        TjsQuery *query = finished;
+
+        finished = query->next;
+
+        if (query->expired) {
+            stats.late++;
+        } else {
+            tjs_query_deliver(query, query->status);
+            ndelivered++;
+        }
+
+        tjs_query_free(query);
+    }
+
+    tjs_query_arm(due);
+
+    return ndelivered;
+}
+
+/**
+ * Get number of queries waiting for delivery
+ *
+ * @return Number of queries
+ **/
+
+int tjs_query_pending(void) {
+    return pending;
+}
+
+/**
+ * Get read end of the pipe workers use to signal finished queries; the
+ * main loop calls #tjs_query_poll when it gets readable
+ *
+ * @return Either fd; otherwise -1 before init
+ **/
+
+int tjs_query_fd(void) {
+    return wakefds[0];
+}
+
+/**
+ * Get number of started workers
+ *
+ * @return Number of workers
+ **/
+
+int tjs_query_workers(void) {
+    return nthreads;
+}
+
+/**
+ * Get counters
+ *
+ * @return A #TjsQueryStats
+ **/
+
+const TjsQueryStats *tjs_query_stats(void) {
+    return &stats;
+}
+
+/**
+ * Add counters to object at given index
+ *
+ * @param[inout]  ctx     A #duk_context
+ * @param[in]     objIdx  Stack index of the object
+ **/
+
+void tjs_query_putstats(duk_context *ctx, duk_idx_t objIdx) {
+    objIdx = duk_normalize_index(ctx, objIdx);
+
+    duk_push_int(ctx, nthreads);
+    duk_put_prop_string(ctx, objIdx, "workers");
+    duk_push_int(ctx, pending);
+    duk_put_prop_string(ctx, objIdx, "pending");
+    duk_push_number(ctx, stats.submitted);
+    duk_put_prop_string(ctx, objIdx, "submitted");
+    duk_push_number(ctx, stats.ok);
+    duk_put_prop_string(ctx, objIdx, "ok");
+    duk_push_number(ctx, stats.failed);
+    duk_put_prop_string(ctx, objIdx, "failed");
+    duk_push_number(ctx, stats.timeouts);
+    duk_put_prop_string(ctx, objIdx, "timeouts");
+    duk_push_number(ctx, stats.late);
+    duk_put_prop_string(ctx, objIdx, "late");
+    duk_push_number(ctx, stats.maxqueued);
+    duk_put_prop_string(ctx, objIdx, "maxqueued");
+
+    /* Latencies in ms */
+    if (NULL != stats.latency) {
+        duk_push_number(ctx,
+            tjs_histogram_percentile(stats.latency, 50) / 1000.0);
+        duk_put_prop_string(ctx, objIdx, "p50");
+        duk_push_number(ctx,
+            tjs_histogram_percentile(stats.latency, 99) / 1000.0);
+        duk_put_prop_string(ctx, objIdx, "p99");
+        duk_push_number(ctx, stats.latency->max / 1000.0);
+        duk_put_prop_string(ctx, objIdx, "max");
+    }
+}
+
+/**
+ * Init async attribute queries; workers start on first use
+ *
+ * @param[in]     querysource  A #TjsQuerySource
+ * @param[inout]  ctx          A #duk_context to keep the deadline timer
+ * @param[in]     workers      Number of workers; 0 uses the default
+ **/
+
+void tjs_query_init(const TjsQuerySource *querysource, duk_context *ctx,
+    int workers)
+{
+    source = querysource;
+    timerctx = ctx;
+    nworkers = (0 < workers ? workers : TJS_QUERY_WORKERS);
+
+    if (TJS_QUERY_WORKERS_MAX < nworkers) nworkers = TJS_QUERY_WORKERS_MAX;
+
+    stats.latency = tjs_histogram_new();
+
+    if (-1 == pipe(wakefds)) {
+        TJS_LOG_ERROR("Failed to create query wakeup pipe");
+
+        wakefds[0] = wakefds[1] = -1;
+    } else {
+        for (int i = 0; i < 2; i++) {
+            fcntl(wakefds[i], F_SETFL, fcntl(wakefds[i], F_GETFL) | O_NONBLOCK);
+            fcntl(wakefds[i], F_SETFD, FD_CLOEXEC);
+        }
+    }
+
+    if (NULL != source->init) source->init(TJS_QUERY_TIMEOUT);
+}
+
+/**
+ * Deinit async attribute queries; waits for workers and drops pending
+ * queries without delivering them
+ **/
+
+void tjs_query_deinit(void) {
+    pthread_mutex_lock(&lock);
+
+    quit = 1;
+
+    pthread_cond_broadcast(&ready);
+    pthread_mutex_unlock(&lock);
+
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Workers are gone; nothing runs anymore */
+    while (NULL != queues) {
+        TjsQueryQueue *queue = queues;
+
+        queues = queue->next;
+
+        while (NULL != queue->head) {
+            TjsQuery *query = queue->head;
+
+            queue->head = query->next;
+            stats.dropped++;
+
+            tjs_query_free(query);
+        }
+
+        free(queue);
+    }
+
+    while (NULL != done) {
+        TjsQuery *query = done;
+
+        done = query->next;
+
+        if (!query->expired) stats.dropped++;
+
+        tjs_query_free(query);
+    }
+
+    if (0 != timer) tjs_timers_clear(touch.timers, timer);
+
+    for (int i = 0; i < 2; i++) {
+        if (-1 != wakefds[i]) close(wakefds[i]);
+
+        wakefds[i] = -1;
+    }
+
+    tjs_histogram_destroy(stats.latency);
+
+    source = NULL;
+    timerctx = NULL;
+    timer = 0;
+    armed = 0;
+    cursor = NULL;
+    donetail = NULL;
+    nqueues = nthreads = nworkers = pending = quit = 0;
+    stats.latency = NULL;
+}
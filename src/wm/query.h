@@ -0,0 +1,82 @@
+/**
+ * @package TouchJS
+ *
+ * @file Async attribute query header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_QUERY_H
+#define TJS_QUERY_H 1
+
+/* Includes */
+#include "../libs/duktape/duktape.h"
+
+#include "source.h"
+
+/* Attributes */
+#define TJS_QUERY_ATTR_TITLE 0
+#define TJS_QUERY_ATTR_ROLE 1
+#define TJS_QUERY_ATTR_SUBROLE 2
+#define TJS_QUERY_ATTR_FRAME 3
+#define TJS_QUERY_ATTR_MAX 4
+
+/* Status */
+#define TJS_QUERY_STATUS_OK 0
+#define TJS_QUERY_STATUS_FAILED 1  ///< Source refused, e.g. window is gone
+#define TJS_QUERY_STATUS_TIMEOUT 2 ///< Deadline passed before the app answered
+
+/* Defaults */
+#define TJS_QUERY_WORKERS 4      ///< Worker threads
+#define TJS_QUERY_WORKERS_MAX 16
+#define TJS_QUERY_TIMEOUT 250.0  ///< Per request timeout in ms
+
+/* Types */
+typedef struct tjs_query_value_t {
+    char str[128];    ///< Title, role or subrole
+    double frame[4];  ///< x, y, width, height
+} TjsQueryValue;
+
+typedef struct tjs_query_t {
+    unsigned long id;
+    int pid, attr, status;
+    int expired; ///< Timeout delivered while on a worker; result is dropped
+
+    void *ref; ///< Retained by the source until the query is freed
+    duk_context *ctx; ///< Heap of the handle
+
+    double submitted, deadline; ///< Wall clock in ms
+    TjsQueryValue value;
+
+    struct tjs_query_t *next; ///< Next in pid queue or done list
+    struct tjs_query_t *nextexpired;
+} TjsQuery;
+
+typedef struct tjs_query_stats_t {
+    unsigned long submitted, ok, failed, timeouts;
+    unsigned long late;  ///< Results that arrived after their timeout
+    unsigned long dropped; ///< Pending at deinit
+    unsigned long maxqueued; ///< Longest queue of a single pid
+
+    struct tjs_histogram_t *latency; ///< Submit to delivery in us
+} TjsQueryStats;
+
+/* Methods */
+int tjs_query_attr(const char *name);
+duk_ret_t tjs_query_push(duk_context *ctx, void *ref, int pid, int attr,
+    double timeout);
+int tjs_query_poll(void);
+int tjs_query_pending(void);
+int tjs_query_fd(void);
+int tjs_query_workers(void);
+const TjsQueryStats *tjs_query_stats(void);
+void tjs_query_putstats(duk_context *ctx, duk_idx_t objIdx);
+
+void tjs_query_init(const TjsQuerySource *source, duk_context *ctx,
+    int nworkers);
+void tjs_query_deinit(void);
+
+#endif /* TJS_QUERY_H */
@@ -0,0 +1,553 @@
+/**
+ * @package TouchJS
+ *
+ * @file Window snapshot functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../touchjs.h"
+
+#include "snapshot.h"
+
+#include "../common/userdata.h"
+#include "../common/alloc.h"
+#include "../common/clock.h"
+
+/* Types */
+typedef struct tjs_snapshot_diff_arg_t {
+    duk_context *ctx;
+    duk_idx_t idx[3]; ///< Result arrays by diff kind
+    int n[3];
+} TjsSnapshotDiffArg;
+
+/* Globals */
+static unsigned long seq = 0;
+
+static const char *kinds[] = { "opened", "closed", "moved" };
+
+/**
+ * Helper to compare windows by id
+ *
+ * @param[in]  a  A #TjsSnapshotWin
+ * @param[in]  b  A #TjsSnapshotWin
+ *
+ * @return Result of comparison
+ **/
+
+static int tjs_snapshot_compare(const void *a, const void *b) {
+    unsigned long ida = ((const TjsSnapshotWin *)a)->id;
+    unsigned long idb = ((const TjsSnapshotWin *)b)->id;
+
+    return (ida < idb ? -1 : (ida > idb ? 1 : 0));
+}
+
+/**
+ * Userdata hook; releases window array of snapshot
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+static void tjs_snapshot_hook(TjsUserdata *userdata) {
+    TjsSnapshot *snapshot = (TjsSnapshot *)userdata;
+
+    tjs_alloc_free(touch.alloc, snapshot->wins);
+
+    snapshot->wins = NULL;
+    snapshot->nwins = snapshot->capacity = 0;
+}
+
+/**
+ * Append new zeroed window to snapshot
+ *
+ * @param[inout]  snapshot  A #TjsSnapshot
+ *
+ * @return Either new #TjsSnapshotWin; otherwise NULL
+ **/
+
+TjsSnapshotWin *tjs_snapshot_add(TjsSnapshot *snapshot) {
+    if (snapshot->nwins == snapshot->capacity) {
+        int capacity = (0 < snapshot->capacity ? snapshot->capacity * 2 : 32);
+
+        TjsSnapshotWin *wins = (TjsSnapshotWin *)tjs_alloc_realloc(touch.alloc,
+            snapshot->wins, capacity * sizeof(TjsSnapshotWin));
+
+        if (NULL == wins) return NULL;
+
+        snapshot->wins = wins;
+        snapshot->capacity = capacity;
+    }
+
+    TjsSnapshotWin *win = &(snapshot->wins[snapshot->nwins++]);
+
+    memset(win, 0, sizeof(TjsSnapshotWin));
+
+    return win;
+}
+
+/**
+ * Take snapshot of all windows of source
+ *
+ * @param[inout]  snapshot  A #TjsSnapshot
+ * @param[in]     source    A #TjsWinSource
+ *
+ * @return Number of windows
+ **/
+
+int tjs_snapshot_take(TjsSnapshot *snapshot, const TjsWinSource *source) {
+    double start = tjs_clock_now();
+
+    snapshot->nwins = 0;
+
+    if (NULL != source->snapshot) {
+        source->snapshot(snapshot);
+    }
+
+    /* Sort for lookup and diff */
+    qsort(snapshot->wins, snapshot->nwins, sizeof(TjsSnapshotWin),
+        tjs_snapshot_compare);
+
+    snapshot->seq = ++seq;
+    snapshot->elapsed = tjs_clock_now() - start;
+
+    return snapshot->nwins;
+}
+
+/**
+ * Find window in snapshot
+ *
+ * @param[in]  snapshot  A #TjsSnapshot
+ * @param[in]  id        Window id
+ *
+ * @return Either found #TjsSnapshotWin; otherwise NULL
+ **/
+
+const TjsSnapshotWin *tjs_snapshot_find(const TjsSnapshot *snapshot,
+    unsigned long id)
+{
+    TjsSnapshotWin key = { .id = id };
+
+    if (0 == snapshot->nwins) return NULL;
+
+    return (const TjsSnapshotWin *)bsearch(&key, snapshot->wins,
+        snapshot->nwins, sizeof(TjsSnapshotWin), tjs_snapshot_compare);
+}
+
+/**
+ * Diff two snapshots; walks both sorted arrays once
+ *
+ * @param[in]     prev  Previous #TjsSnapshot
+ * @param[in]     cur   Current #TjsSnapshot
+ * @param[in]     func  A #TjsSnapshotDiffFunc called per change
+ * @param[inout]  arg   Argument passed to func
+ *
+ * @return Number of changes
+ **/
+
+int tjs_snapshot_diff(const TjsSnapshot *prev, const TjsSnapshot *cur,
+    TjsSnapshotDiffFunc func, void *arg)
+{
+    int i = 0, j = 0, nchanges = 0;
+
+    while (i < prev->nwins || j < cur->nwins) {
+        const TjsSnapshotWin *a = (i < prev->nwins ? &(prev->wins[i]) : NULL);
+        const TjsSnapshotWin *b = (j < cur->nwins ? &(cur->wins[j]) : NULL);
+
+        if (NULL == b || (NULL != a && a->id < b->id)) {
+            func(TJS_SNAPSHOT_CLOSED, a, NULL, arg);
+            nchanges++;
+            i++;
+        } else if (NULL == a || b->id < a->id) {
+            func(TJS_SNAPSHOT_OPENED, NULL, b, arg);
+            nchanges++;
+            j++;
+        } else {
+            if (a->x != b->x || a->y != b->y ||
+                    a->width != b->width || a->height != b->height)
+            {
+                func(TJS_SNAPSHOT_MOVED, a, b, arg);
+                nchanges++;
+            }
+
+            i++;
+            j++;
+        }
+    }
+
+    return nchanges;
+}
+
+/**
+ * Helper to push frame array
+ *
+ * @param[inout]  ctx  A #duk_context
+ * @param[in]     win  A #TjsSnapshotWin
+ **/
+
+static void tjs_snapshot_push_frame(duk_context *ctx, const TjsSnapshotWin *win) {
+    duk_idx_t aryIdx = duk_push_array(ctx);
+
+    duk_push_int(ctx, win->x);
+    duk_put_prop_index(ctx, aryIdx, 0);
+    duk_push_int(ctx, win->y);
+    duk_put_prop_index(ctx, aryIdx, 1);
+    duk_push_int(ctx, win->width);
+    duk_put_prop_index(ctx, aryIdx, 2);
+    duk_push_int(ctx, win->height);
+    duk_put_prop_index(ctx, aryIdx, 3);
+}
+
+/**
+ * Helper to push window as plain object
+ *
+ * @param[inout]  ctx  A #duk_context
+ * @param[in]     win  A #TjsSnapshotWin
+ **/
+
+static void tjs_snapshot_push_win(duk_context *ctx, const TjsSnapshotWin *win) {
+    static const struct {
+        int flag;
+        const char *name;
+    } bools[] = {
+        { TJS_SNAPSHOT_FLAG_NORMAL, "normal" },
+        { TJS_SNAPSHOT_FLAG_SHEET, "sheet" },
+        { TJS_SNAPSHOT_FLAG_MINIMIZED, "minimized" },
+        { TJS_SNAPSHOT_FLAG_HIDDEN, "hidden" },
+        { TJS_SNAPSHOT_FLAG_MOVABLE, "movable" },
+        { TJS_SNAPSHOT_FLAG_RESIZABLE, "resizable" }
+    };
+
+    duk_idx_t objIdx = duk_push_object(ctx);
+
+    duk_push_number(ctx, win->id);
+    duk_put_prop_string(ctx, objIdx, "id");
+    duk_push_int(ctx, win->pid);
+    duk_put_prop_string(ctx, objIdx, "pid");
+    duk_push_string(ctx, win->title);
+    duk_put_prop_string(ctx, objIdx, "title");
+    duk_push_string(ctx, win->role);
+    duk_put_prop_string(ctx, objIdx, "role");
+    duk_push_string(ctx, win->subrole);
+    duk_put_prop_string(ctx, objIdx, "subrole");
+
+    tjs_snapshot_push_frame(ctx, win);
+    duk_put_prop_string(ctx, objIdx, "frame");
+
+    for (int i = 0; i < (int)(sizeof(bools) / sizeof(bools[0])); i++) {
+        duk_push_boolean(ctx, 0 < (win->flags & bools[i].flag));
+        duk_put_prop_string(ctx, objIdx, bools[i].name);
+    }
+}
+
+/**
+ * Helper to collect diff into result arrays
+ *
+ * @param[in]     kind  Diff kind
+ * @param[in]     prev  Previous #TjsSnapshotWin or NULL
+ * @param[in]     cur   Current #TjsSnapshotWin or NULL
+ * @param[inout]  arg   A #TjsSnapshotDiffArg
+ **/
+
+static void tjs_snapshot_collect(int kind, const TjsSnapshotWin *prev,
+    const TjsSnapshotWin *cur, void *arg)
+{
+    TjsSnapshotDiffArg *diff = (TjsSnapshotDiffArg *)arg;
+
+    tjs_snapshot_push_win(diff->ctx, (NULL != cur ? cur : prev));
+
+    /* Keep old frame of moved windows */
+    if (TJS_SNAPSHOT_MOVED == kind) {
+        tjs_snapshot_push_frame(diff->ctx, prev);
+        duk_put_prop_string(diff->ctx, -2, "from");
+    }
+
+    duk_put_prop_index(diff->ctx, diff->idx[kind], diff->n[kind]++);
+}
+
+/**
+ * Push new snapshot object taken from source
+ *
+ * @param[inout]  ctx     A #duk_context
+ * @param[in]     source  A #TjsWinSource
+ *
+ * @return Either 1 when pushed; otherwise 0 and undefined is pushed
+ **/
+
+int tjs_snapshot_push(duk_context *ctx, const TjsWinSource *source) {
+    duk_get_global_string(ctx, "TjsSnapshot");
+    duk_new(ctx, 0);
+
+    TjsSnapshot *snapshot = (TjsSnapshot *)tjs_userdata_from(ctx,
+        TJS_FLAG_TYPE_SNAPSHOT);
+
+    if (NULL == snapshot) {
+        duk_pop(ctx);
+        duk_push_undefined(ctx);
+
+        return 0;
+    }
+
+    tjs_snapshot_take(snapshot, source);
+
+    TJS_LOG_DEBUG("Snapshot: source=%s, seq=%lu, nwins=%d, elapsed=%.3fms",
+        source->name, snapshot->seq, snapshot->nwins, snapshot->elapsed);
+
+    return 1;
+}
+
+/**
+ * Push diff object of two snapshot objects
+ *
+ * @param[inout]  ctx      A #duk_context
+ * @param[in]     prevIdx  Stack index of previous snapshot object
+ * @param[in]     curIdx   Stack index of current snapshot object
+ *
+ * @return Either 1 when pushed; otherwise 0
+ **/
+
+int tjs_snapshot_push_diff(duk_context *ctx, duk_idx_t prevIdx,
+    duk_idx_t curIdx)
+{
+    prevIdx = duk_normalize_index(ctx, prevIdx);
+    curIdx = duk_normalize_index(ctx, curIdx);
+
+    /* Get userdata */
+    duk_dup(ctx, prevIdx);
+    TjsSnapshot *prev = (TjsSnapshot *)tjs_userdata_from(ctx,
+        TJS_FLAG_TYPE_SNAPSHOT);
+    duk_pop(ctx);
+
+    duk_dup(ctx, curIdx);
+    TjsSnapshot *cur = (TjsSnapshot *)tjs_userdata_from(ctx,
+        TJS_FLAG_TYPE_SNAPSHOT);
+    duk_pop(ctx);
+
+    if (NULL == prev || NULL == cur) return 0;
+
+    TjsSnapshotDiffArg arg = { .ctx = ctx };
+
+    duk_idx_t objIdx = duk_push_object(ctx);
+
+    for (int i = 0; i < 3; i++) {
+        arg.idx[i] = duk_push_array(ctx);
+    }
+
+    tjs_snapshot_diff(prev, cur, tjs_snapshot_collect, &arg);
+
+    for (int i = 2; 0 <= i; i--) {
+        duk_put_prop_string(ctx, objIdx, kinds[i]);
+    }
+
+    return 1;
+}
+
+/**
+ * Push diff object of a new snapshot taken from source against previous one;
+ * the new snapshot is stored as snapshot property for the next call
+ *
+ * @param[inout]  ctx      A #duk_context
+ * @param[in]     source   A #TjsWinSource
+ * @param[in]     prevIdx  Stack index of previous snapshot object
+ *
+ * @return Either 1 when pushed; otherwise 0
+ **/
+
+int tjs_snapshot_push_since(duk_context *ctx, const TjsWinSource *source,
+    duk_idx_t prevIdx)
+{
+    prevIdx = duk_normalize_index(ctx, prevIdx);
+
+    if (!tjs_snapshot_push(ctx, source)) {
+        duk_pop(ctx);
+
+        return 0;
+    }
+
+    if (!tjs_snapshot_push_diff(ctx, prevIdx, -1)) {
+        duk_pop(ctx);
+
+        return 0;
+    }
+
+    /* Move current snapshot into result */
+    duk_swap_top(ctx, -2);
+    duk_put_prop_string(ctx, -2, "snapshot");
+
+    return 1;
+}
+
+/**
+ * Native constructor
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_snapshot_ctor(duk_context *ctx) {
+    /* Sanity check */
+    if (!duk_is_constructor_call(ctx)) {
+        return DUK_RET_TYPE_ERROR;
+    }
+
+    /* Create new userdata */
+    TjsSnapshot *snapshot = (TjsSnapshot *)tjs_userdata_new(ctx,
+        TJS_FLAG_TYPE_SNAPSHOT, sizeof(TjsSnapshot));
+
+    if (NULL == snapshot) {
+        return DUK_RET_TYPE_ERROR;
+    }
+
+    tjs_userdata_init(ctx, (TjsUserdata *)snapshot);
+
+    return 0;
+}
+
+/**
+ * Native snapshot getWindows prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_snapshot_prototype_getwindows(duk_context *ctx) {
+    /* Get userdata */
+    TjsSnapshot *snapshot = (TjsSnapshot *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_SNAPSHOT);
+
+    if (NULL != snapshot) {
+        TJS_LOG_OBJ(snapshot);
+
+        duk_idx_t aryIdx = duk_push_array(ctx);
+
+        for (int i = 0; i < snapshot->nwins; i++) {
+            tjs_snapshot_push_win(ctx, &(snapshot->wins[i]));
+            duk_put_prop_index(ctx, aryIdx, i);
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native snapshot getWindow prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_snapshot_prototype_getwindow(duk_context *ctx) {
+    unsigned long id = (unsigned long)duk_require_number(ctx, 0);
+
+    /* Get userdata */
+    TjsSnapshot *snapshot = (TjsSnapshot *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_SNAPSHOT);
+
+    if (NULL != snapshot) {
+        TJS_LOG_OBJ(snapshot);
+
+        const TjsSnapshotWin *win = tjs_snapshot_find(snapshot, id);
+
+        if (NULL != win) {
+            tjs_snapshot_push_win(ctx, win);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Native snapshot size prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_snapshot_prototype_size(duk_context *ctx) {
+    /* Get userdata */
+    TjsSnapshot *snapshot = (TjsSnapshot *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_SNAPSHOT);
+
+    if (NULL != snapshot) {
+        duk_push_int(ctx, snapshot->nwins);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native snapshot diff prototype method; this is the newer snapshot
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_snapshot_prototype_diff(duk_context *ctx) {
+    duk_require_object(ctx, 0);
+    duk_push_this(ctx);
+
+    if (!tjs_snapshot_push_diff(ctx, 0, -1)) {
+        return duk_error(ctx, DUK_ERR_TYPE_ERROR, "Snapshot expected");
+    }
+
+    return 1;
+}
+
+/**
+ * Native snapshot toString prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_snapshot_prototype_tostring(duk_context *ctx) {
+    /* Get userdata */
+    TjsSnapshot *snapshot = (TjsSnapshot *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_SNAPSHOT);
+
+    if (NULL != snapshot) {
+        TJS_LOG_OBJ(snapshot);
+
+        duk_push_sprintf(ctx, "seq=%lu, nwins=%d, elapsed=%.3fms",
+            snapshot->seq, snapshot->nwins, snapshot->elapsed);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Init methods for #TjsSnapshot
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+void tjs_snapshot_init(duk_context *ctx) {
+    /* Register constructor */
+    duk_push_c_function(ctx, tjs_snapshot_ctor, 0);
+    duk_push_object(ctx);
+
+    /* Register methods */
+    duk_push_c_function(ctx, tjs_snapshot_prototype_getwindows, 0);
+    duk_put_prop_string(ctx, -2, "getWindows");
+    duk_push_c_function(ctx, tjs_snapshot_prototype_getwindow, 1);
+    duk_put_prop_string(ctx, -2, "getWindow");
+    duk_push_c_function(ctx, tjs_snapshot_prototype_size, 0);
+    duk_put_prop_string(ctx, -2, "size");
+    duk_push_c_function(ctx, tjs_snapshot_prototype_diff, 1);
+    duk_put_prop_string(ctx, -2, "diff");
+
+    duk_push_c_function(ctx, tjs_snapshot_prototype_tostring, 0);
+    duk_put_prop_string(ctx, -2, "toString");
+
+    duk_put_prop_string(ctx, -2, "prototype");
+    duk_put_global_string(ctx, "TjsSnapshot");
+
+    tjs_userdata_hook(TJS_FLAG_TYPE_SNAPSHOT, tjs_snapshot_hook);
+}
@@ -0,0 +1,69 @@
+/**
+ * @package TouchJS
+ *
+ * @file Window snapshot header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_SNAPSHOT_H
+#define TJS_SNAPSHOT_H 1
+
+/* Includes */
+#include "../libs/duktape/duktape.h"
+
+#include "source.h"
+
+/* Flags */
+#define TJS_SNAPSHOT_FLAG_NORMAL    (1 << 0)
+#define TJS_SNAPSHOT_FLAG_SHEET     (1 << 1)
+#define TJS_SNAPSHOT_FLAG_MINIMIZED (1 << 2)
+#define TJS_SNAPSHOT_FLAG_HIDDEN    (1 << 3)
+#define TJS_SNAPSHOT_FLAG_MOVABLE   (1 << 4)
+#define TJS_SNAPSHOT_FLAG_RESIZABLE (1 << 5)
+
+/* Diff kinds */
+#define TJS_SNAPSHOT_OPENED 0
+#define TJS_SNAPSHOT_CLOSED 1
+#define TJS_SNAPSHOT_MOVED  2
+
+/* Types */
+typedef struct tjs_snapshot_win_t {
+    unsigned long id;
+    int flags, pid;
+    int x, y, width, height;
+
+    char title[64], role[32], subrole[32];
+} TjsSnapshotWin;
+
+typedef struct tjs_snapshot_t {
+    int flags;
+
+    int nwins, capacity;
+    unsigned long seq;
+    double elapsed; ///< Time to take snapshot in ms
+
+    TjsSnapshotWin *wins; ///< Sorted by id after take
+} TjsSnapshot;
+
+typedef void (*TjsSnapshotDiffFunc)(int kind, const TjsSnapshotWin *prev,
+    const TjsSnapshotWin *cur, void *arg);
+
+/* Methods */
+TjsSnapshotWin *tjs_snapshot_add(TjsSnapshot *snapshot);
+int tjs_snapshot_take(TjsSnapshot *snapshot, const TjsWinSource *source);
+const TjsSnapshotWin *tjs_snapshot_find(const TjsSnapshot *snapshot,
+    unsigned long id);
+int tjs_snapshot_diff(const TjsSnapshot *prev, const TjsSnapshot *cur,
+    TjsSnapshotDiffFunc func, void *arg);
+
+int tjs_snapshot_push(duk_context *ctx, const TjsWinSource *source);
+int tjs_snapshot_push_diff(duk_context *ctx, duk_idx_t prevIdx,
+    duk_idx_t curIdx);
+int tjs_snapshot_push_since(duk_context *ctx, const TjsWinSource *source,
+    duk_idx_t prevIdx);
+
+#endif /* TJS_SNAPSHOT_H */
@@ -0,0 +1,56 @@
+/**
+ * @package TouchJS
+ *
+ * @file Window source header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_SOURCE_H
+#define TJS_SOURCE_H 1
+
+/* Includes */
+#include "../common/userdata.h"
+
+/* Types */
+struct tjs_snapshot_t;
+struct tjs_bus_attrs_t;
+struct tjs_query_value_t;
+
+typedef struct tjs_win_source_t {
+    const char *name;
+    const char *ctor; ///< Name of the global JS constructor
+
+    unsigned long (*id)(void *ref); ///< Stable window id; 0 if unknown
+    void (*bind)(TjsUserdata *userdata, void *ref); ///< Retain ref
+    void (*unbind)(TjsUserdata *userdata); ///< Release ref
+    int (*equal)(TjsUserdata *userdata, void *ref); ///< Ref is bound one
+
+    int (*snapshot)(struct tjs_snapshot_t *snapshot); ///< Bulk fetch windows
+    int (*attrs)(void *ref, struct tjs_bus_attrs_t *attrs); ///< Fetch filter attributes; 0 on success
+} TjsWinSource;
+
+typedef struct tjs_app_source_t {
+    const char *name;
+
+    void *(*attach)(int pid); ///< Create observer; NULL when app isn't ready
+    void (*detach)(void *observer, int pid); ///< Destroy observer
+    int (*bind)(void *observer, int pid, int event); ///< Add notification; 0 on success
+    void (*unbind)(void *observer, int pid, int event); ///< Remove notification
+} TjsAppSource;
+
+typedef struct tjs_query_source_t {
+    const char *name;
+
+    void (*init)(double timeout); ///< One-time setup with default timeout; may be NULL
+
+    void (*retain)(void *ref); ///< Keep ref alive while queued; main thread
+    void (*release)(void *ref); ///< Drop ref; main thread
+    int (*fetch)(void *ref, int pid, int attr, struct tjs_query_value_t *value,
+        double timeout); ///< Blocking fetch on a worker thread; returns status
+} TjsQuerySource;
+
+#endif /* TJS_SOURCE_H */
@@ -15,6 +15,7 @@
 #import <Cocoa/Cocoa.h>
 
 #include "frame.h"
+#include "source.h"
 
 /* Types */
 typedef struct tjs_win_t {
@@ -26,6 +27,10 @@ typedef struct tjs_win_t {
     AXUIElementRef elemRef;
 } TjsWin;
 
+/* Globals */
+extern const TjsWinSource tjs_win_source_ax;
+extern const TjsQuerySource tjs_query_source_ax;
+
 /* Methods */
 TjsWin *tjs_win_new(AXUIElementRef elemRef);
 
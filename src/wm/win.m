@@ -14,8 +14,12 @@
 #include "win.h"
 #include "attr.h"
 #include "observer.h"
+#include "snapshot.h"
+#include "query.h"
 
 #include "../common/userdata.h"
+#include "../common/alloc.h"
+#include "../common/bus.h"
 
 /* Flags */
 #define TJS_WIN_SIGNAL_SHOW      (1 << 0)
@@ -32,7 +36,7 @@
  **/
 
 TjsWin *tjs_win_new(AXUIElementRef elemRef) {
-    TjsWin *win = (TjsWin *)calloc(1, sizeof(TjsWin));
+    TjsWin *win = (TjsWin *)tjs_alloc_typed(touch.alloc, sizeof(TjsWin));
 
     if (NULL != win) {
         win->elemRef = CFRetain(elemRef);
@@ -136,6 +140,377 @@ static duk_ret_t tjs_win_signal(duk_context *ctx, int signal) {
     return 0;
 }
 
+/**
+ * Get window id of element
+ *
+ * @param[in]  ref  A #AXUIElementRef
+ *
+ * @return Either window id; otherwise 0
+ **/
+
+static unsigned long tjs_win_source_id(void *ref) {
+    CGWindowID winId = tjs_attr_get_win_id((AXUIElementRef)ref);
+
+    return ((CGWindowID)-1 == winId ? 0 : winId);
+}
+
+/**
+ * Bind element to window object
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ * @param[in]     ref       A #AXUIElementRef
+ **/
+
+static void tjs_win_source_bind(TjsUserdata *userdata, void *ref) {
+    ((TjsWin *)userdata)->elemRef = (AXUIElementRef)CFRetain(ref);
+}
+
+/**
+ * Release element of window object
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+static void tjs_win_source_unbind(TjsUserdata *userdata) {
+    TjsWin *win = (TjsWin *)userdata;
+
+    if (NULL != win->elemRef) {
+        CFRelease(win->elemRef);
+
+        win->elemRef = NULL;
+    }
+}
+
+/**
+ * Compare element with the one of window object
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ * @param[in]     ref       A #AXUIElementRef
+ *
+ * @return Either 1 when equal; otherwise 0
+ **/
+
+static int tjs_win_source_equal(TjsUserdata *userdata, void *ref) {
+    TjsWin *win = (TjsWin *)userdata;
+
+    return (NULL != win->elemRef && CFEqual(win->elemRef, (CFTypeRef)ref));
+}
+
+/**
+ * Helper to copy string value into buffer
+ *
+ * @param[in]     valueRef  A #CFTypeRef
+ * @param[inout]  buf       Buffer to fill
+ * @param[in]     len       Length of buffer
+ **/
+
+static void tjs_win_copy_string(CFTypeRef valueRef, char *buf, size_t len) {
+    if (NULL != valueRef && CFStringGetTypeID() == CFGetTypeID(valueRef)) {
+        CFStringGetCString((CFStringRef)valueRef, buf, len,
+            kCFStringEncodingUTF8);
+    }
+}
+
+/**
+ * Helper to check boolean value
+ *
+ * @param[in]  valueRef  A #CFTypeRef
+ *
+ * @return Either 1 when true; otherwise 0
+ **/
+
+static int tjs_win_is_true(CFTypeRef valueRef) {
+    return (NULL != valueRef && CFBooleanGetTypeID() == CFGetTypeID(valueRef) &&
+        CFBooleanGetValue((CFBooleanRef)valueRef));
+}
+
+/**
+ * Bulk fetch all windows into snapshot; plain attributes are fetched with
+ * one round-trip per window instead of one per attribute. AX has no bulk
+ * call for settability, so movable and resizable cost one more round-trip
+ * each; three per window in total
+ *
+ * @param[inout]  snapshot  A #TjsSnapshot
+ *
+ * @return Number of windows
+ **/
+
+static int tjs_win_source_snapshot(TjsSnapshot *snapshot) {
+    const void *attrs[] = {
+        kAXTitleAttribute, kAXRoleAttribute, kAXSubroleAttribute,
+        kAXPositionAttribute, kAXSizeAttribute,
+        kAXMinimizedAttribute, kAXHiddenAttribute
+    };
+
+    CFArrayRef attrsRef = CFArrayCreate(NULL, attrs,
+        sizeof(attrs) / sizeof(attrs[0]), &kCFTypeArrayCallBacks);
+
+    /* Find running applications */
+    for (NSRunningApplication *app in [[NSWorkspace sharedWorkspace] runningApplications]) {
+        pid_t pid = [app processIdentifier];
+        AXUIElementRef appRef = AXUIElementCreateApplication(pid);
+        CFArrayRef appWins = NULL;
+
+        AXUIElementCopyAttributeValues(appRef, kAXWindowsAttribute,
+            0, 100, &appWins);
+
+        CFRelease(appRef);
+
+        if (NULL == appWins) continue;
+
+        /* Find windows of application */
+        for (CFIndex i = 0; i < CFArrayGetCount(appWins); ++i) {
+            AXUIElementRef elemRef = (AXUIElementRef)CFArrayGetValueAtIndex(
+                appWins, i);
+            CFArrayRef valuesRef = NULL;
+
+            unsigned long id = tjs_win_source_id((void *)elemRef);
+
+            if (0 == id || kAXErrorSuccess != AXUIElementCopyMultipleAttributeValues(
+                    elemRef, attrsRef, 0, &valuesRef) || NULL == valuesRef)
+            {
+                continue;
+            }
+
+            TjsSnapshotWin *win = tjs_snapshot_add(snapshot);
+
+            if (NULL != win) {
+                CGPoint point = { 0 };
+                CGSize size = { 0 };
+
+                win->id = id;
+                win->pid = pid;
+
+                tjs_win_copy_string(CFArrayGetValueAtIndex(valuesRef, 0),
+                    win->title, sizeof(win->title));
+                tjs_win_copy_string(CFArrayGetValueAtIndex(valuesRef, 1),
+                    win->role, sizeof(win->role));
+                tjs_win_copy_string(CFArrayGetValueAtIndex(valuesRef, 2),
+                    win->subrole, sizeof(win->subrole));
+
+                /* Errors are returned as values of type kAXValueAXErrorType */
+                AXValueGetValue((AXValueRef)CFArrayGetValueAtIndex(valuesRef, 3),
+                    kAXValueCGPointType, &point);
+                AXValueGetValue((AXValueRef)CFArrayGetValueAtIndex(valuesRef, 4),
+                    kAXValueCGSizeType, &size);
+
+                win->x      = point.x;
+                win->y      = point.y;
+                win->width  = size.width;
+                win->height = size.height;
+
+                if (CFEqual(CFArrayGetValueAtIndex(valuesRef, 2),
+                        kAXStandardWindowSubrole))
+                {
+                    win->flags |= TJS_SNAPSHOT_FLAG_NORMAL;
+                }
+
+                if (CFEqual(CFArrayGetValueAtIndex(valuesRef, 1), kAXSheetRole)) {
+                    win->flags |= TJS_SNAPSHOT_FLAG_SHEET;
+                }
+
+                if (tjs_win_is_true(CFArrayGetValueAtIndex(valuesRef, 5))) {
+                    win->flags |= TJS_SNAPSHOT_FLAG_MINIMIZED;
+                }
+
+                if (tjs_win_is_true(CFArrayGetValueAtIndex(valuesRef, 6))) {
+                    win->flags |= TJS_SNAPSHOT_FLAG_HIDDEN;
+                }
+
+                /* Extra round-trips; see above */
+                if (tjs_attr_is_settable(elemRef, kAXPositionAttribute)) {
+                    win->flags |= TJS_SNAPSHOT_FLAG_MOVABLE;
+                }
+
+                if (tjs_attr_is_settable(elemRef, kAXSizeAttribute)) {
+                    win->flags |= TJS_SNAPSHOT_FLAG_RESIZABLE;
+                }
+            }
+
+            CFRelease(valuesRef);
+        }
+
+        CFRelease(appWins);
+    }
+
+    CFRelease(attrsRef);
+
+    return snapshot->nwins;
+}
+
+/**
+ * Fetch filter attributes with one round-trip
+ *
+ * @param[in]     ref    A #AXUIElementRef
+ * @param[inout]  attrs  A #TjsBusAttrs
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+static int tjs_win_source_attrs(void *ref, TjsBusAttrs *attrs) {
+    const void *names[] = {
+        kAXTitleAttribute, kAXRoleAttribute, kAXSubroleAttribute
+    };
+
+    AXUIElementRef elemRef = (AXUIElementRef)ref;
+    CFArrayRef valuesRef = NULL;
+    pid_t pid = 0;
+
+    if (kAXErrorSuccess != AXUIElementGetPid(elemRef, &pid)) return -1;
+
+    CFArrayRef namesRef = CFArrayCreate(NULL, names,
+        sizeof(names) / sizeof(names[0]), &kCFTypeArrayCallBacks);
+
+    AXError result = AXUIElementCopyMultipleAttributeValues(elemRef,
+        namesRef, 0, &valuesRef);
+
+    CFRelease(namesRef);
+
+    if (kAXErrorSuccess != result || NULL == valuesRef) return -1;
+
+    attrs->pid = pid;
+
+    tjs_win_copy_string(CFArrayGetValueAtIndex(valuesRef, 0),
+        attrs->title, sizeof(attrs->title));
+    tjs_win_copy_string(CFArrayGetValueAtIndex(valuesRef, 1),
+        attrs->role, sizeof(attrs->role));
+    tjs_win_copy_string(CFArrayGetValueAtIndex(valuesRef, 2),
+        attrs->subrole, sizeof(attrs->subrole));
+
+    CFRelease(valuesRef);
+
+    return 0;
+}
+
+const TjsWinSource tjs_win_source_ax = {
+    .name = "ax",
+    .ctor = "TjsWin",
+    .id = tjs_win_source_id,
+    .bind = tjs_win_source_bind,
+    .unbind = tjs_win_source_unbind,
+    .equal = tjs_win_source_equal,
+    .snapshot = tjs_win_source_snapshot,
+    .attrs = tjs_win_source_attrs
+};
+
+/**
+ * Keep element alive while queried
+ *
+ * @param[inout]  ref  A #AXUIElementRef
+ **/
+
+static void tjs_win_query_retain(void *ref) {
+    CFRetain((CFTypeRef)ref);
+}
+
+/**
+ * Drop element after query
+ *
+ * @param[inout]  ref  A #AXUIElementRef
+ **/
+
+static void tjs_win_query_release(void *ref) {
+    CFRelease((CFTypeRef)ref);
+}
+
+/**
+ * Set the global messaging timeout once on the system-wide element; this
+ * bounds the time a hung app can hold a worker without touching the shared
+ * window refs, but also applies to AX calls on the main thread
+ *
+ * @param[in]  timeout  Timeout in ms
+ **/
+
+static void tjs_win_query_init(double timeout) {
+    AXUIElementRef systemRef = AXUIElementCreateSystemWide();
+
+    if (NULL != systemRef) {
+        AXUIElementSetMessagingTimeout(systemRef, (float)(timeout / 1000.0));
+
+        CFRelease(systemRef);
+    }
+}
+
+/**
+ * Fetch attribute of element on a query worker; the global messaging
+ * timeout bounds the call, the query deadline is enforced by the caller
+ *
+ * @param[in]     ref      A #AXUIElementRef
+ * @param[in]     pid      Process id
+ * @param[in]     attr     Attribute id
+ * @param[inout]  value    A #TjsQueryValue
+ * @param[in]     timeout  Time left in ms
+ *
+ * @return Query status
+ **/
+
+static int tjs_win_query_fetch(void *ref, int pid, int attr,
+    TjsQueryValue *value, double timeout)
+{
+    CFStringRef names[] = {
+        kAXTitleAttribute, kAXRoleAttribute, kAXSubroleAttribute
+    };
+
+    AXUIElementRef elemRef = (AXUIElementRef)ref;
+    AXError result;
+
+    (void)pid;
+    (void)timeout;
+
+    if (TJS_QUERY_ATTR_FRAME == attr) {
+        CFTypeRef pointRef = NULL, sizeRef = NULL;
+
+        result = AXUIElementCopyAttributeValue(elemRef,
+            kAXPositionAttribute, &pointRef);
+
+        if (kAXErrorSuccess == result) {
+            result = AXUIElementCopyAttributeValue(elemRef,
+                kAXSizeAttribute, &sizeRef);
+        }
+
+        if (kAXErrorSuccess == result) {
+            CGPoint point;
+            CGSize size;
+
+            AXValueGetValue((AXValueRef)pointRef, kAXValueCGPointType, &point);
+            AXValueGetValue((AXValueRef)sizeRef, kAXValueCGSizeType, &size);
+
+            value->frame[0] = point.x;
+            value->frame[1] = point.y;
+            value->frame[2] = size.width;
+            value->frame[3] = size.height;
+        }
+
+        if (NULL != pointRef) CFRelease(pointRef);
+        if (NULL != sizeRef) CFRelease(sizeRef);
+    } else {
+        CFTypeRef valueRef = NULL;
+
+        result = AXUIElementCopyAttributeValue(elemRef, names[attr],
+            &valueRef);
+
+        if (kAXErrorSuccess == result) {
+            tjs_win_copy_string(valueRef, value->str, sizeof(value->str));
+
+            CFRelease(valueRef);
+        }
+    }
+
+    switch (result) {
+        case kAXErrorSuccess:        return TJS_QUERY_STATUS_OK;
+        case kAXErrorCannotComplete: return TJS_QUERY_STATUS_TIMEOUT;
+        default:                     return TJS_QUERY_STATUS_FAILED;
+    }
+}
+
+const TjsQuerySource tjs_query_source_ax = {
+    .name = "ax",
+    .init = tjs_win_query_init,
+    .retain = tjs_win_query_retain,
+    .release = tjs_win_query_release,
+    .fetch = tjs_win_query_fetch
+};
+
 /**
  * Native constructor
  *
@@ -611,6 +986,36 @@ static duk_ret_t tjs_win_prototype_getpid(duk_context *ctx) {
     return 0;
 }
 
+/**
+ * Native win fetch prototype method; queries attribute on a worker and
+ * returns a handle with then(onValue, onError)
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_win_prototype_fetch(duk_context *ctx) {
+    const char *name = duk_require_string(ctx, 0);
+    double timeout = duk_get_number_default(ctx, 1, 0);
+    int attr = tjs_query_attr(name);
+
+    if (0 > attr) {
+        return duk_error(ctx, DUK_ERR_RANGE_ERROR, "Unknown attribute: %s",
+            name);
+    }
+
+    /* Get userdata */
+    TjsWin *win = (TjsWin *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_WIN);
+
+    if (NULL != win && NULL != win->elemRef) {
+        pid_t pid = tjs_attr_get_pid(win->elemRef);
+
+        return tjs_query_push(ctx, win->elemRef, (int)pid, attr, timeout);
+    }
+
+    return 0;
+}
+
 /**
  * Native win toString prototype method
  *
@@ -701,6 +1106,10 @@ void tjs_win_init(duk_context *ctx) {
     duk_push_c_function(ctx, tjs_win_prototype_getpid, 0);
     duk_put_prop_string(ctx, -2, "getPid");
 
+    /* Async */
+    duk_push_c_function(ctx, tjs_win_prototype_fetch, 2);
+    duk_put_prop_string(ctx, -2, "fetch");
+
     duk_push_c_function(ctx, tjs_win_prototype_tostring, 0);
     duk_put_prop_string(ctx, -2, "toString");
 
@@ -0,0 +1,353 @@
+/**
+ * @package TouchJS
+ *
+ * @file Window cache functions
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdint.h>
+
+#include "../touchjs.h"
+
+#include "wincache.h"
+
+#include "../common/registry.h"
+
+/* Defines */
+#define TJS_WINCACHE_KEY(ID) ((void *)(uintptr_t)(ID))
+
+/* Globals */
+static const TjsWinSource *source = NULL;
+static TjsRegistry *byid[TJS_HEAPS_MAX] = { NULL }; ///< Window id -> entry per heap
+static TjsRegistry *byuserdata = NULL;              ///< Userdata -> entry
+static TjsRegistry *byattrs = NULL;                 ///< Window id -> #TjsBusAttrs
+static TjsWincacheStats stats = { 0 };
+
+/**
+ * Helper to get index of heap; objects can't be shared between heaps
+ *
+ * @param[in]  ctx  A #duk_context
+ *
+ * @return Index of the heap in #touch
+ **/
+
+static int tjs_wincache_heap(duk_context *ctx) {
+    for (int i = 1; i < touch.nheaps; i++) {
+        if (ctx == touch.heaps[i]) return i;
+    }
+
+    return 0;
+}
+
+/**
+ * Helper to remove entry from both indices
+ *
+ * @param[inout]  entry  A #TjsWincacheEntry
+ **/
+
+static void tjs_wincache_remove(TjsWincacheEntry *entry) {
+    tjs_registry_remove(byid[entry->heap], TJS_WINCACHE_KEY(entry->id));
+    tjs_registry_remove(byuserdata, entry->userdata);
+
+    free(entry);
+}
+
+/**
+ * Userdata hook; called when a window object is destroyed
+ *
+ * @param[inout]  userdata  A #TjsUserdata
+ **/
+
+static void tjs_wincache_hook(TjsUserdata *userdata) {
+    TjsWincacheEntry *entry = (NULL != byuserdata ?
+        (TjsWincacheEntry *)tjs_registry_find(byuserdata, userdata, NULL) : NULL);
+
+    if (NULL != entry) {
+        stats.finalized++;
+
+        tjs_wincache_remove(entry);
+    }
+
+    if (NULL != source) {
+        source->unbind(userdata);
+    }
+}
+
+/**
+ * Push window object for native ref; re-uses the cached object if any
+ *
+ * @param[inout]  ctx  A #duk_context
+ * @param[in]     ref  Native window ref of the source
+ *
+ * @return Either 1 when pushed; otherwise 0 and undefined is pushed
+ **/
+
+int tjs_wincache_push(duk_context *ctx, void *ref) {
+    unsigned long id = source->id(ref);
+    int heap = tjs_wincache_heap(ctx);
+
+    /* Check cache; pushing revives objects pending finalization */
+    if (0 != id) {
+        TjsWincacheEntry *entry = (TjsWincacheEntry *)tjs_registry_find(
+            byid[heap], TJS_WINCACHE_KEY(id), NULL);
+
+        if (NULL != entry) {
+            stats.hits++;
+
+            duk_push_heapptr(ctx, entry->heapptr);
+
+            return 1;
+        }
+    }
+
+    stats.misses++;
+
+    /* Create new object */
+    duk_get_global_string(ctx, source->ctor);
+    duk_new(ctx, 0);
+
+    duk_get_prop_string(ctx, -1, TJS_SYM_USERDATA);
+    TjsUserdata *userdata = (TjsUserdata *)duk_get_pointer(ctx, -1);
+    duk_pop(ctx);
+
+    if (NULL == userdata) {
+        duk_pop(ctx);
+        duk_push_undefined(ctx);
+
+        return 0;
+    }
+
+    source->bind(userdata, ref);
+
+    /* Windows without id can't be found again */
+    if (0 != id) {
+        TjsWincacheEntry *entry = (TjsWincacheEntry *)calloc(1,
+            sizeof(TjsWincacheEntry));
+
+        entry->id = id;
+        entry->heap = heap;
+        entry->heapptr = duk_get_heapptr(ctx, -1);
+        entry->userdata = userdata;
+
+        tjs_registry_add(byid[heap], TJS_WINCACHE_KEY(id), entry);
+        tjs_registry_add(byuserdata, userdata, entry);
+    }
+
+    return 1;
+}
+
+/**
+ * Evict window of all heaps; the objects stay valid but aren't re-used anymore
+ *
+ * @param[in]  ref  Native window ref of the source
+ **/
+
+void tjs_wincache_evict(void *ref) {
+    unsigned long id = source->id(ref);
+
+    if (0 != id) {
+        free(tjs_registry_remove(byattrs, TJS_WINCACHE_KEY(id)));
+    }
+
+    for (int heap = 0; heap < TJS_HEAPS_MAX && NULL != byid[heap]; heap++) {
+        TjsWincacheEntry *entry = NULL;
+
+        if (0 != id) {
+            entry = (TjsWincacheEntry *)tjs_registry_find(
+                byid[heap], TJS_WINCACHE_KEY(id), NULL);
+        } else {
+            /* Closed windows might not report their id anymore */
+            for (int i = 0; i < tjs_registry_size(byid[heap]) &&
+                    NULL == entry; i++)
+            {
+                TjsWincacheEntry *candidate = (TjsWincacheEntry *)
+                    tjs_registry_get(byid[heap], i);
+
+                if (NULL != candidate &&
+                        source->equal(candidate->userdata, ref))
+                {
+                    entry = candidate;
+                }
+            }
+        }
+
+        if (NULL != entry) {
+            stats.evictions++;
+
+            tjs_wincache_remove(entry);
+        }
+    }
+}
+
+/**
+ * Get filter attributes of window; fetched from the source once and
+ * cached by window id until invalidated or evicted
+ *
+ * @param[in]     ref    Native window ref of the source
+ * @param[inout]  attrs  A #TjsBusAttrs to fill
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+int tjs_wincache_attrs(void *ref, TjsBusAttrs *attrs) {
+    unsigned long id = source->id(ref);
+
+    if (0 != id) {
+        TjsBusAttrs *cached = (TjsBusAttrs *)tjs_registry_find(byattrs,
+            TJS_WINCACHE_KEY(id), NULL);
+
+        if (NULL != cached) {
+            stats.attrhits++;
+
+            *attrs = *cached;
+
+            return 0;
+        }
+    }
+
+    stats.attrmisses++;
+
+    if (NULL == source->attrs || 0 != source->attrs(ref, attrs)) return -1;
+
+    /* Windows without id can't be found again */
+    if (0 != id) {
+        TjsBusAttrs *cached = (TjsBusAttrs *)malloc(sizeof(TjsBusAttrs));
+
+        if (NULL != cached) {
+            *cached = *attrs;
+
+            tjs_registry_add(byattrs, TJS_WINCACHE_KEY(id), cached);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Drop cached attributes of window, e.g. after its title changed
+ *
+ * @param[in]  ref  Native window ref of the source
+ **/
+
+void tjs_wincache_invalidate(void *ref) {
+    unsigned long id = source->id(ref);
+
+    if (0 != id) {
+        free(tjs_registry_remove(byattrs, TJS_WINCACHE_KEY(id)));
+    }
+}
+
+/**
+ * Drop cached attributes of all windows of a terminated app
+ *
+ * @param[in]  pid  Process id
+ *
+ * @return Number of dropped entries
+ **/
+
+int tjs_wincache_purge(int pid) {
+    int npurged = 0;
+
+    if (NULL == byattrs) return 0;
+
+    for (int i = 0; i < tjs_registry_size(byattrs); i++) {
+        TjsBusAttrs *cached = (TjsBusAttrs *)tjs_registry_get(byattrs, i);
+
+        if (NULL != cached && pid == cached->pid) {
+            /* Slots stay in place on removal */
+            free(tjs_registry_remove(byattrs, byattrs->slots[i].key));
+
+            npurged++;
+        }
+    }
+
+    return npurged;
+}
+
+/**
+ * Get number of cached windows of all heaps
+ *
+ * @return Number of entries
+ **/
+
+int tjs_wincache_count(void) {
+    int count = 0;
+
+    for (int heap = 0; heap < TJS_HEAPS_MAX && NULL != byid[heap]; heap++) {
+        count += tjs_registry_count(byid[heap]);
+    }
+
+    return count;
+}
+
+/**
+ * Get number of windows with cached attributes
+ *
+ * @return Number of entries
+ **/
+
+int tjs_wincache_attrcount(void) {
+    return tjs_registry_count(byattrs);
+}
+
+/**
+ * Get cache stats
+ *
+ * @return A #TjsWincacheStats
+ **/
+
+const TjsWincacheStats *tjs_wincache_stats(void) {
+    return &stats;
+}
+
+/**
+ * Init window cache
+ *
+ * @param[in]  winsource  A #TjsWinSource
+ **/
+
+void tjs_wincache_init(const TjsWinSource *winsource) {
+    source = winsource;
+    byuserdata = tjs_registry_new();
+    byattrs = tjs_registry_new();
+
+    for (int heap = 0; heap < TJS_HEAPS_MAX; heap++) {
+        byid[heap] = tjs_registry_new();
+    }
+
+    tjs_userdata_hook(TJS_FLAG_TYPE_WIN, tjs_wincache_hook);
+}
+
+/**
+ * Deinit window cache
+ **/
+
+void tjs_wincache_deinit(void) {
+    /* Entries left over belong to objects still alive */
+    for (int heap = 0; heap < TJS_HEAPS_MAX && NULL != byid[heap]; heap++) {
+        for (int i = 0; i < tjs_registry_size(byid[heap]); i++) {
+            TjsWincacheEntry *entry = (TjsWincacheEntry *)tjs_registry_get(
+                byid[heap], i);
+
+            if (NULL != entry) free(entry);
+        }
+
+        tjs_registry_destroy(byid[heap]);
+
+        byid[heap] = NULL;
+    }
+
+    for (int i = 0; i < tjs_registry_size(byattrs); i++) {
+        free(tjs_registry_get(byattrs, i));
+    }
+
+    tjs_registry_destroy(byuserdata);
+    tjs_registry_destroy(byattrs);
+
+    byuserdata = NULL;
+    byattrs = NULL;
+}
@@ -0,0 +1,49 @@
+/**
+ * @package TouchJS
+ *
+ * @file Window cache header
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#ifndef TJS_WINCACHE_H
+#define TJS_WINCACHE_H 1
+
+/* Includes */
+#include "../libs/duktape/duktape.h"
+#include "../common/userdata.h"
+#include "../common/bus.h"
+
+#include "source.h"
+
+/* Types */
+typedef struct tjs_wincache_entry_t {
+    unsigned long id;
+    int heap;      ///< Index of owning heap
+    void *heapptr; ///< Weak; removed when the object is finalized
+
+    struct tjs_userdata_t *userdata;
+} TjsWincacheEntry;
+
+typedef struct tjs_wincache_stats_t {
+    unsigned long hits, misses, evictions, finalized;
+    unsigned long attrhits, attrmisses;
+} TjsWincacheStats;
+
+/* Methods */
+int tjs_wincache_push(duk_context *ctx, void *ref);
+void tjs_wincache_evict(void *ref);
+int tjs_wincache_attrs(void *ref, TjsBusAttrs *attrs);
+void tjs_wincache_invalidate(void *ref);
+int tjs_wincache_purge(int pid);
+int tjs_wincache_count(void);
+int tjs_wincache_attrcount(void);
+const TjsWincacheStats *tjs_wincache_stats(void);
+
+void tjs_wincache_init(const TjsWinSource *source);
+void tjs_wincache_deinit(void);
+
+#endif /* TJS_WINCACHE_H */
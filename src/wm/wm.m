@@ -10,95 +10,252 @@
  **/
 
 #include "../touchjs.h"
+#include "../touchbar.h"
 
 #include "screen.h"
 #include "win.h"
 #include "attr.h"
 #include "observer.h"
+#include "wincache.h"
+#include "snapshot.h"
+#include "apps.h"
+#include "query.h"
 
 #include "../common/userdata.h"
+#include "../common/gc.h"
+#include "../common/callback.h"
+#include "../common/bus.h"
+#include "../common/coalesce.h"
+#include "../common/timer.h"
 
 /* Globals */
-static NSMutableArray *observers;
-static NSMutableDictionary *registry;
+static id launchObserver = nil, terminateObserver = nil; ///< Workspace notifications
+static int evmove = -1, evresize = -1; ///< Interned ids of coalesced events
+static int evclose = -1, evtitle = -1; ///< Interned ids the window cache follows
 
 /* Types */
 typedef struct tjs_wm_t {
     int flags;
 } TjsWM;
 
-static void tjs_wm_create_win(AXUIElementRef elemRef) {
-    /* Create new TjsWin object */
-    duk_get_global_string(touch.ctx, "TjsWin");
-    duk_new(touch.ctx, 0);
+typedef struct tjs_wm_app_t {
+    AXObserverRef observerRef;
+    AXUIElementRef appRef;
+} TjsWMApp;
 
-    /* Add window ref */
-    TjsWin *win = (TjsWin *)tjs_userdata_from(touch.ctx, TJS_FLAG_TYPE_WIN);
+static void tjs_wm_handle_event(CFStringRef notificationRef,
+    AXUIElementRef elemRef);
 
-    if (NULL != win) {
-        win->elemRef = elemRef;
+/**
+ * Bus handler; pushes window object of event
+ *
+ * @param[inout]  ctx  A #duk_context
+ * @param[inout]  arg  A #AXUIElementRef
+ *
+ * @return Number of pushed arguments
+ **/
+
+static int tjs_wm_push_win(duk_context *ctx, void *arg) {
+    tjs_wincache_push(ctx, arg);
+
+    return 1;
+}
+
+/**
+ * Helper to call subscribed handlers of all heaps
+ *
+ * @param[in]  id       Interned event id
+ * @param[in]  window   Window id
+ * @param[in]  elemRef  A #AXUIElementRef
+ **/
+
+static void tjs_wm_deliver(int id, unsigned long window,
+    AXUIElementRef elemRef)
+{
+    TjsBusEvent event = { 0 };
+
+    event.id = id;
+    event.window = window;
+    event.ref = (void *)elemRef;
+    event.fetch = tjs_wincache_attrs;
+
+    /* Apply changes made by the handlers */
+    if (0 < tjs_bus_emit(touch.bus, &event, tjs_wm_push_win,
+            (void *)elemRef) && 0 == touch.tick)
+    {
+        tjs_touchbar_flush();
     }
 }
 
-static void tjs_wm_add_to_registry(const char *eventName, const char *globalName) {
-    /* Add obversation */
-    NSMutableArray *keys;
-    NSString *objEventName = [[NSString alloc] initWithUTF8String: eventName];
-    NSString *objGlobalName = [[NSString alloc] initWithBytes: globalName
-        length: strlen(globalName) encoding: NSASCIIStringEncoding]; ///< Special handling for \xff
+/**
+ * Coalescer handler; delivers collapsed event and drops the element
+ *
+ * @param[inout]  entry  A #TjsCoalesceEntry
+ * @param[inout]  arg    Unused
+ **/
+
+static void tjs_wm_deliver_coalesced(TjsCoalesceEntry *entry, void *arg) {
+    (void)arg;
 
-    id obj = [registry objectForKey: objEventName];
+    tjs_wm_deliver(entry->event, entry->window, (AXUIElementRef)entry->ref);
 
-    if (obj) {
-        keys = obj;
-    } else {
-        keys = [[NSMutableArray alloc] init];
+    CFRelease((AXUIElementRef)entry->ref);
+}
 
-        [registry setObject: keys forKey: objEventName];
-    }
+/**
+ * Coalescer handler; drops the element of an undelivered event
+ *
+ * @param[inout]  entry  A #TjsCoalesceEntry
+ * @param[inout]  arg    Unused
+ **/
+
+static void tjs_wm_release_coalesced(TjsCoalesceEntry *entry, void *arg) {
+    (void)arg;
 
-    [keys addObject: objGlobalName];
-    [objEventName release];
+    CFRelease((AXUIElementRef)entry->ref);
 }
 
 static void tjs_wm_handle_event(CFStringRef notificationRef, AXUIElementRef elemRef) {
-    const char *eventName = tjs_observer_translate_ref_to_event(notificationRef);
-
-    TJS_LOG_OBSERVER("Handle event: name=%s", eventName);
+    int id = 0;
 
-    /* Check for registered handlers */
-    NSString *objEventName = [[NSString alloc] initWithUTF8String: eventName];
+    if (0 >= (id = tjs_observer_translate_ref_to_id(notificationRef))) {
+        return;
+    }
 
-    id array = [registry objectForKey: objEventName];
+    TJS_LOG_OBSERVER("Handle event: name=%s", tjs_bus_name(touch.bus, id));
 
-        TJS_DSTACK(touch.ctx);
+    tjs_gc_activity(touch.gc);
 
-    if (array) {
-        char globalName[50] = { 0 };
+    /* Cached attributes are stale after title changes */
+    if (evtitle == id) {
+        tjs_wincache_invalidate((void *)elemRef);
+    }
 
-        snprintf(globalName, sizeof(globalName), "\xff_event_%s_cb", eventName);
+    pid_t pid = 0;
 
-        tjs_wm_create_win(elemRef);
+    AXUIElementGetPid(elemRef, &pid);
 
-        TJS_DSTACK(touch.ctx);
+    /* Count per app; stale notifications of unbound events are dropped */
+    int bound = tjs_apps_event(pid, id);
 
-        /* Call registered handlers if any */
-        for (NSString *name in array) {
-            duk_get_global_string(touch.ctx, globalName);
+    /* Call subscribed handlers of all heaps; filters run first */
+    if (bound && tjs_bus_subscribed(touch.bus, id)) {
+        unsigned long window = tjs_win_source_ax.id((void *)elemRef);
 
-            if (duk_is_callable(touch.ctx, -1)) {
-                duk_dup(touch.ctx, -2);
-                duk_pcall(touch.ctx, 1);
-                duk_pop(touch.ctx);
+        /* Collapse move and resize storms; attributes are read on delivery */
+        if (NULL != touch.coalesce && 0 != window &&
+                (evmove == id || evresize == id))
+        {
+            if (1 == tjs_coalesce_add(touch.coalesce, window, pid, id,
+                    (void *)elemRef, tjs_timers_now(touch.timers)))
+            {
+                CFRetain(elemRef);
             }
+
+            tjs_coalesce_arm(touch.coalesce, touch.ctx);
+
+            return;
+        }
+
+        /* Pending frames of the window go first */
+        if (NULL != touch.coalesce && 0 != window) {
+            tjs_coalesce_flush_window(touch.coalesce, window,
+                tjs_timers_now(touch.timers));
         }
 
-        duk_pop(touch.ctx);
+        tjs_wm_deliver(id, window, elemRef);
+    }
+
+    /* Don't hand out the same object for a re-used id */
+    if (evclose == id) {
+        tjs_wincache_evict((void *)elemRef);
     }
+}
+
+/**
+ * Create observer for app
+ *
+ * @param[in]  pid  Process id
+ *
+ * @return Either new #TjsWMApp; otherwise NULL when app isn't ready
+ **/
+
+static void *tjs_wm_app_attach(int pid) {
+    AXObserverRef observerRef = tjs_observer_create_from_pid(pid);
+
+    if (NULL == observerRef) return NULL;
+
+    TjsWMApp *app = (TjsWMApp *)calloc(1, sizeof(TjsWMApp));
+
+    app->observerRef = observerRef;
+    app->appRef = AXUIElementCreateApplication(pid);
 
-    [objEventName release];
+    return app;
 }
 
+/**
+ * Destroy observer of app
+ *
+ * @param[inout]  observer  A #TjsWMApp
+ * @param[in]     pid       Process id
+ **/
+
+static void tjs_wm_app_detach(void *observer, int pid) {
+    TjsWMApp *app = (TjsWMApp *)observer;
+
+    (void)pid;
+
+    tjs_observer_destroy(app->observerRef);
+    CFRelease(app->appRef);
+
+    free(app);
+}
+
+/**
+ * Bind notification of app
+ *
+ * @param[inout]  observer  A #TjsWMApp
+ * @param[in]     pid       Process id
+ * @param[in]     event     Interned event id
+ *
+ * @return Either 0 on success; otherwise -1
+ **/
+
+static int tjs_wm_app_bind(void *observer, int pid, int event) {
+    TjsWMApp *app = (TjsWMApp *)observer;
+
+    (void)pid;
+
+    return tjs_observer_bind(app->observerRef, app->appRef,
+        tjs_bus_name(touch.bus, event), tjs_wm_handle_event);
+}
+
+/**
+ * Unbind notification of app
+ *
+ * @param[inout]  observer  A #TjsWMApp
+ * @param[in]     pid       Process id
+ * @param[in]     event     Interned event id
+ **/
+
+static void tjs_wm_app_unbind(void *observer, int pid, int event) {
+    TjsWMApp *app = (TjsWMApp *)observer;
+
+    (void)pid;
+
+    tjs_observer_unbind(app->observerRef, app->appRef,
+        tjs_bus_name(touch.bus, event));
+}
+
+/* Source */
+static const TjsAppSource tjs_app_source_ax = {
+    .name = "ax",
+    .attach = tjs_wm_app_attach,
+    .detach = tjs_wm_app_detach,
+    .bind = tjs_wm_app_bind,
+    .unbind = tjs_wm_app_unbind
+};
+
 /**
  * Native constructor
  *
@@ -150,20 +307,72 @@ static duk_ret_t tjs_wm_prototype_getwindows(duk_context *ctx) {
         for (NSRunningApplication *app in [[NSWorkspace sharedWorkspace] runningApplications]) {
             AXUIElementRef elemRef = AXUIElementCreateApplication(
                 [app processIdentifier]);
+            CFArrayRef appWins = NULL;
 
-            CFArrayRef appWins;
             AXUIElementCopyAttributeValues(elemRef, kAXWindowsAttribute,
                 0, 100, &appWins);
 
-            if (!appWins) continue;
+            CFRelease(elemRef);
 
-            /* Find windows of application */
+            if (NULL == appWins) continue;
+
+            /* Find windows of application; the cache retains them */
             for (CFIndex i = 0; i < CFArrayGetCount(appWins); ++i) {
-                tjs_wm_create_win(CFArrayGetValueAtIndex(appWins, i));
+                tjs_wincache_push(ctx, (void *)CFArrayGetValueAtIndex(appWins, i));
 
                 /* Finally add to result array */
                 duk_put_prop_index(ctx, aryIdx, nwins++);
             }
+
+            CFRelease(appWins);
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native wm snapshot prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_wm_prototype_snapshot(duk_context *ctx) {
+    /* Get userdata */
+    TjsWM *wm = (TjsWM *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_WM);
+
+    if (NULL != wm) {
+        TJS_LOG_OBJ(wm);
+
+        tjs_snapshot_push(ctx, &tjs_win_source_ax);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Native wm diff prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_wm_prototype_diff(duk_context *ctx) {
+    duk_require_object(ctx, 0);
+
+    /* Get userdata */
+    TjsWM *wm = (TjsWM *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_WM);
+
+    if (NULL != wm) {
+        TJS_LOG_OBJ(wm);
+
+        if (!tjs_snapshot_push_since(ctx, &tjs_win_source_ax, 0)) {
+            return duk_error(ctx, DUK_ERR_TYPE_ERROR, "Snapshot expected");
         }
 
         return 1;
@@ -226,10 +435,31 @@ static duk_ret_t tjs_wm_prototype_getscreens(duk_context *ctx) {
  **/
 
 static duk_ret_t tjs_wm_prototype_observe(duk_context *ctx) {
-    /* Sanity check */
-    duk_require_function(ctx, -1);
-    const char *eventName = duk_require_string(ctx, -2);
+    /* Get userdata */
+    TjsWM *wm = (TjsWM *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_WM);
 
+    if (NULL != wm) {
+        TJS_LOG_OBJ(wm);
+
+        duk_ret_t ret = tjs_bus_observe(ctx, touch.bus, 0);
+
+        /* Bind notifications of the event on all apps */
+        tjs_apps_sync();
+
+        return ret;
+    }
+
+    return 0;
+}
+
+/**
+ * Native wm unobserve prototype method
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
+
+static duk_ret_t tjs_wm_prototype_unobserve(duk_context *ctx) {
     /* Get userdata */
     TjsWM *wm = (TjsWM *)tjs_userdata_get(ctx,
         TJS_FLAG_TYPE_WM);
@@ -237,41 +467,62 @@ static duk_ret_t tjs_wm_prototype_observe(duk_context *ctx) {
     if (NULL != wm) {
         TJS_LOG_OBJ(wm);
 
-        /* Check event name */
-        CFStringRef eventRef = tjs_observer_translate_event_to_ref(eventName);
+        duk_ret_t ret = tjs_bus_unobserve(ctx, touch.bus, 0);
 
-        if (NULL != eventRef) {
-            /* Create global name */
-            char globalName[50] = { 0 };
+        tjs_apps_sync();
 
-            snprintf(globalName, sizeof(globalName), "\xff_event_%s_cb", eventName);
+        return ret;
+    }
 
-            /* Store function globally */
-            duk_put_global_string(ctx, globalName);
-            duk_pop(ctx);
+    return 0;
+}
 
-            tjs_wm_add_to_registry(eventName, globalName);
+/**
+ * Native wm getApps prototype method; observed apps and their event rates
+ *
+ * @param[inout]  ctx  A #duk_context
+ **/
 
-            TJS_LOG_OBSERVER("Added event: name=%s", eventName);
-        }
+static duk_ret_t tjs_wm_prototype_getapps(duk_context *ctx) {
+    /* Get userdata */
+    TjsWM *wm = (TjsWM *)tjs_userdata_get(ctx,
+        TJS_FLAG_TYPE_WM);
+
+    if (NULL != wm) {
+        TJS_LOG_OBJ(wm);
+
+        tjs_apps_push(ctx);
+
+        return 1;
     }
 
     return 0;
 }
 
 /**
- * Native wm unobserve prototype method
+ * Native wm getStats prototype method; counters of the token or totals
  *
  * @param[inout]  ctx  A #duk_context
  **/
 
-static duk_ret_t tjs_wm_prototype_unobserve(duk_context *ctx) {
+static duk_ret_t tjs_wm_prototype_getstats(duk_context *ctx) {
     /* Get userdata */
     TjsWM *wm = (TjsWM *)tjs_userdata_get(ctx,
         TJS_FLAG_TYPE_WM);
 
     if (NULL != wm) {
         TJS_LOG_OBJ(wm);
+
+        int totals = (!duk_is_valid_index(ctx, 0) ||
+            duk_is_undefined(ctx, 0));
+        duk_ret_t ret = tjs_bus_getstats(ctx, touch.bus, 0);
+
+        /* Totals include the raw events before coalescing */
+        if (NULL != touch.coalesce && totals) {
+            tjs_coalesce_putstats(ctx, touch.coalesce, -1);
+        }
+
+        return ret;
     }
 
     return 0;
@@ -341,11 +592,19 @@ void tjs_wm_init(duk_context *ctx) {
     duk_put_prop_string(ctx, -2, "getWindows");
     duk_push_c_function(ctx, tjs_wm_prototype_getscreens, 0);
     duk_put_prop_string(ctx, -2, "getScreens");
+    duk_push_c_function(ctx, tjs_wm_prototype_snapshot, 0);
+    duk_put_prop_string(ctx, -2, "snapshot");
+    duk_push_c_function(ctx, tjs_wm_prototype_diff, 1);
+    duk_put_prop_string(ctx, -2, "diff");
 
-    duk_push_c_function(ctx, tjs_wm_prototype_observe, 2);
+    duk_push_c_function(ctx, tjs_wm_prototype_observe, 3);
     duk_put_prop_string(ctx, -2, "observe");
     duk_push_c_function(ctx, tjs_wm_prototype_unobserve, 1);
     duk_put_prop_string(ctx, -2, "unobserve");
+    duk_push_c_function(ctx, tjs_wm_prototype_getstats, DUK_VARARGS);
+    duk_put_prop_string(ctx, -2, "getStats");
+    duk_push_c_function(ctx, tjs_wm_prototype_getapps, 0);
+    duk_put_prop_string(ctx, -2, "getApps");
 
     duk_push_c_function(ctx, tjs_wm_prototype_istrusted, 0);
     duk_put_prop_string(ctx, -2, "isTrusted");
@@ -356,28 +615,54 @@ void tjs_wm_init(duk_context *ctx) {
     duk_put_prop_string(ctx, -2, "prototype");
     duk_put_global_string(ctx, "TjsWM");
 
-    /* Create observers */
-    observers = [[NSMutableArray alloc] init];
-    registry = [[NSMutableDictionary alloc] init];
+    /* Observers are shared by all heaps */
+    if (nil != launchObserver) return;
+
+    tjs_apps_init(&tjs_app_source_ax, ctx);
+    tjs_query_init(&tjs_query_source_ax, ctx, touch.workers);
+    tjs_observer_intern(touch.bus);
+
+    evmove = tjs_bus_lookup(touch.bus, "win_move");
+    evresize = tjs_bus_lookup(touch.bus, "win_resize");
+    evclose = tjs_bus_lookup(touch.bus, "win_close");
+    evtitle = tjs_bus_lookup(touch.bus, "win_title");
+
+    /* Cache eviction and invalidation mustn't depend on subscriptions */
+    tjs_apps_event_keep(evclose);
+    tjs_apps_event_keep(evtitle);
+
+    if (NULL != touch.coalesce) {
+        touch.coalesce->deliver = tjs_wm_deliver_coalesced;
+        touch.coalesce->release = tjs_wm_release_coalesced;
+    }
+
+    /* Follow launches and exits; notifications are bound on observe */
+    NSNotificationCenter *center = [[NSWorkspace sharedWorkspace]
+        notificationCenter];
+
+    launchObserver = [center
+        addObserverForName: NSWorkspaceDidLaunchApplicationNotification
+        object: nil queue: nil usingBlock: ^(NSNotification *note) {
+            NSRunningApplication *app = [[note userInfo]
+                objectForKey: NSWorkspaceApplicationKey];
+
+            tjs_apps_launch([app processIdentifier],
+                [[app localizedName] UTF8String]);
+        }];
+
+    terminateObserver = [center
+        addObserverForName: NSWorkspaceDidTerminateApplicationNotification
+        object: nil queue: nil usingBlock: ^(NSNotification *note) {
+            NSRunningApplication *app = [[note userInfo]
+                objectForKey: NSWorkspaceApplicationKey];
+
+            tjs_apps_terminate([app processIdentifier]);
+        }];
 
     /* Find running applications */
     for (NSRunningApplication *app in [[NSWorkspace sharedWorkspace] runningApplications]) {
-        /* Create observer */
-        pid_t pid = [app processIdentifier];
-
-        AXUIElementRef appRef = AXUIElementCreateApplication(pid);
-        AXObserverRef observerRef = tjs_observer_create_from_pid(pid);
-
-        /* Bind events */
-        tjs_observer_bind(observerRef, appRef, "win_open", tjs_wm_handle_event);
-        tjs_observer_bind(observerRef, appRef, "win_move", tjs_wm_handle_event);
-        tjs_observer_bind(observerRef, appRef, "win_focus", tjs_wm_handle_event);
-        tjs_observer_bind(observerRef, appRef, "win_title", tjs_wm_handle_event);
-        tjs_observer_bind(observerRef, appRef, "win_close", tjs_wm_handle_event);
-        tjs_observer_bind(observerRef, appRef, "win_resize", tjs_wm_handle_event);
-
-        [observers addObject: [NSValue value: observerRef
-            withObjCType: @encode(AXObserverRef)]];
+        tjs_apps_launch([app processIdentifier],
+            [[app localizedName] UTF8String]);
     }
 }
 
@@ -386,13 +671,15 @@ void tjs_wm_init(duk_context *ctx) {
  **/
 
 void tjs_wm_deinit(void) {
-    /* Release observers */
-    for (int i = 0; i < [observers count]; i++) {
-        AXObserverRef observerRef = (AXObserverRef)([[observers objectAtIndex: i] pointerValue]);
+    NSNotificationCenter *center = [[NSWorkspace sharedWorkspace]
+        notificationCenter];
 
-        CFRelease(observerRef);
-    }
-    [observers release];
+    [center removeObserver: launchObserver];
+    [center removeObserver: terminateObserver];
+
+    launchObserver = terminateObserver = nil;
 
-    [registry release];
+    /* Wait for queries in flight; then release observers */
+    tjs_query_deinit();
+    tjs_apps_deinit();
 }
\ No newline at end of file
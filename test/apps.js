@@ -0,0 +1,116 @@
+/* App observer lifecycle; run with -F -S 0 -w 5000 */
+function app(pid) {
+    return tjs_fake_getApps().filter(function (a) {
+        return pid === a.pid;
+    })[0];
+}
+
+/* Attached on launch; only the events the cache follows are bound */
+tjs_fake_launch(500, "Mail");
+tjs_fake_open(10, "Inbox", null, { pid: 500 });
+
+var mail = app(500);
+
+assert("attached" === mail.state &&
+    "win_title,win_close" === mail.bound.join(),
+    "launch: " + JSON.stringify(mail));
+
+tjs_fake_emit("win_move", 10);
+
+assert(0 === app(500).events, "unbound events don't arrive");
+
+/* Subscribing binds the notification on all apps */
+var token = tjs_fake_observe("win_move", record("move"));
+
+assert("win_move,win_title,win_close" === app(500).bound.join(),
+    "bound on observe: " + JSON.stringify(app(500)));
+
+tjs_fake_emit("win_move", 10);
+tjs_fake_emit("win_focus", 10);
+
+assert("move:10" === calls.join(), "bound events: " + calls.join());
+assert(1 === app(500).events, "counted: " + JSON.stringify(app(500)));
+
+/* Windows of unknown pids launch their app */
+tjs_fake_open(20, "Scratch");
+
+assert("app1020" === app(1020).name &&
+    "win_move,win_title,win_close" === app(1020).bound.join(),
+    "implicit launch: " + JSON.stringify(app(1020)));
+
+/* Apps that aren't ready are retried with backoff */
+tjs_fake_launch(600, "Slow", { failAttach: 2 });
+tjs_fake_launch(700, "Stuck", { failAttach: 100 });
+
+assert("pending" === app(600).state && 1 === app(600).attempts,
+    "pending: " + JSON.stringify(app(600)));
+
+var failed = false;
+
+try {
+    tjs_fake_launch(600, "Twice");
+} catch (e) {
+    failed = true;
+}
+
+assert(failed, "launch running pid");
+
+tjs_setTimeout(function () {
+    /* Retried at 50ms and 150ms */
+    var slow = app(600);
+
+    assert("attached" === slow.state && 2 === slow.attempts &&
+        "win_move,win_title,win_close" === slow.bound.join(),
+        "retried: " + JSON.stringify(slow));
+    assert("pending" === app(700).state, "still pending");
+}, 200);
+
+tjs_setTimeout(function () {
+    /* Attempts at 0, 50, 150, 350 and 750ms */
+    assert("failed" === app(700).state && 5 === app(700).attempts,
+        "gave up: " + JSON.stringify(app(700)));
+
+    /* Rates of a busy app */
+    var n = 0, timer = tjs_setInterval(function () {
+        tjs_fake_emit("win_move", 10);
+
+        if (220 === ++n) tjs_clearTimer(timer);
+    }, 10);
+}, 1000);
+
+tjs_setTimeout(function () {
+    var mail = app(500);
+
+    assert(221 === mail.events, "events: " + JSON.stringify(mail));
+    assert(90 <= mail.rate && 110 >= mail.rate && mail.peak >= mail.rate,
+        "rate: " + JSON.stringify(mail));
+
+    /* Unsubscribing unbinds everywhere */
+    tjs_fake_unobserve(token);
+
+    assert("win_title,win_close" === app(500).bound.join() &&
+        "win_title,win_close" === app(600).bound.join(),
+        "unbound: " + JSON.stringify(tjs_fake_getApps()));
+
+    calls = [];
+
+    tjs_fake_emit("win_move", 10);
+
+    assert(0 === calls.length && 221 === app(500).events, "dropped");
+
+    /* Terminate detaches and takes the windows along without events */
+    var inbox = tjs_fake_getWindows().filter(function (w) {
+        return 10 === w.getId();
+    })[0];
+
+    tjs_fake_observe("win_close", record("close"));
+
+    tjs_fake_terminate(500);
+
+    assert(undefined === app(500), "forgotten");
+    assert(!inbox.isOpen() && 0 === calls.length, "windows gone");
+
+    tjs_print("apps: " + JSON.stringify(tjs_fake_getApps().map(function (a) {
+        return a.name + "=" + a.state;
+    })));
+}, 4000);
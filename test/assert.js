@@ -0,0 +1,13 @@
+/* Shared test helpers; load with -f before the test file */
+function assert(cond, msg) {
+    if (!cond) throw new Error("Assertion failed: " + msg);
+}
+
+/* Event recorder; tests reset calls between steps */
+var calls = [];
+
+function record(tag, format) {
+    return function (win) {
+        calls.push(tag + ":" + (format ? format(win) : win.getId()));
+    };
+}
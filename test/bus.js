@@ -0,0 +1,83 @@
+/* Event bus: multiple subscribers, tokens, patterns and filters */
+tjs_fake_open(1, "Terminal");
+tjs_fake_open(2, "Browser");
+
+/* Second subscriber doesn't replace the first; each fires once */
+var t1 = tjs_fake_observe("win_focus", record("a"));
+var t2 = tjs_fake_observe("win_focus", record("b"));
+
+assert(0 < t1 && t1 !== t2, "distinct tokens");
+
+tjs_fake_emit("win_focus", 1);
+
+assert("a:1,b:1" === calls.join(), "both in order: " + calls.join());
+
+/* Unsubscribe by token */
+calls = [];
+
+assert(true === tjs_fake_unobserve(t1), "unobserve");
+assert(false === tjs_fake_unobserve(t1), "unobserve twice");
+
+tjs_fake_emit("win_focus", 1);
+
+assert("b:1" === calls.join(), "removed handler: " + calls.join());
+
+/* Stale token of a re-used slot doesn't remove the new handler */
+var t3 = tjs_fake_observe("win_move", record("c"));
+
+assert(t3 !== t1, "new token for re-used slot");
+assert(false === tjs_fake_unobserve(t1), "stale token");
+
+/* Wildcard and prefix patterns run after exact handlers */
+calls = [];
+
+var t4 = tjs_fake_observe("*", record("any"));
+var t5 = tjs_fake_observe("win_*", record("win"));
+var t6 = tjs_fake_observe("app_*", record("app"));
+
+tjs_fake_emit("win_move", 2);
+
+assert("c:2,any:2,win:2" === calls.join(), "patterns: " + calls.join());
+
+/* Window filter */
+calls = [];
+
+tjs_fake_observe("win_title", record("t"), { window: 2 });
+
+tjs_fake_emit("win_title", 1);
+tjs_fake_emit("win_title", 2);
+
+assert("any:1,win:1,t:2,any:2,win:2" === calls.join(),
+    "filter: " + calls.join());
+
+/* Handlers may unsubscribe themselves and others while dispatching */
+calls = [];
+
+[ t2, t3, t4, t5, t6 ].forEach(tjs_fake_unobserve);
+
+var once = tjs_fake_observe("win_open", function (win) {
+    calls.push("once:" + win.getId());
+
+    tjs_fake_unobserve(once);
+    tjs_fake_unobserve(other);
+
+    /* Added while dispatching; called next time */
+    tjs_fake_observe("win_open", record("late"));
+});
+var other = tjs_fake_observe("win_open", record("other"));
+
+tjs_fake_emit("win_open", 1);
+tjs_fake_emit("win_open", 2);
+
+assert("once:1,late:2" === calls.join(), "reentrant: " + calls.join());
+
+/* Unknown events are rejected */
+var failed = false;
+
+try {
+    tjs_fake_observe("win_unknown", record("x"));
+} catch (e) {
+    failed = true;
+}
+
+assert(failed, "unknown event");
@@ -0,0 +1,59 @@
+/* Dispatch throughput of the event bus against the fake window source;
+ * target is 100k events/s with a mix of exact, pattern and filtered
+ * subscriptions */
+var N = 100000, TARGET = 100000;
+var calls = 0;
+
+function handler(win) {
+    calls++;
+}
+
+for (var i = 1; i <= 8; i++) {
+    tjs_fake_open(i, "Window " + i);
+}
+
+/* Exact handlers on the hot event, some on others */
+for (var i = 0; i < 4; i++) {
+    tjs_fake_observe("win_move", handler);
+    tjs_fake_observe("win_focus", handler);
+}
+
+/* Patterns and filters only match part of the stream */
+tjs_fake_observe("win_*", handler);
+tjs_fake_observe("win_move", handler, { window: 1 });
+
+var events = [ "win_move", "win_move", "win_move", "win_title" ];
+var start = Date.now();
+
+for (var i = 0; i < N; i++) {
+    tjs_fake_emit(events[i & 3], 1 + (i & 7));
+}
+
+var elapsed = Math.max(1, Date.now() - start);
+var rate = N * 1000 / elapsed;
+
+tjs_print("busbench: events=" + N + ", calls=" + calls + ", elapsed=" +
+    elapsed + "ms, rate=" + rate.toFixed(0) + "/s, per event=" +
+    (elapsed * 1000 / N).toFixed(2) + "us, target=" + TARGET + "/s " +
+    (rate >= TARGET ? "ok" : "missed"));
+
+/* Title storm of a noisy app; native filters keep it out of JS */
+var entered = 0;
+
+tjs_fake_observe("win_title", function (win) {
+    entered++;
+}, { pid: 1001, subrole: "AXStandardWindow" });
+
+start = Date.now();
+
+for (var i = 0; i < N; i++) {
+    tjs_fake_emit("win_title", 1 + (i & 7));
+}
+
+elapsed = Math.max(1, Date.now() - start);
+
+var stats = tjs_fake_getStats();
+
+tjs_print("busbench: storm events=" + N + ", entered=" + entered +
+    ", elapsed=" + elapsed + "ms, rate=" + (N * 1000 / elapsed).toFixed(0) +
+    "/s, fetches=" + stats.fetches);
@@ -0,0 +1,50 @@
+/* Command spawn rate and cache hit latency; run with: -w 30000 */
+var NCMDS = 200, NHITS = 20000;
+
+function report(name, count, start) {
+    var elapsed = Math.max(Date.now() - start, 1);
+
+    tjs_print(name + ": count=" + count + ", elapsed=" + elapsed +
+        "ms, rate=" + Math.round(count * 1000 / elapsed) + "/s, latency=" +
+        (elapsed * 1000 / count).toFixed(2) + "us");
+}
+
+/* Spawn rate with and without the login shell; runs one after another */
+function spawn(name, opts, next) {
+    var start = Date.now(), ndone = 0;
+
+    opts.onExit = function () {
+        if (NCMDS === ++ndone) {
+            report(name, NCMDS, start);
+
+            if (next) next();
+        }
+    };
+
+    for (var i = 0; i < NCMDS; i++) {
+        new TjsCommand("true").exec(opts);
+    }
+}
+
+spawn("spawn(shell)", {}, function () {
+    spawn("spawn(direct)", { direct: true }, function () {
+        var cmd = new TjsCommand("echo cached");
+
+        /* Fill cache, then only hits */
+        cmd.exec({ ttl: 60000 }).getOutput();
+
+        var start = Date.now();
+
+        for (var i = 0; i < NHITS; i++) {
+            cmd.exec({ ttl: 60000 });
+        }
+
+        report("hit", NHITS, start);
+
+        var stats = tjs_commandstats();
+
+        tjs_print("stats: limit=" + stats.limit + ", spawned=" +
+            stats.spawned + ", waited=" + stats.waited + ", hits=" +
+            stats.hits + ", misses=" + stats.misses);
+    });
+});
@@ -0,0 +1,89 @@
+/* Command slots and output cache; run with: -x 2 -w 5000 */
+var stats = tjs_commandstats(), done = {}, peak = 0;
+
+assert(2 === stats.limit, "limit: " + stats.limit);
+
+/* Direct exec splits words and skips the shell */
+var direct = new TjsCommand("printf '%s-%s' a \"b c\"");
+
+assert("a-b c" === direct.exec({ direct: true }).getOutput(),
+    "direct: " + direct.getOutput());
+
+new TjsCommand("/nonexistent/touchjs").exec({
+    direct: true,
+    onError: function (msg) { done.error = msg; }
+});
+
+assert(undefined !== done.error, "direct error");
+
+/* Callers of the same line share one child */
+var shared = [], spawned = tjs_commandstats().spawned;
+
+for (var i = 0; i < 5; i++) {
+    new TjsCommand("sleep 0.05; echo $$").exec({
+        ttl: 1000,
+        onExit: function (status) {
+            shared.push(this.getOutput());
+            peak = Math.max(peak, tjs_commandstats().running);
+        }
+    });
+}
+
+stats = tjs_commandstats();
+
+assert(spawned + 1 === stats.spawned, "spawned once: " + stats.spawned);
+assert(4 === stats.shared, "shared: " + stats.shared);
+
+/* Slots limit running children; the rest waits */
+for (var i = 0; i < 6; i++) {
+    new TjsCommand("sleep 0.02").exec({
+        onExit: function () {
+            done.slots = (done.slots || 0) + 1;
+            peak = Math.max(peak, tjs_commandstats().running);
+        }
+    });
+}
+
+assert(0 < tjs_commandstats().queued, "queued: " + tjs_commandstats().queued);
+
+/* Blocking on a queued command skips the line */
+var queued = new TjsCommand("echo queued").exec();
+
+assert(queued.isRunning(), "queued is pending");
+assert("queued\n" === queued.getOutput(), "queued output");
+
+tjs_setTimeout(function () {
+    assert(5 === shared.length, "shared results: " + shared.length);
+
+    for (var i = 1; i < shared.length; i++) {
+        assert(shared[0] === shared[i], "same output: " + shared);
+    }
+
+    assert(6 === done.slots, "slots: " + done.slots);
+    assert(2 >= peak, "peak: " + peak);
+
+    /* Cached output arrives before exec returns */
+    var hit, misses = tjs_commandstats().misses;
+
+    new TjsCommand("sleep 0.05; echo $$").exec({
+        ttl: 1000,
+        onData: function (chunk) { hit = chunk; }
+    });
+
+    assert(shared[0] === hit, "hit: " + hit);
+    assert(1 === tjs_commandstats().hits, "hits");
+    assert(misses === tjs_commandstats().misses, "no miss");
+
+    /* Expired output runs again */
+    var again = new TjsCommand("sleep 0.05; echo $$").exec({ ttl: 0 });
+
+    assert(again.isRunning(), "expired runs");
+    assert(shared[0] !== again.getOutput(), "new output");
+    assert(1 === tjs_commandstats().expired, "expired");
+
+    stats = tjs_commandstats();
+
+    tjs_print("cmdcache: hits=" + stats.hits + ", misses=" + stats.misses +
+        ", shared=" + stats.shared + ", waited=" + stats.waited +
+        ", peak=" + peak);
+}, 500);
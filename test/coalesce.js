@@ -0,0 +1,97 @@
+/* Coalescing of move/resize storms; run with -F -S 0 -C 16:50 */
+tjs_fake_open(1, "Editor", [ 0, 0, 640, 480 ]);
+tjs_fake_open(2, "Terminal", [ 0, 0, 320, 240 ]);
+tjs_fake_open(3, "Viewer", [ 0, 0, 100, 100 ]);
+
+function frame(win) {
+    return win.getId() + ":" + win.getFrame().join("/");
+}
+
+tjs_fake_observe("win_move", record("move", frame));
+tjs_fake_observe("win_resize", record("resize", frame));
+tjs_fake_observe("win_close", record("close", frame));
+
+/* Burst collapses per window and event type; nothing is sent right away */
+for (var i = 1; i <= 10; i++) {
+    tjs_fake_move(1, [ i, i, 640, 480 ]);
+    tjs_fake_emit("win_move", 1);
+}
+
+for (var i = 1; i <= 5; i++) {
+    tjs_fake_move(1, [ 10, 10, 640 + i, 480 ]);
+    tjs_fake_emit("win_resize", 1);
+}
+
+tjs_fake_move(2, [ 5, 5, 320, 240 ]);
+tjs_fake_emit("win_move", 2);
+tjs_fake_emit("win_move", 2);
+
+assert(0 === calls.length, "deferred: " + calls.join());
+
+var stats = tjs_fake_getStats();
+
+assert(17 === stats.raw && 0 === stats.coalesced && 3 === stats.pending,
+    "raw stats: " + JSON.stringify(stats));
+
+/* Close delivers pending frames of the window first */
+tjs_fake_move(3, [ 7, 7, 100, 100 ]);
+tjs_fake_emit("win_move", 3);
+tjs_fake_emit("win_close", 3);
+
+assert("move:3:7/7/100/100,close:3:7/7/100/100" === calls.join(),
+    "close order: " + calls.join());
+
+calls = [];
+
+/* Quiet period passed; one call each with the latest frame */
+tjs_setTimeout(function () {
+    assert("move:1:10/10/645/480,resize:1:10/10/645/480,move:2:5/5/320/240" ===
+        calls.join(), "quiet: " + calls.join());
+
+    stats = tjs_fake_getStats();
+
+    assert(18 === stats.raw && 4 === stats.coalesced && 0 === stats.pending,
+        "delivered stats: " + JSON.stringify(stats));
+
+    calls = [];
+
+    /* Storm that never goes quiet is cut at max delay */
+    var x = 0, timer = tjs_setInterval(function () {
+        tjs_fake_move(2, [ ++x, 0, 320, 240 ]);
+        tjs_fake_emit("win_move", 2);
+
+        if (12 === x) tjs_clearTimer(timer);
+    }, 7);
+}, 20);
+
+tjs_setTimeout(function () {
+    /* Moves at 27..104ms: cut at 77ms (x=8), then quiet at 120ms (x=12) */
+    assert("move:2:8/0/320/240,move:2:12/0/320/240" === calls.join(),
+        "max delay: " + calls.join());
+
+    calls = [];
+
+    /* Pending frames of a terminated app are dropped, not delivered */
+    tjs_fake_launch(800, "Doomed");
+    tjs_fake_open(4, "Dialog", [ 0, 0, 50, 50 ], { pid: 800 });
+    tjs_fake_move(4, [ 1, 1, 50, 50 ]);
+    tjs_fake_emit("win_move", 4);
+
+    stats = tjs_fake_getStats();
+
+    assert(1 === stats.pending, "pending before terminate: " +
+        JSON.stringify(stats));
+
+    tjs_fake_terminate(800);
+
+    stats = tjs_fake_getStats();
+
+    assert(0 === stats.pending && 1 === stats.dropped,
+        "dropped on terminate: " + JSON.stringify(stats));
+}, 200);
+
+tjs_setTimeout(function () {
+    assert(0 === calls.length, "stale delivery: " + calls.join());
+
+    tjs_print("coalesce: " + JSON.stringify(tjs_fake_getStats()));
+}, 300);
@@ -0,0 +1,84 @@
+/* Commands; run with: -w 5000 */
+/* Blocking use still works */
+var sync = new TjsCommand("echo sync; exit 3");
+
+assert("sync\n" === sync.exec().getOutput(), "sync output");
+assert(3 === sync.getStatus(), "sync status: " + sync.getStatus());
+
+/* Handlers finishing other commands while one is drained */
+var nested = {};
+
+var a = new TjsCommand("sleep 0.05; echo a").exec({
+    onExit: function () { nested.a = true; }
+});
+
+var c = new TjsCommand("sleep 0.1; echo c").exec({
+    onExit: function () { nested.c = true; }
+});
+
+var b = new TjsCommand("echo b").exec({
+    onData: function () { nested.inner = a.getOutput(); },
+    onExit: function () { nested.b = true; }
+});
+
+b.getOutput();
+
+assert("a\n" === nested.inner && nested.a && nested.b, "nested finish");
+assert(c.isRunning() && !nested.c, "other command untouched");
+
+/* Streaming; the script keeps running while children do */
+var chunks = [], done = {}, ticks = 0;
+
+new TjsCommand("for i in 1 2 3; do echo line$i; sleep 0.05; done").exec({
+    onData: function (chunk) { chunks.push(chunk); },
+    onExit: function (status) { done.stream = status; }
+});
+
+/* Collected output of async command */
+var quiet = new TjsCommand("printf quiet").exec({
+    onExit: function (status) { done.quiet = this.getOutput(); }
+});
+
+/* Many children share one poll */
+for (var i = 0; i < 20; i++) {
+    new TjsCommand("echo " + i).exec({
+        onExit: function () { done.many = (done.many || 0) + 1; }
+    });
+}
+
+/* Exit status of killed child */
+new TjsCommand("kill -9 $$").exec({
+    onExit: function (status) { done.killed = status; }
+});
+
+assert(quiet.isRunning(), "async returns immediately");
+
+/* Handler finishing its own command */
+var self = new TjsCommand("echo one; sleep 0.05; echo two").exec({
+    onData: function () {
+        if (undefined === nested.self) {
+            nested.self = false;
+            this.getOutput();
+            nested.self = !this.isRunning();
+        }
+    },
+    onExit: function (status) { nested.selfStatus = status; }
+});
+
+var timer = tjs_setInterval(function () { ticks++; }, 20);
+
+tjs_setTimeout(function () {
+    tjs_clearTimer(timer);
+
+    assert("line1\nline2\nline3\n" === chunks.join(""), "stream: " + chunks);
+    assert(1 < chunks.length, "streamed in chunks: " + chunks.length);
+    assert(0 === done.stream, "stream status");
+    assert("quiet" === done.quiet, "collected: " + done.quiet);
+    assert(20 === done.many, "many: " + done.many);
+    assert(137 === done.killed, "killed: " + done.killed);
+    assert(3 < ticks, "timers ran meanwhile: " + ticks);
+    assert(nested.c && !c.isRunning(), "nested: c settled");
+    assert(nested.self && 0 === nested.selfStatus, "nested: self");
+
+    tjs_print("command: chunks=" + chunks.length + ", ticks=" + ticks);
+}, 500);
@@ -0,0 +1,35 @@
+/* Window handlers for replaying test/drag.trace; run with:
+ * -R test/drag.trace -w 200 [-C QUIET[:MAXDELAY]] */
+[
+    [ 1, "Editor", [ 100, 100, 800, 600 ] ],
+    [ 2, "Terminal", [ 900, 100, 600, 400 ] ],
+    [ 3, "Browser", [ 200, 500, 1024, 768 ] ]
+].forEach(function (w) {
+    tjs_fake_open(w[0], w[1], w[2]);
+});
+
+var l1 = new TjsLabel("");
+
+tjs_attach(l1);
+
+/* Snap to the nearest grid cell and show it, like a tiling helper */
+function snap(win) {
+    var frame = win.getFrame(), best = null, dist = Infinity;
+
+    for (var col = 0; col < 12; col++) {
+        for (var row = 0; row < 8; row++) {
+            var dx = frame[0] - col * 160, dy = frame[1] - row * 135,
+                d = dx * dx + dy * dy;
+
+            if (d < dist) {
+                dist = d;
+                best = col + "x" + row;
+            }
+        }
+    }
+
+    l1.setValue(win.getTitle() + " " + best + " " + frame[2] + "x" + frame[3]);
+}
+
+tjs_fake_observe("win_move", snap);
+tjs_fake_observe("win_resize", snap);
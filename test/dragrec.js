@@ -0,0 +1,49 @@
+/* Records a drag session for replay; run with:
+ * -S 0 -w 2600 -T test/drag.trace -f test/dragrec.js
+ * Two windows are dragged at once, then one is resized; the fake source
+ * sends one event per step like AX does during live drags */
+var windows = [
+    [ 1, "Editor", [ 100, 100, 800, 600 ] ],
+    [ 2, "Terminal", [ 900, 100, 600, 400 ] ],
+    [ 3, "Browser", [ 200, 500, 1024, 768 ] ]
+];
+
+windows.forEach(function (w) {
+    tjs_fake_open(w[0], w[1], w[2]);
+});
+
+function gesture(id, event, at, steps, interval, step) {
+    tjs_setTimeout(function () {
+        var n = 0, timer = tjs_setInterval(function () {
+            var frame = windows[id - 1][2];
+
+            step(frame, ++n);
+
+            tjs_fake_move(id, frame);
+            tjs_fake_emit(event, id);
+
+            if (steps === n) tjs_clearTimer(timer);
+        }, interval);
+    }, at);
+}
+
+function move(frame, n) {
+    frame[0] += 3 + (n % 4);
+    frame[1] += (n % 3) - 1;
+}
+
+function resize(frame, n) {
+    frame[2] += 2;
+    frame[3] += (0 === n % 2 ? 1 : 0);
+}
+
+/* Overlapping drags at ~120Hz and ~60Hz */
+gesture(1, "win_move", 100, 90, 8, move);
+gesture(2, "win_move", 300, 45, 16, move);
+
+/* Resize storm after a pause */
+gesture(3, "win_resize", 1300, 120, 6, resize);
+
+/* Short flicks */
+gesture(1, "win_move", 2100, 20, 8, move);
+gesture(2, "win_move", 2200, 20, 8, move);
@@ -0,0 +1,155 @@
+/* Native observe filters against the fake window source */
+tjs_fake_open(1, "Terminal", null, { pid: 100 });
+tjs_fake_open(2, "Browser - News", null, { pid: 200 });
+tjs_fake_open(3, "Inspector", null, { pid: 200, subrole: "AXFloatingWindow" });
+tjs_fake_open(4, "Save", null, { pid: 200, role: "AXSheet", subrole: "" });
+
+var byPid = tjs_fake_observe("win_move", record("pid"), { pid: 200 });
+var bySubrole = tjs_fake_observe("win_move", record("std"),
+    { subrole: "AXStandardWindow" });
+var byRole = tjs_fake_observe("win_move", record("sheet"), { role: "AXSheet" });
+var byTitle = tjs_fake_observe("win_title", record("title"),
+    { titleRegex: /^browser/i });
+var byBoth = tjs_fake_observe("win_move", record("both"),
+    { pid: 200, titleRegex: "News$" });
+
+for (var id = 1; id <= 4; id++) {
+    tjs_fake_emit("win_move", id);
+}
+
+assert("std:1,pid:2,std:2,both:2,pid:3,pid:4,sheet:4" === calls.join(),
+    "attribute filters: " + calls.join());
+
+/* Counters per subscription */
+var stats = tjs_fake_getStats(byPid);
+
+assert(4 === stats.seen && 3 === stats.passed && 1 === stats.dropped,
+    "pid stats: " + JSON.stringify(stats));
+
+stats = tjs_fake_getStats(byRole);
+
+assert(4 === stats.seen && 1 === stats.passed && 3 === stats.dropped,
+    "role stats: " + JSON.stringify(stats));
+
+/* Attributes are fetched once per window and cached */
+var wincache = tjs_memstats().wincache;
+
+assert(4 === wincache.attrMisses, "one fetch per window: " +
+    JSON.stringify(wincache));
+
+calls = [];
+
+tjs_fake_emit("win_move", 2);
+
+assert(4 === tjs_memstats().wincache.attrMisses, "cached attributes");
+
+/* Title events refresh the cached title */
+calls = [];
+
+tjs_fake_emit("win_title", 2);
+tjs_fake_setTitle(2, "Mail");
+tjs_fake_emit("win_title", 2);
+tjs_fake_setTitle(1, "browser");
+tjs_fake_emit("win_title", 1);
+
+assert("title:2,title:1" === calls.join(), "title regex: " + calls.join());
+
+/* Invalid regex */
+var failed = false;
+
+try {
+    tjs_fake_observe("win_move", record("x"), { titleRegex: "(" });
+} catch (e) {
+    failed = true;
+}
+
+assert(failed, "invalid regex");
+
+calls = [];
+
+[ byPid, bySubrole, byRole, byTitle, byBoth ].forEach(tjs_fake_unobserve);
+
+/* Cache follows titles and closes without subscriptions to them */
+var byFocus = tjs_fake_observe("win_focus", record("focus"),
+    { titleRegex: "^Draft" });
+
+tjs_fake_setTitle(3, "Draft");
+tjs_fake_emit("win_title", 3);
+tjs_fake_emit("win_focus", 3);
+
+assert("focus:3" === calls.join(), "fresh title: " + calls.join());
+
+var attrs = tjs_memstats().wincache.attrs;
+
+tjs_fake_emit("win_close", 4);
+
+assert(attrs - 1 === tjs_memstats().wincache.attrs, "evicted on close: " +
+    JSON.stringify(tjs_memstats().wincache));
+
+/* Windows of terminated apps go without close events */
+tjs_fake_terminate(200);
+
+assert(attrs - 3 === tjs_memstats().wincache.attrs, "purged on terminate: " +
+    JSON.stringify(tjs_memstats().wincache));
+
+tjs_fake_unobserve(byFocus);
+
+/* RegExp objects are translated to POSIX; unsupported features throw */
+calls = [];
+
+tjs_fake_setTitle(1, "Build 42");
+tjs_fake_emit("win_title", 1);
+
+var byClass = tjs_fake_observe("win_move", record("class"),
+    { titleRegex: /^build\s\d+$/i });
+var byBracket = tjs_fake_observe("win_move", record("bracket"),
+    { titleRegex: /^\w+ [\d]{2}$/ });
+
+tjs_fake_emit("win_move", 1);
+
+assert("class:1,bracket:1" === calls.join(), "translated: " + calls.join());
+
+tjs_fake_unobserve(byClass);
+tjs_fake_unobserve(byBracket);
+
+var unsupported = [ "(?:a)b", "a+?", "\\bword", "a(?=b)", "(a)\\1", "[\\D]" ];
+
+unsupported.forEach(function (re) {
+    var threw = false;
+
+    try {
+        tjs_fake_observe("win_move", record("x"),
+            { titleRegex: new RegExp(re) });
+    } catch (e) {
+        threw = (e instanceof SyntaxError);
+    }
+
+    assert(threw, "unsupported: " + re);
+});
+
+/* Min interval drops events in between; fake clock only moves on timers */
+calls = [];
+
+var limited = tjs_fake_observe("win_move", record("rate"),
+    { minIntervalMs: 100 });
+
+for (var i = 0; i < 10; i++) {
+    tjs_fake_emit("win_move", 1);
+}
+
+assert("rate:1" === calls.join(), "rate limited: " + calls.join());
+
+tjs_setTimeout(function () {
+    tjs_fake_emit("win_move", 1);
+
+    stats = tjs_fake_getStats(limited);
+
+    if (11 !== stats.seen || 2 !== stats.passed || 9 !== stats.dropped) {
+        throw new Error("Assertion failed: interval stats: " +
+            JSON.stringify(stats));
+    }
+
+    var totals = tjs_fake_getStats();
+
+    tjs_print("filter: " + JSON.stringify(totals));
+}, 150);
@@ -0,0 +1,25 @@
+/* One app with a large retained state and a button making cyclic garbage;
+ * load several copies into one or more heaps with -I and
+ * run with: -g click -n 20000 */
+(function () {
+    var state = [];
+
+    for (var i = 0; i < 20000; i++) {
+        state.push({ id: i, name: "item" + i, tags: [ i, i * 2 ] });
+    }
+
+    var l1 = new TjsLabel("0");
+    var b1 = new TjsButton("Click").bind(function () {
+        /* Cycles are left to mark-and-sweep */
+        for (var i = 0; i < 50; i++) {
+            var a = { n: i }, b = { prev: a };
+
+            a.next = b;
+        }
+
+        l1.setValue(String(state.length));
+    });
+
+    tjs_attach(l1);
+    tjs_attach(b1);
+})();
@@ -0,0 +1,12 @@
+/* Heap isolation; load assert.js and this file into each of two heaps
+ * with -I 2 */
+var fired = false, id = tjs_setTimeout(function () { fired = true; }, 10);
+var pending = tjs_timerstats().pending;
+
+/* Ids are shared by all heaps; timers of the other one are out of reach */
+for (var other = 0; other < id; other++) tjs_clearTimer(other);
+
+assert(pending === tjs_timerstats().pending, "cleared foreign timers: " +
+    JSON.stringify(tjs_timerstats()));
+
+tjs_setTimeout(function () { assert(fired, "own timer fired"); }, 20);
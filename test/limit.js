@@ -0,0 +1,22 @@
+/* Per-heap memory limit; load assert.js and this file into each of
+ * two heaps with -I 2 -m 1M */
+var chunks = [], stats = tjs_memstats();
+
+assert(0 < stats.limit && stats.heap < stats.limit, "limit: " +
+    JSON.stringify(stats));
+
+/* Fill this heap up to its own limit and keep everything alive */
+try {
+    for (;;) chunks.push(new Uint8Array(16 * 1024));
+} catch (e) {
+    assert(/alloc failed/.test(e.message), "alloc failed: " + e);
+}
+
+stats = tjs_memstats();
+
+/* Memory held by the other heap doesn't count here */
+assert(0 < stats.denied && stats.heap <= stats.limit &&
+    stats.limit / 2 < chunks.length * 16 * 1024, "filled: " +
+    chunks.length + " " + JSON.stringify(stats));
+
+tjs_print("limit: chunks=" + chunks.length + " " + JSON.stringify(stats));
@@ -0,0 +1,15 @@
+/* Logging throughput; run with: -l print,info and with or without -o FILE */
+var count = 200000, payload = "";
+
+for (var i = 0; i < 8; i++) payload += "0123456789";
+
+var start = Date.now();
+
+for (var i = 0; i < count; i++) {
+    tjs_print("logbench " + i + " " + payload);
+}
+
+var elapsed = Math.max(Date.now() - start, 1);
+
+tjs_print("logbench: count=" + count + ", elapsed=" + elapsed + "ms, rate=" +
+    Math.round(count / elapsed * 1000) + "/s");
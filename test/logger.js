@@ -0,0 +1,13 @@
+/* Async JSON log; run with: -l print:5,error -o FILE */
+var long = "";
+
+for (var i = 0; i < 2000; i++) long += "x";
+
+/* Long messages are not truncated */
+tjs_print(long);
+
+/* Control characters and quotes are escaped */
+tjs_print("say \"hi\"\tand\nbye");
+
+/* Rate limit leaves three messages of this burst */
+for (var i = 0; i < 20; i++) tjs_print("burst " + i);
@@ -0,0 +1,70 @@
+/* Engine micro-benchmarks; compare build profiles with touchjs-benchsuite */
+var N = 100000;
+
+function bench(name, n, fn) {
+    var start = Date.now();
+
+    fn(n);
+
+    var elapsed = Math.max(Date.now() - start, 1);
+
+    tjs_print(name + ": ops=" + n + ", elapsed=" + elapsed + "ms, rate=" +
+        Math.round(n * 1000 / elapsed) + "/s");
+}
+
+var sink = 0;
+
+/* Integer math like slider handlers do */
+bench("intmath", N * 10, function (n) {
+    var x = 0;
+
+    for (var i = 0; i < n; i++) {
+        x = (x + parseInt(255 * (i % 101) / 100)) & 0xffff;
+    }
+
+    sink += x;
+});
+
+bench("property", N * 10, function (n) {
+    var o = { red: 1, green: 2, blue: 3 };
+
+    for (var i = 0; i < n; i++) {
+        o.red = o.green + o.blue;
+        o.blue = o.red - i;
+    }
+
+    sink += o.red;
+});
+
+bench("call", N * 5, function (n) {
+    function rgb(r, g, b) { return (r << 16) | (g << 8) | b; }
+
+    for (var i = 0; i < n; i++) sink ^= rgb(i & 255, i & 127, i & 63);
+});
+
+bench("string", N, function (n) {
+    var s = "";
+
+    for (var i = 0; i < n; i++) {
+        s = "CPU " + (i % 100) + "%";
+    }
+
+    sink += s.length;
+});
+
+bench("json", N / 10, function (n) {
+    var o = { id: 1, title: "Window", frame: [0, 0, 800, 600] };
+
+    for (var i = 0; i < n; i++) {
+        o.id = i;
+        sink += JSON.parse(JSON.stringify(o)).id;
+    }
+});
+
+bench("native", N, function (n) {
+    var l = new TjsLabel("bench");
+
+    for (var i = 0; i < n; i++) {
+        l.setFgColor(i & 255, 0, 0);
+    }
+});
@@ -0,0 +1,43 @@
+/* Changes of one callback reach the backend in one flush; run with -w 100 */
+var N = 10, labels = [], buttons = [], before;
+
+for (var i = 0; i < N; i++) {
+    labels.push(new TjsLabel("Label " + i));
+    buttons.push(new TjsButton("Button " + i));
+
+    tjs_attach(labels[i]);
+    tjs_attach(buttons[i]);
+}
+
+function delta(ops, name) {
+    return ops[name] - before[name];
+}
+
+tjs_setTimeout(function () {
+    before = tjs_headless_ops();
+
+    /* Repeated changes of a widget collapse into its last state */
+    for (var i = 0; i < N; i++) {
+        labels[i].setFgColor(255, 0, 0).setValue("First " + i);
+        labels[i].setFgColor(0, 255, 0).setValue("Second " + i);
+
+        buttons[i].setBgColor(0, 0, 255).setBgColor(255, 255, 0);
+    }
+
+    var ops = tjs_headless_ops();
+
+    assert(0 === delta(ops, "fg") + delta(ops, "bg") + delta(ops, "value"),
+        "nothing applied before the flush: " + JSON.stringify(ops));
+}, 10);
+
+tjs_setTimeout(function () {
+    var ops = tjs_headless_ops();
+
+    assert(N === delta(ops, "fg"), "fg: " + delta(ops, "fg"));
+    assert(N === delta(ops, "bg"), "bg: " + delta(ops, "bg"));
+    assert(N === delta(ops, "value"), "value: " + delta(ops, "value"));
+    assert(0 === delta(ops, "create") && 0 === delta(ops, "destroy"),
+        "no rebuild: " + JSON.stringify(ops));
+
+    tjs_print("ops: " + JSON.stringify(ops));
+}, 50);
@@ -0,0 +1,28 @@
+/* Callback profiler; run with: -p FILE -w 1000 -e click:0 */
+function busy(ms) {
+    var end = Date.now() + ms;
+
+    while (Date.now() < end) {}
+}
+
+tjs_fake_open(1, "Terminal");
+
+function onFocus(win) {
+    busy(10);
+}
+
+function onClick() {
+    busy(20);
+}
+
+function outer() {
+    busy(5);
+
+    /* Nested transition shows up as child frame */
+    tjs_fake_emit("win_focus", 1);
+    tjs_fake_emit("win_focus", 1);
+}
+
+tjs_fake_observe("win_focus", onFocus);
+tjs_attach(new TjsButton("Busy").bind(onClick));
+tjs_setTimeout(outer, 0);
@@ -0,0 +1,118 @@
+/* Async attribute queries; run with -A 2 -S 0 -w 3000 */
+function win(id) {
+    return tjs_fake_getWindows().filter(function (w) {
+        return id === w.getId();
+    })[0];
+}
+
+tjs_fake_launch(700, "Editor", { latency: 5 });
+tjs_fake_launch(701, "Frozen", { latency: 2000 });
+
+tjs_fake_open(70, "main.c", [ 10, 20, 640, 480 ], { pid: 700 });
+tjs_fake_open(71, "Makefile", null, { pid: 700, subrole: "AXDialog" });
+tjs_fake_open(80, "Spinner", null, { pid: 701 });
+tjs_fake_open(72, "Scratch", null, { pid: 700 });
+
+var threw = false;
+
+try {
+    win(70).fetch("color");
+} catch (e) {
+    threw = (e instanceof RangeError);
+}
+
+assert(threw, "unknown attribute");
+
+var results = [];
+
+function settle(tag) {
+    return function (value) {
+        results.push({ tag: tag, ok: true, value: value, q: this });
+    };
+}
+
+function fail(tag) {
+    return function (err) {
+        results.push({ tag: tag, ok: false, value: err, q: this });
+    };
+}
+
+/* Hung app queues first and holds one worker at most */
+var frozen = [];
+
+for (var i = 0; i < 3; i++) {
+    frozen.push(win(80).fetch("title", 100).then(settle("frozen" + i),
+        fail("frozen" + i)));
+}
+
+var title = win(70).fetch("title").then(settle("title"), fail("title"));
+
+win(70).fetch("frame").then(settle("frame"), fail("frame"));
+win(71).fetch("subrole").then(settle("subrole"), fail("subrole"));
+
+assert(700 === title.pid && "title" === title.attr && 0 < title.id,
+    "handle: " + JSON.stringify(title));
+assert(0 === results.length, "nothing is delivered synchronously");
+
+/* Window closed before the worker gets to it */
+var scratch = win(72);
+
+tjs_fake_emit("win_close", 72);
+
+scratch.fetch("title").then(settle("closed"), fail("closed"));
+
+function dump(r) {
+    return (r ? r.tag + ":" + r.ok + ":" + r.value + ":" + r.q.status : "none");
+}
+
+function find(tag) {
+    return results.filter(function (r) { return tag === r.tag; })[0];
+}
+
+tjs_setTimeout(function () {
+    /* Other apps are served while the hung one times out */
+    var t = find("title"), f = find("frame"), s = find("subrole");
+
+    assert(t && t.ok && "main.c" === t.value, "title: " + dump(t));
+    assert(f && f.ok && "10/20/640/480" === f.value.join("/"),
+        "frame: " + dump(f));
+    assert(s && s.ok && "AXDialog" === s.value, "subrole: " + dump(s));
+    assert(t.q.elapsed < 100 && f.q.elapsed < 100 && s.q.elapsed < 100,
+        "not blocked: " + [ t.q.elapsed, f.q.elapsed, s.q.elapsed ]);
+
+    var c = find("closed");
+
+    assert(c && !c.ok && "failed" === c.q.status, "closed: " + dump(c));
+    assert(undefined === find("frozen0"), "hung app still pending");
+}, 60);
+
+tjs_setTimeout(function () {
+    for (var i = 0; i < 3; i++) {
+        var r = find("frozen" + i);
+
+        assert(r && !r.ok && "timeout" === r.q.status &&
+            /^Timeout/.test(r.value.message), "frozen: " + dump(r));
+        assert(100 <= r.q.elapsed && 400 > r.q.elapsed,
+            "deadline: " + r.q.elapsed);
+    }
+
+    /* Settled handles call back right away, once */
+    var calls = 0;
+
+    title.then(function (value) {
+        calls++;
+        assert("main.c" === value, "late then: " + value);
+    });
+
+    title.then(null, function () { calls++; });
+
+    assert(1 === calls, "late then calls: " + calls);
+
+    var stats = tjs_querystats();
+
+    assert(2 === stats.workers && 7 === stats.submitted && 3 === stats.ok &&
+        1 === stats.failed && 3 === stats.timeouts && 0 === stats.pending,
+        "stats: " + JSON.stringify(stats));
+
+    tjs_print("query: " + JSON.stringify(stats));
+}, 500);
@@ -0,0 +1,81 @@
+/* Tail latency of attribute queries with one hung app; run with -S 0 */
+var ROUNDS = 50, INTERVAL = 20, TIMEOUT = 100;
+
+var healthy = [], hung;
+
+for (var pid = 900; pid < 904; pid++) {
+    tjs_fake_launch(pid, "app" + pid, { latency: 1 });
+
+    for (var i = 0; i < 2; i++) {
+        var id = (pid - 900) * 10 + i + 1;
+
+        tjs_fake_open(id, "Window " + id, null, { pid: pid });
+    }
+}
+
+tjs_fake_launch(950, "Hung", { latency: 5000 });
+tjs_fake_open(99, "Beachball", null, { pid: 950 });
+
+tjs_fake_getWindows().forEach(function (w) {
+    if (99 === w.getId()) {
+        hung = w;
+    } else {
+        healthy.push(w);
+    }
+});
+
+function percentile(values, p) {
+    var sorted = values.slice().sort(function (a, b) { return a - b; });
+
+    return sorted[Math.min(sorted.length - 1,
+        Math.floor(p / 100 * sorted.length))];
+}
+
+function report(phase, values) {
+    tjs_print("querybench: phase=" + phase + " queries=" + values.length +
+        " p50=" + percentile(values, 50).toFixed(3) + "ms" +
+        " p99=" + percentile(values, 99).toFixed(3) + "ms" +
+        " max=" + percentile(values, 100).toFixed(3) + "ms");
+}
+
+function phase(name, withHung, next) {
+    var lat = [], timeouts = 0, round = 0, outstanding = 0;
+
+    function settle() {
+        if (0 === --outstanding && ROUNDS === round) {
+            report(name, lat);
+
+            if (withHung) tjs_print("querybench: hung timeouts=" + timeouts);
+            if (next) next();
+        }
+    }
+
+    var timer = tjs_setInterval(function () {
+        healthy.forEach(function (w) {
+            outstanding++;
+
+            w.fetch("title", TIMEOUT).then(function () {
+                lat.push(this.elapsed);
+                settle();
+            }, function () {
+                lat.push(this.elapsed);
+                settle();
+            });
+        });
+
+        if (withHung) {
+            outstanding++;
+
+            hung.fetch("title", TIMEOUT).then(settle, function () {
+                timeouts++;
+                settle();
+            });
+        }
+
+        if (ROUNDS === ++round) tjs_clearTimer(timer);
+    }, INTERVAL);
+}
+
+phase("healthy", false, function () {
+    phase("hung", true, null);
+});
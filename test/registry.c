@@ -0,0 +1,237 @@
+/**
+ * @package TouchJS
+ *
+ * @file Registry tests
+ * @copyright (c) 2019-present Christoph Kappel <christoph@unexist.dev>
+ * @version $Id$
+ *
+ * This program can be distributed under the terms of the GNU GPLv2.
+ * See the file COPYING for details.
+ **/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../src/common/registry.h"
+
+/* Defines */
+#define TJS_KEY(N) ((void *)(uintptr_t)(N))
+#define TJS_CHECK(COND) \
+    do { \
+        if (!(COND)) { \
+            fprintf(stderr, "%s:%d: Check failed: %s\n", __FILE__, __LINE__, \
+                #COND); \
+            failed++; \
+        } \
+    } while (0)
+
+/* Globals */
+static int failed = 0;
+
+/**
+ * Helper to get bucket of the slot of key
+ *
+ * @param[in]  registry  A #TjsRegistry
+ * @param[in]  key       Key to look up
+ *
+ * @return Either bucket; otherwise -1
+ **/
+
+static int tjs_test_bucket(TjsRegistry *registry, void *key) {
+    int idx = -1;
+
+    tjs_registry_find(registry, key, &idx);
+
+    for (int i = 0; -1 != idx && i < registry->nbuckets; i++) {
+        if (idx == registry->buckets[i]) return i;
+    }
+
+    return -1;
+}
+
+/**
+ * Helper to check that every live slot is linked exactly once
+ *
+ * @param[in]  registry  A #TjsRegistry
+ *
+ * @return Either 1 when consistent; otherwise 0
+ **/
+
+static int tjs_test_consistent(TjsRegistry *registry) {
+    int nlinked = 0, nlive = 0;
+
+    for (int i = 0; i < registry->nbuckets; i++) {
+        if (-1 != registry->buckets[i]) nlinked++;
+    }
+
+    for (int i = 0; i < tjs_registry_size(registry); i++) {
+        void *key = registry->slots[i].key;
+
+        if (NULL == key) continue;
+
+        nlive++;
+
+        if (tjs_registry_get(registry, i) != tjs_registry_find(registry,
+                key, NULL))
+        {
+            return 0;
+        }
+    }
+
+    /* No tombstones: removed entries leave no linked bucket behind */
+    return (nlinked == nlive && nlive == tjs_registry_count(registry));
+}
+
+/**
+ * Add, find and remove
+ **/
+
+static void tjs_test_basic(void) {
+    TjsRegistry *registry = tjs_registry_new();
+    int idx = 0;
+
+    TJS_CHECK(0 == tjs_registry_add(registry, TJS_KEY(1), "one"));
+    TJS_CHECK(1 == tjs_registry_add(registry, TJS_KEY(2), "two"));
+    TJS_CHECK(-1 == tjs_registry_add(registry, NULL, "null"));
+    TJS_CHECK(2 == tjs_registry_count(registry));
+
+    TJS_CHECK(NULL != tjs_registry_find(registry, TJS_KEY(2), &idx) &&
+        1 == idx);
+    TJS_CHECK(NULL == tjs_registry_find(registry, TJS_KEY(3), &idx) &&
+        -1 == idx);
+    TJS_CHECK(NULL == tjs_registry_find(NULL, TJS_KEY(1), NULL));
+
+    TJS_CHECK(0 == strcmp("one", tjs_registry_remove(registry, TJS_KEY(1))));
+    TJS_CHECK(NULL == tjs_registry_remove(registry, TJS_KEY(1)));
+    TJS_CHECK(NULL == tjs_registry_find(registry, TJS_KEY(1), NULL));
+    TJS_CHECK(NULL == tjs_registry_get(registry, 0));
+    TJS_CHECK(1 == tjs_registry_count(registry));
+    TJS_CHECK(tjs_test_consistent(registry));
+
+    tjs_registry_destroy(registry);
+}
+
+/**
+ * Colliding keys stay reachable when the head of their chain goes
+ **/
+
+static void tjs_test_backshift(void) {
+    TjsRegistry *probe = tjs_registry_new();
+    TjsRegistry *registry = tjs_registry_new();
+    uintptr_t keys[4] = { 0 };
+    int nkeys = 0, home = -1;
+
+    /* Find keys sharing a home bucket; alone they land there */
+    for (uintptr_t key = 1; key < 100000 && 4 > nkeys; key++) {
+        tjs_registry_add(probe, TJS_KEY(key), TJS_KEY(key));
+
+        int bucket = tjs_test_bucket(probe, TJS_KEY(key));
+
+        tjs_registry_remove(probe, TJS_KEY(key));
+
+        if (-1 == home) home = bucket;
+        if (home == bucket) keys[nkeys++] = key;
+    }
+
+    TJS_CHECK(4 == nkeys);
+
+    for (int i = 0; i < nkeys; i++) {
+        tjs_registry_add(registry, TJS_KEY(keys[i]), TJS_KEY(keys[i]));
+    }
+
+    /* Chain occupies home onwards */
+    int mask = registry->nbuckets - 1;
+
+    for (int i = 0; i < nkeys; i++) {
+        TJS_CHECK(((home + i) & mask) ==
+            tjs_test_bucket(registry, TJS_KEY(keys[i])));
+    }
+
+    /* Removing the head and the middle shifts the rest back */
+    tjs_registry_remove(registry, TJS_KEY(keys[0]));
+    tjs_registry_remove(registry, TJS_KEY(keys[2]));
+
+    TJS_CHECK(home == tjs_test_bucket(registry, TJS_KEY(keys[1])));
+    TJS_CHECK(((home + 1) & mask) ==
+        tjs_test_bucket(registry, TJS_KEY(keys[3])));
+    TJS_CHECK(-1 == registry->buckets[(home + 2) & mask]);
+    TJS_CHECK(tjs_test_consistent(registry));
+
+    tjs_registry_destroy(probe);
+    tjs_registry_destroy(registry);
+}
+
+/**
+ * Removed slots are re-used last in, first out
+ **/
+
+static void tjs_test_freelist(void) {
+    TjsRegistry *registry = tjs_registry_new();
+
+    for (uintptr_t key = 1; key <= 4; key++) {
+        tjs_registry_add(registry, TJS_KEY(key), TJS_KEY(key));
+    }
+
+    tjs_registry_remove(registry, TJS_KEY(2));
+    tjs_registry_remove(registry, TJS_KEY(4));
+
+    TJS_CHECK(3 == tjs_registry_add(registry, TJS_KEY(5), TJS_KEY(5)));
+    TJS_CHECK(1 == tjs_registry_add(registry, TJS_KEY(6), TJS_KEY(6)));
+    TJS_CHECK(4 == tjs_registry_add(registry, TJS_KEY(7), TJS_KEY(7)));
+    TJS_CHECK(5 == tjs_registry_size(registry));
+    TJS_CHECK(TJS_KEY(6) == tjs_registry_get(registry, 1));
+    TJS_CHECK(tjs_test_consistent(registry));
+
+    tjs_registry_destroy(registry);
+}
+
+/**
+ * Slots and buckets grow; interleaved removals keep everything reachable
+ **/
+
+static void tjs_test_growth(void) {
+    TjsRegistry *registry = tjs_registry_new();
+    int nbuckets = registry->nbuckets, n = 5000;
+
+    for (uintptr_t key = 1; key <= (uintptr_t)n; key++) {
+        TJS_CHECK((int)key - 1 == tjs_registry_add(registry,
+            TJS_KEY(key * 8), TJS_KEY(key)));
+    }
+
+    TJS_CHECK(n == tjs_registry_count(registry));
+    TJS_CHECK(n <= registry->maxslots);
+    TJS_CHECK(nbuckets < registry->nbuckets &&
+        2 * n <= registry->nbuckets);
+
+    for (uintptr_t key = 1; key <= (uintptr_t)n; key += 3) {
+        TJS_CHECK(TJS_KEY(key) == tjs_registry_remove(registry,
+            TJS_KEY(key * 8)));
+    }
+
+    for (uintptr_t key = 1; key <= (uintptr_t)n; key++) {
+        void *value = tjs_registry_find(registry, TJS_KEY(key * 8), NULL);
+
+        TJS_CHECK((1 == key % 3 ? NULL : TJS_KEY(key)) == value);
+    }
+
+    TJS_CHECK(n == tjs_registry_size(registry));
+    TJS_CHECK(tjs_test_consistent(registry));
+
+    tjs_registry_destroy(registry);
+}
+
+/**
+ * Main entry point
+ **/
+
+int main(void) {
+    tjs_test_basic();
+    tjs_test_backshift();
+    tjs_test_freelist();
+    tjs_test_growth();
+
+    printf("registry: %s\n", (0 == failed ? "ok" : "failed"));
+
+    return (0 == failed ? 0 : 1);
+}
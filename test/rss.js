@@ -0,0 +1,46 @@
+/* Flat memory over many exec/getOutput cycles; Linux only */
+var NCYCLES = 100000, NSPAWNS = 500, WARMUP = 10000;
+var big = new TjsCommand("seq 1 5000"), small = new TjsCommand("echo small");
+var label = new TjsLabel("rss"), rss = 0, expect = big.exec({ direct: true }).getOutput();
+
+assert(expect.length > 4096, "large output: " + expect.length);
+
+for (var i = 0; i < NCYCLES; i++) {
+    var cmd = (0 === i % 2 ? big : small);
+
+    /* Spawn now and then, otherwise serve from cache */
+    if (0 === i % (NCYCLES / NSPAWNS)) {
+        cmd.exec({ direct: true });
+    } else {
+        cmd.exec({ direct: true, ttl: 60000 });
+    }
+
+    var output = cmd.getOutput();
+
+    if (big === cmd) assert(expect === output, "output of cycle " + i);
+
+    /* Polled label values and throwaway widgets */
+    label.setValue(output.substr(0, 8));
+    new TjsLabel("tmp" + i);
+    new TjsButton("tmp" + i);
+
+    if (WARMUP === i) {
+        Duktape.gc();
+
+        rss = tjs_memstats().rss;
+    }
+}
+
+Duktape.gc();
+
+var stats = tjs_memstats(), cstats = tjs_commandstats();
+var growth = stats.rss - rss;
+
+tjs_print("rss: cycles=" + NCYCLES + ", spawned=" + cstats.spawned +
+    ", hits=" + cstats.hits + ", start=" + Math.round(rss / 1024) +
+    "k, end=" + Math.round(stats.rss / 1024) + "k, growth=" +
+    Math.round(growth / 1024) + "k, labels=" + stats.objects.label);
+
+assert(0 < rss, "rss available");
+assert(growth < 1024 * 1024, "rss growth: " + growth);
+assert(2 > stats.objects.label, "labels finalized: " + stats.objects.label);
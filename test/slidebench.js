@@ -0,0 +1,38 @@
+/* Synthetic drag across sliders with different slide policies;
+ * run with: -g slide -r 1000 -n 4000 -w 5000 */
+var policies = [
+    { name: "none" },
+    { name: "maxHz=60", opts: { maxHz: 60 } },
+    { name: "maxHz=30", opts: { maxHz: 30 } },
+    { name: "debounce=50", opts: { debounce: 50 } }
+];
+
+var l1 = new TjsLabel("Drag");
+
+policies.forEach(function (policy) {
+    policy.calls = 0;
+    policy.slider = new TjsSlider(0).bind(function (value) {
+        var c = parseInt(255 * value / 100);
+
+        policy.calls++;
+        policy.last = value;
+
+        l1.setFgColor(c, c, c);
+    }, policy.opts);
+
+    tjs_attach(policy.slider);
+});
+
+tjs_attach(l1);
+
+/* Report once the drag is over */
+tjs_setTimeout(function () {
+    policies.forEach(function (policy) {
+        var stats = policy.slider.getStats() || {};
+
+        tjs_print(policy.name + ": calls=" + policy.calls + ", final=" +
+            (policy.last === policy.slider.getPercent()) + ", coalesced=" +
+            (stats.coalesced || 0) + ", lag=" + (stats.lag || 0).toFixed(1) +
+            "ms, maxLag=" + (stats.maxLag || 0).toFixed(1) + "ms");
+    });
+}, 4500);
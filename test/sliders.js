@@ -0,0 +1,16 @@
+var l1 = new TjsLabel("Sliders");
+
+/* Create sliders */
+for (var i = 0; i < 50; i++) {
+    var s = new TjsSlider(0)
+        .bind(function (value) {
+            var c = parseInt(255 * value / 100);
+
+            l1.setFgColor(c, c, c);
+        });
+
+    tjs_attach(s);
+}
+
+/* Attach */
+tjs_attach(l1);
@@ -0,0 +1,37 @@
+/* Snapshot and diff throughput against the fake window source */
+var NWINS = 1000, ROUNDS = 200, MOVES = 50;
+
+for (var id = 1; id <= NWINS; id++) {
+    tjs_fake_open(id, "Window " + id, [id % 1920, id % 1080, 800, 600]);
+}
+
+function bench(name, rounds, fn) {
+    var start = Date.now();
+
+    for (var i = 0; i < rounds; i++) fn(i);
+
+    var elapsed = Math.max(Date.now() - start, 1);
+
+    tjs_print(name + ": rounds=" + rounds + ", elapsed=" + elapsed +
+        "ms, rate=" + Math.round(rounds * 1000 / elapsed) + "/s");
+}
+
+bench("snapshot(" + NWINS + ")", ROUNDS, function () {
+    tjs_fake_snapshot();
+});
+
+var snap = tjs_fake_snapshot();
+
+bench("diff(" + NWINS + ", " + MOVES + " moved)", ROUNDS, function (round) {
+    for (var i = 0; i < MOVES; i++) {
+        var id = 1 + (round * MOVES + i) % NWINS;
+
+        tjs_fake_move(id, [round, i, 800, 600]);
+    }
+
+    snap = tjs_fake_diff(snap).snapshot;
+});
+
+bench("getWindows(" + NWINS + ")", ROUNDS / 10, function () {
+    snap.getWindows().filter(function (win) { return win.normal; });
+});
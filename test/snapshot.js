@@ -0,0 +1,33 @@
+/* Window snapshots and diffing against the fake window source */
+tjs_fake_open(3, "Editor", [0, 0, 800, 600]);
+tjs_fake_open(1, "Terminal", [10, 10, 640, 480]);
+tjs_fake_open(2, "Browser", [100, 0, 1024, 768]);
+
+var snap = tjs_fake_snapshot();
+
+assert(3 === snap.size(), "three windows");
+assert(1 === snap.getWindows()[0].id, "sorted by id");
+assert("Browser" === snap.getWindow(2).title, "lookup by id");
+assert(snap.getWindow(2).normal, "normal flag");
+assert(undefined === snap.getWindow(42), "unknown id");
+
+/* Open, close and move */
+tjs_fake_open(4, "Mail");
+tjs_fake_emit("win_close", 3);
+tjs_fake_move(1, [20, 10, 640, 480]);
+
+var diff = tjs_fake_diff(snap);
+
+assert(1 === diff.opened.length && 4 === diff.opened[0].id, "opened");
+assert(1 === diff.closed.length && 3 === diff.closed[0].id, "closed");
+assert(1 === diff.moved.length && 1 === diff.moved[0].id, "moved");
+assert(20 === diff.moved[0].frame[0] && 10 === diff.moved[0].from[0], "frames");
+
+/* Nothing changed since */
+var again = tjs_fake_diff(diff.snapshot);
+
+assert(0 === again.opened.length + again.closed.length + again.moved.length,
+    "empty diff");
+assert(0 === again.snapshot.diff(diff.snapshot).moved.length, "method diff");
+
+tjs_print("snapshot: " + again.snapshot);
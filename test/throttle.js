@@ -0,0 +1,33 @@
+/* Slider policies; run with: -F -S 0 -w 1000 and slide events to 0-3 */
+var values = [[], [], [], []];
+
+function collect(idx) {
+    return function (value) { values[idx].push(value); };
+}
+
+/* Plain, throttled, throttled without trailing edge and debounced */
+var sliders = [
+    new TjsSlider(0).bind(collect(0)),
+    new TjsSlider(0).bind(collect(1), { maxHz: 30 }),
+    new TjsSlider(0).bind(collect(2), { maxHz: 30, trailing: false }),
+    new TjsSlider(0).bind(collect(3), { debounce: 50 })
+];
+
+for (var i = 0; i < sliders.length; i++) tjs_attach(sliders[i]);
+
+tjs_setTimeout(function () {
+    assert("10,20,30" === values[0].join(), "plain: " + values[0]);
+    assert("10,30" === values[1].join(), "throttled: " + values[1]);
+    assert("10" === values[2].join(), "leading only: " + values[2]);
+    assert("30" === values[3].join(), "debounced: " + values[3]);
+    assert(30 === sliders[2].getPercent(), "value is current");
+
+    var stats = sliders[1].getStats();
+
+    assert(3 === stats.events && 2 === stats.delivered, "stats: " +
+        JSON.stringify(stats));
+    assert(1 === stats.coalesced, "coalesced: " + stats.coalesced);
+    assert(undefined === sliders[0].getStats(), "no policy no stats");
+
+    tjs_print("throttle: " + JSON.stringify(sliders[3].getStats()));
+}, 500);
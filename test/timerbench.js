@@ -0,0 +1,36 @@
+/* Timer scheduling overhead; run with a fake clock: -F -w 11000 */
+var NTIMERS = 10000, NINTERVALS = 100, SPAN = 10000;
+
+var fired = 0, ids = [];
+
+function fire() {
+    fired++;
+}
+
+var start = Date.now();
+
+/* Spread deadlines over SPAN ms; a prime stride avoids sorted input */
+for (var i = 0; i < NTIMERS; i++) {
+    ids.push(tjs_setTimeout(fire, (i * 7919) % SPAN));
+}
+
+for (var i = 0; i < NINTERVALS; i++) {
+    tjs_setInterval(fire, 100 + i);
+}
+
+/* Clear every tenth one-shot */
+for (var i = 0; i < NTIMERS; i += 10) {
+    tjs_clearTimer(ids[i]);
+}
+
+var elapsed = Math.max(Date.now() - start, 1);
+
+tjs_print("schedule(" + NTIMERS + "+" + NINTERVALS + "): elapsed=" + elapsed +
+    "ms, rate=" + Math.round((NTIMERS + NINTERVALS) * 1000 / elapsed) + "/s");
+
+tjs_setTimeout(function () {
+    var stats = tjs_timerstats();
+
+    tjs_print("run: fired=" + fired + ", wakeups=" + stats.wakeups +
+        ", fired/wakeup=" + (stats.fired / stats.wakeups).toFixed(2));
+}, SPAN + 500);
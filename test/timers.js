@@ -0,0 +1,42 @@
+/* Timers; run with a fake clock: -F -S 0 -w 5000 */
+var order = [], ticks = 0, nested = 0;
+
+/* One-shots fire in deadline order */
+tjs_setTimeout(function () { order.push(300); }, 300);
+tjs_setTimeout(function () { order.push(100); }, 100);
+tjs_setTimeout(function () { order.push(200); }, 200);
+
+/* Cleared timers never fire */
+var cleared = tjs_setTimeout(function () { order.push(-1); }, 150);
+
+tjs_clearTimer(cleared);
+
+/* Intervals can clear themselves */
+var interval = tjs_setInterval(function () {
+    if (5 === ++ticks) tjs_clearTimer(interval);
+}, 250);
+
+/* Timers added from callbacks */
+tjs_setTimeout(function () {
+    tjs_setTimeout(function () { nested = tjs_timerstats().now; }, 0);
+}, 400);
+
+/* Status label style update */
+var l1 = new TjsLabel("0");
+
+tjs_attach(l1);
+
+tjs_setInterval(function () {
+    l1.setValue(String(ticks));
+}, 1000);
+
+tjs_setTimeout(function () {
+    var stats = tjs_timerstats();
+
+    assert("100,200,300" === order.join(","), "order: " + order);
+    assert(5 === ticks, "interval ticks: " + ticks);
+    assert(401 === nested, "nested timer: " + nested);
+    assert(2 === stats.cleared, "cleared: " + stats.cleared);
+
+    tjs_print(JSON.stringify(stats));
+}, 4500);
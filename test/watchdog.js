@@ -0,0 +1,53 @@
+/* Watchdog budget; run with: -b 50 -w 1000 -e click:0 -e click:1 */
+var caught = 0;
+
+/* Runaway handler; aborted once the budget is used up */
+function spin() {
+    while (true) {}
+}
+
+/* Swallows the first error; aborted for good after the grace budget */
+function stubborn() {
+    while (true) {
+        try {
+            while (true) {}
+        } catch (e) {
+            caught++;
+        }
+    }
+}
+
+tjs_attach(new TjsButton("Spin").bind(spin));
+tjs_attach(new TjsButton("Stubborn").bind(stubborn));
+
+tjs_setTimeout(function check() {
+    var start = Date.now(), elapsed = -1, name = null;
+
+    try {
+        while (true) {}
+    } catch (e) {
+        elapsed = Date.now() - start;
+        name = e.name;
+    }
+
+    assert("RangeError" === name, "error is " + name);
+    assert(45 <= elapsed && 500 > elapsed, "interrupted after " + elapsed + "ms");
+    assert(1 === caught, "stubborn caught " + caught);
+
+    var stats = tjs_watchdog();
+
+    assert(50 === stats.budget, "budget is " + stats.budget);
+    assert(3 === stats.timeouts, "timeouts: " + stats.timeouts);
+    assert(1 === stats.aborts, "aborts: " + stats.aborts);
+
+    /* Slowest first */
+    var spun = stats.handlers.filter(function (h) {
+        return 0 === h.name.indexOf("click:spin");
+    })[0];
+
+    assert(spun && 1 === spun.timeouts, "spin not recorded");
+    assert(stats.handlers[0].maxCpu >= stats.handlers[1].maxCpu, "sorted");
+
+    tjs_print("watchdog: elapsed=" + elapsed + "ms, timeouts=" +
+        stats.timeouts + ", slowest=" + stats.handlers[0].name);
+}, 0);
@@ -0,0 +1,61 @@
+/* Window identity cache against the fake window source */
+tjs_fake_open(1, "Terminal");
+tjs_fake_open(2, "Browser");
+
+var seen = [];
+
+tjs_fake_observe("win_focus", function (win) {
+    seen.push(win);
+});
+
+tjs_fake_observe("win_close", function (win) {
+    seen.push(win);
+});
+
+/* Same window yields the same object */
+tjs_fake_emit("win_focus", 1);
+tjs_fake_emit("win_focus", 1);
+tjs_fake_emit("win_focus", 2);
+
+assert(seen[0] === seen[1], "same id, same object");
+assert(seen[0] !== seen[2], "different id, different object");
+assert("Terminal" === seen[0].getTitle(), "title");
+
+seen[0].marker = 42;
+
+var wins = tjs_fake_getWindows();
+
+assert(2 === wins.length, "two windows");
+assert(42 === wins.filter(function (w) { return 1 === w.getId(); })[0].marker,
+    "getWindows shares cached object");
+
+/* Close evicts; reused id gets a fresh object */
+var closed = seen[0];
+
+tjs_fake_emit("win_close", 1);
+
+assert(closed === seen[3], "close handler sees cached object");
+assert(!closed.isOpen(), "closed window");
+assert(1 === tjs_memstats().wincache.size, "evicted on close");
+
+tjs_fake_open(1, "Terminal");
+tjs_fake_emit("win_focus", 1);
+
+assert(closed !== seen[4], "reused id gets fresh object");
+
+/* Unreachable objects drop out of the cache */
+seen = [];
+wins = null;
+closed = null;
+
+Duktape.gc();
+Duktape.gc();
+
+var stats = tjs_memstats().wincache;
+
+assert(0 === stats.size, "finalized objects evicted");
+assert(0 < stats.finalized, "finalizer ran");
+
+tjs_fake_emit("win_focus", 2);
+
+tjs_print(JSON.stringify(tjs_memstats().wincache));